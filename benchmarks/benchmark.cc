@@ -0,0 +1,86 @@
+// Copyright 2018 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "benchmark.h"
+
+#include <atomic>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+
+namespace {
+
+std::atomic<int64_t> num_allocations(0);
+std::string filter;
+double min_seconds = 0.5;
+int num_failures = 0;
+
+void* CountedAllocate(std::size_t size) {
+  num_allocations.fetch_add(1, std::memory_order_relaxed);
+  void* ptr = std::malloc(size > 0 ? size : 1);
+  if (ptr == nullptr) {
+    throw std::bad_alloc();
+  }
+  return ptr;
+}
+
+}  // namespace
+
+// Replacing the global allocation functions counts every heap allocation
+// made through new, including those of the standard containers.
+void* operator new(std::size_t size) { return CountedAllocate(size); }
+void* operator new[](std::size_t size) { return CountedAllocate(size); }
+void operator delete(void* ptr) noexcept { std::free(ptr); }
+void operator delete[](void* ptr) noexcept { std::free(ptr); }
+
+namespace hanabi_learning_env {
+namespace benchmark {
+
+bool Init(int argc, char** argv) {
+  const char kMinSecondsFlag[] = "--min_seconds=";
+  for (int i = 1; i < argc; ++i) {
+    if (std::strncmp(argv[i], kMinSecondsFlag, sizeof(kMinSecondsFlag) - 1) ==
+        0) {
+      min_seconds = std::atof(argv[i] + sizeof(kMinSecondsFlag) - 1);
+    } else if (argv[i][0] != '-' && filter.empty()) {
+      filter = argv[i];
+    } else {
+      std::fprintf(stderr, "usage: %s [--min_seconds=<x>] [name_filter]\n",
+                   argv[0]);
+      return false;
+    }
+  }
+  return true;
+}
+
+bool ShouldRun(const std::string& name) {
+  return name.find(filter) != std::string::npos;
+}
+
+double MinSeconds() { return min_seconds; }
+
+int64_t NumAllocations() {
+  return num_allocations.load(std::memory_order_relaxed);
+}
+
+void Fail(const std::string& message) {
+  ++num_failures;
+  std::printf("FAILED: %s\n", message.c_str());
+  std::fflush(stdout);
+}
+
+int ExitStatus() { return num_failures > 0 ? 1 : 0; }
+
+}  // namespace benchmark
+}  // namespace hanabi_learning_env
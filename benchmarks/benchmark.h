@@ -0,0 +1,108 @@
+// Copyright 2018 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// A minimal timing harness for the hanabi_bench micro-benchmarks.
+
+#ifndef __BENCHMARK_H__
+#define __BENCHMARK_H__
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+
+namespace hanabi_learning_env {
+namespace benchmark {
+
+// Parses the command line: an optional substring that benchmark names must
+// contain to run, and --min_seconds=<x> to change the minimum time spent in
+// the timed loop of each benchmark (0.5 by default). Returns false and
+// prints usage on unknown flags.
+bool Init(int argc, char** argv);
+// Returns true if the benchmark name matches the filter given to Init.
+bool ShouldRun(const std::string& name);
+double MinSeconds();
+// Number of calls to the global operator new so far, from all threads.
+int64_t NumAllocations();
+
+// Keeps results alive so that the compiler cannot drop the measured work.
+inline void DoNotOptimize(int64_t value) {
+  static volatile int64_t sink;
+  sink = sink + value;
+}
+
+// Calls fn(iterations), which must perform iterations operations, with a
+// growing iteration count until the loop runs for MinSeconds(), and prints
+// the time and number of allocations per operation. Does nothing if name
+// does not match the filter.
+template <typename Fn>
+void Run(const std::string& name, Fn fn) {
+  if (!ShouldRun(name)) {
+    return;
+  }
+  using Clock = std::chrono::steady_clock;
+  int64_t iterations = 1;
+  while (true) {
+    const int64_t start_allocations = NumAllocations();
+    auto start = Clock::now();
+    fn(iterations);
+    double seconds =
+        std::chrono::duration<double>(Clock::now() - start).count();
+    if (seconds >= MinSeconds() || iterations >= (int64_t{1} << 40)) {
+      const int64_t allocations = NumAllocations() - start_allocations;
+      std::printf("%-40s %12.1f ns/op %10.2f allocs/op %12lld ops\n",
+                  name.c_str(), seconds * 1e9 / iterations,
+                  static_cast<double>(allocations) / iterations,
+                  static_cast<long long>(iterations));
+      std::fflush(stdout);
+      return;
+    }
+    // Aim slightly past the target to avoid many short rounds.
+    iterations = seconds > 0 ? static_cast<int64_t>(iterations * 1.4 *
+                                                    MinSeconds() / seconds) +
+                                   1
+                             : iterations * 10;
+  }
+}
+
+// Records a failed check, printed with the results, which makes
+// ExitStatus() return 1.
+void Fail(const std::string& message);
+int ExitStatus();
+
+// Checks that fn() makes no heap allocations once warmed up: runs it once,
+// then again counting allocations, and fails the run unless there were
+// none. Does nothing if name does not match the filter.
+template <typename Fn>
+void ExpectNoAllocations(const std::string& name, Fn fn) {
+  if (!ShouldRun(name)) {
+    return;
+  }
+  fn();
+  const int64_t start_allocations = NumAllocations();
+  fn();
+  const int64_t allocations = NumAllocations() - start_allocations;
+  if (allocations != 0) {
+    Fail(name + ": " + std::to_string(allocations) +
+         " allocations after warm-up");
+  } else {
+    std::printf("%-40s %12s\n", name.c_str(), "no allocations");
+    std::fflush(stdout);
+  }
+}
+
+}  // namespace benchmark
+}  // namespace hanabi_learning_env
+
+#endif
@@ -0,0 +1,1098 @@
+// Copyright 2018 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Micro-benchmarks for the performance-sensitive paths of hanabi_lib, run
+// for the standard game with 2 to 5 players and for the small variant.
+//
+// Built as part of the top-level project, or on its own with:
+//   cmake -S benchmarks -B build_bench && cmake --build build_bench
+// Run as hanabi_bench [--min_seconds=<x>] [name_filter]; e.g.
+// "hanabi_bench /3p" runs the 3 player benchmarks only.
+
+#include <algorithm>
+#include <cstdint>
+#include <memory>
+#include <random>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "benchmark.h"
+#include "bit_packing.h"
+#include "canonical_encoders.h"
+#include "hanabi_belief.h"
+#include "hanabi_determinization.h"
+#include "hanabi_env_server.h"
+#include "hanabi_expectimax.h"
+#include "hanabi_game.h"
+#include "hanabi_game_log.h"
+#include "hanabi_observation.h"
+#include "hanabi_playout.h"
+#include "hanabi_search.h"
+#include "hanabi_vector_env.h"
+#include "object_pool.h"
+#include "replay_buffer.h"
+#include "hanabi_state.h"
+#include "transposition_table.h"
+
+namespace hle = hanabi_learning_env;
+namespace bench = hanabi_learning_env::benchmark;
+
+namespace {
+
+struct Variant {
+  std::string name;
+  std::unordered_map<std::string, std::string> params;
+};
+
+std::vector<Variant> Variants() {
+  std::vector<Variant> variants;
+  for (int players = 2; players <= 5; ++players) {
+    variants.push_back({std::to_string(players) + "p",
+                        {{"players", std::to_string(players)}, {"seed", "1"}}});
+  }
+  // Same parameters as rl_env's Hanabi-Small.
+  variants.push_back({"small",
+                      {{"players", "2"},
+                       {"colors", "2"},
+                       {"ranks", "5"},
+                       {"hand_size", "2"},
+                       {"max_information_tokens", "3"},
+                       {"max_life_tokens", "1"},
+                       {"seed", "1"}}});
+  return variants;
+}
+
+// Applies a uniformly random legal move, or deals a card at chance nodes.
+// Unless allow_misplays, plays that would cost a life token are skipped, so
+// that games last until the deck runs out.
+void ApplyRandomMove(hle::HanabiState* state, std::mt19937* rng,
+                     bool allow_misplays = true) {
+  if (state->CurPlayer() == hle::kChancePlayerId) {
+    state->ApplyRandomChance(rng);
+    return;
+  }
+  uint64_t mask = state->LegalMoveMask(state->CurPlayer());
+  if (!allow_misplays) {
+    const hle::HanabiGame& game = *state->ParentGame();
+    const auto& cards = state->Hands()[state->CurPlayer()].Cards();
+    for (int index = 0; index < cards.size(); ++index) {
+      if (!state->CardPlayableOnFireworks(cards[index])) {
+        mask &= ~(uint64_t{1} << game.GetMoveUid(hle::HanabiMove::kPlay, index,
+                                                 -1, -1, -1));
+      }
+    }
+  }
+  int num_legal = 0;
+  for (uint64_t m = mask; m != 0; m &= m - 1) {
+    ++num_legal;
+  }
+  for (int skip = (*rng)() % num_legal; skip > 0; --skip) {
+    mask &= mask - 1;
+  }
+  int uid = 0;
+  while (((mask >> uid) & 1) == 0) {
+    ++uid;
+  }
+  state->ApplyMove(state->ParentGame()->GetMove(uid));
+}
+
+// Returns a state after a few random moves, with hints available. Games that
+// end early (e.g. the small variant has one life token) are replayed.
+hle::HanabiState MidGameState(hle::HanabiGame* game) {
+  std::mt19937 rng(1);
+  while (true) {
+    hle::HanabiState state(game);
+    for (int moves = 0;
+         (moves < 8 || state.CurPlayer() == hle::kChancePlayerId) &&
+         !state.IsTerminal();
+         ++moves) {
+      ApplyRandomMove(&state, &rng);
+    }
+    if (!state.IsTerminal()) {
+      return state;
+    }
+  }
+}
+
+// Deals entire decks, one card per operation.
+void BenchDeckDealCard(const std::string& suffix, const hle::HanabiGame& game) {
+  bench::Run("DeckDealCard" + suffix, [&game](int64_t iterations) {
+    std::mt19937 rng(1);
+    const hle::HanabiState::HanabiDeck full_deck(game);
+    hle::HanabiState::HanabiDeck deck = full_deck;
+    for (int64_t i = 0; i < iterations; ++i) {
+      if (deck.Empty()) {
+        deck = full_deck;
+      }
+      bench::DoNotOptimize(deck.DealCard(&rng).Rank());
+    }
+  });
+}
+
+// Replays the moves (deals included) of a recorded random game, one move per
+// operation. Restarting the game adds one state copy per replayed game.
+void BenchApplyMove(const std::string& suffix, hle::HanabiGame* game,
+                    bool record_move_history) {
+  std::mt19937 rng(1);
+  hle::HanabiState start_state(game);
+  start_state.SetRecordMoveHistory(true);
+  hle::HanabiState state = start_state;
+  while (!state.IsTerminal()) {
+    ApplyRandomMove(&state, &rng);
+  }
+  const std::vector<hle::HanabiHistoryItem> moves = state.MoveHistory();
+  start_state.SetRecordMoveHistory(record_move_history);
+  bench::Run(std::string(record_move_history ? "ApplyMove"
+                                             : "ApplyMove/NoMoveHistory") +
+                 suffix,
+             [&](int64_t iterations) {
+               hle::HanabiState state = start_state;
+               size_t next = 0;
+               for (int64_t i = 0; i < iterations; ++i) {
+                 if (next == moves.size()) {
+                   state = start_state;
+                   next = 0;
+                 }
+                 state.ApplyMove(moves[next++].move);
+               }
+               bench::DoNotOptimize(state.Score());
+             });
+}
+
+// Tries each legal move of a mid-game state in turn, as a search expanding a
+// node does: on a copy of the state, or in place followed by UndoMove.
+void BenchTryMoves(const std::string& suffix, hle::HanabiGame* game) {
+  hle::HanabiState state = MidGameState(game);
+  state.SetRecordMoveHistory(false);
+  const std::vector<hle::HanabiMove> moves = state.LegalMoves(state.CurPlayer());
+  bench::Run("TryMoves/Copy" + suffix, [&state, &moves](int64_t iterations) {
+    for (int64_t i = 0; i < iterations; ++i) {
+      hle::HanabiState child(state);
+      child.ApplyMove(moves[i % moves.size()]);
+      bench::DoNotOptimize(child.CurPlayer());
+    }
+  });
+  bench::Run("TryMoves/Undo" + suffix, [&state, &moves](int64_t iterations) {
+    hle::HanabiUndoRecord undo;
+    for (int64_t i = 0; i < iterations; ++i) {
+      state.ApplyMove(moves[i % moves.size()], &undo);
+      bench::DoNotOptimize(state.CurPlayer());
+      state.UndoMove(undo);
+    }
+  });
+}
+
+// Deals the opening hands through the chance-node interface, one card per
+// operation. Includes the cost of adding the card to the hand.
+void BenchApplyRandomChance(const std::string& suffix, hle::HanabiGame* game) {
+  bench::Run("ApplyRandomChance" + suffix, [game](int64_t iterations) {
+    std::mt19937 rng(1);
+    const hle::HanabiState start_state(game);
+    hle::HanabiState state = start_state;
+    for (int64_t i = 0; i < iterations; ++i) {
+      if (state.CurPlayer() != hle::kChancePlayerId) {
+        state = start_state;
+      }
+      state.ApplyRandomChance(&rng);
+    }
+    bench::DoNotOptimize(state.Deck().Size());
+  });
+}
+
+// Starts a game and deals the opening hands: by constructing the state and
+// dealing each card as a chance move, and by resetting a state from the
+// game's template and dealing the hands in one pass, which is also checked
+// to make no allocations.
+void BenchNewGame(const std::string& suffix, hle::HanabiGame* game) {
+  bench::Run("NewGame/Construct+ApplyRandomChance" + suffix,
+             [game](int64_t iterations) {
+               std::mt19937 rng(1);
+               hle::HanabiState state(game);
+               state.SetRecordMoveHistory(false);
+               for (int64_t i = 0; i < iterations; ++i) {
+                 state = hle::HanabiState(game, /*start_player=*/0);
+                 state.SetRecordMoveHistory(false);
+                 while (state.CurPlayer() == hle::kChancePlayerId) {
+                   state.ApplyRandomChance(&rng);
+                 }
+                 bench::DoNotOptimize(state.CurPlayer());
+               }
+             });
+  const std::string name = "NewGame/Reset+DealInitialHands" + suffix;
+  hle::HanabiState state(game);
+  state.SetRecordMoveHistory(false);
+  std::mt19937 rng(1);
+  auto new_game = [&state, &rng]() {
+    state.Reset(/*start_player=*/0);
+    state.DealInitialHands(&rng);
+    bench::DoNotOptimize(state.CurPlayer());
+  };
+  bench::Run(name, [&new_game](int64_t iterations) {
+    for (int64_t i = 0; i < iterations; ++i) {
+      new_game();
+    }
+  });
+  bench::ExpectNoAllocations(name, new_game);
+}
+
+// The general chance-node path: enumerate outcomes, then sample one.
+void BenchChanceOutcomesPick(const std::string& suffix, hle::HanabiGame* game) {
+  bench::Run("ChanceOutcomes+PickRandomChance" + suffix,
+             [game](int64_t iterations) {
+               std::mt19937 rng(1);
+               const hle::HanabiState start_state(game);
+               hle::HanabiState state = start_state;
+               for (int64_t i = 0; i < iterations; ++i) {
+                 if (state.CurPlayer() != hle::kChancePlayerId) {
+                   state = start_state;
+                 }
+                 state.ApplyMove(
+                     game->PickRandomChance(state.ChanceOutcomes(), &rng));
+               }
+               bench::DoNotOptimize(state.Deck().Size());
+             });
+}
+
+void BenchCopyState(const std::string& suffix, hle::HanabiGame* game,
+                    bool record_move_history) {
+  hle::HanabiState state = MidGameState(game);
+  state.SetRecordMoveHistory(record_move_history);
+  bench::Run(std::string(record_move_history ? "CopyState"
+                                             : "CopyState/NoMoveHistory") +
+                 suffix,
+             [&state](int64_t iterations) {
+               for (int64_t i = 0; i < iterations; ++i) {
+                 hle::HanabiState copy(state);
+                 bench::DoNotOptimize(copy.CurPlayer());
+               }
+             });
+}
+
+void BenchLegalMoves(const std::string& suffix, hle::HanabiGame* game) {
+  const hle::HanabiState state = MidGameState(game);
+  bench::Run("LegalMoves" + suffix, [&state](int64_t iterations) {
+    for (int64_t i = 0; i < iterations; ++i) {
+      bench::DoNotOptimize(state.LegalMoves(state.CurPlayer()).size());
+    }
+  });
+}
+
+void BenchLegalMoveMask(const std::string& suffix, hle::HanabiGame* game) {
+  const hle::HanabiState state = MidGameState(game);
+  bench::Run("LegalMoveMask" + suffix, [&state](int64_t iterations) {
+    for (int64_t i = 0; i < iterations; ++i) {
+      bench::DoNotOptimize(state.LegalMoveMask(state.CurPlayer()));
+    }
+  });
+}
+
+void BenchStateHash(const std::string& suffix, hle::HanabiGame* game) {
+  const hle::HanabiState state = MidGameState(game);
+  bench::Run("StateHash" + suffix, [&state](int64_t iterations) {
+    for (int64_t i = 0; i < iterations; ++i) {
+      bench::DoNotOptimize(state.Hash());
+    }
+  });
+  bench::Run("ObserverHash" + suffix, [&state](int64_t iterations) {
+    for (int64_t i = 0; i < iterations; ++i) {
+      bench::DoNotOptimize(state.ObserverHash(state.CurPlayer()));
+    }
+  });
+}
+
+// Stores and looks up the hashes of the states of random games, in a table
+// much larger than the cache.
+void BenchTranspositionTable(const std::string& suffix,
+                             hle::HanabiGame* game) {
+  std::vector<uint64_t> keys;
+  std::mt19937 rng(1);
+  while (keys.size() < 4096) {
+    hle::HanabiState state(game);
+    while (!state.IsTerminal()) {
+      ApplyRandomMove(&state, &rng);
+      keys.push_back(state.Hash());
+    }
+  }
+  hle::TranspositionTable<uint32_t> table(int64_t{1} << 22);
+  bench::Run("TranspositionTable" + suffix,
+             [&keys, &table](int64_t iterations) {
+               uint32_t value = 0;
+               for (int64_t i = 0; i < iterations; ++i) {
+                 const uint64_t key = keys[i % keys.size()];
+                 table.Store(key, static_cast<uint32_t>(i));
+                 bench::DoNotOptimize(table.Lookup(key, &value));
+               }
+               bench::DoNotOptimize(value);
+             });
+}
+
+// Builds the observation of each player in turn.
+void BenchObservation(const std::string& suffix, hle::HanabiGame* game) {
+  const hle::HanabiState state = MidGameState(game);
+  bench::Run("HanabiObservation" + suffix, [&](int64_t iterations) {
+    for (int64_t i = 0; i < iterations; ++i) {
+      hle::HanabiObservation observation(state, i % game->NumPlayers());
+      bench::DoNotOptimize(observation.DeckSize());
+    }
+  });
+}
+
+// Encodes a prebuilt observation into a new std::vector<int>.
+void BenchEncode(const std::string& suffix, hle::HanabiGame* game) {
+  const hle::HanabiState state = MidGameState(game);
+  const hle::HanabiObservation observation(state, state.CurPlayer());
+  const hle::CanonicalObservationEncoder encoder(game);
+  bench::Run("Encode" + suffix, [&](int64_t iterations) {
+    for (int64_t i = 0; i < iterations; ++i) {
+      bench::DoNotOptimize(encoder.Encode(observation)[0]);
+    }
+  });
+}
+
+// Builds the observation, then encodes it into a caller-owned buffer.
+void BenchEncodeObservation(const std::string& suffix, hle::HanabiGame* game) {
+  const hle::HanabiState state = MidGameState(game);
+  const hle::CanonicalObservationEncoder encoder(game);
+  std::vector<uint8_t> buffer(encoder.Size());
+  bench::Run("HanabiObservation+EncodeInto" + suffix, [&](int64_t iterations) {
+    for (int64_t i = 0; i < iterations; ++i) {
+      encoder.EncodeInto(hle::HanabiObservation(state, i % game->NumPlayers()),
+                         buffer.data());
+    }
+    bench::DoNotOptimize(buffer[0]);
+  });
+}
+
+void BenchEncodeState(const std::string& suffix, hle::HanabiGame* game) {
+  const hle::HanabiState state = MidGameState(game);
+  const hle::CanonicalObservationEncoder encoder(game);
+  std::vector<uint8_t> buffer(encoder.Size());
+  bench::Run("EncodeStateInto" + suffix, [&](int64_t iterations) {
+    for (int64_t i = 0; i < iterations; ++i) {
+      encoder.EncodeStateInto(state, i % game->NumPlayers(), buffer.data());
+    }
+    bench::DoNotOptimize(buffer[0]);
+  });
+}
+
+// Encodes a batch of states reached by random play, one state per operation.
+// The batch is checked against EncodeStateInto before timing.
+void BenchEncodeStates(const std::string& suffix, hle::HanabiGame* game) {
+  constexpr int kNumStates = 64;
+  const hle::CanonicalObservationEncoder encoder(game);
+  std::vector<hle::HanabiState> states;
+  std::vector<int> players;
+  hle::HanabiState state = MidGameState(game);
+  std::mt19937 rng(11);
+  while (states.size() < kNumStates) {
+    ApplyRandomMove(&state, &rng);
+    if (state.IsTerminal()) {
+      state = MidGameState(game);
+    } else if (state.CurPlayer() != hle::kChancePlayerId) {
+      states.push_back(state);
+      players.push_back(states.size() % game->NumPlayers());
+    }
+  }
+  std::vector<const hle::HanabiState*> state_ptrs;
+  for (const hle::HanabiState& s : states) {
+    state_ptrs.push_back(&s);
+  }
+  const int size = encoder.Size();
+  std::vector<float> buffer(kNumStates * size);
+  std::vector<float> expected(size);
+  encoder.EncodeStatesInto(state_ptrs.data(), players.data(), kNumStates,
+                           buffer.data());
+  for (int i = 0; i < kNumStates; ++i) {
+    encoder.EncodeStateInto(states[i], players[i], expected.data());
+    if (!std::equal(expected.begin(), expected.end(),
+                    buffer.begin() + i * size)) {
+      bench::Fail("EncodeStatesInto" + suffix + ": mismatch");
+      return;
+    }
+  }
+  bench::Run("EncodeStatesInto/float" + suffix, [&](int64_t iterations) {
+    for (int64_t i = 0; i < iterations; i += kNumStates) {
+      encoder.EncodeStatesInto(state_ptrs.data(), players.data(), kNumStates,
+                               buffer.data());
+    }
+    bench::DoNotOptimize(static_cast<int64_t>(buffer[size - 1]));
+  });
+}
+
+void BenchEncodeStatePacked(const std::string& suffix, hle::HanabiGame* game) {
+  const hle::HanabiState state = MidGameState(game);
+  const hle::CanonicalObservationEncoder encoder(game);
+  std::vector<uint64_t> buffer(encoder.PackedSize());
+  bench::Run("EncodeStatePackedInto" + suffix, [&](int64_t iterations) {
+    for (int64_t i = 0; i < iterations; ++i) {
+      encoder.EncodeStatePackedInto(state, i % game->NumPlayers(),
+                                    buffer.data());
+    }
+    bench::DoNotOptimize(buffer[0]);
+  });
+}
+
+// Unpacks a batch of packed encodings to floats, one encoding per operation,
+// as a learner would for a sampled replay batch. The round trip through
+// PackBits is checked before timing.
+void BenchUnpackBits(const std::string& suffix, hle::HanabiGame* game) {
+  constexpr int kNumRows = 256;
+  const hle::CanonicalObservationEncoder encoder(game);
+  const int size = encoder.Size();
+  const int packed_size = encoder.PackedSize();
+  std::vector<uint8_t> bits(size);
+  std::vector<uint64_t> packed(kNumRows * packed_size);
+  hle::HanabiState state = MidGameState(game);
+  std::mt19937 rng(7);
+  for (int row = 0; row < kNumRows; ++row) {
+    do {
+      ApplyRandomMove(&state, &rng);
+      if (state.IsTerminal()) {
+        state = MidGameState(game);
+      }
+    } while (state.CurPlayer() == hle::kChancePlayerId);
+    encoder.EncodeStateInto(state, row % game->NumPlayers(), bits.data());
+    hle::PackBits(bits.data(), size, packed.data() + row * packed_size);
+    std::vector<uint8_t> unpacked(size);
+    hle::UnpackBits(packed.data() + row * packed_size, size, unpacked.data());
+    if (unpacked != bits) {
+      bench::Fail("UnpackBits" + suffix + ": round trip mismatch");
+      return;
+    }
+  }
+  std::vector<float> values(kNumRows * size);
+  bench::Run("UnpackBitRows/float" + suffix, [&](int64_t iterations) {
+    for (int64_t i = 0; i < iterations; i += kNumRows) {
+      hle::UnpackBitRows(packed.data(), kNumRows, size, values.data());
+    }
+    bench::DoNotOptimize(static_cast<int64_t>(values[size - 1]));
+  });
+}
+
+enum class TurnEncoding { kNone, kEncodeStateInto, kIncremental };
+
+// Plays random games without misplays, and encodes the acting player's
+// observation at every turn, one turn per operation: not at all (the cost of
+// playing), from scratch, or with one IncrementalCanonicalEncoder per player.
+// Before timing, incremental encodings are checked against EncodeStateInto.
+void BenchEncodeTurns(const std::string& suffix, hle::HanabiGame* game,
+                      TurnEncoding turn_encoding) {
+  const hle::CanonicalObservationEncoder encoder(game);
+  std::vector<uint8_t> buffer(encoder.Size());
+  std::vector<hle::IncrementalCanonicalEncoder> player_encoders;
+  for (int player = 0; player < game->NumPlayers(); ++player) {
+    player_encoders.emplace_back(game, player);
+  }
+  hle::HanabiState start_state(game);
+  start_state.SetRecordMoveHistory(false);
+  hle::HanabiState state = start_state;
+  // Plays until the next turn, encodes it, and returns the acting player.
+  auto next_turn = [&](std::mt19937* rng, TurnEncoding encoding) {
+    do {
+      if (state.IsTerminal()) {
+        state = start_state;
+        for (auto& player_encoder : player_encoders) {
+          player_encoder.Invalidate();
+        }
+      }
+      ApplyRandomMove(&state, rng, /*allow_misplays=*/false);
+    } while (state.CurPlayer() == hle::kChancePlayerId || state.IsTerminal());
+    const int player = state.CurPlayer();
+    if (encoding == TurnEncoding::kEncodeStateInto) {
+      encoder.EncodeStateInto(state, player, buffer.data());
+    } else if (encoding == TurnEncoding::kIncremental) {
+      player_encoders[player].Update(state);
+    }
+    return player;
+  };
+
+  if (turn_encoding == TurnEncoding::kIncremental) {
+    std::mt19937 rng(2);
+    for (int turn = 0; turn < 10000; ++turn) {
+      const int player = next_turn(&rng, TurnEncoding::kIncremental);
+      encoder.EncodeStateInto(state, player, buffer.data());
+      if (player_encoders[player].Encoding() != buffer) {
+        bench::Fail("IncrementalCanonicalEncoder mismatch" + suffix);
+        return;
+      }
+    }
+  }
+
+  const char* name =
+      turn_encoding == TurnEncoding::kNone
+          ? "Turns/NoEncoding"
+          : turn_encoding == TurnEncoding::kEncodeStateInto
+                ? "Turns/EncodeStateInto"
+                : "Turns/Incremental";
+  bench::Run(name + suffix, [&](int64_t iterations) {
+    std::mt19937 rng(1);
+    for (int64_t i = 0; i < iterations; ++i) {
+      bench::DoNotOptimize(next_turn(&rng, turn_encoding));
+    }
+    bench::DoNotOptimize(buffer[0] + player_encoders[0].Encoding()[0]);
+  });
+}
+
+// Writes the beliefs of each player in turn, from scratch, as independent
+// (V0) beliefs or refined by iterations of cross-card consistency (V1).
+void BenchBeliefEncode(const std::string& suffix, hle::HanabiGame* game,
+                       int iterations) {
+  const hle::HanabiState state = MidGameState(game);
+  const hle::BeliefObservationEncoder encoder(game, iterations);
+  std::vector<float> buffer(encoder.Size());
+  bench::Run(std::string("Belief/EncodeStateInto/") +
+                 (iterations > 0 ? "V1" : "V0") + suffix,
+             [&](int64_t iterations) {
+               for (int64_t i = 0; i < iterations; ++i) {
+                 encoder.EncodeStateInto(state, i % game->NumPlayers(),
+                                         buffer.data());
+               }
+               bench::DoNotOptimize(buffer[0]);
+             });
+}
+
+// As Turns/Incremental, with one BeliefState per player updated at its turns.
+// Before timing, the updated beliefs are checked against the encoder's.
+void BenchBeliefTurns(const std::string& suffix, hle::HanabiGame* game) {
+  const hle::BeliefObservationEncoder encoder(game);
+  std::vector<float> buffer(encoder.Size());
+  std::vector<hle::BeliefState> beliefs;
+  for (int player = 0; player < game->NumPlayers(); ++player) {
+    beliefs.emplace_back(game, player);
+  }
+  hle::HanabiState start_state(game);
+  start_state.SetRecordMoveHistory(false);
+  hle::HanabiState state = start_state;
+  auto next_turn = [&](std::mt19937* rng) {
+    do {
+      if (state.IsTerminal()) {
+        state = start_state;
+        for (auto& belief : beliefs) {
+          belief.Invalidate();
+        }
+      }
+      ApplyRandomMove(&state, rng, /*allow_misplays=*/false);
+    } while (state.CurPlayer() == hle::kChancePlayerId || state.IsTerminal());
+    const int player = state.CurPlayer();
+    beliefs[player].Update(state);
+    return player;
+  };
+
+  std::mt19937 check_rng(2);
+  for (int turn = 0; turn < 10000; ++turn) {
+    const int player = next_turn(&check_rng);
+    encoder.EncodeStateInto(state, player, buffer.data());
+    if (beliefs[player].Beliefs() != buffer) {
+      bench::Fail("BeliefState mismatch" + suffix);
+      return;
+    }
+  }
+
+  bench::Run("Turns/BeliefUpdate" + suffix, [&](int64_t iterations) {
+    std::mt19937 rng(1);
+    for (int64_t i = 0; i < iterations; ++i) {
+      bench::DoNotOptimize(next_turn(&rng));
+    }
+    bench::DoNotOptimize(beliefs[0].Beliefs()[0]);
+  });
+}
+
+// Plays complete games with uniformly random legal moves, one game per
+// operation.
+void BenchRandomPlayout(const std::string& suffix, hle::HanabiGame* game) {
+  hle::HanabiState start_state(game);
+  start_state.SetRecordMoveHistory(false);
+  bench::Run("RandomPlayout" + suffix, [&](int64_t iterations) {
+    std::mt19937 rng(1);
+    for (int64_t i = 0; i < iterations; ++i) {
+      hle::HanabiState state = start_state;
+      while (!state.IsTerminal()) {
+        ApplyRandomMove(&state, &rng);
+      }
+      bench::DoNotOptimize(state.Score());
+    }
+  });
+}
+
+// Replays logged games whole, and regenerates the observations of their
+// player moves, one game per operation. Games are logged as they are played,
+// without misplays so that they last until the deck runs out.
+void BenchGameLog(const std::string& suffix, hle::HanabiGame* game) {
+  const std::string path = "hanabi_bench_game_log.tmp";
+  {
+    hle::HanabiGameLogWriter writer(path, *game);
+    hle::HanabiState state(game);
+    state.SetRecordMoveHistory(false);
+    state.SetMoveListener(&writer);
+    std::mt19937 rng(1);
+    for (int i = 0; i < 64; ++i) {
+      state.Reset(-1);
+      while (!state.IsTerminal()) {
+        ApplyRandomMove(&state, &rng, /*allow_misplays=*/false);
+      }
+    }
+  }
+  const hle::HanabiGameLogReader reader(path);
+  std::remove(path.c_str());
+  hle::HanabiState state(game);
+  state.SetRecordMoveHistory(false);
+  bench::Run("GameLog/Replay" + suffix, [&](int64_t iterations) {
+    for (int64_t i = 0; i < iterations; ++i) {
+      const int index = i % reader.NumGames();
+      reader.Replay(index, reader.NumMoves(index), &state);
+      bench::DoNotOptimize(state.Score());
+    }
+  });
+  const hle::CanonicalObservationEncoder encoder(game);
+  int max_player_moves = 0;
+  for (int index = 0; index < reader.NumGames(); ++index) {
+    max_player_moves = std::max(max_player_moves, reader.NumPlayerMoves(index));
+  }
+  std::vector<uint8_t> observations(max_player_moves * encoder.Size());
+  bench::Run("GameLog/EncodeGame" + suffix, [&](int64_t iterations) {
+    for (int64_t i = 0; i < iterations; ++i) {
+      const int index = i % reader.NumGames();
+      bench::DoNotOptimize(
+          reader.EncodeGame(index, encoder, observations.data(), nullptr));
+    }
+  });
+}
+
+// Adds the packed observations of random games to a replay buffer, and
+// samples batches of 32 stacked transitions from a full buffer, uniformly or
+// by priority, with their priorities then updated.
+void BenchReplayBuffer(const std::string& suffix, hle::HanabiGame* game) {
+  const hle::CanonicalObservationEncoder encoder(game);
+  const int words = hle::PackedLength(encoder.Size());
+  // The observation before each player move, and whether it ended the game.
+  std::vector<uint64_t> observations;
+  std::vector<uint8_t> terminals;
+  std::mt19937 rng(1);
+  while (terminals.size() < 4096) {
+    hle::HanabiState state(game);
+    while (!state.IsTerminal()) {
+      if (state.CurPlayer() == hle::kChancePlayerId) {
+        ApplyRandomMove(&state, &rng);
+        continue;
+      }
+      observations.resize(observations.size() + words);
+      encoder.EncodeStatePackedInto(state, state.CurPlayer(),
+                                &observations[observations.size() - words]);
+      ApplyRandomMove(&state, &rng);
+      terminals.push_back(state.IsTerminal());
+    }
+  }
+  for (bool prioritized : {false, true}) {
+    hle::ReplayBufferConfig config;
+    config.observation_bits = encoder.Size();
+    config.num_moves = game->MaxMoves();
+    config.capacity = 1 << 16;
+    config.stack_size = 4;
+    config.update_horizon = 3;
+    config.gamma = 0.99;
+    config.prioritized = prioritized;
+    config.seed = 1;
+    hle::ReplayBuffer buffer(config);
+    auto add = [&](int64_t i) {
+      const int index = i % terminals.size();
+      buffer.Add(&observations[static_cast<int64_t>(index) * words],
+                 index % config.num_moves, 1, terminals[index],
+                 ~uint64_t{0} >> (64 - config.num_moves));
+    };
+    if (!prioritized) {
+      bench::Run("ReplayBuffer/Add" + suffix, [&](int64_t iterations) {
+        for (int64_t i = 0; i < iterations; ++i) {
+          add(i);
+        }
+      });
+    }
+    for (int64_t i = 0; i < config.capacity; ++i) {
+      add(i);
+    }
+    constexpr int kBatchSize = 32;
+    std::vector<int> indices(kBatchSize);
+    std::vector<uint8_t> states(kBatchSize * encoder.Size() *
+                                config.stack_size);
+    std::vector<uint8_t> next_states(states.size());
+    std::vector<float> rewards(kBatchSize);
+    std::vector<float> priorities(kBatchSize, 2);
+    hle::ReplayBatch batch;
+    batch.states = states.data();
+    batch.next_states = next_states.data();
+    batch.rewards = rewards.data();
+    bench::Run(std::string(prioritized ? "ReplayBuffer/PrioritizedSample32"
+                                       : "ReplayBuffer/Sample32") +
+                   suffix,
+               [&](int64_t iterations) {
+                 for (int64_t i = 0; i < iterations; ++i) {
+                   bench::DoNotOptimize(
+                       buffer.Sample(kBatchSize, indices.data()));
+                   buffer.GetTransitions(kBatchSize, indices.data(), batch);
+                   if (prioritized) {
+                     buffer.SetPriorities(kBatchSize, indices.data(),
+                                          priorities.data());
+                   }
+                   bench::DoNotOptimize(rewards[0]);
+                 }
+               });
+  }
+}
+
+// Whole games played by a native policy through EvaluatePolicy on one
+// thread, one game per operation.
+void BenchEvaluatePolicy(const std::string& suffix, hle::HanabiGame* game,
+                         const std::string& policy_name,
+                         const hle::HanabiPolicy& policy) {
+  bench::Run("EvaluatePolicy/" + policy_name + suffix,
+             [&](int64_t iterations) {
+               const hle::HanabiEvaluation evaluation =
+                   hle::EvaluatePolicy(game, policy, iterations);
+               bench::DoNotOptimize(evaluation.score_counts[0]);
+             });
+}
+
+// Samples a pool of determinizations for the acting player.
+void BenchDeterminizationPool(const std::string& suffix,
+                              hle::HanabiGame* game) {
+  hle::HanabiState state = MidGameState(game);
+  state.SetRecordMoveHistory(false);
+  hle::HanabiDeterminizationPool pool(/*size=*/64, /*seed=*/1);
+  bench::Run("DeterminizationPool/64" + suffix, [&](int64_t iterations) {
+    for (int64_t i = 0; i < iterations; ++i) {
+      pool.Sample(state, state.CurPlayer());
+    }
+    bench::DoNotOptimize(pool.State(0).CurPlayer());
+  });
+}
+
+// ISMCTS from a mid-game state on one thread, with SimplePolicy rollouts,
+// one search iteration per operation, without and with a transposition
+// table.
+void BenchSearch(const std::string& suffix, hle::HanabiGame* game) {
+  hle::HanabiState state = MidGameState(game);
+  const hle::SimplePolicy policy;
+  bench::Run("Search/Simple" + suffix, [&](int64_t iterations) {
+    hle::HanabiSearchConfig config;
+    config.num_iterations = iterations;
+    config.seed = 1;
+    hle::HanabiSearch search(config, &policy);
+    bench::DoNotOptimize(search.Search(state).num_iterations);
+  });
+  bench::Run("Search/Simple/Transpositions" + suffix,
+             [&](int64_t iterations) {
+               hle::HanabiSearchConfig config;
+               config.num_iterations = iterations;
+               config.seed = 1;
+               config.transposition_table_size = 1 << 16;
+               hle::HanabiSearch search(config, &policy);
+               bench::DoNotOptimize(search.Search(state).num_iterations);
+             });
+}
+
+// Expands the chance node after a discard (or a play if no discard is
+// legal), copying the state for each outcome of ChanceOutcomes() or dealing
+// and undoing each outcome in place with ForEachChanceOutcome; and computes
+// exact depth-2 expectimax values of every move of a mid-game state.
+void BenchExpectimax(const std::string& suffix, hle::HanabiGame* game) {
+  hle::HanabiState state = MidGameState(game);
+  state.SetRecordMoveHistory(false);
+  hle::HanabiState chance_state(state);
+  const hle::HanabiMove discard =
+      game->GetMove(game->GetMoveUid(hle::HanabiMove::kDiscard, 0, -1, -1, -1));
+  chance_state.ApplyMove(
+      chance_state.MoveIsLegal(discard)
+          ? discard
+          : game->GetMove(
+                game->GetMoveUid(hle::HanabiMove::kPlay, 0, -1, -1, -1)));
+  if (chance_state.CurPlayer() != hle::kChancePlayerId) {
+    return;
+  }
+  bench::Run("ChanceNode/Copy" + suffix, [&chance_state](int64_t iterations) {
+    for (int64_t i = 0; i < iterations; ++i) {
+      const auto outcomes = chance_state.ChanceOutcomes();
+      for (const hle::HanabiMove& outcome : outcomes.first) {
+        hle::HanabiState child(chance_state);
+        child.ApplyMove(outcome);
+        bench::DoNotOptimize(child.CurPlayer());
+      }
+    }
+  });
+  bench::Run("ChanceNode/ForEach" + suffix,
+             [&chance_state](int64_t iterations) {
+               for (int64_t i = 0; i < iterations; ++i) {
+                 hle::ForEachChanceOutcome(
+                     &chance_state,
+                     [&chance_state](hle::HanabiMove outcome,
+                                     double probability) {
+                       bench::DoNotOptimize(chance_state.CurPlayer());
+                     });
+               }
+             });
+  bench::Run("Expectimax/MoveValues/Depth2" + suffix,
+             [&state](int64_t iterations) {
+               for (int64_t i = 0; i < iterations; ++i) {
+                 bench::DoNotOptimize(hle::ExpectedMoveValues(state, 2)[0]);
+               }
+             });
+}
+
+// The objects of one step of an agent loop: legal moves, the acting
+// player's observation and its encoding, and a copy of the state, as kept
+// for search or replay. Either newly allocated every step, or taken from
+// pools and reused.
+class StepLoop {
+ public:
+  StepLoop(hle::HanabiGame* game, bool pooled)
+      : game_(game),
+        pooled_(pooled),
+        encoder_(game),
+        encoding_(encoder_.Size()),
+        state_(game),
+        rng_(1) {
+    state_.SetRecordMoveHistory(false);
+    DealCards();
+  }
+
+  void Step() {
+    const int player = state_.CurPlayer();
+    if (pooled_) {
+      state_.LegalMoves(player, &legal_moves_);
+      hle::HanabiObservation* observation =
+          observation_pool_.Acquire(state_, player);
+      encoder_.EncodeInto(*observation, encoding_.data());
+      observation_pool_.Release(observation);
+      state_pool_.Release(state_pool_.Acquire(state_));
+    } else {
+      legal_moves_ = state_.LegalMoves(player);
+      encoder_.EncodeInto(hle::HanabiObservation(state_, player),
+                          encoding_.data());
+      std::unique_ptr<hle::HanabiState> copy(new hle::HanabiState(state_));
+      bench::DoNotOptimize(copy->CurPlayer());
+    }
+    bench::DoNotOptimize(encoding_[0]);
+    state_.ApplyMove(legal_moves_[rng_() % legal_moves_.size()]);
+    if (state_.IsTerminal()) {
+      if (pooled_) {
+        state_.Reset(game_->GetSampledStartPlayer(&rng_));
+      } else {
+        state_ = hle::HanabiState(game_, game_->GetSampledStartPlayer(&rng_));
+        state_.SetRecordMoveHistory(false);
+      }
+    }
+    DealCards();
+  }
+
+ private:
+  void DealCards() {
+    while (state_.CurPlayer() == hle::kChancePlayerId) {
+      state_.ApplyRandomChance(&rng_);
+    }
+  }
+
+  hle::HanabiGame* game_;
+  bool pooled_;
+  const hle::CanonicalObservationEncoder encoder_;
+  std::vector<uint8_t> encoding_;
+  hle::HanabiState state_;
+  std::vector<hle::HanabiMove> legal_moves_;
+  hle::HanabiStatePool state_pool_;
+  hle::HanabiObservationPool observation_pool_;
+  std::mt19937 rng_;
+};
+
+
+// One StepLoop step per operation. The pooled loop is also checked to make
+// no allocations over a thousand steps once warmed up.
+void BenchStepLoop(const std::string& suffix, hle::HanabiGame* game,
+                   bool pooled) {
+  const std::string name =
+      std::string("StepLoop/") + (pooled ? "Pooled" : "Allocating") + suffix;
+  bench::Run(name, [&](int64_t iterations) {
+    StepLoop loop(game, pooled);
+    for (int64_t i = 0; i < iterations; ++i) {
+      loop.Step();
+    }
+  });
+  if (pooled) {
+    StepLoop loop(game, pooled);
+    bench::ExpectNoAllocations(name, [&loop]() {
+      for (int i = 0; i < 1000; ++i) {
+        loop.Step();
+      }
+    });
+  }
+}
+
+// Steps a batch of 64 games with random legal moves, one game step per
+// operation, and checks that stepping makes no allocations.
+void BenchVectorEnvStep(const std::string& suffix, hle::HanabiGame* game) {
+  constexpr int kNumEnvs = 64;
+  hle::HanabiVectorEnv env(game, kNumEnvs);
+  std::vector<uint8_t> observations(kNumEnvs * env.ObservationLength());
+  std::vector<int> move_uids(kNumEnvs);
+  std::mt19937 rng(1);
+  hle::HanabiVectorEnvOutput output;
+  output.observations = observations.data();
+  const auto step = [&]() {
+    for (int i = 0; i < kNumEnvs; ++i) {
+      const hle::HanabiState& state = env.State(i);
+      uint64_t mask = state.LegalMoveMask(state.CurPlayer());
+      for (int skip = rng() % 4; skip > 0 && (mask & (mask - 1)) != 0;
+           --skip) {
+        mask &= mask - 1;
+      }
+      int uid = 0;
+      while (((mask >> uid) & 1) == 0) {
+        ++uid;
+      }
+      move_uids[i] = uid;
+    }
+    env.Step(move_uids.data(), output);
+  };
+  env.Reset(output);
+  bench::Run("VectorEnv/Step/64" + suffix, [&](int64_t iterations) {
+    for (int64_t i = 0; i < iterations; i += kNumEnvs) {
+      step();
+    }
+    bench::DoNotOptimize(observations[0]);
+  });
+  bench::ExpectNoAllocations("VectorEnv/Step/64" + suffix, [&]() {
+    for (int i = 0; i < 100; ++i) {
+      step();
+    }
+  });
+}
+
+// Steps through StepAsync and StepWait, without overlapping any work, for
+// the cost of handing each step to the step thread.
+void BenchVectorEnvStepAsync(const std::string& suffix,
+                             hle::HanabiGame* game) {
+  constexpr int kNumEnvs = 64;
+  hle::HanabiVectorEnv env(game, kNumEnvs);
+  std::vector<uint8_t> observations(kNumEnvs * env.ObservationLength());
+  std::vector<uint8_t> legal_moves(kNumEnvs * env.NumMoves());
+  std::vector<int> move_uids(kNumEnvs);
+  hle::HanabiVectorEnvOutput output;
+  output.observations = observations.data();
+  output.legal_moves = legal_moves.data();
+  // Plays the first legal move of each game, from the last outputs.
+  const auto step = [&]() {
+    for (int i = 0; i < kNumEnvs; ++i) {
+      const uint8_t* row = &legal_moves[i * env.NumMoves()];
+      move_uids[i] = std::find(row, row + env.NumMoves(), 1) - row;
+    }
+    env.StepAsync(move_uids.data(), output);
+    env.StepWait();
+  };
+  env.Reset(output);
+  step();
+  bench::Run("VectorEnv/StepAsync/64" + suffix, [&](int64_t iterations) {
+    for (int64_t i = 0; i < iterations; i += kNumEnvs) {
+      step();
+    }
+    bench::DoNotOptimize(observations[0]);
+  });
+  bench::ExpectNoAllocations("VectorEnv/StepAsync/64" + suffix, [&]() {
+    for (int i = 0; i < 100; ++i) {
+      step();
+    }
+  });
+}
+
+// Steps one shard of an env server through a client in the same process,
+// for the cost of the round trip through shared memory on top of the step.
+void BenchEnvServerStep(const std::string& suffix, hle::HanabiGame* game) {
+  constexpr int kNumEnvs = 64;
+  hle::HanabiEnvServerConfig config;
+  config.name = "hanabi_bench_env_server";
+  config.envs_per_shard = kNumEnvs;
+  hle::HanabiEnvServer server(game, config);
+  hle::HanabiEnvClient client;
+  REQUIRE(client.Connect(server.Name()));
+  std::vector<int> move_uids(kNumEnvs);
+  // Plays the first legal move of each game, from the last outputs.
+  const auto step = [&]() {
+    for (int i = 0; i < kNumEnvs; ++i) {
+      const uint8_t* row = client.LegalMoves() + i * client.NumMoves();
+      move_uids[i] = std::find(row, row + client.NumMoves(), 1) - row;
+    }
+    REQUIRE(client.Step(move_uids.data()) == hle::HanabiEnvClient::kOk);
+  };
+  REQUIRE(client.Reset() == hle::HanabiEnvClient::kOk);
+  step();
+  bench::Run("EnvServer/Step/64" + suffix, [&](int64_t iterations) {
+    for (int64_t i = 0; i < iterations; i += kNumEnvs) {
+      step();
+    }
+    bench::DoNotOptimize(client.Observations()[0]);
+  });
+  bench::ExpectNoAllocations("EnvServer/Step/64" + suffix, [&]() {
+    for (int i = 0; i < 100; ++i) {
+      step();
+    }
+  });
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  if (!bench::Init(argc, argv)) {
+    return 1;
+  }
+  for (const Variant& variant : Variants()) {
+    hle::HanabiGame game(variant.params);
+    const std::string suffix = "/" + variant.name;
+    BenchDeckDealCard(suffix, game);
+    BenchApplyMove(suffix, &game, /*record_move_history=*/true);
+    BenchApplyMove(suffix, &game, /*record_move_history=*/false);
+    BenchTryMoves(suffix, &game);
+    BenchApplyRandomChance(suffix, &game);
+    BenchNewGame(suffix, &game);
+    BenchChanceOutcomesPick(suffix, &game);
+    BenchCopyState(suffix, &game, /*record_move_history=*/true);
+    BenchCopyState(suffix, &game, /*record_move_history=*/false);
+    BenchLegalMoves(suffix, &game);
+    BenchLegalMoveMask(suffix, &game);
+    BenchStateHash(suffix, &game);
+    BenchTranspositionTable(suffix, &game);
+    BenchObservation(suffix, &game);
+    BenchEncode(suffix, &game);
+    BenchEncodeObservation(suffix, &game);
+    BenchEncodeState(suffix, &game);
+    BenchEncodeStates(suffix, &game);
+    BenchEncodeStatePacked(suffix, &game);
+    BenchUnpackBits(suffix, &game);
+    BenchEncodeTurns(suffix, &game, TurnEncoding::kNone);
+    BenchEncodeTurns(suffix, &game, TurnEncoding::kEncodeStateInto);
+    BenchEncodeTurns(suffix, &game, TurnEncoding::kIncremental);
+    BenchBeliefEncode(suffix, &game, /*iterations=*/0);
+    BenchBeliefEncode(suffix, &game, /*iterations=*/3);
+    BenchBeliefTurns(suffix, &game);
+    BenchRandomPlayout(suffix, &game);
+    BenchGameLog(suffix, &game);
+    BenchReplayBuffer(suffix, &game);
+    BenchEvaluatePolicy(suffix, &game, "Random", hle::RandomPolicy());
+    BenchEvaluatePolicy(suffix, &game, "Simple", hle::SimplePolicy());
+    BenchDeterminizationPool(suffix, &game);
+    BenchSearch(suffix, &game);
+    BenchExpectimax(suffix, &game);
+    BenchStepLoop(suffix, &game, /*pooled=*/false);
+    BenchStepLoop(suffix, &game, /*pooled=*/true);
+    BenchVectorEnvStep(suffix, &game);
+    BenchVectorEnvStepAsync(suffix, &game);
+    BenchEnvServerStep(suffix, &game);
+  }
+  return bench::ExitStatus();
+}
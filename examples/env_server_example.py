@@ -0,0 +1,109 @@
+# Copyright 2018 Google LLC
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#    https://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+
+"""Smoke check of pyhanabi.HanabiEnvClient against tools/hanabi_env_server.
+
+Usage:
+  python env_server_example.py [path/to/hanabi_env_server]
+
+The server binary defaults to build/tools/hanabi_env_server. It is started
+with a fresh shared memory object name, and stopped with SIGTERM at the end.
+"""
+
+from __future__ import print_function
+
+import array
+import os
+import signal
+import subprocess
+import sys
+import time
+
+from hanabi_learning_environment import pyhanabi
+
+NUM_ENVS = 4
+
+
+def connect(name, server, timeout_seconds=10.0):
+  """Returns a client of name, retrying until the server is up."""
+  deadline = time.time() + timeout_seconds
+  while True:
+    try:
+      return pyhanabi.HanabiEnvClient(name)
+    except RuntimeError:
+      if server.poll() is not None:
+        raise RuntimeError("hanabi_env_server exited with status {}.".format(
+            server.returncode))
+      if time.time() > deadline:
+        raise
+      time.sleep(0.05)
+
+
+def first_legal_moves(client):
+  """Returns an int32 array of the lowest legal uid of each game."""
+  return array.array("i", [row.index(1) for row in
+                            client.legal_moves().tolist()])
+
+
+def run_smoke_check(server_path):
+  """Resets, then steps one legal and one illegal batch."""
+  name = "hanabi_example_{}".format(os.getpid())
+  server = subprocess.Popen([
+      server_path, "--name=" + name, "--envs_per_shard={}".format(NUM_ENVS),
+      "players=2", "seed=7"
+  ])
+  client = None
+  try:
+    client = connect(name, server)
+    print("Connected to shard {} of {}: {} games, {} moves.".format(
+        client.shard(), name, client.num_envs(), client.num_moves()))
+
+    client.reset()
+    client.step(first_legal_moves(client))
+    print("Legal batch stepped, rewards: {}".format(
+        client.rewards().tolist()))
+
+    # Every game played a card, so all information tokens are left and the
+    # discards of game 0 are illegal.
+    moves = first_legal_moves(client)
+    players = client.current_players().tolist()
+    observations = client.observations().tobytes()
+    moves[0] = client.legal_moves().tolist()[0].index(0)
+    try:
+      client.step(moves)
+    except ValueError as error:
+      print("Illegal batch rejected: {}".format(error))
+    else:
+      raise AssertionError("Illegal batch was stepped.")
+    assert client.current_players().tolist() == players
+    assert client.observations().tobytes() == observations
+
+    # The shard still steps after a rejected batch.
+    client.step(first_legal_moves(client))
+    print("Smoke check passed.")
+  finally:
+    if client is not None:
+      client.close()
+    server.send_signal(signal.SIGTERM)
+    server.wait()
+
+
+if __name__ == "__main__":
+  # Check that the cdef and library were loaded from the standard paths.
+  assert pyhanabi.cdef_loaded(), "cdef failed to load"
+  assert pyhanabi.lib_loaded(), "lib failed to load"
+  if len(sys.argv) > 1:
+    run_smoke_check(sys.argv[1])
+  else:
+    run_smoke_check(os.path.join("build", "tools", "hanabi_env_server"))
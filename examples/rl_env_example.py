@@ -18,10 +18,15 @@ from __future__ import print_function
 import sys
 import getopt
 from hanabi_learning_environment import rl_env
+from hanabi_learning_environment.agents.ismcts_agent import ISMCTSAgent
 from hanabi_learning_environment.agents.random_agent import RandomAgent
 from hanabi_learning_environment.agents.simple_agent import SimpleAgent
 
-AGENT_CLASSES = {'SimpleAgent': SimpleAgent, 'RandomAgent': RandomAgent}
+AGENT_CLASSES = {
+    'SimpleAgent': SimpleAgent,
+    'RandomAgent': RandomAgent,
+    'ISMCTSAgent': ISMCTSAgent
+}
 
 
 class Runner(object):
@@ -0,0 +1,46 @@
+# Copyright 2018 Google LLC
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#    https://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+"""Information-Set Monte Carlo Tree Search Agent."""
+
+from hanabi_learning_environment import pyhanabi
+from hanabi_learning_environment.rl_env import Agent
+
+
+class ISMCTSAgent(Agent):
+  """Agent that searches natively with ISMCTS from its observation."""
+
+  def __init__(self, config, *args, **kwargs):
+    """Initialize the agent.
+
+    Besides the game parameters, config may set the search parameters
+    'search_iterations' (default 1000), 'search_time_limit' (seconds, default
+    0 for none), 'search_exploration' (default 0.5), 'search_threads'
+    (default 1), 'rollout_policy' (a pyhanabi.HanabiPolicyType, default
+    SIMPLE) and 'search_seed' (default -1 for a random seed).
+    """
+    self.config = config
+    self.search = pyhanabi.HanabiSearch(
+        rollout_policy=pyhanabi.HanabiPolicy(
+            config.get('rollout_policy', pyhanabi.HanabiPolicyType.SIMPLE)),
+        num_iterations=config.get('search_iterations', 1000),
+        time_limit=config.get('search_time_limit', 0.0),
+        exploration=config.get('search_exploration', 0.5),
+        num_threads=config.get('search_threads', 1),
+        seed=config.get('search_seed', -1))
+
+  def act(self, observation):
+    """Act based on an observation."""
+    if observation['current_player_offset'] != 0:
+      return None
+    return self.search.search(observation['pyhanabi'])['move'].to_dict()
@@ -82,7 +82,8 @@ class OutOfGraphReplayMemory(object):
   """
 
   def __init__(self, num_actions, observation_size, stack_size, replay_capacity,
-               batch_size, update_horizon=1, gamma=1.0):
+               batch_size, update_horizon=1, gamma=1.0,
+               pack_observations=False):
     """Data structure doing the heavy lifting.
 
     Args:
@@ -93,8 +94,11 @@ class OutOfGraphReplayMemory(object):
       batch_size: int, batch size.
       update_horizon: int, length of update ('n' in n-step update).
       gamma: float, the discount factor.
+      pack_observations: bool, when True observations are stored packed 8
+        bits per byte and unpacked when sampled, using 8x less memory.
     """
     self._observation_size = observation_size
+    self._pack_observations = pack_observations
     self._num_actions = num_actions
     self._replay_capacity = replay_capacity
     self._batch_size = batch_size
@@ -108,9 +112,15 @@ class OutOfGraphReplayMemory(object):
         [math.pow(self._gamma, n) for n in range(update_horizon)],
         dtype=np.float32)
 
-    # Create numpy arrays used to store sampled transitions.
+    # Create numpy arrays used to store sampled transitions. Packed rows are
+    # padded to whole 64-bit words, the layout of the packed observations of
+    # pyhanabi on little-endian hosts.
+    if pack_observations:
+      stored_size = (observation_size + 63) // 64 * 8
+    else:
+      stored_size = observation_size
     self.observations = np.empty(
-        (replay_capacity, observation_size), dtype=np.uint8)
+        (replay_capacity, stored_size), dtype=np.uint8)
     self.actions = np.empty((replay_capacity), dtype=np.int32)
     self.rewards = np.empty((replay_capacity), dtype=np.float32)
     self.terminals = np.empty((replay_capacity), dtype=np.uint8)
@@ -146,7 +156,13 @@ class OutOfGraphReplayMemory(object):
 
   def _add(self, observation, action, reward, terminal, legal_actions):
     cursor = self.cursor()
-    self.observations[cursor] = observation
+    if self._pack_observations:
+      packed = np.packbits(np.asarray(observation, dtype=np.uint8),
+                           bitorder='little')
+      self.observations[cursor, :packed.size] = packed
+      self.observations[cursor, packed.size:] = 0
+    else:
+      self.observations[cursor] = observation
     self.actions[cursor] = action
     self.rewards[cursor] = reward
     self.terminals[cursor] = terminal
@@ -194,6 +210,9 @@ class OutOfGraphReplayMemory(object):
 
   def get_observation_stack(self, index):
     state = self.get_stack(self.observations, index)
+    if self._pack_observations:
+      state = np.unpackbits(state, axis=1, count=self._observation_size,
+                            bitorder='little')
     return np.transpose(state, [1, 0])
 
   def get_terminal_stack(self, index):
@@ -457,7 +476,8 @@ class WrappedReplayMemory(object):
                batch_size=32,
                update_horizon=1,
                gamma=1.0,
-               wrapped_memory=None):
+               wrapped_memory=None,
+               pack_observations=False):
     """Initializes a graph wrapper for the python replay memory.
 
     Args:
@@ -472,6 +492,8 @@ class WrappedReplayMemory(object):
       gamma: int, the discount factor.
       wrapped_memory: The 'inner' memory data structure. Defaults to None, which
         creates the standard DQN replay memory.
+      pack_observations: bool, when True the standard replay memory stores
+        observations packed 8 bits per byte. Ignored with wrapped_memory.
 
     Raises:
       ValueError: If update_horizon is not positive.
@@ -492,7 +514,8 @@ class WrappedReplayMemory(object):
     else:
       self.memory = OutOfGraphReplayMemory(
           num_actions, observation_size, stack_size,
-          replay_capacity, batch_size, update_horizon, gamma)
+          replay_capacity, batch_size, update_horizon, gamma,
+          pack_observations)
 
     with tf.name_scope('replay'):
       with tf.name_scope('add_placeholders'):
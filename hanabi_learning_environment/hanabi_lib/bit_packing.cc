@@ -0,0 +1,212 @@
+// Copyright 2018 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "bit_packing.h"
+
+#include <algorithm>
+#include <cstring>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+namespace hanabi_learning_env {
+
+namespace {
+
+// The eight values of each byte, lowest bit first, so that unpacking a byte
+// is a single fixed-size copy.
+template <typename T>
+struct ByteTable {
+  ByteTable() {
+    for (int byte = 0; byte < 256; ++byte) {
+      for (int bit = 0; bit < 8; ++bit) {
+        values[byte][bit] = static_cast<T>((byte >> bit) & 1);
+      }
+    }
+  }
+  T values[256][8];
+};
+
+template <typename T>
+const ByteTable<T>& Table() {
+  static const ByteTable<T> table;
+  return table;
+}
+
+// Packs eight 0/1 bytes into one byte, bits[0] lowest. The bytes are loaded
+// as one word with bits[j] in byte j, and the multiplication moves bit 0 of
+// byte j to bit 56 + j without any carries.
+inline uint64_t PackByte(const uint8_t* bits) {
+  uint64_t bytes;
+  std::memcpy(&bytes, bits, sizeof(bytes));
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+  bytes = __builtin_bswap64(bytes);
+#endif
+  return (bytes * 0x0102040810204080ULL) >> 56;
+}
+
+// Writes bits [first, num_bits) one table row per byte, then one at a time.
+template <typename T>
+void ExpandTail(uint64_t bits, int first, int num_bits, T* values) {
+  const ByteTable<T>& table = Table<T>();
+  int i = first;
+  for (; i + 8 <= num_bits; i += 8) {
+    std::memcpy(values + i, table.values[(bits >> i) & 0xff],
+                sizeof(table.values[0]));
+  }
+  for (; i < num_bits; ++i) {
+    values[i] = static_cast<T>((bits >> i) & 1);
+  }
+}
+
+// ExpandBits for 4-byte values, where one is the bit pattern of the value 1.
+template <typename T>
+void ExpandBits32(uint64_t bits, int num_bits, uint32_t one, T* values) {
+  static_assert(sizeof(T) == 4, "Expected 4-byte values.");
+  int i = 0;
+#if defined(__AVX2__)
+  {
+    // Each lane tests one bit of the broadcast byte.
+    const __m256i select = _mm256_setr_epi32(1, 2, 4, 8, 16, 32, 64, 128);
+    const __m256i ones = _mm256_set1_epi32(one);
+    for (; i + 8 <= num_bits; i += 8) {
+      const __m256i byte = _mm256_set1_epi32((bits >> i) & 0xff);
+      const __m256i set =
+          _mm256_cmpeq_epi32(_mm256_and_si256(byte, select), select);
+      _mm256_storeu_si256(reinterpret_cast<__m256i*>(values + i),
+                          _mm256_and_si256(set, ones));
+    }
+  }
+#endif
+#if defined(__SSE2__)
+  {
+    const __m128i select = _mm_setr_epi32(1, 2, 4, 8);
+    const __m128i ones = _mm_set1_epi32(one);
+    for (; i + 4 <= num_bits; i += 4) {
+      const __m128i nibble = _mm_set1_epi32((bits >> i) & 0xf);
+      const __m128i set = _mm_cmpeq_epi32(_mm_and_si128(nibble, select), select);
+      _mm_storeu_si128(reinterpret_cast<__m128i*>(values + i),
+                       _mm_and_si128(set, ones));
+    }
+  }
+#endif
+  ExpandTail(bits, i, num_bits, values);
+}
+
+template <typename T>
+void UnpackWords(const uint64_t* words, int num_bits, T* values) {
+  for (int i = 0; i < num_bits; i += 64) {
+    ExpandBits(words[i / 64], std::min(64, num_bits - i), values + i);
+  }
+}
+
+template <typename T>
+void UnpackRows(const uint64_t* words, int num_rows, int num_bits,
+                T* values) {
+  const int stride = PackedLength(num_bits);
+  for (int row = 0; row < num_rows; ++row) {
+    UnpackWords(words + row * stride, num_bits, values + row * num_bits);
+  }
+}
+
+}  // namespace
+
+void PackBits(const uint8_t* bits, int num_bits, uint64_t* words) {
+  const int num_words = PackedLength(num_bits);
+  for (int w = 0; w < num_words; ++w) {
+    const int start = 64 * w;
+    uint64_t word = 0;
+    if (start + 64 <= num_bits) {
+      for (int b = 0; b < 8; ++b) {
+        word |= PackByte(bits + start + 8 * b) << (8 * b);
+      }
+    } else {
+      for (int i = start; i < num_bits; ++i) {
+        word |= static_cast<uint64_t>(bits[i] != 0) << (i - start);
+      }
+    }
+    words[w] = word;
+  }
+}
+
+void ExpandBits(uint64_t bits, int num_bits, uint8_t* values) {
+  int i = 0;
+#if defined(__AVX2__)
+  {
+    // Byte j of each 8-byte group tests bit j of the group's source byte.
+    const __m256i select = _mm256_set1_epi64x(0x8040201008040201LL);
+    const __m256i spread = _mm256_setr_epi8(
+        0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 1, 1, 1, 1,
+        2, 2, 2, 2, 2, 2, 2, 2, 3, 3, 3, 3, 3, 3, 3, 3);
+    const __m256i ones = _mm256_set1_epi8(1);
+    for (; i + 32 <= num_bits; i += 32) {
+      const __m256i bytes = _mm256_shuffle_epi8(
+          _mm256_set1_epi32(static_cast<int>(bits >> i)), spread);
+      const __m256i set =
+          _mm256_cmpeq_epi8(_mm256_and_si256(bytes, select), select);
+      _mm256_storeu_si256(reinterpret_cast<__m256i*>(values + i),
+                          _mm256_and_si256(set, ones));
+    }
+  }
+#endif
+#if defined(__SSE2__)
+  {
+    const __m128i select = _mm_set1_epi64x(0x8040201008040201LL);
+    const __m128i ones = _mm_set1_epi8(1);
+    for (; i + 16 <= num_bits; i += 16) {
+      // Repeat the two source bytes into eight bytes each.
+      __m128i bytes = _mm_cvtsi32_si128(static_cast<int>((bits >> i) & 0xffff));
+      bytes = _mm_unpacklo_epi8(bytes, bytes);
+      bytes = _mm_unpacklo_epi16(bytes, bytes);
+      bytes = _mm_unpacklo_epi32(bytes, bytes);
+      const __m128i set = _mm_cmpeq_epi8(_mm_and_si128(bytes, select), select);
+      _mm_storeu_si128(reinterpret_cast<__m128i*>(values + i),
+                       _mm_and_si128(set, ones));
+    }
+  }
+#endif
+  ExpandTail(bits, i, num_bits, values);
+}
+
+void ExpandBits(uint64_t bits, int num_bits, int32_t* values) {
+  ExpandBits32(bits, num_bits, 1, values);
+}
+
+void ExpandBits(uint64_t bits, int num_bits, float* values) {
+  ExpandBits32(bits, num_bits, 0x3f800000, values);
+}
+
+void UnpackBits(const uint64_t* words, int num_bits, uint8_t* values) {
+  UnpackWords(words, num_bits, values);
+}
+
+void UnpackBits(const uint64_t* words, int num_bits, float* values) {
+  UnpackWords(words, num_bits, values);
+}
+
+void UnpackBitRows(const uint64_t* words, int num_rows, int num_bits,
+                   uint8_t* values) {
+  UnpackRows(words, num_rows, num_bits, values);
+}
+
+void UnpackBitRows(const uint64_t* words, int num_rows, int num_bits,
+                   float* values) {
+  UnpackRows(words, num_rows, num_bits, values);
+}
+
+}  // namespace hanabi_learning_env
@@ -0,0 +1,56 @@
+// Copyright 2018 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Packing of binary encodings into 64-bit words, for compact storage and
+// transport of observations, and unpacking back to one value per bit.
+//
+// Bit i of an encoding is bit i % 64 of word i / 64, and the unused high
+// bits of the last word are zero. On little-endian hosts this is the layout
+// of numpy.packbits(bits, bitorder="little") padded to a multiple of 8 bytes.
+
+#ifndef __BIT_PACKING_H__
+#define __BIT_PACKING_H__
+
+#include <cstdint>
+
+namespace hanabi_learning_env {
+
+// Number of words holding num_bits bits.
+inline int PackedLength(int num_bits) { return (num_bits + 63) / 64; }
+
+// Writes bit i of bits as values[i] (0 or 1), for i < num_bits <= 64, and
+// nothing past values[num_bits - 1]. Uses SSE2 where available, or AVX2
+// when built with HANABI_ENABLE_AVX2, with a table-lookup fallback.
+void ExpandBits(uint64_t bits, int num_bits, uint8_t* values);
+void ExpandBits(uint64_t bits, int num_bits, int32_t* values);
+void ExpandBits(uint64_t bits, int num_bits, float* values);
+
+// Packs num_bits values, each 0 or 1, into PackedLength(num_bits) words.
+void PackBits(const uint8_t* bits, int num_bits, uint64_t* words);
+
+// Writes the num_bits bits packed in words as one value (0 or 1) each.
+void UnpackBits(const uint64_t* words, int num_bits, uint8_t* values);
+void UnpackBits(const uint64_t* words, int num_bits, float* values);
+
+// Unpacks num_rows consecutive packed encodings of num_bits bits each, as
+// stored by a batch of PackBits calls with a row stride of
+// PackedLength(num_bits) words, into a [num_rows, num_bits] array.
+void UnpackBitRows(const uint64_t* words, int num_rows, int num_bits,
+                   uint8_t* values);
+void UnpackBitRows(const uint64_t* words, int num_rows, int num_bits,
+                   float* values);
+
+}  // namespace hanabi_learning_env
+
+#endif
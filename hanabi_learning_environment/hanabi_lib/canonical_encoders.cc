@@ -19,18 +19,15 @@
 #include <vector>
 
 #include "canonical_encoders.h"
+#include "hanabi_observation_view.h"
+#include "instrumentation.h"
+#include "static_game.h"
+#include "util.h"
 
 namespace hanabi_learning_env {
 
 namespace {
 
-// Computes the product of dimensions in shape, i.e. how many individual
-// pieces of data the encoded observation requires.
-int FlatLength(const std::vector<int>& shape) {
-  return std::accumulate(std::begin(shape), std::end(shape), 1,
-                         std::multiplies<int>());
-}
-
 const HanabiHistoryItem* GetLastNonDealMove(
     const std::vector<HanabiHistoryItem>& past_moves) {
   auto it = std::find_if(
@@ -40,7 +37,47 @@ const HanabiHistoryItem* GetLastNonDealMove(
   return it == past_moves.end() ? nullptr : &(*it);
 }
 
-int BitsPerCard(const HanabiGame& game) {
+// Accessors shared by HanabiObservation and HanabiObservationView, so that
+// the section encoders below can be written once for both. Hands are
+// addressed by offset from the observing player.
+int NumCards(const HanabiObservation& obs, int offset) {
+  return obs.Hands()[offset].Cards().size();
+}
+int NumCards(const HanabiObservationView& obs, int offset) {
+  return obs.NumCards(offset);
+}
+
+HanabiCard Card(const HanabiObservation& obs, int offset, int index) {
+  return obs.Hands()[offset].Cards()[index];
+}
+HanabiCard Card(const HanabiObservationView& obs, int offset, int index) {
+  return obs.Card(offset, index);
+}
+
+const HanabiHand::CardKnowledge& Knowledge(const HanabiObservation& obs,
+                                           int offset, int index) {
+  return obs.Hands()[offset].Knowledge()[index];
+}
+const HanabiHand::CardKnowledge& Knowledge(const HanabiObservationView& obs,
+                                           int offset, int index) {
+  return obs.Knowledge(offset, index);
+}
+
+bool LastNonDealMove(const HanabiObservation& obs, HanabiHistoryItem* item) {
+  const HanabiHistoryItem* last_move = GetLastNonDealMove(obs.LastMoves());
+  if (last_move == nullptr) {
+    return false;
+  }
+  *item = *last_move;
+  return true;
+}
+bool LastNonDealMove(const HanabiObservationView& obs,
+                     HanabiHistoryItem* item) {
+  return obs.LastNonDealMove(item);
+}
+
+template <typename Game>
+int BitsPerCard(const Game& game) {
   return game.NumColors() * game.NumRanks();
 }
 
@@ -49,53 +86,55 @@ int CardIndex(int color, int rank, int num_ranks) {
   return color * num_ranks + rank;
 }
 
-int HandsSectionLength(const HanabiGame& game) {
+template <typename Game>
+int HandsSectionLength(const Game& game) {
   return (game.NumPlayers() - 1) * game.HandSize() * BitsPerCard(game) +
          game.NumPlayers();
 }
 
+// Writes the one-hot encoding of cards [first_index, NumCards(obs, player))
+// of a hand, where hand_bits points to the bits of the hand's first card.
+template <typename Game, typename Observation, typename T>
+void EncodeHandCards(const Game& game, const Observation& obs, int player,
+                     int first_index, T* hand_bits) {
+  int bits_per_card = BitsPerCard(game);
+  int num_ranks = game.NumRanks();
+  int num_cards = NumCards(obs, player);
+  for (int index = first_index; index < num_cards; ++index) {
+    const HanabiCard card = Card(obs, player, index);
+    // Only a player's own cards can be invalid/unobserved.
+    assert(card.IsValid());
+    assert(card.Color() < game.NumColors());
+    assert(card.Rank() < num_ranks);
+    hand_bits[index * bits_per_card +
+              CardIndex(card.Color(), card.Rank(), num_ranks)] = 1;
+  }
+}
+
 // Enocdes cards in all other player's hands (excluding our unknown hand),
 // and whether the hand is missing a card for all players (when deck is empty.)
 // Each card in a hand is encoded with a one-hot representation using
 // <num_colors> * <num_ranks> bits (25 bits in a standard game) per card.
 // Returns the number of entries written to the encoding.
-int EncodeHands(const HanabiGame& game, const HanabiObservation& obs,
-                int start_offset, std::vector<int>* encoding) {
+template <typename Game, typename Observation, typename T>
+int EncodeHands(const Game& game, const Observation& obs, int start_offset,
+                T* encoding) {
   int bits_per_card = BitsPerCard(game);
-  int num_ranks = game.NumRanks();
   int num_players = game.NumPlayers();
   int hand_size = game.HandSize();
 
   int offset = start_offset;
-  const std::vector<HanabiHand>& hands = obs.Hands();
-  assert(hands.size() == num_players);
   for (int player = 1; player < num_players; ++player) {
-    const std::vector<HanabiCard>& cards = hands[player].Cards();
-    int num_cards = 0;
-
-    for (const HanabiCard& card : cards) {
-      // Only a player's own cards can be invalid/unobserved.
-      assert(card.IsValid());
-      assert(card.Color() < game.NumColors());
-      assert(card.Rank() < num_ranks);
-      (*encoding)[offset + CardIndex(card.Color(), card.Rank(), num_ranks)] = 1;
-
-      ++num_cards;
-      offset += bits_per_card;
-    }
-
+    EncodeHandCards(game, obs, player, /*first_index=*/0, encoding + offset);
     // A player's hand can have fewer cards than the initial hand size.
-    // Leave the bits for the absent cards empty (adjust the offset to skip
-    // bits for the missing cards).
-    if (num_cards < hand_size) {
-      offset += (hand_size - num_cards) * bits_per_card;
-    }
+    // Leave the bits for the absent cards empty.
+    offset += hand_size * bits_per_card;
   }
 
   // For each player, set a bit if their hand is missing a card.
   for (int player = 0; player < num_players; ++player) {
-    if (hands[player].Cards().size() < game.HandSize()) {
-      (*encoding)[offset + player] = 1;
+    if (NumCards(obs, player) < game.HandSize()) {
+      encoding[offset + player] = 1;
     }
   }
   offset += num_players;
@@ -104,7 +143,8 @@ int EncodeHands(const HanabiGame& game, const HanabiObservation& obs,
   return offset - start_offset;
 }
 
-int BoardSectionLength(const HanabiGame& game) {
+template <typename Game>
+int BoardSectionLength(const Game& game) {
   return game.MaxDeckSize() - game.NumPlayers() * game.HandSize() +  // deck
          game.NumColors() * game.NumRanks() +  // fireworks
          game.MaxInformationTokens() +         // info tokens
@@ -120,8 +160,9 @@ int BoardSectionLength(const HanabiGame& game) {
 // We note several features use a thermometer representation instead of one-hot.
 // For example, life tokens could be: 000 (0), 100 (1), 110 (2), 111 (3).
 // Returns the number of entries written to the encoding.
-int EncodeBoard(const HanabiGame& game, const HanabiObservation& obs,
-                int start_offset, std::vector<int>* encoding) {
+template <typename Game, typename Observation, typename T>
+int EncodeBoard(const Game& game, const Observation& obs, int start_offset,
+                T* encoding) {
   int num_colors = game.NumColors();
   int num_ranks = game.NumRanks();
   int num_players = game.NumPlayers();
@@ -131,17 +172,17 @@ int EncodeBoard(const HanabiGame& game, const HanabiObservation& obs,
   int offset = start_offset;
   // Encode the deck size
   for (int i = 0; i < obs.DeckSize(); ++i) {
-    (*encoding)[offset + i] = 1;
+    encoding[offset + i] = 1;
   }
   offset += (max_deck_size - hand_size * num_players);  // 40 in normal 2P game
 
   // fireworks
-  const std::vector<int>& fireworks = obs.Fireworks();
+  const auto& fireworks = obs.Fireworks();
   for (int c = 0; c < num_colors; ++c) {
     // fireworks[color] is the number of successfully played <color> cards.
     // If some were played, one-hot encode the highest (0-indexed) rank played
     if (fireworks[c] > 0) {
-      (*encoding)[offset + fireworks[c] - 1] = 1;
+      encoding[offset + fireworks[c] - 1] = 1;
     }
     offset += num_ranks;
   }
@@ -150,7 +191,7 @@ int EncodeBoard(const HanabiGame& game, const HanabiObservation& obs,
   assert(obs.InformationTokens() >= 0);
   assert(obs.InformationTokens() <= game.MaxInformationTokens());
   for (int i = 0; i < obs.InformationTokens(); ++i) {
-    (*encoding)[offset + i] = 1;
+    encoding[offset + i] = 1;
   }
   offset += game.MaxInformationTokens();
 
@@ -158,7 +199,7 @@ int EncodeBoard(const HanabiGame& game, const HanabiObservation& obs,
   assert(obs.LifeTokens() >= 0);
   assert(obs.LifeTokens() <= game.MaxLifeTokens());
   for (int i = 0; i < obs.LifeTokens(); ++i) {
-    (*encoding)[offset + i] = 1;
+    encoding[offset + i] = 1;
   }
   offset += game.MaxLifeTokens();
 
@@ -166,7 +207,8 @@ int EncodeBoard(const HanabiGame& game, const HanabiObservation& obs,
   return offset - start_offset;
 }
 
-int DiscardSectionLength(const HanabiGame& game) { return game.MaxDeckSize(); }
+template <typename Game>
+int DiscardSectionLength(const Game& game) { return game.MaxDeckSize(); }
 
 // Encode the discard pile. (max_deck_size bits)
 // Encoding is in color-major ordering, as in kColorStr ("RYGWB"), with each
@@ -185,32 +227,36 @@ int DiscardSectionLength(const HanabiGame& game) { return game.MaxDeckSize(); }
 //   - one of the second highest rank have been discarded
 //   - the highest rank card has been discarded
 // Returns the number of entries written to the encoding.
-int EncodeDiscards(const HanabiGame& game, const HanabiObservation& obs,
-                   int start_offset, std::vector<int>* encoding) {
+// The section is built as a 64-bit word, one bit per entry, and expanded
+// into the encoding with ExpandBits.
+template <typename Game, typename Observation, typename T>
+int EncodeDiscards(const Game& game, const Observation& obs, int start_offset,
+                   T* encoding) {
+  static_assert(kMaxDeckSize <= 64, "Discards must fit in 64 bits.");
   int num_colors = game.NumColors();
   int num_ranks = game.NumRanks();
 
-  int offset = start_offset;
-  std::vector<int> discard_counts(num_colors * num_ranks, 0);
-  for (const HanabiCard& card : obs.DiscardPile()) {
-    ++discard_counts[card.Color() * num_ranks + card.Rank()];
-  }
-
+  // Next unset bit of each card's thermometer.
+  int next_bit[kMaxNumColors * kMaxNumRanks];
+  int length = 0;
   for (int c = 0; c < num_colors; ++c) {
     for (int r = 0; r < num_ranks; ++r) {
-      int num_discarded = discard_counts[c * num_ranks + r];
-      for (int i = 0; i < num_discarded; ++i) {
-        (*encoding)[offset + i] = 1;
-      }
-      offset += game.NumberCardInstances(c, r);
+      next_bit[c * num_ranks + r] = length;
+      length += game.NumberCardInstances(c, r);
     }
   }
+  uint64_t bits = 0;
+  for (const HanabiCard& card : obs.DiscardPile()) {
+    bits |= uint64_t{1} << next_bit[card.Color() * num_ranks + card.Rank()]++;
+  }
+  ExpandBits(bits, length, encoding + start_offset);
 
-  assert(offset - start_offset == DiscardSectionLength(game));
-  return offset - start_offset;
+  assert(length == DiscardSectionLength(game));
+  return length;
 }
 
-int LastActionSectionLength(const HanabiGame& game) {
+template <typename Game>
+int LastActionSectionLength(const Game& game) {
   return game.NumPlayers() +  // player id
          4 +                  // move types (play, dis, rev col, rev rank)
          game.NumPlayers() +  // target player id (if hint action)
@@ -233,39 +279,40 @@ int LastActionSectionLength(const HanabiGame& game) {
 //  - Position played/discarded (<hand_size> bits; one-hot)
 //  - Card played/discarded (<num_colors> * <num_ranks> bits; one-hot)
 // Returns the number of entries written to the encoding.
-int EncodeLastAction(const HanabiGame& game, const HanabiObservation& obs,
-                     int start_offset, std::vector<int>* encoding) {
+template <typename Game, typename Observation, typename T>
+int EncodeLastAction(const Game& game, const Observation& obs, int start_offset,
+                     T* encoding) {
   int num_colors = game.NumColors();
   int num_ranks = game.NumRanks();
   int num_players = game.NumPlayers();
   int hand_size = game.HandSize();
 
   int offset = start_offset;
-  const HanabiHistoryItem* last_move = GetLastNonDealMove(obs.LastMoves());
-  if (last_move == nullptr) {
+  HanabiHistoryItem last_move(HanabiMove(HanabiMove::kInvalid, -1, -1, -1, -1));
+  if (!LastNonDealMove(obs, &last_move)) {
     offset += LastActionSectionLength(game);
   } else {
-    HanabiMove::Type last_move_type = last_move->move.MoveType();
+    HanabiMove::Type last_move_type = last_move.move.MoveType();
 
     // player_id
     // Note: no assertion here. At a terminal state, the last player could have
     // been me (player id 0).
-    (*encoding)[offset + last_move->player] = 1;
+    encoding[offset + last_move.player] = 1;
     offset += num_players;
 
     // move type
     switch (last_move_type) {
       case HanabiMove::Type::kPlay:
-        (*encoding)[offset] = 1;
+        encoding[offset] = 1;
         break;
       case HanabiMove::Type::kDiscard:
-        (*encoding)[offset + 1] = 1;
+        encoding[offset + 1] = 1;
         break;
       case HanabiMove::Type::kRevealColor:
-        (*encoding)[offset + 2] = 1;
+        encoding[offset + 2] = 1;
         break;
       case HanabiMove::Type::kRevealRank:
-        (*encoding)[offset + 3] = 1;
+        encoding[offset + 3] = 1;
         break;
       default:
         std::abort();
@@ -276,20 +323,20 @@ int EncodeLastAction(const HanabiGame& game, const HanabiObservation& obs,
     if (last_move_type == HanabiMove::Type::kRevealColor ||
         last_move_type == HanabiMove::Type::kRevealRank) {
       int8_t observer_relative_target =
-          (last_move->player + last_move->move.TargetOffset()) % num_players;
-      (*encoding)[offset + observer_relative_target] = 1;
+          (last_move.player + last_move.move.TargetOffset()) % num_players;
+      encoding[offset + observer_relative_target] = 1;
     }
     offset += num_players;
 
     // color (if hint action)
     if (last_move_type == HanabiMove::Type::kRevealColor) {
-      (*encoding)[offset + last_move->move.Color()] = 1;
+      encoding[offset + last_move.move.Color()] = 1;
     }
     offset += num_colors;
 
     // rank (if hint action)
     if (last_move_type == HanabiMove::Type::kRevealRank) {
-      (*encoding)[offset + last_move->move.Rank()] = 1;
+      encoding[offset + last_move.move.Rank()] = 1;
     }
     offset += num_ranks;
 
@@ -297,8 +344,8 @@ int EncodeLastAction(const HanabiGame& game, const HanabiObservation& obs,
     if (last_move_type == HanabiMove::Type::kRevealColor ||
         last_move_type == HanabiMove::Type::kRevealRank) {
       for (int i = 0, mask = 1; i < hand_size; ++i, mask <<= 1) {
-        if ((last_move->reveal_bitmask & mask) > 0) {
-          (*encoding)[offset + i] = 1;
+        if ((last_move.reveal_bitmask & mask) > 0) {
+          encoding[offset + i] = 1;
         }
       }
     }
@@ -307,27 +354,27 @@ int EncodeLastAction(const HanabiGame& game, const HanabiObservation& obs,
     // position (if play or discard action)
     if (last_move_type == HanabiMove::Type::kPlay ||
         last_move_type == HanabiMove::Type::kDiscard) {
-      (*encoding)[offset + last_move->move.CardIndex()] = 1;
+      encoding[offset + last_move.move.CardIndex()] = 1;
     }
     offset += hand_size;
 
     // card (if play or discard action)
     if (last_move_type == HanabiMove::Type::kPlay ||
         last_move_type == HanabiMove::Type::kDiscard) {
-      assert(last_move->color >= 0);
-      assert(last_move->rank >= 0);
-      (*encoding)[offset +
-                  CardIndex(last_move->color, last_move->rank, num_ranks)] = 1;
+      assert(last_move.color >= 0);
+      assert(last_move.rank >= 0);
+      encoding[offset +
+               CardIndex(last_move.color, last_move.rank, num_ranks)] = 1;
     }
     offset += BitsPerCard(game);
 
     // was successful and/or added information token (if play action)
     if (last_move_type == HanabiMove::Type::kPlay) {
-      if (last_move->scored) {
-        (*encoding)[offset] = 1;
+      if (last_move.scored) {
+        encoding[offset] = 1;
       }
-      if (last_move->information_token) {
-        (*encoding)[offset + 1] = 1;
+      if (last_move.information_token) {
+        encoding[offset + 1] = 1;
       }
     }
     offset += 2;
@@ -337,9 +384,83 @@ int EncodeLastAction(const HanabiGame& game, const HanabiObservation& obs,
   return offset - start_offset;
 }
 
-int CardKnowledgeSectionLength(const HanabiGame& game) {
-  return game.NumPlayers() * game.HandSize() *
-         (BitsPerCard(game) + game.NumColors() + game.NumRanks());
+template <typename Game>
+int KnowledgeBitsPerCard(const Game& game) {
+  return BitsPerCard(game) + game.NumColors() + game.NumRanks();
+}
+
+template <typename Game>
+int CardKnowledgeSectionLength(const Game& game) {
+  return game.NumPlayers() * game.HandSize() * KnowledgeBitsPerCard(game);
+}
+
+// For each number of ranks and color mask, the bits starting the rows of the
+// plausible colors in a color-major color x rank matrix.
+struct ColorRowTable {
+  ColorRowTable() {
+    for (int num_ranks = 0; num_ranks <= kMaxNumRanks; ++num_ranks) {
+      for (int mask = 0; mask < (1 << kMaxNumColors); ++mask) {
+        uint32_t rows = 0;
+        for (int color = 0; color < kMaxNumColors; ++color) {
+          if ((mask >> color) & 1) {
+            rows |= uint32_t{1} << (color * num_ranks);
+          }
+        }
+        row_starts[num_ranks][mask] = rows;
+      }
+    }
+  }
+  uint32_t row_starts[kMaxNumRanks + 1][1 << kMaxNumColors];
+};
+
+uint32_t ColorRowStarts(int num_ranks, unsigned color_mask) {
+  static const ColorRowTable table;
+  return table.row_starts[num_ranks][color_mask];
+}
+
+// Writes all KnowledgeBitsPerCard(game) entries of one card's knowledge,
+// including the zeros. The bits are built as one 64-bit word and expanded
+// into the encoding with ExpandBits.
+template <typename Game, typename T>
+void EncodeKnowledge(const Game& game,
+                     const HanabiHand::CardKnowledge& card_knowledge,
+                     T* encoding) {
+  static_assert(kMaxNumColors * kMaxNumRanks + kMaxNumColors + kMaxNumRanks <=
+                    64,
+                "Card knowledge must fit in 64 bits.");
+  int num_colors = game.NumColors();
+  int num_ranks = game.NumRanks();
+
+  // Add bits for plausible card. The plausible cards are the product of
+  // the plausible colors and ranks: the rank mask copied to the row of each
+  // plausible color. Rows do not overlap, so the multiply has no carries.
+  uint64_t bits =
+      static_cast<uint64_t>(card_knowledge.RankPlausibleMask()) *
+      ColorRowStarts(num_ranks, card_knowledge.ColorPlausibleMask());
+  int offset = BitsPerCard(game);
+
+  // Add bits for explicitly revealed colors and ranks.
+  if (card_knowledge.ColorHinted()) {
+    bits |= uint64_t{1} << (offset + card_knowledge.Color());
+  }
+  offset += num_colors;
+  if (card_knowledge.RankHinted()) {
+    bits |= uint64_t{1} << (offset + card_knowledge.Rank());
+  }
+  ExpandBits(bits, KnowledgeBitsPerCard(game), encoding);
+}
+
+// Writes the knowledge of cards [first_index, NumCards(obs, player)) of a
+// hand, where hand_bits points to the knowledge bits of the hand's first card.
+template <typename Game, typename Observation, typename T>
+void EncodeHandKnowledge(const Game& game, const Observation& obs, int player,
+                         int first_index, T* hand_bits) {
+  int bits_per_card = KnowledgeBitsPerCard(game);
+  int num_cards = NumCards(obs, player);
+  for (int index = first_index; index < num_cards; ++index) {
+    EncodeKnowledge(game, Knowledge(obs, player, index),
+                    hand_bits + index * bits_per_card);
+  }
 }
 
 // Encode the common card knowledge.
@@ -363,91 +484,474 @@ int CardKnowledgeSectionLength(const HanabiGame& game) {
 // Uses <num_players> * <hand_size> *
 // (<num_colors> * <num_ranks> + <num_colors> + <num_ranks>) bits.
 // Returns the number of entries written to the encoding.
-int EncodeCardKnowledge(const HanabiGame& game, const HanabiObservation& obs,
-                        int start_offset, std::vector<int>* encoding) {
-  int bits_per_card = BitsPerCard(game);
-  int num_colors = game.NumColors();
-  int num_ranks = game.NumRanks();
+template <typename Game, typename Observation, typename T>
+int EncodeCardKnowledge(const Game& game, const Observation& obs,
+                        int start_offset, T* encoding) {
   int num_players = game.NumPlayers();
   int hand_size = game.HandSize();
 
   int offset = start_offset;
-  const std::vector<HanabiHand>& hands = obs.Hands();
-  assert(hands.size() == num_players);
   for (int player = 0; player < num_players; ++player) {
-    const std::vector<HanabiHand::CardKnowledge>& knowledge =
-        hands[player].Knowledge();
-    int num_cards = 0;
-
-    for (const HanabiHand::CardKnowledge& card_knowledge : knowledge) {
-      // Add bits for plausible card.
-      for (int color = 0; color < num_colors; ++color) {
-        if (card_knowledge.ColorPlausible(color)) {
-          for (int rank = 0; rank < num_ranks; ++rank) {
-            if (card_knowledge.RankPlausible(rank)) {
-              (*encoding)[offset + CardIndex(color, rank, num_ranks)] = 1;
-            }
-          }
-        }
-      }
-      offset += bits_per_card;
-
-      // Add bits for explicitly revealed colors and ranks.
-      if (card_knowledge.ColorHinted()) {
-        (*encoding)[offset + card_knowledge.Color()] = 1;
-      }
-      offset += num_colors;
-      if (card_knowledge.RankHinted()) {
-        (*encoding)[offset + card_knowledge.Rank()] = 1;
-      }
-      offset += num_ranks;
-
-      ++num_cards;
-    }
-
+    EncodeHandKnowledge(game, obs, player, /*first_index=*/0,
+                        encoding + offset);
     // A player's hand can have fewer cards than the initial hand size.
-    // Leave the bits for the absent cards empty (adjust the offset to skip
-    // bits for the missing cards).
-    if (num_cards < hand_size) {
-      offset +=
-          (hand_size - num_cards) * (bits_per_card + num_colors + num_ranks);
-    }
+    // Leave the bits for the absent cards empty.
+    offset += hand_size * KnowledgeBitsPerCard(game);
   }
 
   assert(offset - start_offset == CardKnowledgeSectionLength(game));
   return offset - start_offset;
 }
 
+template <typename Game>
+int EncodingLength(const Game& game) {
+  return HandsSectionLength(game) + BoardSectionLength(game) +
+         DiscardSectionLength(game) + LastActionSectionLength(game) +
+         (game.ObservationType() == HanabiGame::kMinimal
+              ? 0
+              : CardKnowledgeSectionLength(game));
+}
+
+// Writes the full encoding into a zeroed buffer of EncodingLength(game)
+// elements.
+template <typename Game, typename Observation, typename T>
+void EncodeSections(const Game& game, const Observation& obs, T* encoding) {
+  // This offset is an index to the start of each section of the bit vector.
+  // It is incremented at the end of each section.
+  int offset = 0;
+  offset += EncodeHands(game, obs, offset, encoding);
+  offset += EncodeBoard(game, obs, offset, encoding);
+  offset += EncodeDiscards(game, obs, offset, encoding);
+  offset += EncodeLastAction(game, obs, offset, encoding);
+  if (game.ObservationType() != HanabiGame::kMinimal) {
+    offset += EncodeCardKnowledge(game, obs, offset, encoding);
+  }
+
+  assert(offset == EncodingLength(game));
+}
+
+template <typename Game, typename T>
+void EncodeBatch(const Game& game, const HanabiState* const* states,
+                 const int* players, int num_states, T* buffer) {
+  const int length = EncodingLength(game);
+  std::fill_n(buffer, num_states * length, 0);
+  for (int i = 0; i < num_states; ++i) {
+    EncodeSections(game, HanabiObservationView(*states[i], players[i]),
+                   buffer + i * length);
+  }
+}
+
+// Dispatchers running EncodeSections and EncodeBatch on the StaticGame view
+// of the game when it has one, so that the section loops are specialized for
+// the common variants.
+template <typename Observation, typename T>
+struct SectionsEncoder {
+  template <typename Game>
+  void operator()(const Game& game) const {
+    EncodeSections(game, obs, encoding);
+  }
+  const Observation& obs;
+  T* encoding;
+};
+
+template <typename Observation, typename T>
+void DispatchEncodeSections(const HanabiGame& game, const Observation& obs,
+                            T* encoding) {
+  HANABI_INSTRUMENT(kCounterEncode);
+  DispatchStaticGame(game, SectionsEncoder<Observation, T>{obs, encoding});
+}
+
+template <typename T>
+struct BatchEncoder {
+  template <typename Game>
+  void operator()(const Game& game) const {
+    EncodeBatch(game, states, players, num_states, buffer);
+  }
+  const HanabiState* const* states;
+  const int* players;
+  int num_states;
+  T* buffer;
+};
+
+template <typename T>
+void DispatchEncodeBatch(const HanabiGame& game,
+                         const HanabiState* const* states, const int* players,
+                         int num_states, T* buffer) {
+  HANABI_INSTRUMENT_N(kCounterEncode, num_states);
+  DispatchStaticGame(game,
+                     BatchEncoder<T>{states, players, num_states, buffer});
+}
+
+bool SameKnowledge(const HanabiHand::CardKnowledge& a,
+                   const HanabiHand::CardKnowledge& b) {
+  return a.ColorPlausibleMask() == b.ColorPlausibleMask() &&
+         a.RankPlausibleMask() == b.RankPlausibleMask() &&
+         a.Color() == b.Color() && a.Rank() == b.Rank();
+}
+
+// Changes a thermometer encoding old_value into one encoding new_value.
+void UpdateThermometer(int old_value, int new_value, uint8_t* bits) {
+  if (new_value > old_value) {
+    std::fill(bits + old_value, bits + new_value, 1);
+  } else {
+    std::fill(bits + new_value, bits + old_value, 0);
+  }
+}
+
+bool SameHistoryItem(const HanabiHistoryItem& a, const HanabiHistoryItem& b) {
+  return a.move == b.move && a.player == b.player && a.scored == b.scored &&
+         a.color == b.color && a.rank == b.rank &&
+         a.reveal_bitmask == b.reveal_bitmask &&
+         a.deal_to_player == b.deal_to_player;
+}
+
+// Per-thread buffer for encodings that are packed once encoded.
+uint8_t* PackingBuffer(int size) {
+  thread_local std::vector<uint8_t> buffer;
+  if (static_cast<int>(buffer.size()) < size) {
+    buffer.resize(size);
+  }
+  return buffer.data();
+}
+
 }  // namespace
 
 std::vector<int> CanonicalObservationEncoder::Shape() const {
-  return {HandsSectionLength(*parent_game_) +
-          BoardSectionLength(*parent_game_) +
-          DiscardSectionLength(*parent_game_) +
-          LastActionSectionLength(*parent_game_) +
-          (parent_game_->ObservationType() == HanabiGame::kMinimal
-               ? 0
-               : CardKnowledgeSectionLength(*parent_game_))};
+  return {EncodingLength(*parent_game_)};
+}
+
+int CanonicalObservationEncoder::Size() const {
+  return EncodingLength(*parent_game_);
 }
 
 std::vector<int> CanonicalObservationEncoder::Encode(
     const HanabiObservation& obs) const {
   // Make an empty bit string of the proper size.
-  std::vector<int> encoding(FlatLength(Shape()), 0);
+  std::vector<int> encoding(EncodingLength(*parent_game_), 0);
+  DispatchEncodeSections(*parent_game_, obs, encoding.data());
+  return encoding;
+}
 
-  // This offset is an index to the start of each section of the bit vector.
-  // It is incremented at the end of each section.
-  int offset = 0;
-  offset += EncodeHands(*parent_game_, obs, offset, &encoding);
-  offset += EncodeBoard(*parent_game_, obs, offset, &encoding);
-  offset += EncodeDiscards(*parent_game_, obs, offset, &encoding);
-  offset += EncodeLastAction(*parent_game_, obs, offset, &encoding);
-  if (parent_game_->ObservationType() != HanabiGame::kMinimal) {
-    offset += EncodeCardKnowledge(*parent_game_, obs, offset, &encoding);
+void CanonicalObservationEncoder::EncodeInto(const HanabiObservation& obs,
+                                             uint8_t* buffer) const {
+  std::fill_n(buffer, EncodingLength(*parent_game_), 0);
+  DispatchEncodeSections(*parent_game_, obs, buffer);
+}
+
+void CanonicalObservationEncoder::EncodeInto(const HanabiObservation& obs,
+                                             float* buffer) const {
+  std::fill_n(buffer, EncodingLength(*parent_game_), 0.0f);
+  DispatchEncodeSections(*parent_game_, obs, buffer);
+}
+
+void CanonicalObservationEncoder::EncodeInto(const HanabiObservationView& obs,
+                                             uint8_t* buffer) const {
+  std::fill_n(buffer, EncodingLength(*parent_game_), 0);
+  DispatchEncodeSections(*parent_game_, obs, buffer);
+}
+
+void CanonicalObservationEncoder::EncodeInto(const HanabiObservationView& obs,
+                                             float* buffer) const {
+  std::fill_n(buffer, EncodingLength(*parent_game_), 0.0f);
+  DispatchEncodeSections(*parent_game_, obs, buffer);
+}
+
+void CanonicalObservationEncoder::EncodeStateInto(const HanabiState& state,
+                                                  int player,
+                                                  uint8_t* buffer) const {
+  EncodeInto(HanabiObservationView(state, player), buffer);
+}
+
+void CanonicalObservationEncoder::EncodeStateInto(const HanabiState& state,
+                                                  int player,
+                                                  float* buffer) const {
+  EncodeInto(HanabiObservationView(state, player), buffer);
+}
+
+void CanonicalObservationEncoder::EncodeStatesInto(
+    const HanabiState* const* states, const int* players, int num_states,
+    uint8_t* buffer) const {
+  DispatchEncodeBatch(*parent_game_, states, players, num_states, buffer);
+}
+
+void CanonicalObservationEncoder::EncodeStatesInto(
+    const HanabiState* const* states, const int* players, int num_states,
+    float* buffer) const {
+  DispatchEncodeBatch(*parent_game_, states, players, num_states, buffer);
+}
+
+void CanonicalObservationEncoder::EncodePackedInto(const HanabiObservation& obs,
+                                                   uint64_t* buffer) const {
+  const int size = EncodingLength(*parent_game_);
+  uint8_t* bits = PackingBuffer(size);
+  EncodeInto(obs, bits);
+  PackBits(bits, size, buffer);
+}
+
+void CanonicalObservationEncoder::EncodeStatePackedInto(
+    const HanabiState& state, int player, uint64_t* buffer) const {
+  const int size = EncodingLength(*parent_game_);
+  uint8_t* bits = PackingBuffer(size);
+  EncodeStateInto(state, player, bits);
+  PackBits(bits, size, buffer);
+}
+
+IncrementalCanonicalEncoder::IncrementalCanonicalEncoder(
+    const HanabiGame* parent_game, int observer)
+    : parent_game_(parent_game),
+      observer_(observer),
+      initial_knowledge_(parent_game->NumColors(), parent_game->NumRanks()),
+      last_move_(HanabiMove(HanabiMove::kInvalid, /*card_index=*/-1,
+                            /*target_offset=*/-1, /*color=*/-1, /*rank=*/-1)) {
+  REQUIRE(observer >= 0 && observer < parent_game->NumPlayers());
+  const HanabiGame& game = *parent_game_;
+  encode_knowledge_ = game.ObservationType() != HanabiGame::kMinimal;
+  board_start_ = HandsSectionLength(game);
+  discards_start_ = board_start_ + BoardSectionLength(game);
+  last_action_start_ = discards_start_ + DiscardSectionLength(game);
+  knowledge_start_ = last_action_start_ + LastActionSectionLength(game);
+  encoding_.resize(EncodingLength(game), 0);
+  int start = discards_start_;
+  for (int color = 0; color < game.NumColors(); ++color) {
+    for (int rank = 0; rank < game.NumRanks(); ++rank) {
+      discard_start_[CardIndex(color, rank, game.NumRanks())] = start;
+      start += game.NumberCardInstances(color, rank);
+    }
   }
+}
 
-  assert(offset == encoding.size());
-  return encoding;
+void IncrementalCanonicalEncoder::Reset(const HanabiState& state) {
+  REQUIRE(state.ParentGame() == parent_game_);
+  const HanabiGame& game = *parent_game_;
+  const HanabiObservationView obs(state, observer_);
+  std::fill(encoding_.begin(), encoding_.end(), 0);
+  DispatchEncodeSections(game, obs, encoding_.data());
+
+  valid_ = true;
+  move_count_ = state.MoveCount();
+  if (state.NumRecentMoves() > 0) {
+    last_move_ = state.RecentMove(0);
+  }
+  for (int offset = 0; offset < game.NumPlayers(); ++offset) {
+    cards_[offset].clear();
+    knowledge_[offset].clear();
+    for (int index = 0; index < obs.NumCards(offset); ++index) {
+      cards_[offset].push_back(obs.Card(offset, index));
+      knowledge_[offset].push_back(obs.Knowledge(offset, index));
+    }
+  }
+  deck_size_ = obs.DeckSize();
+  information_tokens_ = obs.InformationTokens();
+  life_tokens_ = obs.LifeTokens();
+  std::copy(obs.Fireworks().begin(), obs.Fireworks().end(), fireworks_);
+  std::fill_n(discard_count_, BitsPerCard(game), 0);
+  for (const HanabiCard& card : obs.DiscardPile()) {
+    ++discard_count_[CardIndex(card.Color(), card.Rank(), game.NumRanks())];
+  }
+}
+
+void IncrementalCanonicalEncoder::Update(const HanabiState& state) {
+  REQUIRE(state.ParentGame() == parent_game_);
+  // Counts once even when falling back to Reset.
+  HANABI_INSTRUMENT(kCounterEncode);
+  const int num_new_moves = state.MoveCount() - move_count_;
+  // As a sanity check, the move encoded last should be the recent move just
+  // before the new ones. It is unavailable when the new moves fill the
+  // state's recent moves (e.g. between two turns of a player in a 5 player
+  // game), or when the previous state had no moves at all.
+  const bool can_check =
+      move_count_ > 0 && num_new_moves < state.NumRecentMoves();
+  if (!valid_ || num_new_moves < 0 ||
+      num_new_moves > state.NumRecentMoves() ||
+      (move_count_ > 0 && num_new_moves == state.NumRecentMoves() &&
+       state.NumRecentMoves() < HanabiState::kRecentMoveCapacity) ||
+      (can_check &&
+       !SameHistoryItem(state.RecentMove(num_new_moves), last_move_))) {
+    Reset(state);
+    return;
+  }
+  if (num_new_moves == 0) {
+    return;
+  }
+
+  const HanabiGame& game = *parent_game_;
+  const int num_players = game.NumPlayers();
+  const HanabiObservationView obs(state, observer_);
+  bool player_moved = false;
+  // Bit per observer-relative hand whose cards or knowledge may differ from
+  // the encoded ones once all moves are applied.
+  unsigned changed_hands = 0;
+  for (int age = num_new_moves - 1; age >= 0; --age) {
+    const HanabiHistoryItem& item = state.RecentMove(age);
+    const int offset = (item.player - observer_ + num_players) % num_players;
+    switch (item.move.MoveType()) {
+      case HanabiMove::kDeal: {
+        const int deal_offset =
+            (item.deal_to_player - observer_ + num_players) % num_players;
+        AddCard(deal_offset);
+        changed_hands |= 1u << deal_offset;
+        break;
+      }
+      case HanabiMove::kPlay:
+      case HanabiMove::kDiscard:
+        player_moved = true;
+        RemoveCard(offset, item.move.CardIndex());
+        // Failed plays are discarded too.
+        if (!item.scored) {
+          AddDiscard(item.color, item.rank);
+        }
+        break;
+      case HanabiMove::kRevealColor:
+      case HanabiMove::kRevealRank:
+        player_moved = true;
+        changed_hands |= 1u << ((offset + item.move.TargetOffset()) %
+                                num_players);
+        break;
+      default:
+        std::abort();
+    }
+  }
+
+  for (int offset = 0; offset < num_players; ++offset) {
+    if ((changed_hands >> offset) & 1) {
+      UpdateHand(obs, offset);
+    }
+  }
+  UpdateBoard(obs);
+  if (player_moved) {
+    std::fill_n(encoding_.begin() + last_action_start_,
+                LastActionSectionLength(game), 0);
+    EncodeLastAction(game, obs, last_action_start_, encoding_.data());
+  }
+  move_count_ = state.MoveCount();
+  last_move_ = state.RecentMove(0);
+}
+
+uint8_t* IncrementalCanonicalEncoder::HandBits(int offset) {
+  // The observer's own cards are not part of the hands section.
+  assert(offset > 0);
+  return encoding_.data() +
+         (offset - 1) * parent_game_->HandSize() * BitsPerCard(*parent_game_);
+}
+
+uint8_t* IncrementalCanonicalEncoder::KnowledgeBits(int offset) {
+  assert(encode_knowledge_);
+  return encoding_.data() + knowledge_start_ +
+         offset * parent_game_->HandSize() *
+             KnowledgeBitsPerCard(*parent_game_);
+}
+
+void IncrementalCanonicalEncoder::RemoveCard(int offset, int index) {
+  const HanabiGame& game = *parent_game_;
+  const int hand_size = game.HandSize();
+  const int num_cards = cards_[offset].size();
+  REQUIRE(index >= 0 && index < num_cards);
+  // Move the bits of the newer cards down by one card.
+  if (offset > 0) {
+    const int bits_per_card = BitsPerCard(game);
+    uint8_t* hand_bits = HandBits(offset);
+    std::copy(hand_bits + (index + 1) * bits_per_card,
+              hand_bits + num_cards * bits_per_card,
+              hand_bits + index * bits_per_card);
+    std::fill_n(hand_bits + (num_cards - 1) * bits_per_card, bits_per_card, 0);
+  }
+  if (encode_knowledge_) {
+    const int bits_per_card = KnowledgeBitsPerCard(game);
+    uint8_t* hand_bits = KnowledgeBits(offset);
+    std::copy(hand_bits + (index + 1) * bits_per_card,
+              hand_bits + num_cards * bits_per_card,
+              hand_bits + index * bits_per_card);
+    std::fill_n(hand_bits + (num_cards - 1) * bits_per_card, bits_per_card, 0);
+  }
+  cards_[offset].erase(cards_[offset].begin() + index);
+  knowledge_[offset].erase(knowledge_[offset].begin() + index);
+  // Missing card bit, after the cards of the hands section.
+  encoding_[(game.NumPlayers() - 1) * hand_size * BitsPerCard(game) + offset] =
+      num_cards - 1 < hand_size;
+}
+
+void IncrementalCanonicalEncoder::AddCard(int offset) {
+  const HanabiGame& game = *parent_game_;
+  const int hand_size = game.HandSize();
+  const int index = cards_[offset].size();
+  REQUIRE(index < hand_size);
+  cards_[offset].push_back(HanabiCard());
+  knowledge_[offset].push_back(initial_knowledge_);
+  if (encode_knowledge_) {
+    EncodeKnowledge(
+        game, initial_knowledge_,
+        KnowledgeBits(offset) + index * KnowledgeBitsPerCard(game));
+  }
+  encoding_[(game.NumPlayers() - 1) * hand_size * BitsPerCard(game) + offset] =
+      index + 1 < hand_size;
+}
+
+void IncrementalCanonicalEncoder::UpdateHand(const HanabiObservationView& obs,
+                                             int offset) {
+  const HanabiGame& game = *parent_game_;
+  FixedVector<HanabiCard, kMaxHandSize>& cards = cards_[offset];
+  FixedVector<HanabiHand::CardKnowledge, kMaxHandSize>& knowledge =
+      knowledge_[offset];
+  REQUIRE(cards.size() == obs.NumCards(offset));
+  for (int index = 0; index < cards.size(); ++index) {
+    const HanabiCard card = obs.Card(offset, index);
+    if (!(card == cards[index])) {
+      if (offset > 0) {
+        uint8_t* card_bits = HandBits(offset) + index * BitsPerCard(game);
+        if (cards[index].IsValid()) {
+          card_bits[CardIndex(cards[index].Color(), cards[index].Rank(),
+                              game.NumRanks())] = 0;
+        }
+        card_bits[CardIndex(card.Color(), card.Rank(), game.NumRanks())] = 1;
+      }
+      cards[index] = card;
+    }
+    if (encode_knowledge_) {
+      const HanabiHand::CardKnowledge& card_knowledge =
+          obs.Knowledge(offset, index);
+      if (!SameKnowledge(card_knowledge, knowledge[index])) {
+        EncodeKnowledge(
+            game, card_knowledge,
+            KnowledgeBits(offset) + index * KnowledgeBitsPerCard(game));
+        knowledge[index] = card_knowledge;
+      }
+    }
+  }
+}
+
+void IncrementalCanonicalEncoder::UpdateBoard(
+    const HanabiObservationView& obs) {
+  const HanabiGame& game = *parent_game_;
+  uint8_t* bits = encoding_.data() + board_start_;
+  UpdateThermometer(deck_size_, obs.DeckSize(), bits);
+  deck_size_ = obs.DeckSize();
+  bits += game.MaxDeckSize() - game.HandSize() * game.NumPlayers();
+
+  const auto& fireworks = obs.Fireworks();
+  for (int color = 0; color < game.NumColors(); ++color) {
+    if (fireworks[color] != fireworks_[color]) {
+      if (fireworks_[color] > 0) {
+        bits[fireworks_[color] - 1] = 0;
+      }
+      if (fireworks[color] > 0) {
+        bits[fireworks[color] - 1] = 1;
+      }
+      fireworks_[color] = fireworks[color];
+    }
+    bits += game.NumRanks();
+  }
+
+  UpdateThermometer(information_tokens_, obs.InformationTokens(), bits);
+  information_tokens_ = obs.InformationTokens();
+  bits += game.MaxInformationTokens();
+  UpdateThermometer(life_tokens_, obs.LifeTokens(), bits);
+  life_tokens_ = obs.LifeTokens();
+}
+
+void IncrementalCanonicalEncoder::AddDiscard(int color, int rank) {
+  const int index = CardIndex(color, rank, parent_game_->NumRanks());
+  encoding_[discard_start_[index] + discard_count_[index]] = 1;
+  ++discard_count_[index];
 }
 
 }  // namespace hanabi_learning_env
@@ -18,10 +18,17 @@
 #ifndef __CANONICAL_ENCODERS_H__
 #define __CANONICAL_ENCODERS_H__
 
+#include <cstdint>
 #include <vector>
 
+#include "bit_packing.h"
+#include "fixed_vector.h"
 #include "hanabi_game.h"
+#include "hanabi_hand.h"
+#include "hanabi_history_item.h"
 #include "hanabi_observation.h"
+#include "hanabi_observation_view.h"
+#include "hanabi_state.h"
 #include "observation_encoder.h"
 
 namespace hanabi_learning_env {
@@ -33,7 +40,31 @@ class CanonicalObservationEncoder : public ObservationEncoder {
       : parent_game_(parent_game) {}
 
   std::vector<int> Shape() const override;
+  int Size() const override;
   std::vector<int> Encode(const HanabiObservation& obs) const override;
+  // Writes the encoding without any intermediate allocation.
+  void EncodeInto(const HanabiObservation& obs, uint8_t* buffer) const override;
+  void EncodeInto(const HanabiObservation& obs, float* buffer) const override;
+  void EncodeInto(const HanabiObservationView& obs, uint8_t* buffer) const;
+  void EncodeInto(const HanabiObservationView& obs, float* buffer) const;
+  // Encodes through a HanabiObservationView, without building an observation.
+  void EncodeStateInto(const HanabiState& state, int player,
+                       uint8_t* buffer) const override;
+  void EncodeStateInto(const HanabiState& state, int player,
+                       float* buffer) const override;
+  // Encodes players[i]'s observation of *states[i] into row i of a
+  // [num_states, Size()] buffer, as EncodeStateInto, zeroing the whole batch
+  // at once.
+  void EncodeStatesInto(const HanabiState* const* states, const int* players,
+                        int num_states, uint8_t* buffer) const;
+  void EncodeStatesInto(const HanabiState* const* states, const int* players,
+                        int num_states, float* buffer) const;
+  // Packed encodings, built without allocating once a thread has encoded
+  // its first observation.
+  void EncodePackedInto(const HanabiObservation& obs,
+                        uint64_t* buffer) const override;
+  void EncodeStatePackedInto(const HanabiState& state, int player,
+                             uint64_t* buffer) const override;
 
   ObservationEncoder::Type type() const override {
     return ObservationEncoder::Type::kCanonical;
@@ -43,6 +74,76 @@ class CanonicalObservationEncoder : public ObservationEncoder {
   const HanabiGame* parent_game_ = nullptr;
 };
 
+// Keeps the canonical encoding of one player's observation up to date as
+// moves are applied to a game. Update reads the moves applied since the
+// previous call from the state's recent moves, and applies each as a delta:
+// plays and discards shift the encoded cards of the hand, deals append one,
+// hints rule out the values they exclude from the target's card knowledge,
+// and the board, new discards and last action are updated in place.
+// Encoding() always equals CanonicalObservationEncoder::EncodeStateInto for
+// the last state given.
+class IncrementalCanonicalEncoder {
+ public:
+  IncrementalCanonicalEncoder(const HanabiGame* parent_game, int observer);
+
+  int Observer() const { return observer_; }
+  int Size() const { return encoding_.size(); }
+  const std::vector<uint8_t>& Encoding() const { return encoding_; }
+  // Writes Encoding() packed into PackedLength(Size()) words.
+  void EncodingPacked(uint64_t* buffer) const {
+    PackBits(encoding_.data(), encoding_.size(), buffer);
+  }
+
+  // Encodes state, which must be the state of the previous call with zero or
+  // more moves applied. Encodes from scratch on the first call, after
+  // Invalidate(), or when more moves were applied than the state keeps.
+  void Update(const HanabiState& state);
+  // Encodes state from scratch.
+  void Reset(const HanabiState& state);
+  // Makes the next Update encode from scratch. Needed when moving to another
+  // game, or after changing the state through its manual setters.
+  void Invalidate() { valid_ = false; }
+
+ private:
+  // Hands are addressed by offset from the observer.
+  void RemoveCard(int offset, int index);
+  // Appends a card that is not encoded yet, with initial knowledge.
+  void AddCard(int offset);
+  // Encodes the cards and knowledge of a hand that differ from obs.
+  void UpdateHand(const HanabiObservationView& obs, int offset);
+  void UpdateBoard(const HanabiObservationView& obs);
+  void AddDiscard(int color, int rank);
+  uint8_t* HandBits(int offset);
+  uint8_t* KnowledgeBits(int offset);
+
+  const HanabiGame* parent_game_ = nullptr;
+  int observer_ = -1;
+  bool encode_knowledge_ = false;
+  // Section starts within encoding_.
+  int board_start_ = 0;
+  int discards_start_ = 0;
+  int last_action_start_ = 0;
+  int knowledge_start_ = 0;
+  std::vector<uint8_t> encoding_;
+  HanabiHand::CardKnowledge initial_knowledge_;
+
+  // What encoding_ currently represents.
+  bool valid_ = false;
+  // state.MoveCount() and most recent move of the last state encoded.
+  int move_count_ = 0;
+  HanabiHistoryItem last_move_;
+  FixedVector<HanabiCard, kMaxHandSize> cards_[kMaxPlayers];
+  FixedVector<HanabiHand::CardKnowledge, kMaxHandSize> knowledge_[kMaxPlayers];
+  int deck_size_ = 0;
+  int information_tokens_ = 0;
+  int life_tokens_ = 0;
+  int fireworks_[kMaxNumColors];
+  // Start of each card's thermometer in the discards section, and the number
+  // of encoded discards, indexed by color * num_ranks + rank.
+  int discard_start_[kMaxNumColors * kMaxNumRanks];
+  int discard_count_[kMaxNumColors * kMaxNumRanks];
+};
+
 }  // namespace hanabi_learning_env
 
 #endif
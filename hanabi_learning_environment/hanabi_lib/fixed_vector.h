@@ -0,0 +1,194 @@
+// Copyright 2018 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// A vector with inline storage for up to N elements. Used for the parts of
+// a HanabiState whose size is bounded by the game rules, so that copying a
+// state copies a flat block of memory and never allocates.
+
+#ifndef __FIXED_VECTOR_H__
+#define __FIXED_VECTOR_H__
+
+#include <cassert>
+#include <cstddef>
+#include <cstring>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+#include "util.h"
+
+namespace hanabi_learning_env {
+
+// Supports the subset of the std::vector interface used by hanabi_lib.
+// Exceeding the capacity is a checked error (REQUIRE), not a reallocation.
+template <typename T, int N>
+class FixedVector {
+ public:
+  using value_type = T;
+  using size_type = std::size_t;
+  using iterator = T*;
+  using const_iterator = const T*;
+  using reference = T&;
+  using const_reference = const T&;
+
+  FixedVector() = default;
+  FixedVector(size_type count, const T& value) { resize(count, value); }
+  explicit FixedVector(size_type count) { resize(count); }
+  template <typename InputIt, typename = typename std::enable_if<
+                                  !std::is_integral<InputIt>::value>::type>
+  FixedVector(InputIt first, InputIt last) {
+    assign(first, last);
+  }
+  FixedVector(const FixedVector& other) { CopyFrom(other, IsTrivial()); }
+  FixedVector& operator=(const FixedVector& other) {
+    if (this != &other) {
+      CopyFrom(other, IsTrivial());
+    }
+    return *this;
+  }
+  ~FixedVector() { clear(); }
+
+  static constexpr int Capacity() { return N; }
+  size_type capacity() const { return N; }
+  size_type size() const { return size_; }
+  bool empty() const { return size_ == 0; }
+
+  T* data() { return reinterpret_cast<T*>(storage_); }
+  const T* data() const { return reinterpret_cast<const T*>(storage_); }
+  iterator begin() { return data(); }
+  iterator end() { return data() + size_; }
+  const_iterator begin() const { return data(); }
+  const_iterator end() const { return data() + size_; }
+
+  // Unchecked, as for std::vector; at() checks the index.
+  reference operator[](size_type index) { return data()[index]; }
+  const_reference operator[](size_type index) const { return data()[index]; }
+  reference at(size_type index) {
+    REQUIRE(index < size_);
+    return data()[index];
+  }
+  const_reference at(size_type index) const {
+    REQUIRE(index < size_);
+    return data()[index];
+  }
+  reference front() { return (*this)[0]; }
+  const_reference front() const { return (*this)[0]; }
+  reference back() { return (*this)[size_ - 1]; }
+  const_reference back() const { return (*this)[size_ - 1]; }
+
+  void push_back(const T& value) { emplace_back(value); }
+  template <typename... Args>
+  void emplace_back(Args&&... args) {
+    REQUIRE(size_ < capacity());
+    new (data() + size_) T(std::forward<Args>(args)...);
+    ++size_;
+  }
+  void pop_back() {
+    assert(size_ > 0);
+    --size_;
+    data()[size_].~T();
+  }
+  // Removes the element at position, shifting later elements down.
+  iterator erase(const_iterator position) {
+    iterator it = begin() + (position - begin());
+    assert(it >= begin() && it < end());
+    for (iterator next = it + 1; next != end(); ++next) {
+      *(next - 1) = *next;
+    }
+    pop_back();
+    return it;
+  }
+  // Inserts value before position, shifting later elements up.
+  iterator insert(const_iterator position, const T& value) {
+    const size_type index = position - begin();
+    assert(index <= size_);
+    if (index == size_) {
+      push_back(value);
+    } else {
+      emplace_back(back());
+      for (size_type i = size_ - 2; i > index; --i) {
+        (*this)[i] = (*this)[i - 1];
+      }
+      (*this)[index] = value;
+    }
+    return begin() + index;
+  }
+  void clear() {
+    if (std::is_trivially_destructible<T>::value) {
+      size_ = 0;
+    }
+    while (size_ > 0) {
+      pop_back();
+    }
+  }
+  void resize(size_type count, const T& value) {
+    REQUIRE(count <= capacity());
+    while (size_ > count) {
+      pop_back();
+    }
+    while (size_ < count) {
+      emplace_back(value);
+    }
+  }
+  void resize(size_type count) {
+    REQUIRE(count <= capacity());
+    while (size_ > count) {
+      pop_back();
+    }
+    while (size_ < count) {
+      emplace_back();
+    }
+  }
+  template <typename InputIt>
+  void assign(InputIt first, InputIt last) {
+    clear();
+    for (; first != last; ++first) {
+      emplace_back(*first);
+    }
+  }
+  // Capacity is fixed; provided for compatibility with std::vector code.
+  void reserve(size_type count) { REQUIRE(count <= capacity()); }
+
+  bool operator==(const FixedVector& other) const {
+    if (size_ != other.size_) {
+      return false;
+    }
+    for (size_type i = 0; i < size_; ++i) {
+      if (!((*this)[i] == other[i])) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+ private:
+  // Elements of trivially copyable types are copied as one block of memory.
+  using IsTrivial = std::integral_constant<
+      bool, std::is_trivially_copyable<T>::value &&
+                std::is_trivially_destructible<T>::value>;
+  void CopyFrom(const FixedVector& other, std::true_type) {
+    std::memcpy(storage_, other.storage_, other.size_ * sizeof(T));
+    size_ = other.size_;
+  }
+  void CopyFrom(const FixedVector& other, std::false_type) {
+    assign(other.begin(), other.end());
+  }
+
+  size_type size_ = 0;
+  typename std::aligned_storage<sizeof(T), alignof(T)>::type storage_[N];
+};
+
+}  // namespace hanabi_learning_env
+
+#endif
@@ -0,0 +1,368 @@
+// Copyright 2018 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "hanabi_belief.h"
+
+#include <algorithm>
+#include <cstdlib>
+
+#include "instrumentation.h"
+
+namespace hanabi_learning_env {
+
+namespace {
+
+constexpr int kMaxIdentities = kMaxNumColors * kMaxNumRanks;
+constexpr int kMaxHandCards = kMaxPlayers * kMaxHandSize;
+
+// Accessors shared by HanabiObservation and HanabiObservationView. Hands are
+// addressed by offset from the observing player.
+int NumCards(const HanabiObservation& obs, int offset) {
+  return obs.Hands()[offset].Cards().size();
+}
+int NumCards(const HanabiObservationView& obs, int offset) {
+  return obs.NumCards(offset);
+}
+
+HanabiCard Card(const HanabiObservation& obs, int offset, int index) {
+  return obs.Hands()[offset].Cards()[index];
+}
+HanabiCard Card(const HanabiObservationView& obs, int offset, int index) {
+  return obs.Card(offset, index);
+}
+
+const HanabiHand::CardKnowledge& Knowledge(const HanabiObservation& obs,
+                                           int offset, int index) {
+  return obs.Hands()[offset].Knowledge()[index];
+}
+const HanabiHand::CardKnowledge& Knowledge(const HanabiObservationView& obs,
+                                           int offset, int index) {
+  return obs.Knowledge(offset, index);
+}
+
+bool SameHistoryItem(const HanabiHistoryItem& a, const HanabiHistoryItem& b) {
+  return a.move == b.move && a.player == b.player && a.scored == b.scored &&
+         a.color == b.color && a.rank == b.rank &&
+         a.reveal_bitmask == b.reveal_bitmask &&
+         a.deal_to_player == b.deal_to_player;
+}
+
+// Counts the copies of each identity neither played nor discarded, and
+// those not in the other hands either, from scratch.
+template <typename Observation>
+void CountCards(const HanabiGame& game, const Observation& obs,
+                int* public_counts, int* unseen_counts) {
+  const int num_ranks = game.NumRanks();
+  for (int color = 0; color < game.NumColors(); ++color) {
+    for (int rank = 0; rank < num_ranks; ++rank) {
+      public_counts[color * num_ranks + rank] =
+          game.NumberCardInstances(color, rank) -
+          (rank < obs.Fireworks()[color] ? 1 : 0);
+    }
+  }
+  for (const HanabiCard& card : obs.DiscardPile()) {
+    --public_counts[card.Color() * num_ranks + card.Rank()];
+  }
+  std::copy_n(public_counts, game.NumColors() * num_ranks, unseen_counts);
+  for (int offset = 1; offset < game.NumPlayers(); ++offset) {
+    for (int index = 0; index < NumCards(obs, offset); ++index) {
+      const HanabiCard card = Card(obs, offset, index);
+      --unseen_counts[card.Color() * num_ranks + card.Rank()];
+    }
+  }
+}
+
+// Bit color * num_ranks + rank is set for each identity the knowledge
+// leaves plausible.
+uint32_t PlausibleIdentities(const HanabiGame& game,
+                             const HanabiHand::CardKnowledge& knowledge) {
+  const uint32_t ranks = knowledge.RankPlausibleMask();
+  uint32_t identities = 0;
+  for (int color = 0; color < game.NumColors(); ++color) {
+    if (knowledge.ColorPlausible(color)) {
+      identities |= ranks << (color * game.NumRanks());
+    }
+  }
+  return identities;
+}
+
+// Writes the row of num_identities beliefs proportional to the weights of
+// identities, zero elsewhere; returns false, leaving the row unchanged, if
+// the weights sum to zero.
+bool Normalize(int num_identities, uint32_t identities, const float* weights,
+               float* beliefs) {
+  float total = 0;
+  for (uint32_t bits = identities; bits != 0; bits &= bits - 1) {
+    total += weights[__builtin_ctz(bits)];
+  }
+  if (total <= 0) {
+    return false;
+  }
+  const float scale = 1 / total;
+  std::fill_n(beliefs, num_identities, 0.0f);
+  for (uint32_t bits = identities; bits != 0; bits &= bits - 1) {
+    const int i = __builtin_ctz(bits);
+    beliefs[i] = weights[i] * scale;
+  }
+  return true;
+}
+
+// Writes the beliefs of num_cards cards, rows of num_identities, given the
+// identities each may have and the copies remaining among them (and the
+// deck).
+void SolveBeliefs(int num_identities, const int* counts, int num_cards,
+                  const uint32_t* identities, int iterations,
+                  float* beliefs) {
+  float weights[kMaxIdentities];
+  for (int i = 0; i < num_identities; ++i) {
+    weights[i] = counts[i];
+  }
+  for (int card = 0; card < num_cards; ++card) {
+    // Copies of the card's own identity are never all accounted for.
+    const bool normalized = Normalize(num_identities, identities[card],
+                                      weights, beliefs + card * num_identities);
+    REQUIRE(normalized);
+  }
+  float previous[kMaxHandCards * kMaxIdentities];
+  float expected[kMaxIdentities];
+  for (int iteration = 0; iteration < iterations; ++iteration) {
+    std::copy_n(beliefs, num_cards * num_identities, previous);
+    std::fill_n(expected, num_identities, 0.0f);
+    for (int card = 0; card < num_cards; ++card) {
+      for (int i = 0; i < num_identities; ++i) {
+        expected[i] += previous[card * num_identities + i];
+      }
+    }
+    for (int card = 0; card < num_cards; ++card) {
+      const float* own = previous + card * num_identities;
+      for (uint32_t bits = identities[card]; bits != 0; bits &= bits - 1) {
+        const int i = __builtin_ctz(bits);
+        weights[i] = std::max(0.0f, counts[i] - (expected[i] - own[i]));
+      }
+      // A card whose every identity is claimed by the others keeps its
+      // previous belief.
+      Normalize(num_identities, identities[card], weights,
+                beliefs + card * num_identities);
+    }
+  }
+}
+
+// Writes the beliefs of obs, laid out as BeliefState::Beliefs(), given its
+// counts.
+template <typename Observation>
+void ComputeBeliefs(const HanabiGame& game, const Observation& obs,
+                    const int* public_counts, const int* unseen_counts,
+                    int iterations, float* beliefs) {
+  const int num_identities = game.NumColors() * game.NumRanks();
+  const int row_size = game.HandSize() * num_identities;
+  std::fill_n(beliefs, game.NumPlayers() * row_size, 0.0f);
+  uint32_t identities[kMaxHandCards];
+  int num_cards = 0;
+  for (int offset = 0; offset < game.NumPlayers(); ++offset) {
+    for (int index = 0; index < NumCards(obs, offset); ++index) {
+      identities[num_cards++] =
+          PlausibleIdentities(game, Knowledge(obs, offset, index));
+    }
+  }
+  // The observer's cards, with the other hands seen.
+  const int num_own_cards = NumCards(obs, 0);
+  SolveBeliefs(num_identities, unseen_counts, num_own_cards, identities,
+               iterations, beliefs);
+  // The other hands from common knowledge. Independent beliefs are solved
+  // hand by hand in place, consistent ones over all cards, the observer's
+  // included.
+  if (iterations == 0) {
+    const uint32_t* hand_identities = identities + num_own_cards;
+    for (int offset = 1; offset < game.NumPlayers(); ++offset) {
+      SolveBeliefs(num_identities, public_counts, NumCards(obs, offset),
+                   hand_identities, 0, beliefs + offset * row_size);
+      hand_identities += NumCards(obs, offset);
+    }
+    return;
+  }
+  float common[kMaxHandCards * kMaxIdentities];
+  SolveBeliefs(num_identities, public_counts, num_cards, identities,
+               iterations, common);
+  const float* card_beliefs = common + num_own_cards * num_identities;
+  for (int offset = 1; offset < game.NumPlayers(); ++offset) {
+    const int hand_cards = NumCards(obs, offset) * num_identities;
+    std::copy_n(card_beliefs, hand_cards, beliefs + offset * row_size);
+    card_beliefs += hand_cards;
+  }
+}
+
+template <typename Observation>
+void EncodeBeliefs(const HanabiGame& game, const Observation& obs,
+                   int iterations, float* buffer) {
+  HANABI_INSTRUMENT(kCounterEncode);
+  int public_counts[kMaxIdentities];
+  int unseen_counts[kMaxIdentities];
+  CountCards(game, obs, public_counts, unseen_counts);
+  ComputeBeliefs(game, obs, public_counts, unseen_counts, iterations, buffer);
+}
+
+// Integer encodings are 1 for the identities of nonzero probability.
+template <typename Observation, typename T>
+void EncodeBeliefs(const HanabiGame& game, const Observation& obs,
+                   int iterations, T* buffer) {
+  float beliefs[kMaxHandCards * kMaxIdentities];
+  EncodeBeliefs(game, obs, iterations, beliefs);
+  const int size = game.NumPlayers() * game.HandSize() * game.NumColors() *
+                   game.NumRanks();
+  for (int i = 0; i < size; ++i) {
+    buffer[i] = beliefs[i] > 0;
+  }
+}
+
+}  // namespace
+
+BeliefState::BeliefState(const HanabiGame* parent_game, int observer,
+                         int iterations)
+    : parent_game_(parent_game),
+      observer_(observer),
+      iterations_(iterations),
+      num_identities_(parent_game->NumColors() * parent_game->NumRanks()),
+      last_move_(HanabiMove(HanabiMove::kInvalid, /*card_index=*/-1,
+                            /*target_offset=*/-1, /*color=*/-1, /*rank=*/-1)) {
+  REQUIRE(observer >= 0 && observer < parent_game->NumPlayers());
+  REQUIRE(iterations >= 0);
+  beliefs_.resize(parent_game->NumPlayers() * parent_game->HandSize() *
+                      num_identities_,
+                  0);
+}
+
+void BeliefState::Reset(const HanabiState& state) {
+  REQUIRE(state.ParentGame() == parent_game_);
+  const HanabiGame& game = *parent_game_;
+  const HanabiObservationView obs(state, observer_);
+  CountCards(game, obs, public_counts_, unseen_counts_);
+  for (int offset = 0; offset < game.NumPlayers(); ++offset) {
+    num_cards_[offset] = obs.NumCards(offset);
+  }
+  ComputeBeliefs(game, obs, public_counts_, unseen_counts_, iterations_,
+                 beliefs_.data());
+  valid_ = true;
+  move_count_ = state.MoveCount();
+  if (state.NumRecentMoves() > 0) {
+    last_move_ = state.RecentMove(0);
+  }
+}
+
+void BeliefState::Update(const HanabiState& state) {
+  REQUIRE(state.ParentGame() == parent_game_);
+  const int num_new_moves = state.MoveCount() - move_count_;
+  // The same checks as IncrementalCanonicalEncoder::Update that the new
+  // moves are all recent and follow the last one counted.
+  const bool can_check =
+      move_count_ > 0 && num_new_moves < state.NumRecentMoves();
+  if (!valid_ || num_new_moves < 0 ||
+      num_new_moves > state.NumRecentMoves() ||
+      (move_count_ > 0 && num_new_moves == state.NumRecentMoves() &&
+       state.NumRecentMoves() < HanabiState::kRecentMoveCapacity) ||
+      (can_check &&
+       !SameHistoryItem(state.RecentMove(num_new_moves), last_move_))) {
+    Reset(state);
+    return;
+  }
+  if (num_new_moves == 0) {
+    return;
+  }
+
+  const HanabiGame& game = *parent_game_;
+  const int num_players = game.NumPlayers();
+  const int num_ranks = game.NumRanks();
+  for (int age = num_new_moves - 1; age >= 0; --age) {
+    const HanabiHistoryItem& item = state.RecentMove(age);
+    const int offset = (item.player - observer_ + num_players) % num_players;
+    switch (item.move.MoveType()) {
+      case HanabiMove::kDeal: {
+        const int deal_offset =
+            (item.deal_to_player - observer_ + num_players) % num_players;
+        ++num_cards_[deal_offset];
+        if (deal_offset != 0) {
+          --unseen_counts_[item.move.Color() * num_ranks + item.move.Rank()];
+        }
+        break;
+      }
+      case HanabiMove::kPlay:
+      case HanabiMove::kDiscard: {
+        const int identity = item.color * num_ranks + item.rank;
+        --num_cards_[offset];
+        --public_counts_[identity];
+        // Cards leaving the observer's hand become seen.
+        if (offset == 0) {
+          --unseen_counts_[identity];
+        }
+        break;
+      }
+      case HanabiMove::kRevealColor:
+      case HanabiMove::kRevealRank:
+        break;
+      default:
+        std::abort();
+    }
+  }
+  // Hints change only the card knowledge, which is read from the state.
+  ComputeBeliefs(game, HanabiObservationView(state, observer_),
+                 public_counts_, unseen_counts_, iterations_, beliefs_.data());
+  move_count_ = state.MoveCount();
+  last_move_ = state.RecentMove(0);
+}
+
+BeliefObservationEncoder::BeliefObservationEncoder(
+    const HanabiGame* parent_game, int iterations)
+    : parent_game_(parent_game), iterations_(iterations) {
+  REQUIRE(parent_game != nullptr);
+  REQUIRE(iterations >= 0);
+}
+
+std::vector<int> BeliefObservationEncoder::Shape() const {
+  return {parent_game_->NumPlayers(), parent_game_->HandSize(),
+          parent_game_->NumColors() * parent_game_->NumRanks()};
+}
+
+std::vector<int> BeliefObservationEncoder::Encode(
+    const HanabiObservation& obs) const {
+  std::vector<int> encoding(Size());
+  EncodeBeliefs(*parent_game_, obs, iterations_, encoding.data());
+  return encoding;
+}
+
+void BeliefObservationEncoder::EncodeInto(const HanabiObservation& obs,
+                                          uint8_t* buffer) const {
+  EncodeBeliefs(*parent_game_, obs, iterations_, buffer);
+}
+
+void BeliefObservationEncoder::EncodeInto(const HanabiObservation& obs,
+                                          float* buffer) const {
+  EncodeBeliefs(*parent_game_, obs, iterations_, buffer);
+}
+
+void BeliefObservationEncoder::EncodeStateInto(const HanabiState& state,
+                                               int player,
+                                               uint8_t* buffer) const {
+  REQUIRE(state.ParentGame() == parent_game_);
+  EncodeBeliefs(*parent_game_, HanabiObservationView(state, player),
+                iterations_, buffer);
+}
+
+void BeliefObservationEncoder::EncodeStateInto(const HanabiState& state,
+                                               int player,
+                                               float* buffer) const {
+  REQUIRE(state.ParentGame() == parent_game_);
+  EncodeBeliefs(*parent_game_, HanabiObservationView(state, player),
+                iterations_, buffer);
+}
+
+}  // namespace hanabi_learning_env
@@ -0,0 +1,133 @@
+// Copyright 2018 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Per-card beliefs: the probability of each identity of every card in hand,
+// from the copies not yet accounted for and the card knowledge from hints.
+//
+// The beliefs of the observer's own cards are conditioned on everything the
+// observer sees, including the other hands. Those of another player's cards
+// are conditioned on common knowledge only (hints, plays and discards),
+// i.e. what every player can infer about them.
+//
+// With no iterations, each card's belief is the independent "V0" belief:
+// proportional to the remaining copies of each plausible identity. Each
+// iteration then refines them towards cross-card consistency ("V1"): a
+// card's copies are reduced by the expected number held by the other cards
+// of the same computation, so that two cards do not both claim the last
+// copy of an identity.
+
+#ifndef __HANABI_BELIEF_H__
+#define __HANABI_BELIEF_H__
+
+#include <cstdint>
+#include <vector>
+
+#include "hanabi_game.h"
+#include "hanabi_history_item.h"
+#include "hanabi_observation.h"
+#include "hanabi_observation_view.h"
+#include "hanabi_state.h"
+#include "observation_encoder.h"
+#include "util.h"
+
+namespace hanabi_learning_env {
+
+// The beliefs of one player's observation, kept up to date as moves are
+// applied to a game. Update applies the moves applied since the previous
+// call, from the state's recent moves, to the counts of remaining copies,
+// then recomputes the beliefs from them and the current card knowledge.
+class BeliefState {
+ public:
+  BeliefState(const HanabiGame* parent_game, int observer,
+              int iterations = 0);
+
+  int Observer() const { return observer_; }
+  int Iterations() const { return iterations_; }
+  // Identities per card, indexed color * NumRanks() + rank.
+  int BeliefSize() const { return num_identities_; }
+  // Copies of the identity neither played nor discarded.
+  int PublicCount(int color, int rank) const {
+    return public_counts_[color * parent_game_->NumRanks() + rank];
+  }
+  // PublicCount less the copies in the hands the observer sees.
+  int UnseenCount(int color, int rank) const {
+    return unseen_counts_[color * parent_game_->NumRanks() + rank];
+  }
+  // Hands are addressed by offset from the observer.
+  int NumCards(int offset) const { return num_cards_[offset]; }
+  // BeliefSize() probabilities of card index of the hand at offset.
+  const float* Belief(int offset, int index) const {
+    return &beliefs_[(offset * parent_game_->HandSize() + index) *
+                     num_identities_];
+  }
+  // [NumPlayers(), HandSize(), BeliefSize()], zero for missing cards.
+  const std::vector<float>& Beliefs() const { return beliefs_; }
+
+  // Computes the beliefs of state, which must be the state of the previous
+  // call with zero or more moves applied. Counts from scratch on the first
+  // call, after Invalidate(), or when more moves were applied than the state
+  // keeps.
+  void Update(const HanabiState& state);
+  // Computes the beliefs of state from scratch.
+  void Reset(const HanabiState& state);
+  // Makes the next Update count from scratch.
+  void Invalidate() { valid_ = false; }
+
+ private:
+  const HanabiGame* parent_game_ = nullptr;
+  int observer_ = -1;
+  int iterations_ = 0;
+  int num_identities_ = 0;
+  std::vector<float> beliefs_;
+
+  // What the counts currently represent.
+  bool valid_ = false;
+  int move_count_ = 0;
+  HanabiHistoryItem last_move_;
+  int num_cards_[kMaxPlayers];
+  int public_counts_[kMaxNumColors * kMaxNumRanks];
+  int unseen_counts_[kMaxNumColors * kMaxNumRanks];
+};
+
+// Encodes an observation as its beliefs, laid out as BeliefState::Beliefs().
+// Beliefs are probabilities, so only the float encodings are exact; the
+// integer and bit encodings are 1 for the identities of nonzero probability.
+class BeliefObservationEncoder : public ObservationEncoder {
+ public:
+  explicit BeliefObservationEncoder(const HanabiGame* parent_game,
+                                    int iterations = 0);
+
+  int Iterations() const { return iterations_; }
+  std::vector<int> Shape() const override;
+  std::vector<int> Encode(const HanabiObservation& obs) const override;
+  void EncodeInto(const HanabiObservation& obs, uint8_t* buffer) const override;
+  void EncodeInto(const HanabiObservation& obs, float* buffer) const override;
+  // Reads the state through a HanabiObservationView.
+  void EncodeStateInto(const HanabiState& state, int player,
+                       uint8_t* buffer) const override;
+  void EncodeStateInto(const HanabiState& state, int player,
+                       float* buffer) const override;
+
+  ObservationEncoder::Type type() const override {
+    return ObservationEncoder::Type::kBelief;
+  }
+
+ private:
+  const HanabiGame* parent_game_ = nullptr;
+  int iterations_ = 0;
+};
+
+}  // namespace hanabi_learning_env
+
+#endif
@@ -0,0 +1,353 @@
+// Copyright 2018 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "hanabi_determinization.h"
+
+#include <algorithm>
+#include <cstdint>
+
+#include "util.h"
+
+namespace hanabi_learning_env {
+
+namespace {
+
+constexpr int kMaxCardTypes = kMaxNumColors * kMaxNumRanks;
+// Number of rejection sampling attempts before falling back to drawing with
+// exact completion counts.
+constexpr int kMaxSampleAttempts = 32;
+
+// The observer's hand as a constraint problem over card types, where card
+// type color * num_ranks + rank indexes the unseen card counts.
+struct HandConstraints {
+  int num_cards = 0;
+  int num_ranks = 0;
+  int num_types = 0;
+  // Bit t of plausible[i] is set if card i could be of type t.
+  uint32_t plausible[kMaxHandSize];
+  // Card indices, most constrained card first.
+  int order[kMaxHandSize];
+  // An upper bound on the number of unseen cards card order[k] could be
+  // once the cards before it in order are drawn.
+  int max_candidates[kMaxHandSize];
+};
+
+HandConstraints Constraints(const HanabiHand& hand, const HanabiGame& game,
+                            const int* unseen) {
+  HandConstraints constraints;
+  constraints.num_cards = hand.Cards().size();
+  constraints.num_ranks = game.NumRanks();
+  constraints.num_types = game.NumColors() * game.NumRanks();
+  int num_candidates[kMaxHandSize];
+  for (int i = 0; i < constraints.num_cards; ++i) {
+    const HanabiHand::CardKnowledge& knowledge = hand.Knowledge()[i];
+    uint32_t plausible = 0;
+    num_candidates[i] = 0;
+    for (int color = 0; color < game.NumColors(); ++color) {
+      if (!knowledge.ColorPlausible(color)) {
+        continue;
+      }
+      for (int rank = 0; rank < game.NumRanks(); ++rank) {
+        if (knowledge.RankPlausible(rank)) {
+          const int type = color * game.NumRanks() + rank;
+          plausible |= static_cast<uint32_t>(1) << type;
+          num_candidates[i] += unseen[type];
+        }
+      }
+    }
+    constraints.plausible[i] = plausible;
+    constraints.order[i] = i;
+  }
+  std::sort(constraints.order, constraints.order + constraints.num_cards,
+            [&num_candidates](int a, int b) {
+              return num_candidates[a] < num_candidates[b];
+            });
+  // An earlier card whose plausible types are all plausible for a later one
+  // always takes one of the later card's candidates.
+  for (int k = 0; k < constraints.num_cards; ++k) {
+    const uint32_t plausible = constraints.plausible[constraints.order[k]];
+    int max_candidates = num_candidates[constraints.order[k]];
+    for (int j = 0; j < k; ++j) {
+      if ((constraints.plausible[constraints.order[j]] & ~plausible) == 0) {
+        --max_candidates;
+      }
+    }
+    constraints.max_candidates[k] = max_candidates;
+  }
+  return constraints;
+}
+
+HanabiCard TypeToCard(const HandConstraints& constraints, int type) {
+  return HanabiCard(type / constraints.num_ranks, type % constraints.num_ranks);
+}
+
+// Draws each card in order from the unseen cards it could be, by rejection:
+// a card with total candidates left is kept with probability
+// total / max_candidates, which makes every consistent hand equally likely
+// (counting unseen cards of the same type as distinct) given that all cards
+// are kept. Returns false if a card is rejected or has no candidate left.
+bool SampleSequentially(const HandConstraints& constraints,
+                        const int* unseen_counts, std::mt19937* rng,
+                        FixedVector<HanabiCard, kMaxHandSize>* cards) {
+  int unseen[kMaxCardTypes];
+  std::copy(unseen_counts, unseen_counts + constraints.num_types, unseen);
+  for (int k = 0; k < constraints.num_cards; ++k) {
+    const int i = constraints.order[k];
+    const uint32_t plausible = constraints.plausible[i];
+    int total = 0;
+    for (int type = 0; type < constraints.num_types; ++type) {
+      if ((plausible >> type) & 1) {
+        total += unseen[type];
+      }
+    }
+    if (total == 0) {
+      return false;
+    }
+    int instance = std::uniform_int_distribution<int>(
+        0, constraints.max_candidates[k] - 1)(*rng);
+    if (instance >= total) {
+      return false;
+    }
+    int type = 0;
+    for (;; ++type) {
+      if ((plausible >> type) & 1) {
+        if (instance < unseen[type]) {
+          break;
+        }
+        instance -= unseen[type];
+      }
+    }
+    --unseen[type];
+    (*cards)[i] = TypeToCard(constraints, type);
+  }
+  return true;
+}
+
+// Number of ways to draw cards order[k...] from the unseen cards, counting
+// unseen cards of the same type as distinct.
+uint64_t NumCompletions(const HandConstraints& constraints, int k,
+                        int* unseen) {
+  if (k == constraints.num_cards) {
+    return 1;
+  }
+  const uint32_t plausible = constraints.plausible[constraints.order[k]];
+  uint64_t num_completions = 0;
+  for (int type = 0; type < constraints.num_types; ++type) {
+    if (((plausible >> type) & 1) == 0 || unseen[type] == 0) {
+      continue;
+    }
+    const int count = unseen[type]--;
+    num_completions += count * NumCompletions(constraints, k + 1, unseen);
+    ++unseen[type];
+  }
+  return num_completions;
+}
+
+// Draws each card in order with each type weighted by its number of unseen
+// cards times the number of completions of the rest of the hand, which is
+// exactly uniform without rejection but enumerates the remaining hand for
+// every draw. Returns false if no hand is consistent.
+bool SampleByCounting(const HandConstraints& constraints,
+                      const int* unseen_counts, std::mt19937* rng,
+                      FixedVector<HanabiCard, kMaxHandSize>* cards) {
+  int unseen[kMaxCardTypes];
+  std::copy(unseen_counts, unseen_counts + constraints.num_types, unseen);
+  uint64_t weights[kMaxCardTypes];
+  for (int k = 0; k < constraints.num_cards; ++k) {
+    const int i = constraints.order[k];
+    const uint32_t plausible = constraints.plausible[i];
+    uint64_t total = 0;
+    for (int type = 0; type < constraints.num_types; ++type) {
+      weights[type] = 0;
+      if (((plausible >> type) & 1) == 0 || unseen[type] == 0) {
+        continue;
+      }
+      const int count = unseen[type]--;
+      weights[type] = count * NumCompletions(constraints, k + 1, unseen);
+      ++unseen[type];
+      total += weights[type];
+    }
+    if (total == 0) {
+      return false;
+    }
+    uint64_t instance =
+        std::uniform_int_distribution<uint64_t>(0, total - 1)(*rng);
+    int type = 0;
+    for (; instance >= weights[type]; ++type) {
+      instance -= weights[type];
+    }
+    --unseen[type];
+    (*cards)[i] = TypeToCard(constraints, type);
+  }
+  return true;
+}
+
+// Draws cards for hand from the unseen cards, consistent with its knowledge.
+void SampleHand(const HanabiHand& hand, const HanabiGame& game,
+                const int* unseen, std::mt19937* rng,
+                FixedVector<HanabiCard, kMaxHandSize>* cards) {
+  const HandConstraints constraints = Constraints(hand, game, unseen);
+  cards->resize(constraints.num_cards);
+  bool sampled = false;
+  for (int attempt = 0; attempt < kMaxSampleAttempts && !sampled; ++attempt) {
+    sampled = SampleSequentially(constraints, unseen, rng, cards);
+  }
+  if (!sampled) {
+    sampled = SampleByCounting(constraints, unseen, rng, cards);
+  }
+  // The actual hand is always consistent with the observer's knowledge.
+  REQUIRE(sampled);
+}
+
+}  // namespace
+
+HanabiState SampleDeterminization(const HanabiState& state, int observer,
+                                  std::mt19937* rng) {
+  HanabiState determinization(state);
+  SampleDeterminization(state, observer, rng, &determinization);
+  return determinization;
+}
+
+void SampleDeterminization(const HanabiState& state, int observer,
+                           std::mt19937* rng, HanabiState* determinization) {
+  REQUIRE(rng != nullptr);
+  REQUIRE(determinization != nullptr);
+  const HanabiGame& game = *state.ParentGame();
+  REQUIRE(observer >= 0 && observer < game.NumPlayers());
+  *determinization = state;
+  if (game.ObservationType() == HanabiGame::kSeer) {
+    return;
+  }
+
+  // The observer sees every card except those in its hand and the deck.
+  const HanabiHand& hand = state.Hands()[observer];
+  int unseen[kMaxCardTypes];
+  for (int color = 0; color < game.NumColors(); ++color) {
+    for (int rank = 0; rank < game.NumRanks(); ++rank) {
+      unseen[color * game.NumRanks() + rank] =
+          state.Deck().CardCount(color, rank);
+    }
+  }
+  for (const HanabiCard& card : hand.Cards()) {
+    ++unseen[card.Color() * game.NumRanks() + card.Rank()];
+  }
+
+  FixedVector<HanabiCard, kMaxHandSize> cards;
+  SampleHand(hand, game, unseen, rng, &cards);
+  determinization->SetHandCards(observer, cards);
+}
+
+HanabiState SampleDeterminization(const HanabiObservation& observation,
+                                  std::mt19937* rng) {
+  REQUIRE(rng != nullptr);
+  // The state draws from the game's generator only through non-const
+  // methods that searches replace with their own generators.
+  HanabiGame* game = const_cast<HanabiGame*>(observation.ParentGame());
+  const int num_players = game->NumPlayers();
+  const int num_ranks = game->NumRanks();
+  int unseen[kMaxCardTypes];
+  for (int color = 0; color < game->NumColors(); ++color) {
+    for (int rank = 0; rank < num_ranks; ++rank) {
+      unseen[color * num_ranks + rank] =
+          game->NumberCardInstances(color, rank) -
+          (rank < observation.Fireworks()[color] ? 1 : 0);
+    }
+  }
+  for (const HanabiCard& card : observation.DiscardPile()) {
+    --unseen[card.Color() * num_ranks + card.Rank()];
+  }
+  for (int offset = 1; offset < num_players; ++offset) {
+    for (const HanabiCard& card : observation.Hands()[offset].Cards()) {
+      --unseen[card.Color() * num_ranks + card.Rank()];
+    }
+  }
+
+  // Only kSeer observations show the observer its own cards.
+  const HanabiHand& own_hand = observation.Hands()[0];
+  FixedVector<HanabiCard, kMaxHandSize> cards(own_hand.Cards());
+  if (own_hand.Cards().empty() || own_hand.Cards()[0].IsValid()) {
+    for (const HanabiCard& card : cards) {
+      REQUIRE(card.IsValid());
+    }
+  } else {
+    SampleHand(own_hand, *game, unseen, rng, &cards);
+  }
+  HanabiHand hand;
+  for (int i = 0; i < cards.size(); ++i) {
+    hand.AddCard(cards[i], own_hand.Knowledge()[i]);
+    --unseen[cards[i].Color() * num_ranks + cards[i].Rank()];
+  }
+
+  HanabiState state(game, /*start_player=*/0);
+  state.SetHand(0, hand);
+  for (int offset = 1; offset < num_players; ++offset) {
+    state.SetHand(offset, observation.Hands()[offset]);
+  }
+  std::vector<HanabiCard> deck;
+  for (int type = 0; type < game->NumColors() * num_ranks; ++type) {
+    REQUIRE(unseen[type] >= 0);
+    deck.insert(deck.end(), unseen[type],
+                HanabiCard(type / num_ranks, type % num_ranks));
+  }
+  REQUIRE(static_cast<int>(deck.size()) == observation.DeckSize());
+  state.SetDeck(deck);
+  state.SetDiscardPile(std::vector<HanabiCard>(
+      observation.DiscardPile().begin(), observation.DiscardPile().end()));
+  state.SetFireworks(std::vector<int>(observation.Fireworks().begin(),
+                                      observation.Fireworks().end()));
+  state.SetInformationTokens(observation.InformationTokens());
+  state.SetLifeTokens(observation.LifeTokens());
+  state.SetCurPlayer(observation.CurPlayerOffset());
+  if (deck.empty()) {
+    // Every player gets one more turn after the last card is dealt, and the
+    // last deal is always among the moves since the observer's last turn.
+    int turns_played = 0;
+    for (const HanabiHistoryItem& item : observation.LastMoves()) {
+      if (item.move.MoveType() == HanabiMove::kDeal) {
+        break;
+      }
+      ++turns_played;
+    }
+    state.SetTurnsToPlay(num_players - turns_played);
+  }
+  return state;
+}
+
+void SampleDeterminizations(const HanabiState& state, int observer,
+                            std::mt19937* rng, HanabiState* determinizations,
+                            int num_determinizations) {
+  REQUIRE(determinizations != nullptr || num_determinizations == 0);
+  for (int i = 0; i < num_determinizations; ++i) {
+    SampleDeterminization(state, observer, rng, &determinizations[i]);
+  }
+}
+
+HanabiDeterminizationPool::HanabiDeterminizationPool(int size, int seed)
+    : size_(size) {
+  REQUIRE(size > 0);
+  while (seed == -1) {
+    seed = std::random_device()();
+  }
+  rng_.seed(seed);
+}
+
+void HanabiDeterminizationPool::Sample(const HanabiState& state,
+                                       int observer) {
+  if (states_.empty()) {
+    states_.assign(size_, state);
+  }
+  SampleDeterminizations(state, observer, &rng_, states_.data(), size_);
+}
+
+}  // namespace hanabi_learning_env
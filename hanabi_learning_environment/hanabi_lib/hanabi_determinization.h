@@ -0,0 +1,87 @@
+// Copyright 2018 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Sampling of full game states consistent with one player's information,
+// for information-set search methods such as ISMCTS.
+
+#ifndef __HANABI_DETERMINIZATION_H__
+#define __HANABI_DETERMINIZATION_H__
+
+#include <random>
+#include <vector>
+
+#include "hanabi_observation.h"
+#include "hanabi_state.h"
+
+namespace hanabi_learning_env {
+
+// Returns a copy of state in which the observer's hand is replaced by cards
+// drawn from the cards the observer cannot see (its own hand and the deck),
+// consistent with the observer's card knowledge. Everything the observer
+// can see, including its card knowledge, is unchanged. The deck holds the
+// remaining unseen cards; deals are drawn from the deck counts when the
+// determinization is simulated, so there is no deck order to sample.
+//
+// Every hand consistent with the observer's knowledge is equally likely,
+// counting unseen cards of the same color and rank as distinct, so a hand is
+// as likely as the actual hand given what the observer has seen. Cards are
+// drawn one at a time, most constrained card first, and a partial hand is
+// rejected in proportion to how much its earlier cards narrowed the later
+// ones. Hands rejected too often are drawn with weights from exact counts of
+// the consistent completions. In kSeer games the observer sees its own
+// cards, and the state is returned unchanged.
+HanabiState SampleDeterminization(const HanabiState& state, int observer,
+                                  std::mt19937* rng);
+// As above, assigning the determinization to *determinization, which reuses
+// its storage.
+void SampleDeterminization(const HanabiState& state, int observer,
+                           std::mt19937* rng, HanabiState* determinization);
+// Builds a state consistent with observation, seen from the observing
+// player: the observer is player 0 and the others are numbered by their
+// offset, so that moves of the state are moves of the observation. The
+// observer's hand is sampled as above and the deck holds the rest of the
+// unseen cards. The state has no move history.
+HanabiState SampleDeterminization(const HanabiObservation& observation,
+                                  std::mt19937* rng);
+// Fills determinizations[0, num_determinizations) with independent
+// determinizations of state.
+void SampleDeterminizations(const HanabiState& state, int observer,
+                            std::mt19937* rng, HanabiState* determinizations,
+                            int num_determinizations);
+
+// A reusable set of determinizations with its own generator. After the first
+// call to Sample, resampling does not allocate as long as the sampled states
+// do not record their full move history.
+class HanabiDeterminizationPool {
+ public:
+  // A seed of -1 picks a random seed, as for the game's seed parameter.
+  HanabiDeterminizationPool(int size, int seed);
+
+  int Size() const { return size_; }
+  // Number of available states: 0 before the first Sample, Size() after.
+  int NumSampled() const { return states_.size(); }
+  // Replaces every state of the pool by a determinization of state.
+  void Sample(const HanabiState& state, int observer);
+  // Determinization i of the last call to Sample.
+  const HanabiState& State(int i) const { return states_[i]; }
+
+ private:
+  int size_ = 0;
+  std::mt19937 rng_;
+  std::vector<HanabiState> states_;  // Empty until the first Sample.
+};
+
+}  // namespace hanabi_learning_env
+
+#endif
@@ -0,0 +1,515 @@
+// Copyright 2018 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "hanabi_env_server.h"
+
+#include <fcntl.h>
+#include <signal.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <new>
+#include <utility>
+
+#include "util.h"
+
+namespace hanabi_learning_env {
+
+namespace {
+
+constexpr char kMagic[8] = {'H', 'L', 'E', 'S', 'E', 'R', 'V', '\0'};
+constexpr uint32_t kFormatVersion = 1;
+constexpr int64_t kAlignment = 64;
+
+// Values of ServerHeader::status.
+enum ServerStatus : uint32_t { kStarting = 0, kServing, kStopped };
+
+// First word of a request slot, followed by one move uid per game.
+enum Command : int32_t { kCommandReset = 0, kCommandStep };
+
+// Sections of a response slot, after its status word, each at an offset
+// aligned to kAlignment.
+enum Section {
+  kObservations = 0,
+  kLegalMoves,
+  kRewards,
+  kDones,
+  kCurrentPlayers,
+  kNumSections
+};
+
+// The start of the shared memory object, followed by the game parameters as
+// "key=value\n" lines and then by the shards from shards_offset on.
+struct ServerHeader {
+  char magic[8];
+  uint32_t version;
+  int32_t num_shards;
+  int32_t envs_per_shard;
+  int32_t observation_length;
+  int32_t packed_observation_length;
+  int32_t num_moves;
+  int32_t ring_capacity;
+  int32_t parameters_size;
+  int64_t shards_offset;
+  int64_t shard_size;
+  int64_t request_size;
+  int64_t response_size;
+  int64_t section_offsets[kNumSections];
+  // Set to kServing once everything else is written.
+  std::atomic<uint32_t> status;
+};
+
+// The start of each shard, followed by its request and response slots.
+struct ShardHeader {
+  SpscRingIndices requests;
+  SpscRingIndices responses;
+  // Process id of the client holding the shard, or zero.
+  alignas(64) std::atomic<uint32_t> client_pid;
+};
+
+int64_t Align(int64_t size) {
+  return (size + kAlignment - 1) / kAlignment * kAlignment;
+}
+
+std::string SharedName(const std::string& name) {
+  return !name.empty() && name[0] == '/' ? name : "/" + name;
+}
+
+ShardHeader* GetShard(uint8_t* data, int shard) {
+  const ServerHeader* header = reinterpret_cast<const ServerHeader*>(data);
+  return reinterpret_cast<ShardHeader*>(data + header->shards_offset +
+                                        shard * header->shard_size);
+}
+
+SpscRing RequestRing(uint8_t* data, int shard) {
+  const ServerHeader* header = reinterpret_cast<const ServerHeader*>(data);
+  ShardHeader* shard_header = GetShard(data, shard);
+  return SpscRing(&shard_header->requests,
+                  reinterpret_cast<uint8_t*>(shard_header) +
+                      Align(sizeof(ShardHeader)),
+                  header->ring_capacity, header->request_size);
+}
+
+SpscRing ResponseRing(uint8_t* data, int shard) {
+  const ServerHeader* header = reinterpret_cast<const ServerHeader*>(data);
+  ShardHeader* shard_header = GetShard(data, shard);
+  return SpscRing(&shard_header->responses,
+                  reinterpret_cast<uint8_t*>(shard_header) +
+                      Align(sizeof(ShardHeader)) +
+                      header->ring_capacity * header->request_size,
+                  header->ring_capacity, header->response_size);
+}
+
+// The outputs of a HanabiVectorEnv step written into a response slot.
+HanabiVectorEnvOutput SlotOutput(const ServerHeader& header, uint8_t* slot,
+                                 bool packed_observations) {
+  HanabiVectorEnvOutput output;
+  uint8_t* observations = slot + header.section_offsets[kObservations];
+  if (packed_observations) {
+    output.packed_observations = reinterpret_cast<uint64_t*>(observations);
+  } else {
+    output.observations = observations;
+  }
+  output.legal_moves = slot + header.section_offsets[kLegalMoves];
+  output.rewards =
+      reinterpret_cast<float*>(slot + header.section_offsets[kRewards]);
+  output.dones = slot + header.section_offsets[kDones];
+  output.current_players =
+      reinterpret_cast<int*>(slot + header.section_offsets[kCurrentPlayers]);
+  return output;
+}
+
+// Whether no process of the id exists, e.g. a client that exited without
+// disconnecting.
+bool ProcessIsGone(uint32_t pid) {
+  return kill(static_cast<pid_t>(pid), 0) != 0 && errno == ESRCH;
+}
+
+}  // namespace
+
+HanabiEnvServer::HanabiEnvServer(HanabiGame* parent_game,
+                                 const HanabiEnvServerConfig& config)
+    : name_(SharedName(config.name)), stop_(false) {
+  REQUIRE(parent_game != nullptr);
+  REQUIRE(!config.name.empty());
+  REQUIRE(config.num_shards > 0 && config.envs_per_shard > 0);
+  REQUIRE(config.ring_capacity >= 2);
+  envs_.reserve(config.num_shards);
+  for (int shard = 0; shard < config.num_shards; ++shard) {
+    envs_.emplace_back(new HanabiVectorEnv(parent_game, config.envs_per_shard,
+                                           config.threads_per_shard,
+                                           shard * config.envs_per_shard));
+  }
+  const HanabiVectorEnv& env = *envs_[0];
+  const int num_envs = env.NumEnvs();
+
+  std::string parameters;
+  std::vector<std::pair<std::string, std::string>> sorted;
+  for (const auto& param : parent_game->Parameters()) {
+    sorted.push_back(param);
+  }
+  std::sort(sorted.begin(), sorted.end());
+  for (const auto& param : sorted) {
+    parameters += param.first + "=" + param.second + "\n";
+  }
+
+  int64_t section_offsets[kNumSections];
+  int64_t offset = kAlignment;  // The status word.
+  section_offsets[kObservations] = offset;
+  offset += Align(config.packed_observations
+                      ? int64_t{num_envs} * env.PackedObservationLength() *
+                            sizeof(uint64_t)
+                      : int64_t{num_envs} * env.ObservationLength());
+  section_offsets[kLegalMoves] = offset;
+  offset += Align(int64_t{num_envs} * env.NumMoves());
+  section_offsets[kRewards] = offset;
+  offset += Align(num_envs * sizeof(float));
+  section_offsets[kDones] = offset;
+  offset += Align(num_envs);
+  section_offsets[kCurrentPlayers] = offset;
+  offset += Align(num_envs * sizeof(int32_t));
+  const int64_t response_size = offset;
+  const int64_t request_size = Align((num_envs + 1) * sizeof(int32_t));
+  const int64_t shard_size =
+      Align(sizeof(ShardHeader)) +
+      config.ring_capacity * (request_size + response_size);
+  const int64_t shards_offset =
+      Align(sizeof(ServerHeader) + parameters.size());
+  size_ = shards_offset + config.num_shards * shard_size;
+
+  // Replaces any object left by a server that did not stop cleanly.
+  shm_unlink(name_.c_str());
+  const int fd = shm_open(name_.c_str(), O_RDWR | O_CREAT | O_EXCL, 0600);
+  REQUIRE(fd >= 0);
+  const bool resized = ftruncate(fd, size_) == 0;
+  void* data = resized ? mmap(nullptr, size_, PROT_READ | PROT_WRITE,
+                              MAP_SHARED, fd, 0)
+                       : MAP_FAILED;
+  close(fd);
+  if (data == MAP_FAILED) {
+    shm_unlink(name_.c_str());
+  }
+  REQUIRE(data != MAP_FAILED);
+  data_ = static_cast<uint8_t*>(data);
+
+  ServerHeader* header = new (data_) ServerHeader();
+  header->version = kFormatVersion;
+  header->num_shards = config.num_shards;
+  header->envs_per_shard = num_envs;
+  header->observation_length =
+      config.packed_observations ? 0 : env.ObservationLength();
+  header->packed_observation_length =
+      config.packed_observations ? env.PackedObservationLength() : 0;
+  header->num_moves = env.NumMoves();
+  header->ring_capacity = config.ring_capacity;
+  header->parameters_size = parameters.size();
+  header->shards_offset = shards_offset;
+  header->shard_size = shard_size;
+  header->request_size = request_size;
+  header->response_size = response_size;
+  std::copy(section_offsets, section_offsets + kNumSections,
+            header->section_offsets);
+  std::memcpy(data_ + sizeof(ServerHeader), parameters.data(),
+              parameters.size());
+  for (int shard = 0; shard < config.num_shards; ++shard) {
+    ShardHeader* shard_header = GetShard(data_, shard);
+    shard_header->requests.Initialize();
+    shard_header->responses.Initialize();
+    new (&shard_header->client_pid) std::atomic<uint32_t>(0);
+  }
+  std::memcpy(header->magic, kMagic, sizeof(kMagic));
+  header->status.store(kServing, std::memory_order_release);
+
+  threads_.reserve(config.num_shards);
+  for (int shard = 0; shard < config.num_shards; ++shard) {
+    threads_.emplace_back([this, shard]() { ServeShard(shard); });
+  }
+}
+
+HanabiEnvServer::~HanabiEnvServer() {
+  stop_.store(true, std::memory_order_relaxed);
+  for (std::thread& thread : threads_) {
+    thread.join();
+  }
+  reinterpret_cast<ServerHeader*>(data_)->status.store(
+      kStopped, std::memory_order_release);
+  munmap(data_, size_);
+  shm_unlink(name_.c_str());
+}
+
+void HanabiEnvServer::ServeShard(int shard) {
+  const ServerHeader& header = *reinterpret_cast<ServerHeader*>(data_);
+  const bool packed_observations = header.packed_observation_length > 0;
+  HanabiVectorEnv& env = *envs_[shard];
+  SpscRing requests = RequestRing(data_, shard);
+  SpscRing responses = ResponseRing(data_, shard);
+  // The response holding the client's current outputs, which an invalid
+  // request repeats.
+  const uint8_t* last_response = nullptr;
+  SpscBackoff backoff;
+  while (!stop_.load(std::memory_order_relaxed)) {
+    // A client waits for each response before its next request, and holds
+    // at most one older response, so a slot is free whenever it has sent a
+    // request.
+    uint8_t* response = requests.Readable() > 0 ? responses.WriteSlot()
+                                                : nullptr;
+    if (response == nullptr) {
+      backoff.Wait();
+      continue;
+    }
+    backoff.Reset();
+    const int32_t* request =
+        reinterpret_cast<const int32_t*>(requests.ReadSlot());
+    HanabiEnvClient::Status status = HanabiEnvClient::kOk;
+    if (request[0] == kCommandReset) {
+      env.Reset(SlotOutput(header, response, packed_observations));
+    } else if (request[0] != kCommandStep ||
+               !env.Step(request + 1,
+                         SlotOutput(header, response, packed_observations))) {
+      // Step checks every move before stepping any game.
+      status = HanabiEnvClient::kInvalidRequest;
+      if (last_response != nullptr) {
+        std::memcpy(response, last_response, header.response_size);
+      }
+    }
+    *reinterpret_cast<int32_t*>(response) = status;
+    requests.Release();
+    responses.Commit();
+    if (status == HanabiEnvClient::kOk || last_response != nullptr) {
+      last_response = response;
+    }
+  }
+}
+
+HanabiEnvClient::~HanabiEnvClient() { Disconnect(); }
+
+bool HanabiEnvClient::Connect(const std::string& name, int shard) {
+  Disconnect();
+  const int fd = shm_open(SharedName(name).c_str(), O_RDWR, 0);
+  if (fd < 0) {
+    return false;
+  }
+  struct stat file_stat;
+  void* data = MAP_FAILED;
+  if (fstat(fd, &file_stat) == 0 &&
+      file_stat.st_size >= static_cast<off_t>(sizeof(ServerHeader))) {
+    data = mmap(nullptr, file_stat.st_size, PROT_READ | PROT_WRITE,
+                MAP_SHARED, fd, 0);
+  }
+  close(fd);
+  if (data == MAP_FAILED) {
+    return false;
+  }
+  data_ = static_cast<uint8_t*>(data);
+  size_ = file_stat.st_size;
+  const ServerHeader* header = reinterpret_cast<const ServerHeader*>(data_);
+  if (header->status.load(std::memory_order_acquire) != kServing ||
+      std::memcmp(header->magic, kMagic, sizeof(kMagic)) != 0 ||
+      header->version != kFormatVersion ||
+      header->shards_offset + header->num_shards * header->shard_size >
+          size_ ||
+      shard >= header->num_shards) {
+    Disconnect();
+    return false;
+  }
+  const int begin = shard < 0 ? 0 : shard;
+  const int end = shard < 0 ? header->num_shards : shard + 1;
+  const uint32_t pid = getpid();
+  bool taken_over = false;
+  for (int s = begin; s < end && shard_ < 0; ++s) {
+    std::atomic<uint32_t>& client_pid = GetShard(data_, s)->client_pid;
+    uint32_t owner = 0;
+    if (client_pid.compare_exchange_strong(owner, pid,
+                                           std::memory_order_acquire)) {
+      shard_ = s;
+    } else if (owner != pid && ProcessIsGone(owner) &&
+               client_pid.compare_exchange_strong(
+                   owner, pid, std::memory_order_acquire)) {
+      shard_ = s;
+      taken_over = true;
+    }
+  }
+  if (shard_ < 0) {
+    Disconnect();
+    return false;
+  }
+  requests_ = RequestRing(data_, shard_);
+  responses_ = ResponseRing(data_, shard_);
+  if (taken_over) {
+    // Lets the server answer any request left by the previous client, and
+    // drops the responses it held or never read.
+    const SpscRingIndices& indices = GetShard(data_, shard_)->requests;
+    SpscBackoff backoff;
+    while (indices.committed.load(std::memory_order_relaxed) !=
+               indices.released.load(std::memory_order_acquire) &&
+           !ServerStopped()) {
+      backoff.Wait();
+    }
+    while (responses_.Readable() > 0) {
+      responses_.Release();
+    }
+  }
+  return true;
+}
+
+void HanabiEnvClient::Disconnect() {
+  if (data_ == nullptr) {
+    return;
+  }
+  if (shard_ >= 0) {
+    if (holds_response_) {
+      responses_.Release();
+    }
+    GetShard(data_, shard_)->client_pid.store(0, std::memory_order_release);
+  }
+  munmap(data_, size_);
+  data_ = nullptr;
+  size_ = 0;
+  shard_ = -1;
+  requests_ = SpscRing();
+  responses_ = SpscRing();
+  holds_response_ = false;
+}
+
+int HanabiEnvClient::NumEnvs() const {
+  REQUIRE(Connected());
+  return reinterpret_cast<const ServerHeader*>(data_)->envs_per_shard;
+}
+
+int HanabiEnvClient::ObservationLength() const {
+  REQUIRE(Connected());
+  return reinterpret_cast<const ServerHeader*>(data_)->observation_length;
+}
+
+int HanabiEnvClient::PackedObservationLength() const {
+  REQUIRE(Connected());
+  return reinterpret_cast<const ServerHeader*>(data_)
+      ->packed_observation_length;
+}
+
+int HanabiEnvClient::NumMoves() const {
+  REQUIRE(Connected());
+  return reinterpret_cast<const ServerHeader*>(data_)->num_moves;
+}
+
+std::unordered_map<std::string, std::string> HanabiEnvClient::Parameters()
+    const {
+  REQUIRE(Connected());
+  const ServerHeader* header = reinterpret_cast<const ServerHeader*>(data_);
+  const std::string text(
+      reinterpret_cast<const char*>(data_ + sizeof(ServerHeader)),
+      header->parameters_size);
+  std::unordered_map<std::string, std::string> params;
+  size_t begin = 0;
+  while (begin < text.size()) {
+    const size_t end = text.find('\n', begin);
+    REQUIRE(end != std::string::npos);
+    const size_t equals = text.find('=', begin);
+    REQUIRE(equals != std::string::npos && equals < end);
+    params[text.substr(begin, equals - begin)] =
+        text.substr(equals + 1, end - equals - 1);
+    begin = end + 1;
+  }
+  return params;
+}
+
+HanabiEnvClient::Status HanabiEnvClient::Reset() {
+  return Request(kCommandReset, nullptr);
+}
+
+HanabiEnvClient::Status HanabiEnvClient::Step(const int* move_uids) {
+  REQUIRE(move_uids != nullptr);
+  return Request(kCommandStep, move_uids);
+}
+
+HanabiEnvClient::Status HanabiEnvClient::Request(int command,
+                                                 const int* move_uids) {
+  REQUIRE(Connected());
+  SpscBackoff backoff;
+  uint8_t* slot;
+  while ((slot = requests_.WriteSlot()) == nullptr) {
+    if (ServerStopped()) {
+      return kServerStopped;
+    }
+    backoff.Wait();
+  }
+  int32_t* request = reinterpret_cast<int32_t*>(slot);
+  request[0] = command;
+  if (move_uids != nullptr) {
+    std::copy(move_uids, move_uids + NumEnvs(), request + 1);
+  }
+  requests_.Commit();
+
+  // The new response follows the one the client holds, if any.
+  const int index = holds_response_ ? 1 : 0;
+  backoff.Reset();
+  while (responses_.Readable() <= index) {
+    if (ServerStopped()) {
+      return kServerStopped;
+    }
+    backoff.Wait();
+  }
+  const Status status = static_cast<Status>(
+      *reinterpret_cast<const int32_t*>(responses_.ReadSlot(index)));
+  // After an invalid request the new response repeats the held one, if any,
+  // and is held instead.
+  if (holds_response_ || status != kOk) {
+    responses_.Release();
+  }
+  holds_response_ = holds_response_ || status == kOk;
+  return status;
+}
+
+bool HanabiEnvClient::ServerStopped() const {
+  return reinterpret_cast<const ServerHeader*>(data_)->status.load(
+             std::memory_order_acquire) != kServing;
+}
+
+const uint8_t* HanabiEnvClient::Output(int section) const {
+  if (!holds_response_) {
+    return nullptr;
+  }
+  return responses_.ReadSlot() +
+         reinterpret_cast<const ServerHeader*>(data_)->section_offsets[section];
+}
+
+const uint8_t* HanabiEnvClient::Observations() const {
+  return ObservationLength() > 0 ? Output(kObservations) : nullptr;
+}
+
+const uint64_t* HanabiEnvClient::PackedObservations() const {
+  return PackedObservationLength() > 0
+             ? reinterpret_cast<const uint64_t*>(Output(kObservations))
+             : nullptr;
+}
+
+const uint8_t* HanabiEnvClient::LegalMoves() const {
+  return Output(kLegalMoves);
+}
+
+const float* HanabiEnvClient::Rewards() const {
+  return reinterpret_cast<const float*>(Output(kRewards));
+}
+
+const uint8_t* HanabiEnvClient::Dones() const { return Output(kDones); }
+
+const int* HanabiEnvClient::CurrentPlayers() const {
+  return reinterpret_cast<const int*>(Output(kCurrentPlayers));
+}
+
+}  // namespace hanabi_learning_env
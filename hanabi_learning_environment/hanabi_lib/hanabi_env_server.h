@@ -0,0 +1,158 @@
+// Copyright 2018 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Serves shards of HanabiVectorEnv games to clients in other processes
+// through POSIX shared memory, for actors that run apart from the process
+// simulating the games.
+//
+// The server creates one shared memory object holding, for each shard, a
+// ring of requests (a reset or one move uid per game) and a ring of
+// responses (the outputs of HanabiVectorEnvOutput), both single-producer
+// single-consumer rings of spsc_ring.h. Each shard is stepped by its own
+// server thread and used by one client at a time. The server steps its
+// games directly into the response slots, and clients read them in place,
+// so observations are never copied or serialized on the way.
+
+#ifndef __HANABI_ENV_SERVER_H__
+#define __HANABI_ENV_SERVER_H__
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "hanabi_game.h"
+#include "hanabi_vector_env.h"
+#include "spsc_ring.h"
+
+namespace hanabi_learning_env {
+
+struct HanabiEnvServerConfig {
+  // Name of the shared memory object, e.g. "/hanabi". A leading '/' is
+  // added if missing. An existing object of the name is replaced.
+  std::string name;
+  int num_shards = 1;
+  int envs_per_shard = 64;
+  // Threads stepping the games of each shard, as in HanabiVectorEnv.
+  int threads_per_shard = 1;
+  // Whether responses hold packed rather than uint8 observations.
+  bool packed_observations = false;
+  // Responses per shard, at least 2: the one a client is reading and the
+  // one being stepped into.
+  int ring_capacity = 2;
+};
+
+class HanabiEnvServer {
+ public:
+  // Creates the shared memory object and starts serving. parent_game must
+  // outlive the server. Shard s steps games s * envs_per_shard onwards of
+  // the game seed, so the shards together play the games of one
+  // HanabiVectorEnv of num_shards * envs_per_shard games.
+  HanabiEnvServer(HanabiGame* parent_game, const HanabiEnvServerConfig& config);
+  // Stops serving and removes the name; mapped clients see the server as
+  // stopped.
+  ~HanabiEnvServer();
+  HanabiEnvServer(const HanabiEnvServer&) = delete;
+  HanabiEnvServer& operator=(const HanabiEnvServer&) = delete;
+
+  const std::string& Name() const { return name_; }
+  int NumShards() const { return envs_.size(); }
+  // Total size of the shared memory object in bytes.
+  int64_t Size() const { return size_; }
+
+ private:
+  void ServeShard(int shard);
+
+  std::string name_;
+  uint8_t* data_ = nullptr;
+  int64_t size_ = 0;
+  std::vector<std::unique_ptr<HanabiVectorEnv>> envs_;
+  std::vector<std::thread> threads_;
+  std::atomic<bool> stop_;
+};
+
+// One shard of a HanabiEnvServer, used from any process. Not safe to use
+// from several threads at once.
+class HanabiEnvClient {
+ public:
+  enum Status {
+    kOk = 0,
+    // The server is gone; the client must be connected again.
+    kServerStopped,
+    // A move uid was not legal in its game. Nothing was applied, and the
+    // outputs are those of the previous request.
+    kInvalidRequest,
+  };
+
+  HanabiEnvClient() = default;
+  // Disconnects.
+  ~HanabiEnvClient();
+  HanabiEnvClient(const HanabiEnvClient&) = delete;
+  HanabiEnvClient& operator=(const HanabiEnvClient&) = delete;
+
+  // Maps the server's object of the name and takes shard for this client,
+  // or the first free shard if shard < 0. A shard whose client process has
+  // exited without disconnecting is free. Returns false, connected to
+  // nothing, if no server serves the name or the shard is taken.
+  bool Connect(const std::string& name, int shard = -1);
+  void Disconnect();
+  bool Connected() const { return data_ != nullptr; }
+
+  int Shard() const { return shard_; }
+  int NumEnvs() const;
+  // Entries per game of Observations(), zero if the server packs them.
+  int ObservationLength() const;
+  // Words per game of PackedObservations(), zero unless the server packs
+  // them.
+  int PackedObservationLength() const;
+  int NumMoves() const;
+  // The parameters of the served game.
+  std::unordered_map<std::string, std::string> Parameters() const;
+
+  // Starts a new game in every slot of the shard.
+  Status Reset();
+  // Applies move_uids[i] for the acting player of game i, as
+  // HanabiVectorEnv::Step.
+  Status Step(const int* move_uids);
+
+  // Outputs of the last successful request, laid out as in
+  // HanabiVectorEnvOutput, in shared memory. Valid until the next request.
+  // Null before the first request.
+  const uint8_t* Observations() const;
+  const uint64_t* PackedObservations() const;
+  const uint8_t* LegalMoves() const;
+  const float* Rewards() const;
+  const uint8_t* Dones() const;
+  const int* CurrentPlayers() const;
+
+ private:
+  Status Request(int command, const int* move_uids);
+  bool ServerStopped() const;
+  const uint8_t* Output(int section) const;
+
+  uint8_t* data_ = nullptr;
+  int64_t size_ = 0;
+  int shard_ = -1;
+  SpscRing requests_;
+  SpscRing responses_;
+  // Whether the client holds the oldest response, the current outputs.
+  bool holds_response_ = false;
+};
+
+}  // namespace hanabi_learning_env
+
+#endif
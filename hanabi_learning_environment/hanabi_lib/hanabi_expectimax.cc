@@ -0,0 +1,148 @@
+// Copyright 2018 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "hanabi_expectimax.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <random>
+#include <tuple>
+
+#include "thread_pool.h"
+
+namespace hanabi_learning_env {
+
+namespace {
+
+double Value(HanabiState* state, int depth, const HanabiPolicy* policy,
+             std::mt19937* rng);
+
+// The value of applying move, a player move or a chance outcome, at state
+// with depth player moves left counting move.
+double MoveValue(HanabiState* state, HanabiMove move, int depth,
+                 const HanabiPolicy* policy, std::mt19937* rng) {
+  HanabiUndoRecord undo;
+  state->ApplyMove(move, &undo);
+  const double value =
+      Value(state, move.MoveType() == HanabiMove::kDeal ? depth : depth - 1,
+            policy, rng);
+  state->UndoMove(undo);
+  return value;
+}
+
+double Value(HanabiState* state, int depth, const HanabiPolicy* policy,
+             std::mt19937* rng) {
+  // Pending deals do not change the score.
+  if (depth == 0 || state->IsTerminal()) {
+    return state->Score();
+  }
+  if (state->CurPlayer() == kChancePlayerId) {
+    double value = 0;
+    ForEachChanceOutcome(state, [&](HanabiMove /*outcome*/, double probability) {
+      value += probability * Value(state, depth, policy, rng);
+    });
+    return value;
+  }
+  if (policy != nullptr) {
+    return MoveValue(state, policy->Act(*state, rng), depth, policy, rng);
+  }
+  const HanabiGame& game = *state->ParentGame();
+  double best = 0;
+  for (uint64_t mask = state->LegalMoveMask(state->CurPlayer()); mask != 0;
+       mask &= mask - 1) {
+    best = std::max(best, MoveValue(state, game.GetMove(__builtin_ctzll(mask)),
+                                    depth, policy, rng));
+  }
+  return best;
+}
+
+// The legal moves of the acting player at state, in uid order.
+std::vector<HanabiMove> PlayerMoves(const HanabiState& state) {
+  std::vector<HanabiMove> moves;
+  for (uint64_t mask = state.LegalMoveMask(state.CurPlayer()); mask != 0;
+       mask &= mask - 1) {
+    moves.push_back(state.ParentGame()->GetMove(__builtin_ctzll(mask)));
+  }
+  return moves;
+}
+
+// The MoveValue of each of moves at state, split across num_threads
+// threads with a copy of state each.
+std::vector<double> MoveValues(const HanabiState& state,
+                               const std::vector<HanabiMove>& moves, int depth,
+                               const HanabiPolicy* policy, int num_threads) {
+  std::vector<double> values(moves.size());
+  ThreadPool pool(num_threads);
+  pool.ParallelFor(moves.size(), [&](int begin, int end) {
+    HanabiState copy(state);
+    copy.SetRecordMoveHistory(false);
+    for (int i = begin; i < end; ++i) {
+      std::seed_seq seed{static_cast<unsigned>(state.ParentGame()->Seed()),
+                         static_cast<unsigned>(i)};
+      std::mt19937 rng(seed);
+      values[i] = MoveValue(&copy, moves[i], depth, policy, &rng);
+    }
+  });
+  return values;
+}
+
+}  // namespace
+
+double ExpectedValue(const HanabiState& state, int depth,
+                     const HanabiPolicy* policy, int num_threads) {
+  REQUIRE(depth >= 0);
+  if (depth == 0 || state.IsTerminal()) {
+    return state.Score();
+  }
+  if (state.CurPlayer() == kChancePlayerId) {
+    std::vector<HanabiMove> outcomes;
+    std::vector<double> probabilities;
+    std::tie(outcomes, probabilities) = state.ChanceOutcomes();
+    const std::vector<double> values =
+        MoveValues(state, outcomes, depth, policy, num_threads);
+    double value = 0;
+    for (int i = 0; i < static_cast<int>(values.size()); ++i) {
+      value += probabilities[i] * values[i];
+    }
+    return value;
+  }
+  if (policy != nullptr) {
+    // A single branch, as in MoveValues.
+    std::seed_seq seed{static_cast<unsigned>(state.ParentGame()->Seed()), 0u};
+    std::mt19937 rng(seed);
+    HanabiState copy(state);
+    copy.SetRecordMoveHistory(false);
+    return MoveValue(&copy, policy->Act(copy, &rng), depth, policy, &rng);
+  }
+  const std::vector<double> values =
+      MoveValues(state, PlayerMoves(state), depth, policy, num_threads);
+  return values.empty() ? 0 : *std::max_element(values.begin(), values.end());
+}
+
+std::vector<double> ExpectedMoveValues(const HanabiState& state, int depth,
+                                       const HanabiPolicy* policy,
+                                       int num_threads) {
+  REQUIRE(depth >= 1);
+  REQUIRE(state.CurPlayer() != kChancePlayerId && !state.IsTerminal());
+  const std::vector<HanabiMove> moves = PlayerMoves(state);
+  const std::vector<double> values =
+      MoveValues(state, moves, depth, policy, num_threads);
+  std::vector<double> move_values(state.ParentGame()->MaxMoves(), -1);
+  for (int i = 0; i < static_cast<int>(moves.size()); ++i) {
+    move_values[state.ParentGame()->GetMoveUid(moves[i])] = values[i];
+  }
+  return move_values;
+}
+
+}  // namespace hanabi_learning_env
@@ -0,0 +1,85 @@
+// Copyright 2018 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Exact expectations over chance nodes, for expectimax and for exact
+// short-horizon values of moves in analysis tools.
+//
+// Chance nodes branch once per distinct card (color, rank) left in the deck,
+// weighted by its count, rather than once per physical card. Outcomes are
+// applied to one state in place and undone, so no state is copied per
+// outcome and no outcome list is built.
+
+#ifndef __HANABI_EXPECTIMAX_H__
+#define __HANABI_EXPECTIMAX_H__
+
+#include <vector>
+
+#include "hanabi_game.h"
+#include "hanabi_move.h"
+#include "hanabi_playout.h"
+#include "hanabi_state.h"
+#include "util.h"
+
+namespace hanabi_learning_env {
+
+// Calls fn(outcome, probability) for every card the chance player can deal
+// at state, with *state advanced by the deal, and undoes the deal after each
+// call. The outcomes and probabilities are those of ChanceOutcomes(). fn may
+// apply further moves, but must undo them before returning.
+template <typename Fn>
+void ForEachChanceOutcome(HanabiState* state, const Fn& fn) {
+  REQUIRE(state != nullptr && state->CurPlayer() == kChancePlayerId);
+  const HanabiGame& game = *state->ParentGame();
+  const double deck_size = state->Deck().Size();
+  HanabiUndoRecord undo;
+  for (int uid = 0; uid < game.MaxChanceOutcomes(); ++uid) {
+    const HanabiMove outcome = game.GetChanceOutcome(uid);
+    const int count = state->Deck().CardCount(outcome.Color(), outcome.Rank());
+    if (count == 0) {
+      continue;
+    }
+    state->ApplyMove(outcome, &undo);
+    fn(outcome, count / deck_size);
+    state->UndoMove(undo);
+  }
+}
+
+// The expected Score() of state after depth more player moves, or at the end
+// of the game if sooner, over every deal of the deck. Player moves are
+// chosen by policy, or if it is null, maximize the expected score
+// (expectimax). The state is taken as it is, hidden cards included; average
+// over determinizations (see hanabi_determinization.h) for the value to a
+// player who cannot see them.
+//
+// The branches of the first node (its chance outcomes, or its legal moves
+// under expectimax) are split across num_threads threads (<= 0 uses all
+// hardware threads), each working on its own copy of state. Policies draw
+// from a generator seeded from the game seed and the index of the branch,
+// so results do not depend on num_threads.
+double ExpectedValue(const HanabiState& state, int depth,
+                     const HanabiPolicy* policy = nullptr,
+                     int num_threads = 1);
+
+// The ExpectedValue of applying each legal move of the acting player at
+// state and continuing for depth - 1 more player moves, indexed by move
+// uid, with -1 for illegal moves. state must not be at a chance node, and
+// depth must be at least 1. The moves are split across num_threads
+// threads.
+std::vector<double> ExpectedMoveValues(const HanabiState& state, int depth,
+                                       const HanabiPolicy* policy = nullptr,
+                                       int num_threads = 1);
+
+}  // namespace hanabi_learning_env
+
+#endif
@@ -14,6 +14,8 @@
 
 #include "hanabi_game.h"
 
+#include "hanabi_state.h"
+#include "static_game.h"
 #include "util.h"
 
 namespace hanabi_learning_env {
@@ -36,6 +38,7 @@ HanabiGame::HanabiGame(
   num_ranks_ = ParameterValue<int>(params_, "ranks", kMaxNumRanks);
   REQUIRE(num_ranks_ > 0 && num_ranks_ <= kMaxNumRanks);
   hand_size_ = ParameterValue<int>(params_, "hand_size", HandSizeFromRules());
+  REQUIRE(hand_size_ > 0 && hand_size_ <= kMaxHandSize);
   max_information_tokens_ = ParameterValue<int>(
       params_, "max_information_tokens", kInformationTokens);
   max_life_tokens_ =
@@ -56,6 +59,8 @@ HanabiGame::HanabiGame(
     cards_per_color_ += NumberCardInstances(0, rank);
   }
   REQUIRE(hand_size_ * num_players_ <= cards_per_color_ * num_colors_);
+  static_variant_ =
+      FindStaticGameVariant(num_colors_, num_ranks_, num_players_, hand_size_);
 
   // Build static list of moves.
   for (int uid = 0; uid < MaxMoves(); ++uid) {
@@ -64,8 +69,13 @@ HanabiGame::HanabiGame(
   for (int uid = 0; uid < MaxChanceOutcomes(); ++uid) {
     chance_outcomes_.push_back(ConstructChanceOutcome(uid));
   }
+  // An explicit start player, so that building the template does not draw
+  // from rng_.
+  initial_state_.reset(new HanabiState(this, /*start_player=*/0));
 }
 
+HanabiGame::~HanabiGame() = default;
+
 int HanabiGame::MaxMoves() const {
   return MaxDiscardMoves() + MaxPlayMoves() + MaxRevealColorMoves() +
          MaxRevealRankMoves();
@@ -106,9 +116,16 @@ int HanabiGame::GetChanceOutcomeUid(HanabiMove move) const {
 HanabiMove HanabiGame::PickRandomChance(
     const std::pair<std::vector<HanabiMove>, std::vector<double>>&
         chance_outcomes) const {
+  return PickRandomChance(chance_outcomes, &rng_);
+}
+
+HanabiMove HanabiGame::PickRandomChance(
+    const std::pair<std::vector<HanabiMove>, std::vector<double>>&
+        chance_outcomes,
+    std::mt19937* rng) const {
   std::discrete_distribution<std::mt19937::result_type> dist(
       chance_outcomes.second.begin(), chance_outcomes.second.end());
-  return chance_outcomes.first[dist(rng_)];
+  return chance_outcomes.first[dist(*rng)];
 }
 
 std::unordered_map<std::string, std::string> HanabiGame::Parameters() const {
@@ -136,10 +153,14 @@ int HanabiGame::NumberCardInstances(int color, int rank) const {
 }
 
 int HanabiGame::GetSampledStartPlayer() const {
+  return GetSampledStartPlayer(&rng_);
+}
+
+int HanabiGame::GetSampledStartPlayer(std::mt19937* rng) const {
   if (random_start_player_) {
     std::uniform_int_distribution<std::mt19937::result_type> dist(
         0, num_players_ - 1);
-    return dist(rng_);
+    return dist(*rng);
   }
   return 0;
 }
@@ -15,6 +15,7 @@
 #ifndef __HANABI_GAME_H__
 #define __HANABI_GAME_H__
 
+#include <memory>
 #include <random>
 #include <string>
 #include <unordered_map>
@@ -22,9 +23,12 @@
 
 #include "hanabi_card.h"
 #include "hanabi_move.h"
+#include "util.h"
 
 namespace hanabi_learning_env {
 
+class HanabiState;
+
 class HanabiGame {
  public:
   // An agent's observation of a state does include all state knowledge.
@@ -56,6 +60,10 @@ class HanabiGame {
   //     Value must be one of AgentObservationType defined above.
   explicit HanabiGame(
       const std::unordered_map<std::string, std::string>& params);
+  // States point to their game, so games stay where they were created.
+  HanabiGame(const HanabiGame&) = delete;
+  HanabiGame& operator=(const HanabiGame&) = delete;
+  ~HanabiGame();
 
   // Number of different player moves.
   int MaxMoves() const;
@@ -76,10 +84,16 @@ class HanabiGame {
   HanabiMove PickRandomChance(
       const std::pair<std::vector<HanabiMove>, std::vector<double>>&
           chance_outcomes) const;
+  // As above, but draws from rng instead of the game's shared generator, so
+  // that states of one game can be dealt concurrently.
+  HanabiMove PickRandomChance(
+      const std::pair<std::vector<HanabiMove>, std::vector<double>>&
+          chance_outcomes,
+      std::mt19937* rng) const;
 
   std::unordered_map<std::string, std::string> Parameters() const;
   int MinPlayers() const { return 2; }
-  int MaxPlayers() const { return 5; }
+  int MaxPlayers() const { return kMaxPlayers; }
   int MinScore() const { return 0; }
   int MaxScore() const { return num_ranks_ * num_colors_; }
   std::string Name() const { return "Hanabi"; }
@@ -97,9 +111,22 @@ class HanabiGame {
     return NumberCardInstances(card.Color(), card.Rank());
   }
   AgentObservationType ObservationType() const { return observation_type_; }
+  // The StaticGameVariant of static_game.h matching the game's dimensions,
+  // for code that dispatches to compile-time specialized variants.
+  int StaticVariant() const { return static_variant_; }
 
   // Get the first player to act. Might be randomly generated at each call.
   int GetSampledStartPlayer() const;
+  int GetSampledStartPlayer(std::mt19937* rng) const;
+  // Seed of the game's generator, after resolving the default of -1.
+  int Seed() const { return seed_; }
+  // The game's shared generator, used when no generator is passed
+  // explicitly. Not safe to use from several threads.
+  std::mt19937* Rng() const { return &rng_; }
+  // The state every game starts from, before the opening deal, built once
+  // with the game so that HanabiState::Reset copies it instead of
+  // constructing the deck and hands again. Its start player is 0.
+  const HanabiState& InitialStateTemplate() const { return *initial_state_; }
 
  private:
   // Calculating max moves by move type.
@@ -127,7 +154,9 @@ class HanabiGame {
   int seed_ = -1;
   bool random_start_player_ = false;
   AgentObservationType observation_type_ = kCardKnowledge;
+  int static_variant_ = 0;
   mutable std::mt19937 rng_;
+  std::unique_ptr<HanabiState> initial_state_;
 };
 
 }  // namespace hanabi_learning_env
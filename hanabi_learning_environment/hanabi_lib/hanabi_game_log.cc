@@ -0,0 +1,316 @@
+// Copyright 2018 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "hanabi_game_log.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cstring>
+#include <unordered_map>
+#include <utility>
+
+#include "util.h"
+
+namespace hanabi_learning_env {
+
+namespace {
+
+constexpr char kMagic[8] = {'H', 'L', 'E', 'G', 'L', 'O', 'G', '\0'};
+constexpr uint32_t kFormatVersion = 1;
+constexpr int kFileHeaderSize = sizeof(kMagic) + 2 * sizeof(uint32_t);
+// Seed, number of moves and start player.
+constexpr int kRecordHeaderSize = 8 + 2 + 1;
+constexpr int kMaxMovesPerGame = 0xffff;
+
+void PutUint(uint64_t value, int num_bytes, std::vector<uint8_t>* bytes) {
+  for (int i = 0; i < num_bytes; ++i) {
+    bytes->push_back(static_cast<uint8_t>(value >> (8 * i)));
+  }
+}
+
+uint64_t GetUint(const uint8_t* bytes, int num_bytes) {
+  uint64_t value = 0;
+  for (int i = 0; i < num_bytes; ++i) {
+    value |= static_cast<uint64_t>(bytes[i]) << (8 * i);
+  }
+  return value;
+}
+
+std::string SerializeParameters(const HanabiGame& game) {
+  const std::unordered_map<std::string, std::string> params =
+      game.Parameters();
+  std::vector<std::pair<std::string, std::string>> sorted(params.begin(),
+                                                          params.end());
+  std::sort(sorted.begin(), sorted.end());
+  std::string text;
+  for (const auto& param : sorted) {
+    text += param.first + "=" + param.second + "\n";
+  }
+  return text;
+}
+
+std::unordered_map<std::string, std::string> ParseParameters(
+    const std::string& text) {
+  std::unordered_map<std::string, std::string> params;
+  size_t begin = 0;
+  while (begin < text.size()) {
+    size_t end = text.find('\n', begin);
+    REQUIRE(end != std::string::npos);
+    const size_t equals = text.find('=', begin);
+    REQUIRE(equals != std::string::npos && equals < end);
+    params[text.substr(begin, equals - begin)] =
+        text.substr(equals + 1, end - equals - 1);
+    begin = end + 1;
+  }
+  return params;
+}
+
+// The player who acts first in the game of state: the player of its first
+// player move, or if it has none, the player to act once the opening hands
+// are dealt.
+int StartPlayer(const HanabiState& state,
+                const std::vector<HanabiHistoryItem>& moves) {
+  for (const HanabiHistoryItem& item : moves) {
+    if (item.player != kChancePlayerId) {
+      return item.player;
+    }
+  }
+  return state.CurPlayer() != kChancePlayerId ? state.CurPlayer()
+                                              : state.NextNonChancePlayer();
+}
+
+}  // namespace
+
+constexpr uint8_t HanabiGameLogWriter::kDealFlag;
+
+HanabiGameLogWriter::HanabiGameLogWriter(const std::string& path,
+                                         const HanabiGame& game)
+    : game_(game) {
+  REQUIRE(game.MaxMoves() < kDealFlag && game.MaxChanceOutcomes() < kDealFlag);
+  file_ = std::fopen(path.c_str(), "wb");
+  REQUIRE(file_ != nullptr);
+  const std::string params = SerializeParameters(game);
+  std::vector<uint8_t> header(kMagic, kMagic + sizeof(kMagic));
+  PutUint(kFormatVersion, 4, &header);
+  PutUint(params.size(), 4, &header);
+  header.insert(header.end(), params.begin(), params.end());
+  REQUIRE(std::fwrite(header.data(), 1, header.size(), file_) ==
+          header.size());
+}
+
+HanabiGameLogWriter::~HanabiGameLogWriter() {
+  if (file_ != nullptr) {
+    Close();
+  }
+}
+
+uint8_t HanabiGameLogWriter::EncodeMove(const HanabiHistoryItem& item) const {
+  if (item.move.MoveType() == HanabiMove::kDeal) {
+    return kDealFlag | game_.GetChanceOutcomeUid(item.move);
+  }
+  return game_.GetMoveUid(item.move);
+}
+
+void HanabiGameLogWriter::WriteRecord(uint64_t seed, int start_player,
+                                      const std::vector<uint8_t>& moves) {
+  REQUIRE(file_ != nullptr);
+  REQUIRE(static_cast<int>(moves.size()) <= kMaxMovesPerGame);
+  uint8_t header[kRecordHeaderSize];
+  for (int i = 0; i < 8; ++i) {
+    header[i] = static_cast<uint8_t>(seed >> (8 * i));
+  }
+  header[8] = static_cast<uint8_t>(moves.size());
+  header[9] = static_cast<uint8_t>(moves.size() >> 8);
+  header[10] = static_cast<uint8_t>(start_player);
+  REQUIRE(std::fwrite(header, 1, sizeof(header), file_) == sizeof(header));
+  REQUIRE(std::fwrite(moves.data(), 1, moves.size(), file_) == moves.size());
+  ++num_games_;
+}
+
+void HanabiGameLogWriter::WriteGame(const HanabiState& state, uint64_t seed) {
+  const std::vector<HanabiHistoryItem>& history = state.MoveHistory();
+  REQUIRE(state.RecordsMoveHistory() &&
+          static_cast<int>(history.size()) == state.MoveCount());
+  std::vector<uint8_t> moves;
+  moves.reserve(history.size());
+  for (const HanabiHistoryItem& item : history) {
+    moves.push_back(EncodeMove(item));
+  }
+  WriteRecord(seed, StartPlayer(state, history), moves);
+}
+
+void HanabiGameLogWriter::OnMove(const HanabiState& state,
+                                 const HanabiHistoryItem& item) {
+  if (state.MoveCount() == 1) {
+    // The state starts a new game, possibly leaving one unfinished.
+    if (in_game_) {
+      EndGame();
+    }
+    in_game_ = true;
+    seed_ = next_seed_;
+    next_seed_ = 0;
+    start_player_ = StartPlayer(state, {item});
+  }
+  if (!in_game_) {
+    // The writer started listening in the middle of a game.
+    return;
+  }
+  moves_.push_back(EncodeMove(item));
+  if (state.IsTerminal()) {
+    EndGame();
+  }
+}
+
+void HanabiGameLogWriter::EndGame() {
+  WriteRecord(seed_, start_player_, moves_);
+  in_game_ = false;
+  moves_.clear();
+}
+
+void HanabiGameLogWriter::Flush() {
+  REQUIRE(file_ != nullptr);
+  if (in_game_) {
+    EndGame();
+  }
+  REQUIRE(std::fflush(file_) == 0);
+}
+
+void HanabiGameLogWriter::Close() {
+  Flush();
+  REQUIRE(std::fclose(file_) == 0);
+  file_ = nullptr;
+}
+
+HanabiGameLogReader::HanabiGameLogReader(const std::string& path) {
+  const int fd = open(path.c_str(), O_RDONLY);
+  REQUIRE(fd >= 0);
+  struct stat file_stat;
+  REQUIRE(fstat(fd, &file_stat) == 0);
+  size_ = file_stat.st_size;
+  REQUIRE(size_ >= kFileHeaderSize);
+  void* data = mmap(nullptr, size_, PROT_READ, MAP_SHARED, fd, 0);
+  close(fd);
+  REQUIRE(data != MAP_FAILED);
+  data_ = static_cast<const uint8_t*>(data);
+
+  REQUIRE(std::memcmp(data_, kMagic, sizeof(kMagic)) == 0);
+  REQUIRE(GetUint(data_ + sizeof(kMagic), 4) == kFormatVersion);
+  const int64_t params_size = GetUint(data_ + sizeof(kMagic) + 4, 4);
+  REQUIRE(kFileHeaderSize + params_size <= size_);
+  game_.reset(new HanabiGame(ParseParameters(std::string(
+      reinterpret_cast<const char*>(data_ + kFileHeaderSize), params_size))));
+
+  int64_t offset = kFileHeaderSize + params_size;
+  while (offset < size_) {
+    REQUIRE(offset + kRecordHeaderSize <= size_);
+    offsets_.push_back(offset);
+    offset += kRecordHeaderSize + GetUint(data_ + offset + 8, 2);
+  }
+  REQUIRE(offset == size_);
+}
+
+HanabiGameLogReader::~HanabiGameLogReader() {
+  munmap(const_cast<uint8_t*>(data_), size_);
+}
+
+const uint8_t* HanabiGameLogReader::Record(int game) const {
+  REQUIRE(game >= 0 && game < static_cast<int>(offsets_.size()));
+  return data_ + offsets_[game];
+}
+
+uint64_t HanabiGameLogReader::Seed(int game) const {
+  return GetUint(Record(game), 8);
+}
+
+int HanabiGameLogReader::StartPlayer(int game) const {
+  return static_cast<int8_t>(Record(game)[10]);
+}
+
+int HanabiGameLogReader::NumMoves(int game) const {
+  return GetUint(Record(game) + 8, 2);
+}
+
+int HanabiGameLogReader::NumPlayerMoves(int game) const {
+  const uint8_t* moves = Record(game) + kRecordHeaderSize;
+  const int num_moves = NumMoves(game);
+  int num_player_moves = 0;
+  for (int i = 0; i < num_moves; ++i) {
+    if ((moves[i] & HanabiGameLogWriter::kDealFlag) == 0) {
+      ++num_player_moves;
+    }
+  }
+  return num_player_moves;
+}
+
+HanabiMove HanabiGameLogReader::Move(int game, int index) const {
+  REQUIRE(index >= 0 && index < NumMoves(game));
+  const uint8_t code = Record(game)[kRecordHeaderSize + index];
+  if (code & HanabiGameLogWriter::kDealFlag) {
+    return game_->GetChanceOutcome(code & ~HanabiGameLogWriter::kDealFlag);
+  }
+  return game_->GetMove(code);
+}
+
+bool HanabiGameLogReader::IsCompatible(const HanabiGame& game) const {
+  return game.NumPlayers() == game_->NumPlayers() &&
+         game.NumColors() == game_->NumColors() &&
+         game.NumRanks() == game_->NumRanks() &&
+         game.HandSize() == game_->HandSize() &&
+         game.MaxInformationTokens() == game_->MaxInformationTokens() &&
+         game.MaxLifeTokens() == game_->MaxLifeTokens() &&
+         game.ObservationType() == game_->ObservationType();
+}
+
+void HanabiGameLogReader::Replay(int game, int num_moves,
+                                 HanabiState* state) const {
+  REQUIRE(state != nullptr && IsCompatible(*state->ParentGame()));
+  REQUIRE(num_moves >= 0 && num_moves <= NumMoves(game));
+  state->Reset(StartPlayer(game));
+  for (int i = 0; i < num_moves; ++i) {
+    state->ApplyMove(Move(game, i));
+  }
+}
+
+int HanabiGameLogReader::EncodeGame(int game,
+                                    const CanonicalObservationEncoder& encoder,
+                                    uint8_t* observations,
+                                    int* move_uids) const {
+  HanabiState state(game_.get(), StartPlayer(game));
+  state.SetRecordMoveHistory(false);
+  const uint8_t* moves = Record(game) + kRecordHeaderSize;
+  const int num_moves = NumMoves(game);
+  const int size = encoder.Size();
+  int step = 0;
+  for (int i = 0; i < num_moves; ++i) {
+    if ((moves[i] & HanabiGameLogWriter::kDealFlag) == 0) {
+      if (observations != nullptr) {
+        encoder.EncodeStateInto(state, state.CurPlayer(),
+                                observations + static_cast<int64_t>(step) *
+                                                   size);
+      }
+      if (move_uids != nullptr) {
+        move_uids[step] = moves[i];
+      }
+      ++step;
+    }
+    state.ApplyMove(Move(game, i));
+  }
+  return step;
+}
+
+}  // namespace hanabi_learning_env
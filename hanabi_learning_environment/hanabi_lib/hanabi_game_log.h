@@ -0,0 +1,143 @@
+// Copyright 2018 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// A compact binary log of games, one byte per move, for archiving self-play
+// and regenerating observations from the moves rather than storing them.
+//
+// A log file holds games of a single HanabiGame. All integers are
+// little-endian.
+//   File header: the magic "HLEGLOG\0", the uint32 format version, the
+//     uint32 length of the game parameters, then the parameters of
+//     HanabiGame::Parameters() as "key=value\n" lines sorted by key.
+//   Each game: the uint64 seed given by the writer (0 if none), the uint16
+//     number of moves, the int8 start player, then one byte per move: the
+//     move uid of a player move, or kDealFlag | the chance outcome uid of a
+//     deal.
+// Everything else about a move (the card played, whether it scored, the
+// cards a hint revealed) is recomputed by replaying it.
+
+#ifndef __HANABI_GAME_LOG_H__
+#define __HANABI_GAME_LOG_H__
+
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "canonical_encoders.h"
+#include "hanabi_game.h"
+#include "hanabi_history_item.h"
+#include "hanabi_move.h"
+#include "hanabi_state.h"
+
+namespace hanabi_learning_env {
+
+// Appends games to a new log file. Games are either written whole from a
+// state's move history, or streamed as the moves are applied to a state the
+// writer listens to: a game starts with the first move of a state and is
+// written once it is terminal, or once the state starts another game, or
+// when the writer is closed. Not thread-safe; use one writer per thread.
+class HanabiGameLogWriter : public HanabiMoveListener {
+ public:
+  static constexpr uint8_t kDealFlag = 0x80;
+
+  // Creates or truncates the file at path and writes the header for game.
+  HanabiGameLogWriter(const std::string& path, const HanabiGame& game);
+  HanabiGameLogWriter(const HanabiGameLogWriter&) = delete;
+  HanabiGameLogWriter& operator=(const HanabiGameLogWriter&) = delete;
+  // Closes the file.
+  ~HanabiGameLogWriter() override;
+
+  // Writes the game of state, which must have recorded its move history
+  // since its first move. The game need not be finished.
+  void WriteGame(const HanabiState& state, uint64_t seed = 0);
+  // Sets the seed recorded for the next game that starts while listening,
+  // e.g. the seed of the generator dealing it.
+  void SetNextSeed(uint64_t seed) { next_seed_ = seed; }
+  // Listener interface: logs item as a move of the game of state.
+  void OnMove(const HanabiState& state, const HanabiHistoryItem& item) override;
+
+  // Number of games written so far.
+  int64_t NumGames() const { return num_games_; }
+  // Writes the game being listened to, if any, and flushes the file.
+  void Flush();
+  // Flushes and closes the file. Nothing may be logged afterwards.
+  void Close();
+
+ private:
+  uint8_t EncodeMove(const HanabiHistoryItem& item) const;
+  void WriteRecord(uint64_t seed, int start_player,
+                   const std::vector<uint8_t>& moves);
+  void EndGame();
+
+  const HanabiGame& game_;
+  std::FILE* file_ = nullptr;
+  int64_t num_games_ = 0;
+  // The game being listened to: whether one has started, and its seed,
+  // start player and moves so far.
+  bool in_game_ = false;
+  uint64_t next_seed_ = 0;
+  uint64_t seed_ = 0;
+  int start_player_ = -1;
+  std::vector<uint8_t> moves_;
+};
+
+// Reads a log file in place through a read-only memory mapping, and replays
+// its games. All methods are const and safe to call from several threads.
+class HanabiGameLogReader {
+ public:
+  explicit HanabiGameLogReader(const std::string& path);
+  HanabiGameLogReader(const HanabiGameLogReader&) = delete;
+  HanabiGameLogReader& operator=(const HanabiGameLogReader&) = delete;
+  ~HanabiGameLogReader();
+
+  // The game of the log's parameters, owned by the reader. Replayed states
+  // may have this or any game of the same parameters as parent.
+  HanabiGame* ParentGame() const { return game_.get(); }
+  int NumGames() const { return offsets_.size(); }
+  uint64_t Seed(int game) const;
+  int StartPlayer(int game) const;
+  // Number of moves of game, including deals.
+  int NumMoves(int game) const;
+  // Number of player moves of game.
+  int NumPlayerMoves(int game) const;
+  // The index-th move of game, a deal or a player move.
+  HanabiMove Move(int game, int index) const;
+
+  // Sets *state to game after its first num_moves moves. state keeps
+  // whether it records its move history.
+  void Replay(int game, int num_moves, HanabiState* state) const;
+  // Replays game and writes, for each of its player moves in order, the
+  // encoding of the acting player's observation before the move to
+  // observations, [NumPlayerMoves(game), encoder.Size()], and the move's uid
+  // to move_uids, [NumPlayerMoves(game)]. Either may be null. encoder is for
+  // a game with the log's parameters. Returns NumPlayerMoves(game).
+  int EncodeGame(int game, const CanonicalObservationEncoder& encoder,
+                 uint8_t* observations, int* move_uids) const;
+
+ private:
+  const uint8_t* Record(int game) const;
+  bool IsCompatible(const HanabiGame& game) const;
+
+  const uint8_t* data_ = nullptr;
+  int64_t size_ = 0;
+  std::unique_ptr<HanabiGame> game_;
+  // Offset of each game record in the file.
+  std::vector<int64_t> offsets_;
+};
+
+}  // namespace hanabi_learning_env
+
+#endif
@@ -21,24 +21,27 @@
 
 namespace hanabi_learning_env {
 
+constexpr int HanabiHand::ValueKnowledge::kMaxValueRange;
+
 HanabiHand::ValueKnowledge::ValueKnowledge(int value_range)
-    : value_(-1), value_plausible_(std::max(value_range, 0), true) {
-  assert(value_range > 0);
+    : value_(-1),
+      range_(std::max(value_range, 0)),
+      plausible_((1u << range_) - 1) {
+  assert(value_range > 0 && value_range <= kMaxValueRange);
 }
 
 void HanabiHand::ValueKnowledge::ApplyIsValueHint(int value) {
-  assert(value >= 0 && value < value_plausible_.size());
+  assert(value >= 0 && value < range_);
   assert(value_ < 0 || value_ == value);
-  assert(value_plausible_[value] == true);
+  assert(IsPlausible(value));
   value_ = value;
-  std::fill(value_plausible_.begin(), value_plausible_.end(), false);
-  value_plausible_[value] = true;
+  plausible_ = static_cast<uint8_t>(1) << value;
 }
 
 void HanabiHand::ValueKnowledge::ApplyIsNotValueHint(int value) {
-  assert(value >= 0 && value < value_plausible_.size());
+  assert(value >= 0 && value < range_);
   assert(value_ < 0 || value_ != value);
-  value_plausible_[value] = false;
+  plausible_ &= ~(static_cast<uint8_t>(1) << value);
 }
 
 HanabiHand::CardKnowledge::CardKnowledge(int num_colors, int num_ranks)
@@ -84,8 +87,8 @@ void HanabiHand::AddCard(HanabiCard card,
   card_knowledge_.push_back(initial_knowledge);
 }
 
-void HanabiHand::RemoveFromHand(int card_index,
-                                std::vector<HanabiCard>* discard_pile) {
+void HanabiHand::RemoveFromHand(
+    int card_index, FixedVector<HanabiCard, kMaxDeckSize>* discard_pile) {
   if (discard_pile != nullptr) {
     discard_pile->push_back(cards_[card_index]);
   }
@@ -93,6 +96,14 @@ void HanabiHand::RemoveFromHand(int card_index,
   card_knowledge_.erase(card_knowledge_.begin() + card_index);
 }
 
+void HanabiHand::InsertCard(int card_index, HanabiCard card,
+                            const CardKnowledge& knowledge) {
+  REQUIRE(card_index >= 0 && card_index <= cards_.size());
+  REQUIRE(card.IsValid());
+  cards_.insert(cards_.begin() + card_index, card);
+  card_knowledge_.insert(card_knowledge_.begin() + card_index, knowledge);
+}
+
 void HanabiHand::Clear() {
   cards_.clear();
   card_knowledge_.clear();
@@ -137,6 +148,17 @@ void HanabiHand::SetCard(int index, HanabiCard card, const CardKnowledge& initia
   card_knowledge_[index] = initial_knowledge;
 }
 
+void HanabiHand::SetCard(int index, HanabiCard card) {
+  REQUIRE(index >= 0 && index < cards_.size());
+  REQUIRE(card.IsValid());
+  cards_[index] = card;
+}
+
+void HanabiHand::SetKnowledge(int index, const CardKnowledge& knowledge) {
+  REQUIRE(index >= 0 && index < card_knowledge_.size());
+  card_knowledge_[index] = knowledge;
+}
+
 std::string HanabiHand::ToString() const {
   std::string result;
   assert(cards_.size() == card_knowledge_.size());
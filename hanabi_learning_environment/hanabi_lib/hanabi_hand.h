@@ -19,7 +19,9 @@
 #include <string>
 #include <vector>
 
+#include "fixed_vector.h"
 #include "hanabi_card.h"
+#include "util.h"
 
 namespace hanabi_learning_env {
 
@@ -36,15 +38,21 @@ class HanabiHand {
     // ValueHinted()=false, value()=-1, and ValueCouldBe(1)=false.
     // After recording that the value is 0, we have
     // ValueHinted()=true, value()=0, and ValueCouldBe(v)=false for v=1, and 2.
+    // Plausible values are kept as a bitmask, so at most kMaxValueRange
+    // values are supported and the knowledge is trivially copyable.
    public:
+    static constexpr int kMaxValueRange = 8;
+
     explicit ValueKnowledge(int value_range);
-    int Range() const { return value_plausible_.size(); }
+    int Range() const { return range_; }
     // Returns true if and only if the exact value was revealed.
     // Does not perform inference to get a known value from not-value hints.
     bool ValueHinted() const { return value_ >= 0; }
     int Value() const { return value_; }  // -1 if value was not hinted.
     // Returns true if we have no hint saying variable is not the given value.
-    bool IsPlausible(int value) const { return value_plausible_[value]; }
+    bool IsPlausible(int value) const { return (plausible_ >> value) & 1; }
+    // Bit v is set if IsPlausible(v).
+    uint8_t PlausibleMask() const { return plausible_; }
     // Record a hint that gives the value of the variable.
     void ApplyIsValueHint(int value);
     // Record a hint that the variable does not have the given value.
@@ -52,8 +60,9 @@ class HanabiHand {
 
    private:
     // Value if hint directly provided the value, or -1 with no direct hint.
-    int value_ = -1;
-    std::vector<bool> value_plausible_;  // Knowledge from not-value hints.
+    int8_t value_ = -1;
+    uint8_t range_ = 0;
+    uint8_t plausible_ = 0;  // Knowledge from not-value hints, bit per value.
   };
 
   class CardKnowledge {
@@ -69,6 +78,8 @@ class HanabiHand {
     int Color() const { return color_.Value(); }
     // Returns true if we have no hint saying card is not the given color.
     bool ColorPlausible(int color) const { return color_.IsPlausible(color); }
+    // Bit c is set if ColorPlausible(c).
+    uint8_t ColorPlausibleMask() const { return color_.PlausibleMask(); }
     void ApplyIsColorHint(int color) { color_.ApplyIsValueHint(color); }
     void ApplyIsNotColorHint(int color) { color_.ApplyIsNotValueHint(color); }
     // Returns number of possible ranks being tracked.
@@ -80,6 +91,8 @@ class HanabiHand {
     int Rank() const { return rank_.Value(); }
     // Returns true if we have no hint saying card is not the given rank.
     bool RankPlausible(int rank) const { return rank_.IsPlausible(rank); }
+    // Bit r is set if RankPlausible(r).
+    uint8_t RankPlausibleMask() const { return rank_.PlausibleMask(); }
     void ApplyIsRankHint(int rank) { rank_.ApplyIsValueHint(rank); }
     void ApplyIsNotRankHint(int rank) { rank_.ApplyIsNotValueHint(rank); }
     std::string ToString() const;
@@ -90,21 +103,26 @@ class HanabiHand {
   };
 
   HanabiHand() {}
-  HanabiHand(const HanabiHand& hand)
-      : cards_(hand.cards_), card_knowledge_(hand.card_knowledge_) {}
+  HanabiHand(const HanabiHand& hand) = default;
+  HanabiHand& operator=(const HanabiHand& hand) = default;
   // Copy hand. Hide cards (set to invalid) if hide_cards is true.
   // Hide card knowledge (set to unknown) if hide_knowledge is true.
   HanabiHand(const HanabiHand& hand, bool hide_cards, bool hide_knowledge);
   // Cards and corresponding card knowledge are always arranged from oldest to
   // newest, with the oldest card or knowledge at index 0.
-  const std::vector<HanabiCard>& Cards() const { return cards_; }
-  const std::vector<CardKnowledge>& Knowledge() const {
+  const FixedVector<HanabiCard, kMaxHandSize>& Cards() const { return cards_; }
+  const FixedVector<CardKnowledge, kMaxHandSize>& Knowledge() const {
     return card_knowledge_;
   }
   void AddCard(HanabiCard card, const CardKnowledge& initial_knowledge);
   // Remove card_index card from hand. Put in discard_pile if not nullptr
   // (pushes the card to the back of the discard_pile vector).
-  void RemoveFromHand(int card_index, std::vector<HanabiCard>* discard_pile);
+  void RemoveFromHand(int card_index,
+                      FixedVector<HanabiCard, kMaxDeckSize>* discard_pile);
+  // Inserts a card and its knowledge at card_index, shifting newer cards up;
+  // the inverse of RemoveFromHand.
+  void InsertCard(int card_index, HanabiCard card,
+                  const CardKnowledge& knowledge);
   // Make cards with the given rank visible.
   // Returns new information bitmask, bit_i set if card_i color was revealed
   // and was previously unknown.
@@ -117,12 +135,16 @@ class HanabiHand {
   // Replaces the card at the given index.
   // Resets knowledge for that card to initial state (unknown).
   void SetCard(int index, HanabiCard card, const CardKnowledge& initial_knowledge);
+  // Replaces the card at the given index, keeping the knowledge about it.
+  void SetCard(int index, HanabiCard card);
+  // Replaces the knowledge about the card at the given index.
+  void SetKnowledge(int index, const CardKnowledge& knowledge);
   std::string ToString() const;
 
  private:
   // A set of cards and knowledge about them.
-  std::vector<HanabiCard> cards_;
-  std::vector<CardKnowledge> card_knowledge_;
+  FixedVector<HanabiCard, kMaxHandSize> cards_;
+  FixedVector<CardKnowledge, kMaxHandSize> card_knowledge_;
 };
 
 }  // namespace hanabi_learning_env
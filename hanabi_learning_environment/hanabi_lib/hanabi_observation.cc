@@ -17,6 +17,7 @@
 #include <algorithm>
 #include <cassert>
 
+#include "instrumentation.h"
 #include "util.h"
 
 namespace hanabi_learning_env {
@@ -50,43 +51,54 @@ void ChangeHistoryItemToObserverRelative(int observer_pid, int num_players,
 }  // namespace
 
 HanabiObservation::HanabiObservation(const HanabiState& state,
-                                     int observing_player)
-    : cur_player_offset_(PlayerToOffset(state.CurPlayer(), observing_player,
-                                        state.ParentGame()->NumPlayers())),
-      discard_pile_(state.DiscardPile()),
-      fireworks_(state.Fireworks()),
-      deck_size_(state.Deck().Size()),
-      information_tokens_(state.InformationTokens()),
-      life_tokens_(state.LifeTokens()),
-      legal_moves_(state.LegalMoves(observing_player)),
-      parent_game_(state.ParentGame()) {
-  REQUIRE(observing_player >= 0 &&
-          observing_player < state.ParentGame()->NumPlayers());
-  hands_.reserve(state.Hands().size());
-  const bool hide_knowledge =
-      state.ParentGame()->ObservationType() == HanabiGame::kMinimal;
-  const bool show_cards = state.ParentGame()->ObservationType() == HanabiGame::kSeer;
+                                     int observing_player) {
+  Update(state, observing_player);
+}
+
+void HanabiObservation::Update(const HanabiState& state,
+                               int observing_player) {
+  const HanabiGame& game = *state.ParentGame();
+  REQUIRE(observing_player >= 0 && observing_player < game.NumPlayers());
+  HANABI_INSTRUMENT(kCounterObservation);
+  cur_player_offset_ =
+      PlayerToOffset(state.CurPlayer(), observing_player, game.NumPlayers());
+  discard_pile_ = state.DiscardPile();
+  fireworks_ = state.Fireworks();
+  deck_size_ = state.Deck().Size();
+  information_tokens_ = state.InformationTokens();
+  life_tokens_ = state.LifeTokens();
+  state.LegalMoves(observing_player, &legal_moves_);
+  legal_move_mask_ = state.LegalMoveMask(observing_player);
+  parent_game_ = state.ParentGame();
+
+  hands_.clear();
+  const bool hide_knowledge = game.ObservationType() == HanabiGame::kMinimal;
+  const bool show_cards = game.ObservationType() == HanabiGame::kSeer;
   hands_.push_back(
       HanabiHand(state.Hands()[observing_player], !show_cards, hide_knowledge));
-  for (int offset = 1; offset < state.ParentGame()->NumPlayers(); ++offset) {
-    hands_.push_back(HanabiHand(state.Hands()[(observing_player + offset) %
-                                              state.ParentGame()->NumPlayers()],
-                                false, hide_knowledge));
+  for (int offset = 1; offset < game.NumPlayers(); ++offset) {
+    hands_.push_back(HanabiHand(
+        state.Hands()[(observing_player + offset) % game.NumPlayers()], false,
+        hide_knowledge));
   }
 
-  const auto& history = state.MoveHistory();
-  auto start = std::find_if(history.begin(), history.end(),
-                            [](const HanabiHistoryItem& item) {
-                              return item.player != kChancePlayerId;
-                            });
-  std::reverse_iterator<decltype(start)> rend(start);
-  for (auto it = history.rbegin(); it != rend; ++it) {
-    last_moves_.push_back(*it);
-    ChangeHistoryItemToObserverRelative(observing_player,
-                                        state.ParentGame()->NumPlayers(),
-                                        show_cards,
-                                        &last_moves_.back());
-    if (it->player == observing_player) {
+  // Walk back from the most recent move to observing_player's last move,
+  // stopping early at the deal of the opening hands (all moves older than
+  // the first player move).
+  last_moves_.clear();
+  int player_moves_seen = 0;
+  for (int age = 0; age < state.NumRecentMoves(); ++age) {
+    const HanabiHistoryItem& item = state.RecentMove(age);
+    if (player_moves_seen == state.PlayerMoveCount()) {
+      break;
+    }
+    if (item.player != kChancePlayerId) {
+      ++player_moves_seen;
+    }
+    last_moves_.push_back(item);
+    ChangeHistoryItemToObserverRelative(observing_player, game.NumPlayers(),
+                                        show_cards, &last_moves_.back());
+    if (item.player == observing_player) {
       break;
     }
   }
@@ -15,15 +15,18 @@
 #ifndef __HANABI_OBSERVATION_H__
 #define __HANABI_OBSERVATION_H__
 
+#include <cstdint>
 #include <string>
 #include <vector>
 
+#include "fixed_vector.h"
 #include "hanabi_card.h"
 #include "hanabi_game.h"
 #include "hanabi_hand.h"
 #include "hanabi_history_item.h"
 #include "hanabi_move.h"
 #include "hanabi_state.h"
+#include "util.h"
 
 namespace hanabi_learning_env {
 
@@ -31,6 +34,10 @@ namespace hanabi_learning_env {
 class HanabiObservation {
  public:
   HanabiObservation(const HanabiState& state, int observing_player);
+  // Replaces the observation by observing_player's view of state, reusing
+  // the storage of its vectors, so that updating an observation of the
+  // same game does not allocate once it has seen its largest move lists.
+  void Update(const HanabiState& state, int observing_player);
 
   std::string ToString() const;
 
@@ -41,8 +48,12 @@ class HanabiObservation {
   // invalid cards as players don't see their own cards.
   const std::vector<HanabiHand>& Hands() const { return hands_; }
   // The element at the back is the most recent discard.
-  const std::vector<HanabiCard>& DiscardPile() const { return discard_pile_; }
-  const std::vector<int>& Fireworks() const { return fireworks_; }
+  const FixedVector<HanabiCard, kMaxDeckSize>& DiscardPile() const {
+    return discard_pile_;
+  }
+  const FixedVector<int, kMaxNumColors>& Fireworks() const {
+    return fireworks_;
+  }
   int DeckSize() const { return deck_size_; }  // number of remaining cards
   const HanabiGame* ParentGame() const { return parent_game_; }
   // Moves made since observing_player's last action, most recent to oldest
@@ -55,6 +66,8 @@ class HanabiObservation {
   int InformationTokens() const { return information_tokens_; }
   int LifeTokens() const { return life_tokens_; }
   const std::vector<HanabiMove>& LegalMoves() const { return legal_moves_; }
+  // LegalMoves() as a bitmask indexed by move uid.
+  uint64_t LegalMoveMask() const { return legal_move_mask_; }
 
   // returns true if card with color and rank can be played on fireworks pile
   bool CardPlayableOnFireworks(int color, int rank) const;
@@ -65,13 +78,15 @@ class HanabiObservation {
  private:
   int cur_player_offset_;  // offset of current_player from observing_player
   std::vector<HanabiHand> hands_;         // observing player is element 0
-  std::vector<HanabiCard> discard_pile_;  // back is most recent discard
-  std::vector<int> fireworks_;
+  // back is most recent discard
+  FixedVector<HanabiCard, kMaxDeckSize> discard_pile_;
+  FixedVector<int, kMaxNumColors> fireworks_;
   int deck_size_;
   std::vector<HanabiHistoryItem> last_moves_;
   int information_tokens_;
   int life_tokens_;
   std::vector<HanabiMove> legal_moves_;  // list of legal moves
+  uint64_t legal_move_mask_ = 0;
   const HanabiGame* parent_game_ = nullptr;
 };
 
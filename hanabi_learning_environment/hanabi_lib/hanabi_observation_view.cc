@@ -0,0 +1,70 @@
+// Copyright 2018 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "hanabi_observation_view.h"
+
+#include "util.h"
+
+namespace hanabi_learning_env {
+
+HanabiObservationView::HanabiObservationView(const HanabiState& state,
+                                             int observing_player)
+    : state_(&state),
+      parent_game_(state.ParentGame()),
+      observing_player_(observing_player),
+      show_own_cards_(parent_game_->ObservationType() == HanabiGame::kSeer),
+      hide_knowledge_(parent_game_->ObservationType() == HanabiGame::kMinimal),
+      hidden_knowledge_(parent_game_->NumColors(), parent_game_->NumRanks()) {
+  REQUIRE(observing_player >= 0 &&
+          observing_player < state.ParentGame()->NumPlayers());
+}
+
+int HanabiObservationView::CurPlayerOffset() const {
+  int cur_player = state_->CurPlayer();
+  return cur_player >= 0
+             ? (cur_player - observing_player_ + NumPlayers()) % NumPlayers()
+             : cur_player;
+}
+
+HanabiCard HanabiObservationView::Card(int offset, int index) const {
+  if (offset == 0 && !show_own_cards_) {
+    return HanabiCard();
+  }
+  return Hand(offset).Cards()[index];
+}
+
+const HanabiHand::CardKnowledge& HanabiObservationView::Knowledge(
+    int offset, int index) const {
+  if (hide_knowledge_) {
+    return hidden_knowledge_;
+  }
+  return Hand(offset).Knowledge()[index];
+}
+
+bool HanabiObservationView::LastNonDealMove(HanabiHistoryItem* item) const {
+  // A player move is followed by at most one deal, so the last player move
+  // is always among the recent moves.
+  for (int age = 0; age < state_->NumRecentMoves(); ++age) {
+    const HanabiHistoryItem& recent_move = state_->RecentMove(age);
+    if (recent_move.move.MoveType() != HanabiMove::kDeal) {
+      *item = recent_move;
+      item->player = (recent_move.player - observing_player_ + NumPlayers()) %
+                     NumPlayers();
+      return true;
+    }
+  }
+  return false;
+}
+
+}  // namespace hanabi_learning_env
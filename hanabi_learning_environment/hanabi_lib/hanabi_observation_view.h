@@ -0,0 +1,83 @@
+// Copyright 2018 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef __HANABI_OBSERVATION_VIEW_H__
+#define __HANABI_OBSERVATION_VIEW_H__
+
+#include <cstdint>
+#include <vector>
+
+#include "fixed_vector.h"
+#include "hanabi_card.h"
+#include "hanabi_game.h"
+#include "hanabi_hand.h"
+#include "hanabi_history_item.h"
+#include "hanabi_state.h"
+#include "util.h"
+
+namespace hanabi_learning_env {
+
+// A lightweight alternative to HanabiObservation which reads the state it
+// was built from. Nothing is copied up front; hiding the observer's cards
+// and making players observer-relative happen on each read. The view is
+// only valid while the state is alive and unchanged.
+class HanabiObservationView {
+ public:
+  HanabiObservationView(const HanabiState& state, int observing_player);
+
+  // offset of current player from observing player.
+  int CurPlayerOffset() const;
+  int NumPlayers() const { return parent_game_->NumPlayers(); }
+  // Hands are addressed by offset from observing_player, as in
+  // HanabiObservation::Hands().
+  int NumCards(int offset) const { return Hand(offset).Cards().size(); }
+  // Invalid card for the observing player's own cards.
+  HanabiCard Card(int offset, int index) const;
+  // Blank knowledge for a kMinimal game.
+  const HanabiHand::CardKnowledge& Knowledge(int offset, int index) const;
+  // The element at the back is the most recent discard.
+  const FixedVector<HanabiCard, kMaxDeckSize>& DiscardPile() const {
+    return state_->DiscardPile();
+  }
+  const FixedVector<int, kMaxNumColors>& Fireworks() const {
+    return state_->Fireworks();
+  }
+  int DeckSize() const { return state_->Deck().Size(); }
+  const HanabiGame* ParentGame() const { return parent_game_; }
+  int InformationTokens() const { return state_->InformationTokens(); }
+  int LifeTokens() const { return state_->LifeTokens(); }
+  uint64_t LegalMoveMask() const {
+    return state_->LegalMoveMask(observing_player_);
+  }
+  // Sets item to the most recent move which was not a deal, with the acting
+  // player relative to observing_player, as in HanabiObservation::LastMoves().
+  // Returns false if no player has moved yet.
+  bool LastNonDealMove(HanabiHistoryItem* item) const;
+
+ private:
+  const HanabiHand& Hand(int offset) const {
+    return state_->Hands()[(observing_player_ + offset) % NumPlayers()];
+  }
+
+  const HanabiState* state_ = nullptr;
+  const HanabiGame* parent_game_ = nullptr;
+  int observing_player_ = -1;
+  bool show_own_cards_ = false;
+  bool hide_knowledge_ = false;
+  HanabiHand::CardKnowledge hidden_knowledge_;
+};
+
+}  // namespace hanabi_learning_env
+
+#endif
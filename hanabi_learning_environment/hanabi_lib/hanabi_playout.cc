@@ -0,0 +1,229 @@
+// Copyright 2018 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "hanabi_playout.h"
+
+#include <algorithm>
+#include <cmath>
+#include <mutex>
+
+#include "thread_pool.h"
+#include "util.h"
+
+namespace hanabi_learning_env {
+
+namespace {
+
+// Games played in sequence from one generator by EvaluatePolicy. Seeding a
+// generator costs more than playing a game.
+constexpr int kEvaluationBlockSize = 64;
+
+// Integer totals over games, so that merging shards in any order gives the
+// same result.
+struct EvaluationTotals {
+  int64_t num_games = 0;
+  int64_t score = 0;
+  int64_t score_squared = 0;
+  int64_t moves = 0;
+  int64_t plays = 0;
+  int64_t misplays = 0;
+  int64_t discards = 0;
+  int64_t hints = 0;
+  int64_t end_of_game[HanabiState::kCompletedFireworks + 1] = {0};
+  std::vector<int64_t> score_counts;
+
+  void Add(const HanabiPlayoutResult& result) {
+    ++num_games;
+    score += result.score;
+    score_squared += result.score * result.score;
+    moves += result.num_moves;
+    plays += result.num_plays;
+    misplays += result.num_misplays;
+    discards += result.num_discards;
+    hints += result.num_hints;
+    ++end_of_game[result.end_of_game];
+    ++score_counts[result.score];
+  }
+
+  void Add(const EvaluationTotals& totals) {
+    num_games += totals.num_games;
+    score += totals.score;
+    score_squared += totals.score_squared;
+    moves += totals.moves;
+    plays += totals.plays;
+    misplays += totals.misplays;
+    discards += totals.discards;
+    hints += totals.hints;
+    for (int i = 0; i <= HanabiState::kCompletedFireworks; ++i) {
+      end_of_game[i] += totals.end_of_game[i];
+    }
+    for (int i = 0; i < static_cast<int>(score_counts.size()); ++i) {
+      score_counts[i] += totals.score_counts[i];
+    }
+  }
+};
+
+}  // namespace
+
+HanabiMove RandomPolicy::Act(const HanabiState& state,
+                             std::mt19937* rng) const {
+  uint64_t mask = state.LegalMoveMask(state.CurPlayer());
+  REQUIRE(mask != 0);
+  int num_legal = 0;
+  for (uint64_t m = mask; m != 0; m &= m - 1) {
+    ++num_legal;
+  }
+  // Clear the lowest set bits until the chosen move is the lowest.
+  for (int skip = std::uniform_int_distribution<int>(0, num_legal - 1)(*rng);
+       skip > 0; --skip) {
+    mask &= mask - 1;
+  }
+  int uid = 0;
+  while (((mask >> uid) & 1) == 0) {
+    ++uid;
+  }
+  return state.ParentGame()->GetMove(uid);
+}
+
+HanabiMove SimplePolicy::Act(const HanabiState& state,
+                             std::mt19937* /*rng*/) const {
+  const HanabiGame& game = *state.ParentGame();
+  const int player = state.CurPlayer();
+  const HanabiHand& hand = state.Hands()[player];
+
+  // Play a card that has been hinted.
+  for (int index = 0; index < hand.Knowledge().size(); ++index) {
+    const HanabiHand::CardKnowledge& knowledge = hand.Knowledge()[index];
+    if (knowledge.ColorHinted() || knowledge.RankHinted()) {
+      return HanabiMove(HanabiMove::kPlay, index, /*target_offset=*/-1,
+                        /*color=*/-1, /*rank=*/-1);
+    }
+  }
+
+  // Hint the color of a playable card that has no color hint.
+  if (state.InformationTokens() > 0) {
+    for (int offset = 1; offset < game.NumPlayers(); ++offset) {
+      const HanabiHand& other =
+          state.Hands()[(player + offset) % game.NumPlayers()];
+      for (int index = 0; index < other.Cards().size(); ++index) {
+        const HanabiCard& card = other.Cards()[index];
+        if (state.CardPlayableOnFireworks(card) &&
+            !other.Knowledge()[index].ColorHinted()) {
+          return HanabiMove(HanabiMove::kRevealColor, /*card_index=*/-1,
+                            offset, card.Color(), /*rank=*/-1);
+        }
+      }
+    }
+  }
+
+  if (state.InformationTokens() < game.MaxInformationTokens()) {
+    return HanabiMove(HanabiMove::kDiscard, /*card_index=*/0,
+                      /*target_offset=*/-1, /*color=*/-1, /*rank=*/-1);
+  }
+  return HanabiMove(HanabiMove::kPlay, /*card_index=*/0, /*target_offset=*/-1,
+                    /*color=*/-1, /*rank=*/-1);
+}
+
+HanabiPlayoutResult Playout(HanabiState* state, const HanabiPolicy& policy,
+                            std::mt19937* rng,
+                            std::vector<HanabiMove>* trajectory) {
+  REQUIRE(state != nullptr);
+  REQUIRE(rng != nullptr);
+  HanabiPlayoutResult result;
+  while (!state->IsTerminal()) {
+    if (state->CurPlayer() == kChancePlayerId) {
+      state->ApplyRandomChance(rng);
+      continue;
+    }
+    const HanabiMove move = policy.Act(*state, rng);
+    const int life_tokens = state->LifeTokens();
+    state->ApplyMove(move);
+    ++result.num_moves;
+    switch (move.MoveType()) {
+      case HanabiMove::kPlay:
+        if (state->LifeTokens() < life_tokens) {
+          ++result.num_misplays;
+        } else {
+          ++result.num_plays;
+        }
+        break;
+      case HanabiMove::kDiscard:
+        ++result.num_discards;
+        break;
+      default:
+        ++result.num_hints;
+        break;
+    }
+    if (trajectory != nullptr) {
+      trajectory->push_back(move);
+    }
+  }
+  result.score = state->Score();
+  result.end_of_game = state->EndOfGameStatus();
+  return result;
+}
+
+HanabiEvaluation EvaluatePolicy(HanabiGame* game, const HanabiPolicy& policy,
+                                int num_games, int num_threads) {
+  REQUIRE(game != nullptr);
+  REQUIRE(num_games >= 0);
+  EvaluationTotals totals;
+  totals.score_counts.assign(game->MaxScore() + 1, 0);
+  std::mutex mutex;
+  ThreadPool pool(num_threads);
+  const int num_blocks =
+      (num_games + kEvaluationBlockSize - 1) / kEvaluationBlockSize;
+  pool.ParallelFor(num_blocks, [&](int begin, int end) {
+    EvaluationTotals shard_totals;
+    shard_totals.score_counts.assign(game->MaxScore() + 1, 0);
+    for (int block = begin; block < end; ++block) {
+      std::seed_seq seed{static_cast<unsigned>(game->Seed()),
+                         static_cast<unsigned>(block)};
+      std::mt19937 rng(seed);
+      const int block_end =
+          std::min(num_games, (block + 1) * kEvaluationBlockSize);
+      for (int i = block * kEvaluationBlockSize; i < block_end; ++i) {
+        HanabiState state(game, game->GetSampledStartPlayer(&rng));
+        state.SetRecordMoveHistory(false);
+        shard_totals.Add(Playout(&state, policy, &rng));
+      }
+    }
+    std::lock_guard<std::mutex> lock(mutex);
+    totals.Add(shard_totals);
+  });
+
+  HanabiEvaluation evaluation;
+  evaluation.num_games = num_games;
+  evaluation.score_counts = totals.score_counts;
+  evaluation.num_out_of_life_tokens =
+      totals.end_of_game[HanabiState::kOutOfLifeTokens];
+  evaluation.num_out_of_cards = totals.end_of_game[HanabiState::kOutOfCards];
+  evaluation.num_completed_fireworks =
+      totals.end_of_game[HanabiState::kCompletedFireworks];
+  if (num_games > 0) {
+    const double n = num_games;
+    evaluation.mean_score = totals.score / n;
+    evaluation.score_stddev = std::sqrt(std::max(
+        0.0, totals.score_squared / n -
+                 evaluation.mean_score * evaluation.mean_score));
+    evaluation.mean_moves = totals.moves / n;
+    evaluation.mean_plays = totals.plays / n;
+    evaluation.mean_misplays = totals.misplays / n;
+    evaluation.mean_discards = totals.discards / n;
+    evaluation.mean_hints = totals.hints / n;
+  }
+  return evaluation;
+}
+
+}  // namespace hanabi_learning_env
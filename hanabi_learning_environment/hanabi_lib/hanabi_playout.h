@@ -0,0 +1,107 @@
+// Copyright 2018 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Native policies and whole-game playouts, for evaluating baseline agents
+// and for rollouts in search without a round trip to Python per move.
+
+#ifndef __HANABI_PLAYOUT_H__
+#define __HANABI_PLAYOUT_H__
+
+#include <cstdint>
+#include <random>
+#include <vector>
+
+#include "hanabi_game.h"
+#include "hanabi_move.h"
+#include "hanabi_state.h"
+
+namespace hanabi_learning_env {
+
+// Chooses moves for the acting player. EvaluatePolicy shares one policy
+// between its threads, so Act must be safe to call concurrently.
+class HanabiPolicy {
+ public:
+  enum Type { kRandom = 0, kSimple = 1 };
+  virtual ~HanabiPolicy() = default;
+
+  // Returns a legal move for state.CurPlayer(), which is not the chance
+  // player. Policies should only use what the acting player observes. rng
+  // belongs to the calling thread.
+  virtual HanabiMove Act(const HanabiState& state, std::mt19937* rng) const = 0;
+};
+
+// Plays a uniformly random legal move, as agents/random_agent.py.
+class RandomPolicy : public HanabiPolicy {
+ public:
+  HanabiMove Act(const HanabiState& state, std::mt19937* rng) const override;
+};
+
+// The rule-based policy of agents/simple_agent.py: play a card with any
+// hint, else hint the color of a playable card that is not color-hinted in
+// another player's hand, else discard the oldest card, or play it if
+// information tokens are full.
+class SimplePolicy : public HanabiPolicy {
+ public:
+  HanabiMove Act(const HanabiState& state, std::mt19937* rng) const override;
+};
+
+// Summary of one playout, counting player moves only.
+struct HanabiPlayoutResult {
+  int score = 0;
+  HanabiState::EndOfGameType end_of_game = HanabiState::kNotFinished;
+  int num_moves = 0;
+  // Plays that added a card to the fireworks, and plays that cost a life.
+  int num_plays = 0;
+  int num_misplays = 0;
+  int num_discards = 0;
+  int num_hints = 0;
+};
+
+// Plays state to the end in place, dealing chance moves from rng and
+// choosing player moves with policy. Appends the player moves to trajectory
+// unless it is null.
+HanabiPlayoutResult Playout(HanabiState* state, const HanabiPolicy& policy,
+                            std::mt19937* rng,
+                            std::vector<HanabiMove>* trajectory = nullptr);
+
+// Aggregate results of EvaluatePolicy.
+struct HanabiEvaluation {
+  int num_games = 0;
+  double mean_score = 0;
+  double score_stddev = 0;
+  // Per-game means of the HanabiPlayoutResult counts.
+  double mean_moves = 0;
+  double mean_plays = 0;
+  double mean_misplays = 0;
+  double mean_discards = 0;
+  double mean_hints = 0;
+  // Number of games with final score s at index s, MaxScore() + 1 entries.
+  std::vector<int64_t> score_counts;
+  // Number of games per HanabiState::EndOfGameType.
+  int64_t num_out_of_life_tokens = 0;
+  int64_t num_out_of_cards = 0;
+  int64_t num_completed_fireworks = 0;
+};
+
+// Plays num_games games of game with policy for every player, split across
+// num_threads threads (<= 0 uses all hardware threads). Games are played in
+// fixed blocks of consecutive games, each drawing its deals from a generator
+// seeded from the game seed and the block index, so results do not depend on
+// num_threads.
+HanabiEvaluation EvaluatePolicy(HanabiGame* game, const HanabiPolicy& policy,
+                                int num_games, int num_threads = 1);
+
+}  // namespace hanabi_learning_env
+
+#endif
@@ -0,0 +1,252 @@
+// Copyright 2018 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "hanabi_search.h"
+
+#include <climits>
+#include <cmath>
+
+#include "hanabi_determinization.h"
+#include "util.h"
+
+namespace hanabi_learning_env {
+
+namespace {
+
+// Iterations between two reads of the clock when searching against time.
+constexpr int kDeadlineCheckInterval = 16;
+
+// Key of the move uid from the information set with ObserverHash info_set.
+uint64_t MoveKey(uint64_t info_set, int uid) {
+  const uint64_t key =
+      info_set ^ (static_cast<uint64_t>(uid + 1) * 0x9e3779b97f4a7c15);
+  return key != 0 ? key : 1;
+}
+
+// Returns the index of a uniformly chosen set bit of mask, which is not 0.
+int RandomSetBit(uint64_t mask, std::mt19937* rng) {
+  int num_set = 0;
+  for (uint64_t m = mask; m != 0; m &= m - 1) {
+    ++num_set;
+  }
+  for (int skip = std::uniform_int_distribution<int>(0, num_set - 1)(*rng);
+       skip > 0; --skip) {
+    mask &= mask - 1;
+  }
+  int bit = 0;
+  while (((mask >> bit) & 1) == 0) {
+    ++bit;
+  }
+  return bit;
+}
+
+}  // namespace
+
+HanabiSearch::HanabiSearch(const HanabiSearchConfig& config,
+                           const HanabiPolicy* rollout_policy)
+    : config_(config),
+      rollout_policy_(rollout_policy),
+      pool_(config.num_threads) {
+  REQUIRE(rollout_policy != nullptr);
+  REQUIRE(config.num_iterations >= 0 && config.time_limit >= 0);
+  REQUIRE(config.num_iterations > 0 || config.time_limit > 0);
+  int seed = config.seed;
+  while (seed == -1) {
+    seed = std::random_device()();
+  }
+  rng_.seed(seed);
+  trees_.resize(pool_.NumThreads());
+  REQUIRE(config.transposition_table_size >= 0);
+  if (config.transposition_table_size > 0) {
+    table_.reset(new TranspositionTable<MoveStatistics>(
+        config.transposition_table_size));
+  }
+}
+
+int HanabiSearch::RunIterations(
+    const HanabiState& state, int num_iterations,
+    const std::chrono::steady_clock::time_point* deadline, std::mt19937* rng,
+    std::vector<Node>* tree) const {
+  const HanabiGame& game = *state.ParentGame();
+  const int observer = state.CurPlayer();
+  // Copies of root and of its determinizations never allocate.
+  HanabiState root(state);
+  root.SetRecordMoveHistory(false);
+  HanabiState determinization(root);
+  std::vector<int> path;
+  // Transposition table keys of the moves on path.
+  std::vector<uint64_t> move_keys;
+  tree->assign(1, Node());
+
+  int iteration = 0;
+  for (; iteration < num_iterations; ++iteration) {
+    if (deadline != nullptr && iteration > 0 &&
+        iteration % kDeadlineCheckInterval == 0 &&
+        std::chrono::steady_clock::now() >= *deadline) {
+      break;
+    }
+    SampleDeterminization(root, observer, rng, &determinization);
+    path.assign(1, 0);
+    move_keys.clear();
+    int node = 0;
+    bool added_node = false;
+    while (!added_node && !determinization.IsTerminal()) {
+      if (determinization.CurPlayer() == kChancePlayerId) {
+        determinization.ApplyRandomChance(rng);
+        continue;
+      }
+      const uint64_t legal =
+          determinization.LegalMoveMask(determinization.CurPlayer());
+      // Root moves are left out of the table: the trees' root statistics are
+      // summed anyway, and sharing them makes the trees explore alike.
+      const bool use_table = table_ != nullptr && node != 0;
+      const uint64_t info_set =
+          use_table ? determinization.ObserverHash(observer) : 0;
+      int best = -1;
+      double best_score = 0;
+      for (int child = (*tree)[node].first_child; child >= 0;
+           child = (*tree)[child].next_sibling) {
+        Node& candidate = (*tree)[child];
+        if (((legal >> candidate.uid) & 1) == 0) {
+          continue;
+        }
+        ++candidate.availability;
+        double value = candidate.total_value / candidate.visits;
+        MoveStatistics statistics;
+        if (use_table &&
+            table_->Lookup(MoveKey(info_set, candidate.uid), &statistics)) {
+          value = statistics.total_value / statistics.visits;
+        }
+        const double score =
+            value +
+            config_.exploration *
+                std::sqrt(std::log(candidate.availability) / candidate.visits);
+        if (best < 0 || score > best_score) {
+          best = child;
+          best_score = score;
+        }
+      }
+      const uint64_t unexpanded = legal & ~(*tree)[node].expanded;
+      if (unexpanded != 0) {
+        Node child;
+        child.uid = RandomSetBit(unexpanded, rng);
+        child.next_sibling = (*tree)[node].first_child;
+        child.availability = 1;
+        best = tree->size();
+        (*tree)[node].first_child = best;
+        (*tree)[node].expanded |= static_cast<uint64_t>(1) << child.uid;
+        tree->push_back(child);
+        added_node = true;
+      }
+      if (use_table) {
+        move_keys.push_back(MoveKey(info_set, (*tree)[best].uid));
+      }
+      determinization.ApplyMove(game.GetMove((*tree)[best].uid));
+      node = best;
+      path.push_back(node);
+    }
+
+    const HanabiPlayoutResult playout =
+        Playout(&determinization, *rollout_policy_, rng);
+    int score = playout.score;
+    if (config_.score_lost_games &&
+        playout.end_of_game == HanabiState::kOutOfLifeTokens) {
+      for (int firework : determinization.Fireworks()) {
+        score += firework;
+      }
+    }
+    const double value = static_cast<double>(score) / game.MaxScore();
+    for (int n : path) {
+      ++(*tree)[n].visits;
+      (*tree)[n].total_value += value;
+    }
+    for (uint64_t key : move_keys) {
+      MoveStatistics statistics = {0, 0};
+      table_->Lookup(key, &statistics);
+      ++statistics.visits;
+      statistics.total_value += value;
+      table_->Store(key, statistics);
+    }
+  }
+  return iteration;
+}
+
+HanabiSearchResult HanabiSearch::Search(const HanabiState& state) {
+  REQUIRE(state.CurPlayer() != kChancePlayerId);
+  REQUIRE(!state.IsTerminal());
+  const HanabiGame& game = *state.ParentGame();
+  const int num_trees = trees_.size();
+  std::vector<unsigned> seeds(num_trees);
+  for (unsigned& seed : seeds) {
+    seed = rng_();
+  }
+  std::vector<int> num_iterations(num_trees, 0);
+  if (table_ != nullptr) {
+    table_->Clear();
+  }
+  std::chrono::steady_clock::time_point deadline;
+  if (config_.time_limit > 0) {
+    deadline = std::chrono::steady_clock::now() +
+               std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+                   std::chrono::duration<double>(config_.time_limit));
+  }
+  pool_.ParallelFor(num_trees, [&](int begin, int end) {
+    for (int t = begin; t < end; ++t) {
+      int budget = INT_MAX;
+      if (config_.num_iterations > 0) {
+        budget = config_.num_iterations / num_trees +
+                 (t < config_.num_iterations % num_trees ? 1 : 0);
+      }
+      std::mt19937 rng(seeds[t]);
+      num_iterations[t] = RunIterations(
+          state, budget, config_.time_limit > 0 ? &deadline : nullptr, &rng,
+          &trees_[t]);
+    }
+  });
+
+  HanabiSearchResult result;
+  result.visit_counts.assign(game.MaxMoves(), 0);
+  result.values.assign(game.MaxMoves(), 0.0);
+  for (int t = 0; t < num_trees; ++t) {
+    result.num_iterations += num_iterations[t];
+    const std::vector<Node>& tree = trees_[t];
+    for (int child = tree[0].first_child; child >= 0;
+         child = tree[child].next_sibling) {
+      result.visit_counts[tree[child].uid] += tree[child].visits;
+      result.values[tree[child].uid] += tree[child].total_value;
+    }
+  }
+  int best = -1;
+  for (int uid = 0; uid < game.MaxMoves(); ++uid) {
+    if (result.visit_counts[uid] == 0) {
+      continue;
+    }
+    result.values[uid] /= result.visit_counts[uid];
+    if (best < 0 || result.visit_counts[uid] > result.visit_counts[best] ||
+        (result.visit_counts[uid] == result.visit_counts[best] &&
+         result.values[uid] > result.values[best])) {
+      best = uid;
+    }
+  }
+  REQUIRE(best >= 0);
+  result.move = game.GetMove(best);
+  return result;
+}
+
+HanabiSearchResult HanabiSearch::Search(const HanabiObservation& observation) {
+  REQUIRE(observation.CurPlayerOffset() == 0);
+  return Search(SampleDeterminization(observation, &rng_));
+}
+
+}  // namespace hanabi_learning_env
@@ -0,0 +1,141 @@
+// Copyright 2018 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Information-Set Monte Carlo Tree Search over native determinizations and
+// playouts, for a strong search baseline and for expert moves to distill.
+
+#ifndef __HANABI_SEARCH_H__
+#define __HANABI_SEARCH_H__
+
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <random>
+#include <vector>
+
+#include "hanabi_move.h"
+#include "hanabi_observation.h"
+#include "hanabi_playout.h"
+#include "hanabi_state.h"
+#include "thread_pool.h"
+#include "transposition_table.h"
+
+namespace hanabi_learning_env {
+
+struct HanabiSearchConfig {
+  // Iterations per search, shared between the threads. 0 for no limit, in
+  // which case time_limit must be set.
+  int num_iterations = 1000;
+  // Wall-clock budget per search in seconds, 0 for no limit. Every thread
+  // runs at least one iteration.
+  double time_limit = 0;
+  // UCT exploration constant, for values scaled to [0, 1] by MaxScore().
+  double exploration = 0.5;
+  // Number of independent trees searched in parallel, one per thread,
+  // <= 0 for one per hardware thread.
+  int num_threads = 1;
+  // Value playouts that run out of life tokens by their fireworks rather
+  // than by their score of 0. Weak rollout policies lose most games, and
+  // their fireworks still tell good moves from bad ones.
+  bool score_lost_games = true;
+  // Seed of the search's generator, -1 for a random seed.
+  int seed = -1;
+  // Entries of a transposition table shared by the threads, 0 for none.
+  // With a table, a move below the root is valued by every visit to it from
+  // the same information set of the searching player (ObserverHash), in any
+  // tree and after any order of moves, rather than only by the visits to its
+  // node. Exploration still uses the node's own counts. Concurrent updates
+  // of an entry may lose visits, so results then depend on thread timing.
+  int transposition_table_size = 0;
+};
+
+struct HanabiSearchResult {
+  // The most visited move at the root.
+  HanabiMove move = HanabiMove(HanabiMove::kInvalid, -1, -1, -1, -1);
+  int num_iterations = 0;
+  // Root statistics summed over all trees, indexed by move uid: how often
+  // each move was visited, and its mean value in [0, 1] (0 if unvisited).
+  std::vector<int> visit_counts;
+  std::vector<double> values;
+};
+
+// Single-observer ISMCTS with UCT. Every iteration redeals the searching
+// player's hand with SampleDeterminization, descends the tree of player
+// moves through the moves that are legal in that determinization (scoring
+// each child by how often it was available rather than by its parent's
+// visits), adds one node, and plays out the rest of the game with the
+// rollout policy. Deals are drawn at random and are not part of the tree.
+//
+// Threads never share a tree: each searches its own, with its own
+// generator, and their root statistics are summed (root parallelization),
+// so no node is ever locked or written concurrently. Only the optional
+// transposition table is shared, without locks.
+class HanabiSearch {
+ public:
+  // rollout_policy plays every player in playouts, and must outlive the
+  // search.
+  HanabiSearch(const HanabiSearchConfig& config,
+               const HanabiPolicy* rollout_policy);
+  HanabiSearch(const HanabiSearch&) = delete;
+  HanabiSearch& operator=(const HanabiSearch&) = delete;
+
+  const HanabiSearchConfig& Config() const { return config_; }
+
+  // Searches for state.CurPlayer(), which is not the chance player, using
+  // only that player's information. Not reentrant.
+  HanabiSearchResult Search(const HanabiState& state);
+  // Searches for the observing player, who must be the current player.
+  // Moves in the result are relative to the observer, as in observation.
+  HanabiSearchResult Search(const HanabiObservation& observation);
+
+ private:
+  // A player move below its parent, with the statistics of the
+  // determinizations that went through it.
+  struct Node {
+    int uid = -1;
+    int first_child = -1;
+    int next_sibling = -1;
+    // Bit m is set if the node has a child for move uid m.
+    uint64_t expanded = 0;
+    int visits = 0;
+    // Number of visits to the parent in which this move was legal.
+    int availability = 0;
+    double total_value = 0;
+  };
+  // Statistics of a move from an information set, in the transposition
+  // table.
+  struct MoveStatistics {
+    int32_t visits;
+    float total_value;
+  };
+
+  // Runs up to num_iterations iterations on a new tree, stopping at
+  // *deadline unless it is null, and returns the number run.
+  int RunIterations(const HanabiState& state, int num_iterations,
+                    const std::chrono::steady_clock::time_point* deadline,
+                    std::mt19937* rng, std::vector<Node>* tree) const;
+
+  HanabiSearchConfig config_;
+  const HanabiPolicy* rollout_policy_;
+  std::mt19937 rng_;
+  ThreadPool pool_;
+  // One tree per thread, kept to reuse their storage between searches.
+  std::vector<std::vector<Node>> trees_;
+  // Cleared at the start of every search. Null without a table.
+  std::unique_ptr<TranspositionTable<MoveStatistics>> table_;
+};
+
+}  // namespace hanabi_learning_env
+
+#endif
@@ -18,6 +18,8 @@
 #include <cassert>
 #include <numeric>
 
+#include "instrumentation.h"
+#include "static_game.h"
 #include "util.h"
 
 namespace hanabi_learning_env {
@@ -48,6 +50,106 @@ uint8_t HandRankBitmask(const HanabiHand& hand, int rank) {
   }
   return mask;
 }
+
+// Kinds of hashed features, in the top bits of a feature code.
+enum ZobristFeature : uint64_t {
+  kHandCardFeature = 1,
+  kDeckCountFeature,
+  kUnseenCountFeature,
+  kFireworkFeature,
+  kInformationTokensFeature,
+  kLifeTokensFeature,
+  kTurnsToPlayFeature,
+  kCurPlayerFeature,
+  kNextPlayerFeature,
+  kLastMoveFeature,
+  kLastMoveOutcomeFeature,
+};
+
+uint64_t Feature(ZobristFeature kind, int a, int b = 0) {
+  constexpr uint64_t kFieldMask = (uint64_t{1} << 28) - 1;
+  return kind << 56 | (static_cast<uint64_t>(a) & kFieldMask) << 28 |
+         (static_cast<uint64_t>(b) & kFieldMask);
+}
+
+// Zobrist key of a feature. Keys are derived from the feature code by the
+// splitmix64 finalizer rather than read from tables, so that they cover
+// games of any size.
+uint64_t ZobristKey(uint64_t feature) {
+  uint64_t z = feature + 0x9e3779b97f4a7c15ULL;
+  z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+  z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+  return z ^ (z >> 31);
+}
+
+uint64_t ZobristKey(ZobristFeature kind, int a, int b = 0) {
+  return ZobristKey(Feature(kind, a, b));
+}
+
+// Hashes the cards, if show_cards, and the knowledge at each position of the
+// hand in seat slot.
+uint64_t HashHand(int slot, const HanabiHand& hand, bool show_cards) {
+  uint64_t hash = 0;
+  for (int i = 0; i < hand.Cards().size(); ++i) {
+    const HanabiHand::CardKnowledge& knowledge = hand.Knowledge()[i];
+    int code = knowledge.ColorPlausibleMask() |
+               knowledge.RankPlausibleMask() << 5 |
+               (knowledge.Color() + 1) << 10 | (knowledge.Rank() + 1) << 13;
+    if (show_cards) {
+      const HanabiCard& card = hand.Cards()[i];
+      code |= ((card.Color() + 1) << 3 | (card.Rank() + 1)) << 16;
+    }
+    hash ^= ZobristKey(kHandCardFeature, slot * kMaxHandSize + i, code);
+  }
+  return hash;
+}
+
+// The first player after the opening deal: start_player if it is a player,
+// else one sampled by the game.
+int StartPlayer(const HanabiGame& game, int start_player) {
+  return start_player >= 0 && start_player < game.NumPlayers()
+             ? start_player
+             : game.GetSampledStartPlayer();
+}
+
+// Computes HanabiState::LegalMoveMask for the current player, templated on
+// the game type so that the loops over players and colors unroll for the
+// StaticGame variants. Move uids are laid out as contiguous blocks: discards,
+// plays, then hints by target offset and color or rank, as in
+// HanabiGame::GetMoveUid().
+struct LegalMoveMasker {
+  template <typename Game>
+  uint64_t operator()(const Game& game) const {
+    const int num_players = game.NumPlayers();
+    const int hand_size = game.HandSize();
+    const int player = state.CurPlayer();
+    const uint64_t cards =
+        (static_cast<uint64_t>(1) << state.Hands()[player].Cards().size()) -
+        1;
+    uint64_t mask = cards << hand_size;
+    if (state.InformationTokens() < game.MaxInformationTokens()) {
+      mask |= cards;
+    }
+    if (state.InformationTokens() > 0) {
+      const int colors_start = 2 * hand_size;
+      const int ranks_start =
+          colors_start + (num_players - 1) * game.NumColors();
+      for (int offset = 1; offset < num_players; ++offset) {
+        uint64_t colors = 0;
+        uint64_t ranks = 0;
+        for (const HanabiCard& card :
+             state.Hands()[(player + offset) % num_players].Cards()) {
+          colors |= static_cast<uint64_t>(1) << card.Color();
+          ranks |= static_cast<uint64_t>(1) << card.Rank();
+        }
+        mask |= colors << (colors_start + (offset - 1) * game.NumColors());
+        mask |= ranks << (ranks_start + (offset - 1) * game.NumRanks());
+      }
+    }
+    return mask;
+  }
+  const HanabiState& state;
+};
 }  // namespace
 
 HanabiState::HanabiDeck::HanabiDeck(const HanabiGame& game)
@@ -59,20 +161,41 @@ HanabiState::HanabiDeck::HanabiDeck(const HanabiGame& game)
       auto count = game.NumberCardInstances(color, rank);
       card_count_[CardToIndex(color, rank)] = count;
       total_count_ += count;
+      hash_ ^= ZobristKey(kDeckCountFeature, CardToIndex(color, rank), count);
     }
   }
 }
 
+void HanabiState::HanabiDeck::ChangeCount(int index, int delta) {
+  hash_ ^= ZobristKey(kDeckCountFeature, index, card_count_[index]);
+  card_count_[index] += delta;
+  total_count_ += delta;
+  hash_ ^= ZobristKey(kDeckCountFeature, index, card_count_[index]);
+}
+
 HanabiCard HanabiState::HanabiDeck::DealCard(std::mt19937* rng) {
+  HanabiCard card = SampleCard(rng);
+  if (!card.IsValid()) {
+    return card;
+  }
+  return DealCard(card.Color(), card.Rank());
+}
+
+HanabiCard HanabiState::HanabiDeck::SampleCard(std::mt19937* rng) const {
   if (Empty()) {
     return HanabiCard();
   }
-  std::discrete_distribution<std::mt19937::result_type> dist(
-      card_count_.begin(), card_count_.end());
-  int index = dist(*rng);
-  assert(card_count_[index] > 0);
-  --card_count_[index];
-  --total_count_;
+  // Pick one of the remaining card instances, then find its (color, rank)
+  // by walking the counts. There are at most kMaxNumColors * kMaxNumRanks
+  // entries, so this is cheaper than building a distribution per deal.
+  std::uniform_int_distribution<int> dist(0, total_count_ - 1);
+  int instance = dist(*rng);
+  int index = 0;
+  while (instance >= card_count_[index]) {
+    instance -= card_count_[index];
+    ++index;
+  }
+  assert(index < card_count_.size());
   return HanabiCard(IndexToColor(index), IndexToRank(index));
 }
 
@@ -82,15 +205,12 @@ HanabiCard HanabiState::HanabiDeck::DealCard(int color, int rank) {
     return HanabiCard();
   }
   assert(card_count_[index] > 0);
-  --card_count_[index];
-  --total_count_;
+  ChangeCount(index, -1);
   return HanabiCard(IndexToColor(index), IndexToRank(index));
 }
 
 void HanabiState::HanabiDeck::AddCard(int color, int rank) {
-  int index = CardToIndex(color, rank);
-  card_count_[index]++;
-  total_count_++;
+  ChangeCount(CardToIndex(color, rank), 1);
 }
 
 void HanabiState::HanabiDeck::SetContent(const std::vector<HanabiCard>& cards) {
@@ -103,22 +223,42 @@ void HanabiState::HanabiDeck::SetContent(const std::vector<HanabiCard>& cards) {
       total_count_++;
     }
   }
+  hash_ = 0;
+  for (int index = 0; index < card_count_.size(); ++index) {
+    hash_ ^= ZobristKey(kDeckCountFeature, index, card_count_[index]);
+  }
 }
 
+constexpr int HanabiState::kRecentMoveCapacity;
+
 HanabiState::HanabiState(HanabiGame* parent_game, int start_player)
     : parent_game_(parent_game),
       deck_(*parent_game),
       hands_(parent_game->NumPlayers()),
       cur_player_(kChancePlayerId),
-      next_non_chance_player_(start_player >= 0 &&
-                                      start_player < parent_game->NumPlayers()
-                                  ? start_player
-                                  : parent_game->GetSampledStartPlayer()),
+      next_non_chance_player_(StartPlayer(*parent_game, start_player)),
       information_tokens_(parent_game->MaxInformationTokens()),
       life_tokens_(parent_game->MaxLifeTokens()),
       fireworks_(parent_game->NumColors(), 0),
       turns_to_play_(parent_game->NumPlayers()) {}
 
+void HanabiState::Reset(int start_player) {
+  std::vector<HanabiHistoryItem> move_history;
+  move_history.swap(move_history_);
+  move_history.clear();
+  const bool record_move_history = record_move_history_;
+  *this = parent_game_->InitialStateTemplate();
+  next_non_chance_player_ = StartPlayer(*parent_game_, start_player);
+  record_move_history_ = record_move_history;
+  move_history_.swap(move_history);
+}
+
+void HanabiState::RehashHand(int player) {
+  hands_hash_ ^= hand_hashes_[player];
+  hand_hashes_[player] = HashHand(player, hands_[player], /*show_cards=*/true);
+  hands_hash_ ^= hand_hashes_[player];
+}
+
 void HanabiState::AdvanceToNextPlayer() {
   if (!deck_.Empty() && PlayerToDeal() >= 0) {
     cur_player_ = kChancePlayerId;
@@ -236,8 +376,29 @@ bool HanabiState::MoveIsLegal(HanabiMove move) const {
   return true;
 }
 
-void HanabiState::ApplyMove(HanabiMove move) {
+void HanabiState::ApplyMove(HanabiMove move, HanabiUndoRecord* undo) {
   REQUIRE(MoveIsLegal(move));
+  HANABI_INSTRUMENT(static_cast<InstrumentationCounter>(
+      kCounterApplyPlay + (move.MoveType() - HanabiMove::kPlay)));
+  if (undo != nullptr) {
+    undo->knowledge.clear();
+    if (move.MoveType() == HanabiMove::kDeal) {
+      undo->hand_hash = hand_hashes_[PlayerToDeal()];
+    } else if (move.MoveType() == HanabiMove::kDiscard ||
+               move.MoveType() == HanabiMove::kPlay) {
+      undo->knowledge.push_back(
+          hands_[cur_player_].Knowledge()[move.CardIndex()]);
+      undo->hand_hash = hand_hashes_[cur_player_];
+    } else {
+      const int target = (cur_player_ + move.TargetOffset()) % hands_.size();
+      undo->knowledge = hands_[target].Knowledge();
+      undo->hand_hash = hand_hashes_[target];
+    }
+    if (recent_moves_.size() == kRecentMoveCapacity) {
+      undo->overwritten_recent_move =
+          recent_moves_[move_count_ % kRecentMoveCapacity];
+    }
+  }
   if (deck_.Empty()) {
     --turns_to_play_;
   }
@@ -255,6 +416,7 @@ void HanabiState::ApplyMove(HanabiMove move) {
         hands_[history.deal_to_player].AddCard(
             deck_.DealCard(move.Color(), move.Rank()),
             card_knowledge);
+        RehashHand(history.deal_to_player);
       }
       break;
     case HanabiMove::kDiscard:
@@ -262,6 +424,7 @@ void HanabiState::ApplyMove(HanabiMove move) {
       history.color = hands_[cur_player_].Cards()[move.CardIndex()].Color();
       history.rank = hands_[cur_player_].Cards()[move.CardIndex()].Rank();
       hands_[cur_player_].RemoveFromHand(move.CardIndex(), &discard_pile_);
+      RehashHand(cur_player_);
       break;
     case HanabiMove::kPlay:
       history.color = hands_[cur_player_].Cards()[move.CardIndex()].Color();
@@ -270,6 +433,7 @@ void HanabiState::ApplyMove(HanabiMove move) {
           AddToFireworks(hands_[cur_player_].Cards()[move.CardIndex()]);
       hands_[cur_player_].RemoveFromHand(
           move.CardIndex(), history.scored ? nullptr : &discard_pile_);
+      RehashHand(cur_player_);
       break;
     case HanabiMove::kRevealColor:
       DecrementInformationTokens();
@@ -277,6 +441,7 @@ void HanabiState::ApplyMove(HanabiMove move) {
           HandColorBitmask(*HandByOffset(move.TargetOffset()), move.Color());
       history.newly_revealed_bitmask =
           HandByOffset(move.TargetOffset())->RevealColor(move.Color());
+      RehashHand((cur_player_ + move.TargetOffset()) % hands_.size());
       break;
     case HanabiMove::kRevealRank:
       DecrementInformationTokens();
@@ -284,12 +449,104 @@ void HanabiState::ApplyMove(HanabiMove move) {
           HandRankBitmask(*HandByOffset(move.TargetOffset()), move.Rank());
       history.newly_revealed_bitmask =
           HandByOffset(move.TargetOffset())->RevealRank(move.Rank());
+      RehashHand((cur_player_ + move.TargetOffset()) % hands_.size());
       break;
     default:
       std::abort();  // Should not be possible.
   }
-  move_history_.push_back(history);
+  RecordMove(history);
   AdvanceToNextPlayer();
+  if (move_listener_.listener != nullptr) {
+    move_listener_.listener->OnMove(*this, history);
+  }
+}
+
+void HanabiState::RecordMove(const HanabiHistoryItem& history) {
+  if (recent_moves_.size() < kRecentMoveCapacity) {
+    recent_moves_.push_back(history);
+  } else {
+    recent_moves_[move_count_ % kRecentMoveCapacity] = history;
+  }
+  ++move_count_;
+  if (history.player != kChancePlayerId) {
+    ++player_move_count_;
+  }
+  if (record_move_history_) {
+    move_history_.push_back(history);
+  }
+}
+
+void HanabiState::UndoMove(const HanabiUndoRecord& undo) {
+  REQUIRE(move_count_ > 0);
+  const HanabiHistoryItem history = RecentMove(0);
+  const HanabiMove& move = history.move;
+  // ApplyMove ends with AdvanceToNextPlayer, which either hands the turn to
+  // chance or moves on the next player to act.
+  if (cur_player_ != kChancePlayerId) {
+    next_non_chance_player_ = cur_player_;
+  }
+  cur_player_ = history.player;
+  switch (move.MoveType()) {
+    case HanabiMove::kDeal: {
+      HanabiHand* hand = &hands_[history.deal_to_player];
+      const HanabiCard card = hand->Cards().back();
+      hand->RemoveFromHand(hand->Cards().size() - 1, nullptr);
+      deck_.AddCard(card.Color(), card.Rank());
+      SetHandHash(history.deal_to_player, undo.hand_hash);
+      break;
+    }
+    case HanabiMove::kDiscard:
+    case HanabiMove::kPlay:
+      REQUIRE(undo.knowledge.size() == 1);
+      if (history.scored) {
+        --fireworks_[history.color];
+      } else {
+        discard_pile_.pop_back();
+        if (move.MoveType() == HanabiMove::kPlay) {
+          ++life_tokens_;
+        }
+      }
+      if (history.information_token) {
+        --information_tokens_;
+      }
+      hands_[cur_player_].InsertCard(move.CardIndex(),
+                                     HanabiCard(history.color, history.rank),
+                                     undo.knowledge[0]);
+      SetHandHash(cur_player_, undo.hand_hash);
+      break;
+    case HanabiMove::kRevealColor:
+    case HanabiMove::kRevealRank: {
+      ++information_tokens_;
+      HanabiHand* hand = HandByOffset(move.TargetOffset());
+      REQUIRE(undo.knowledge.size() == hand->Knowledge().size());
+      for (int i = 0; i < undo.knowledge.size(); ++i) {
+        hand->SetKnowledge(i, undo.knowledge[i]);
+      }
+      SetHandHash((cur_player_ + move.TargetOffset()) % hands_.size(),
+                  undo.hand_hash);
+      break;
+    }
+    default:
+      std::abort();  // Should not be possible.
+  }
+  // Other than deals, moves leave the deck as it was, and deals are only
+  // applied to a deck that was not empty.
+  if (deck_.Empty()) {
+    ++turns_to_play_;
+  }
+  --move_count_;
+  if (move_count_ < kRecentMoveCapacity) {
+    recent_moves_.pop_back();
+  } else {
+    recent_moves_[move_count_ % kRecentMoveCapacity] =
+        undo.overwritten_recent_move;
+  }
+  if (history.player != kChancePlayerId) {
+    --player_move_count_;
+  }
+  if (record_move_history_ && !move_history_.empty()) {
+    move_history_.pop_back();
+  }
 }
 
 double HanabiState::ChanceOutcomeProb(HanabiMove move) const {
@@ -298,27 +555,90 @@ double HanabiState::ChanceOutcomeProb(HanabiMove move) const {
 }
 
 void HanabiState::ApplyRandomChance() {
-  auto chance_outcomes = ChanceOutcomes();
-  REQUIRE(!chance_outcomes.second.empty());
-  ApplyMove(ParentGame()->PickRandomChance(chance_outcomes));
+  ApplyRandomChance(ParentGame()->Rng());
+}
+
+void HanabiState::ApplyRandomChance(std::mt19937* rng) {
+  // Equivalent to sampling from ChanceOutcomes(), whose probabilities are
+  // proportional to the deck counts, without building the outcome lists.
+  REQUIRE(cur_player_ == kChancePlayerId);
+  HANABI_INSTRUMENT(kCounterRandomChance);
+  HanabiCard card = deck_.SampleCard(rng);
+  REQUIRE(card.IsValid());
+  ApplyMove(HanabiMove(HanabiMove::kDeal, /*card_index=*/-1,
+                       /*target_offset=*/-1, card.Color(), card.Rank()));
+}
+
+void HanabiState::DealInitialHands() {
+  DealInitialHands(ParentGame()->Rng());
+}
+
+void HanabiState::DealInitialHands(std::mt19937* rng) {
+  REQUIRE(move_count_ == 0 && cur_player_ == kChancePlayerId);
+  if (move_listener_.listener != nullptr) {
+    while (cur_player_ == kChancePlayerId) {
+      ApplyRandomChance(rng);
+    }
+    return;
+  }
+  const int hand_size = ParentGame()->HandSize();
+  HANABI_INSTRUMENT_N(kCounterRandomChance, hands_.size() * hand_size);
+  const HanabiHand::CardKnowledge unknown(ParentGame()->NumColors(),
+                                          ParentGame()->NumRanks());
+  const bool seer = ParentGame()->ObservationType() == HanabiGame::kSeer;
+  // The game holds enough cards for every opening hand, so the deck does
+  // not run out and no turn is counted down.
+  for (int player = 0; player < hands_.size(); ++player) {
+    HanabiHand& hand = hands_[player];
+    while (hand.Cards().size() < hand_size) {
+      const HanabiCard card = deck_.DealCard(rng);
+      REQUIRE(card.IsValid());
+      HanabiHand::CardKnowledge card_knowledge = unknown;
+      if (seer) {
+        card_knowledge.ApplyIsColorHint(card.Color());
+        card_knowledge.ApplyIsRankHint(card.Rank());
+      }
+      hand.AddCard(card, card_knowledge);
+      HanabiHistoryItem history(HanabiMove(HanabiMove::kDeal,
+                                           /*card_index=*/-1,
+                                           /*target_offset=*/-1, card.Color(),
+                                           card.Rank()));
+      history.player = kChancePlayerId;
+      history.deal_to_player = player;
+      RecordMove(history);
+    }
+    RehashHand(player);
+  }
+  AdvanceToNextPlayer();
 }
 
 std::vector<HanabiMove> HanabiState::LegalMoves(int player) const {
   std::vector<HanabiMove> movelist;
-  // kChancePlayer=-1 must be handled by ChanceOutcome.
-  REQUIRE(player >= 0 && player < ParentGame()->NumPlayers());
-  if (player != cur_player_) {
-    // Turn-based game. Empty move list for other players.
-    return movelist;
-  }
+  LegalMoves(player, &movelist);
+  return movelist;
+}
+
+void HanabiState::LegalMoves(int player, std::vector<HanabiMove>* moves) const {
+  REQUIRE(moves != nullptr);
+  HANABI_INSTRUMENT(kCounterLegalMoves);
+  moves->clear();
+  uint64_t mask = LegalMoveMask(player);
   int max_move_uid = ParentGame()->MaxMoves();
   for (int uid = 0; uid < max_move_uid; ++uid) {
-    HanabiMove move = ParentGame()->GetMove(uid);
-    if (MoveIsLegal(move)) {
-      movelist.push_back(move);
+    if ((mask >> uid) & 1) {
+      moves->push_back(ParentGame()->GetMove(uid));
     }
   }
-  return movelist;
+}
+
+uint64_t HanabiState::LegalMoveMask(int player) const {
+  // kChancePlayer=-1 must be handled by ChanceOutcome.
+  REQUIRE(player >= 0 && player < ParentGame()->NumPlayers());
+  if (player != cur_player_) {
+    // Turn-based game. No legal moves for other players.
+    return 0;
+  }
+  return DispatchStaticGame(*ParentGame(), LegalMoveMasker{*this});
 }
 
 bool HanabiState::CardPlayableOnFireworks(int color, int rank) const {
@@ -391,11 +711,19 @@ void HanabiState::SetInformationTokens(int information_tokens) {
 
 void HanabiState::SetFireworks(const std::vector<int>& fireworks) {
   REQUIRE(fireworks.size() == fireworks_.size());
-  fireworks_ = fireworks;
+  fireworks_.assign(fireworks.begin(), fireworks.end());
 }
 
 void HanabiState::SetDiscardPile(const std::vector<HanabiCard>& discard_pile) {
-  discard_pile_ = discard_pile;
+  discard_pile_.assign(discard_pile.begin(), discard_pile.end());
+}
+
+void HanabiState::SetRecordMoveHistory(bool record) {
+  record_move_history_ = record;
+  if (!record) {
+    move_history_.clear();
+    move_history_.shrink_to_fit();
+  }
 }
 
 void HanabiState::SetHand(int player_id, const std::vector<HanabiCard>& cards) {
@@ -407,6 +735,13 @@ void HanabiState::SetHand(int player_id, const std::vector<HanabiCard>& cards) {
   for (const auto& card : cards) {
     hands_[player_id].AddCard(card, knowledge);
   }
+  RehashHand(player_id);
+}
+
+void HanabiState::SetHand(int player_id, const HanabiHand& hand) {
+  REQUIRE(player_id >= 0 && player_id < hands_.size());
+  hands_[player_id] = hand;
+  RehashHand(player_id);
 }
 
 void HanabiState::SetDeck(const std::vector<HanabiCard>& cards) {
@@ -415,6 +750,13 @@ void HanabiState::SetDeck(const std::vector<HanabiCard>& cards) {
 
 void HanabiState::SetCurPlayer(int cur_player) {
   cur_player_ = cur_player;
+  if (cur_player >= 0 && cur_player < hands_.size()) {
+    next_non_chance_player_ = (cur_player + 1) % hands_.size();
+  }
+}
+
+void HanabiState::SetTurnsToPlay(int turns_to_play) {
+  turns_to_play_ = turns_to_play;
 }
 
 void HanabiState::SetHandCard(int player, int card_index, HanabiCard card) {
@@ -444,6 +786,95 @@ void HanabiState::SetHandCard(int player, int card_index, HanabiCard card) {
   HanabiHand::CardKnowledge knowledge(ParentGame()->NumColors(),
                                       ParentGame()->NumRanks());
   hands_[player].SetCard(card_index, card, knowledge);
+  RehashHand(player);
+}
+
+void HanabiState::SetHandCards(
+    int player, const FixedVector<HanabiCard, kMaxHandSize>& cards) {
+  REQUIRE(player >= 0 && player < hands_.size());
+  HanabiHand& hand = hands_[player];
+  REQUIRE(cards.size() == hand.Cards().size());
+  for (const HanabiCard& old_card : hand.Cards()) {
+    deck_.AddCard(old_card.Color(), old_card.Rank());
+  }
+  for (int i = 0; i < cards.size(); ++i) {
+    REQUIRE(cards[i].IsValid());
+    HanabiCard card = deck_.DealCard(cards[i].Color(), cards[i].Rank());
+    REQUIRE(card.IsValid());
+    hand.SetCard(i, card);
+  }
+  RehashHand(player);
+}
+
+uint64_t HanabiState::Hash() const {
+  uint64_t hash = hands_hash_ ^ deck_.Hash() ^
+                  ZobristKey(kInformationTokensFeature, information_tokens_) ^
+                  ZobristKey(kLifeTokensFeature, life_tokens_) ^
+                  ZobristKey(kTurnsToPlayFeature, turns_to_play_) ^
+                  ZobristKey(kCurPlayerFeature, cur_player_ + 1) ^
+                  ZobristKey(kNextPlayerFeature, next_non_chance_player_ + 1);
+  for (int color = 0; color < fireworks_.size(); ++color) {
+    hash ^= ZobristKey(kFireworkFeature, color, fireworks_[color]);
+  }
+  return hash != 0 ? hash : 1;
+}
+
+uint64_t HanabiState::ObserverHash(int observer) const {
+  REQUIRE(observer >= 0 && observer < hands_.size());
+  const int num_players = hands_.size();
+  const int num_ranks = ParentGame()->NumRanks();
+  const bool show_own_cards =
+      ParentGame()->ObservationType() == HanabiGame::kSeer;
+  // Seats and players to act relative to observer, 0 for chance.
+  auto relative = [observer, num_players](int player) {
+    return player == kChancePlayerId
+               ? 0
+               : 1 + (player - observer + num_players) % num_players;
+  };
+  uint64_t hash = ZobristKey(kInformationTokensFeature, information_tokens_) ^
+                  ZobristKey(kLifeTokensFeature, life_tokens_) ^
+                  ZobristKey(kTurnsToPlayFeature, turns_to_play_) ^
+                  ZobristKey(kCurPlayerFeature, relative(cur_player_)) ^
+                  ZobristKey(kNextPlayerFeature,
+                             relative(next_non_chance_player_));
+  int unseen[kMaxNumColors * kMaxNumRanks];
+  for (int color = 0; color < fireworks_.size(); ++color) {
+    hash ^= ZobristKey(kFireworkFeature, color, fireworks_[color]);
+    for (int rank = 0; rank < num_ranks; ++rank) {
+      unseen[color * num_ranks + rank] = deck_.CardCount(color, rank);
+    }
+  }
+  for (int offset = 0; offset < num_players; ++offset) {
+    const HanabiHand& hand = hands_[(observer + offset) % num_players];
+    const bool show_cards = offset != 0 || show_own_cards;
+    hash ^= HashHand(offset, hand, show_cards);
+    if (!show_cards) {
+      for (const HanabiCard& card : hand.Cards()) {
+        ++unseen[card.Color() * num_ranks + card.Rank()];
+      }
+    }
+  }
+  for (int index = 0; index < fireworks_.size() * num_ranks; ++index) {
+    hash ^= ZobristKey(kUnseenCountFeature, index, unseen[index]);
+  }
+  // The last non-deal move, which observations also encode.
+  for (int age = 0; age < NumRecentMoves(); ++age) {
+    const HanabiHistoryItem& item = RecentMove(age);
+    if (item.player == kChancePlayerId) {
+      continue;
+    }
+    const HanabiMove& move = item.move;
+    hash ^= ZobristKey(kLastMoveFeature, relative(item.player),
+                       move.MoveType() | (move.CardIndex() + 1) << 4 |
+                           (move.TargetOffset() + 1) << 8 |
+                           (move.Color() + 1) << 12 | (move.Rank() + 1) << 16);
+    hash ^= ZobristKey(kLastMoveOutcomeFeature,
+                       item.scored | item.information_token << 1 |
+                           (item.color + 1) << 2 | (item.rank + 1) << 5,
+                       item.reveal_bitmask);
+    break;
+  }
+  return hash != 0 ? hash : 1;
 }
 
 HanabiState::EndOfGameType HanabiState::EndOfGameStatus() const {
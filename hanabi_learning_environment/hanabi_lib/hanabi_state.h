@@ -15,10 +15,13 @@
 #ifndef __HANABI_STATE_H__
 #define __HANABI_STATE_H__
 
+#include <cassert>
+#include <cstdint>
 #include <random>
 #include <string>
 #include <vector>
 
+#include "fixed_vector.h"
 #include "hanabi_card.h"
 #include "hanabi_game.h"
 #include "hanabi_hand.h"
@@ -29,6 +32,33 @@ namespace hanabi_learning_env {
 
 constexpr int kChancePlayerId = -1;
 
+class HanabiState;
+
+// Receives the moves applied to the states it listens to, e.g. to log games.
+class HanabiMoveListener {
+ public:
+  virtual ~HanabiMoveListener() = default;
+  // Called at the end of every ApplyMove, with the state after the move and
+  // the move's history item. Undone moves are not reported.
+  virtual void OnMove(const HanabiState& state,
+                      const HanabiHistoryItem& item) = 0;
+};
+
+// What HanabiState::UndoMove needs to take back a move, beyond what the
+// state's recent moves record. Fixed-size, so that search can keep one per
+// ply without allocating.
+struct HanabiUndoRecord {
+  // Knowledge the move destroyed: of the card played or discarded, or of
+  // every card of the hinted hand. Empty for deals.
+  FixedVector<HanabiHand::CardKnowledge, kMaxHandSize> knowledge;
+  // Hash of the hand the move changed, so that it is not rehashed.
+  uint64_t hand_hash = 0;
+  // The recent move that the move pushed out of the state's ring buffer, if
+  // it was full.
+  HanabiHistoryItem overwritten_recent_move =
+      HanabiHistoryItem(HanabiMove(HanabiMove::kInvalid, -1, -1, -1, -1));
+};
+
 class HanabiState {
  public:
   class HanabiDeck {
@@ -37,6 +67,9 @@ class HanabiState {
     // DealCard returns invalid card on failure.
     HanabiCard DealCard(int color, int rank);
     HanabiCard DealCard(std::mt19937* rng);
+    // Returns a card drawn uniformly from the remaining cards, without
+    // removing it. Returns invalid card if the deck is empty.
+    HanabiCard SampleCard(std::mt19937* rng) const;
     int Size() const { return total_count_; }
     bool Empty() const { return total_count_ == 0; }
     int CardCount(int color, int rank) const {
@@ -46,6 +79,9 @@ class HanabiState {
     void AddCard(int color, int rank);
     // Replaces the deck content with the given cards.
     void SetContent(const std::vector<HanabiCard>& cards);
+    // Zobrist hash of the card counts, kept up to date as cards are dealt
+    // and added.
+    uint64_t Hash() const { return hash_; }
 
    private:
     int CardToIndex(int color, int rank) const {
@@ -53,13 +89,16 @@ class HanabiState {
     }
     int IndexToColor(int index) const { return index / num_ranks_; }
     int IndexToRank(int index) const { return index % num_ranks_; }
+    // Changes card_count_[index] by delta, updating the hash.
+    void ChangeCount(int index, int delta);
 
     // Number of instances in the deck for each card.
     // E.g., if card_count_[CardToIndex(card)] == 2, then there are two
     // instances of card remaining in the deck, available to be dealt out.
-    std::vector<int> card_count_;
+    FixedVector<uint8_t, kMaxNumColors * kMaxNumRanks> card_count_;
     int total_count_ = -1;  // Total number of cards available to be dealt out.
     int num_ranks_ = -1;    // From game.NumRanks(), used to map card to index.
+    uint64_t hash_ = 0;
   };
 
   enum EndOfGameType {
@@ -69,17 +108,40 @@ class HanabiState {
     kCompletedFireworks  // All fireworks played.
   };
 
+  // Number of most recent moves kept by every state, enough to cover all
+  // moves since any player's last action (each move is followed by at most
+  // one deal).
+  static constexpr int kRecentMoveCapacity = 2 * kMaxPlayers;
+
   // Construct a HanabiState, initialised to the start of the game.
   // If start_player >= 0, the game-provided start player is overridden
   // and the first player after chance is start_player.
   explicit HanabiState(HanabiGame* parent_game, int start_player = -1);
   // Copy constructor for recursive game traversals using copy + apply-move.
   HanabiState(const HanabiState& state) = default;
+  // Starts a new game in place, as HanabiState(ParentGame(), start_player),
+  // except that whether the move history is recorded is unchanged and the
+  // history keeps its storage. Copies the game's InitialStateTemplate().
+  void Reset(int start_player);
 
   bool MoveIsLegal(HanabiMove move) const;
-  void ApplyMove(HanabiMove move);
+  void ApplyMove(HanabiMove move) { ApplyMove(move, nullptr); }
+  // As above, and fills *undo, unless it is null, for UndoMove.
+  void ApplyMove(HanabiMove move, HanabiUndoRecord* undo);
+  // Restores the state exactly as it was before the last move applied,
+  // given the record that move filled: tokens, fireworks, hands and their
+  // knowledge, deck, discard pile, turns, players, move counts and history.
+  // Moves can be undone back to front, e.g. along a depth-first search on a
+  // single state, provided no setter, Reset or SetRecordMoveHistory was
+  // called since they were applied. Never allocates.
+  void UndoMove(const HanabiUndoRecord& undo);
   // Legal moves for state. Moves point into an unchanging list in parent_game.
   std::vector<HanabiMove> LegalMoves(int player) const;
+  // As above, replacing the content of *moves, which keeps its capacity.
+  void LegalMoves(int player, std::vector<HanabiMove>* moves) const;
+  // Legal moves for state as a bitmask, with bit uid set if move uid is
+  // legal. Computed from hands and tokens, without testing each move.
+  uint64_t LegalMoveMask(int player) const;
   // Returns true if card with color and rank can be played on fireworks pile.
   bool CardPlayableOnFireworks(int color, int rank) const;
   bool CardPlayableOnFireworks(HanabiCard card) const {
@@ -89,6 +151,16 @@ class HanabiState {
   double ChanceOutcomeProb(HanabiMove move) const;
   void ApplyChanceOutcome(HanabiMove move) { ApplyMove(move); }
   void ApplyRandomChance();
+  // Samples the chance outcome from rng rather than the parent game's shared
+  // generator, which is not safe to use from several threads.
+  void ApplyRandomChance(std::mt19937* rng);
+  // Deals the opening hands of a state at the start of the game, leaving the
+  // first player to act. Deals the same cards, from the same draws, and
+  // records the same deal moves as calling ApplyRandomChance until then,
+  // but in one pass over the hands, without testing, dispatching and
+  // rehashing each deal. A move listener still sees every deal.
+  void DealInitialHands();
+  void DealInitialHands(std::mt19937* rng);
   // Get the valid chance moves, and associated probabilities.
   // Guaranteed that moves.size() == probabilities.size().
   std::pair<std::vector<HanabiMove>, std::vector<double>> ChanceOutcomes()
@@ -98,10 +170,28 @@ class HanabiState {
   int Score() const;
   std::string ToString() const;
 
+  // 64-bit Zobrist hash of the game position: cards and knowledge of every
+  // hand, deck counts, fireworks, tokens, turns left and the players to act.
+  // Equal positions reached by different moves hash equally; the move
+  // history and the order of the discard pile are not covered. The hand and
+  // deck parts are updated incrementally by ApplyMove and the setters, and
+  // the few scalars are mixed in on each call. Never 0.
+  uint64_t Hash() const;
+  // Hash of what observer sees of the position, equal for all states that
+  // give observer the same observation, up to the moves before the last
+  // non-deal move. Hands and players are relative to observer, observer's
+  // own cards are left out unless the game shows them, and deck counts are
+  // replaced by the counts of the cards observer has not seen. Computed on
+  // each call. Never 0.
+  uint64_t ObserverHash(int observer) const;
+
   int CurPlayer() const { return cur_player_; }
+  // The next player to act other than chance: the player after CurPlayer(),
+  // or at chance nodes, the player who acts once the cards are dealt.
+  int NextNonChancePlayer() const { return next_non_chance_player_; }
   int LifeTokens() const { return life_tokens_; }
   int InformationTokens() const { return information_tokens_; }
-  const std::vector<HanabiHand>& Hands() const { return hands_; }
+  const FixedVector<HanabiHand, kMaxPlayers>& Hands() const { return hands_; }
 
   // Manual state setters for determinization
   void SetLifeTokens(int life_tokens);
@@ -109,21 +199,64 @@ class HanabiState {
   void SetFireworks(const std::vector<int>& fireworks);
   void SetDiscardPile(const std::vector<HanabiCard>& discard_pile);
   void SetHand(int player_id, const std::vector<HanabiCard>& cards);
+  // Replaces a player's hand, cards and card knowledge. The deck is unchanged.
+  void SetHand(int player_id, const HanabiHand& hand);
   void SetDeck(const std::vector<HanabiCard>& cards);
+  // Sets the player to act, who is followed by the next player in turn.
   void SetCurPlayer(int cur_player);
+  // Sets the number of player turns left once the deck is empty.
+  void SetTurnsToPlay(int turns_to_play);
   // Replaces a specific card in a player's hand.
   // Updates deck counts (returns old card to deck, takes new card from deck).
   void SetHandCard(int player, int card_index, HanabiCard card);
+  // Replaces all cards in a player's hand, keeping the card knowledge.
+  // The old cards are returned to the deck before the new cards are taken
+  // from it, so cards may be permuted within the hand or swapped with the
+  // deck. Every new card must be available after the old ones are returned.
+  void SetHandCards(int player,
+                    const FixedVector<HanabiCard, kMaxHandSize>& cards);
 
-  const std::vector<int>& Fireworks() const { return fireworks_; }
+  const FixedVector<int, kMaxNumColors>& Fireworks() const {
+    return fireworks_;
+  }
   HanabiGame* ParentGame() const { return parent_game_; }
   const HanabiDeck& Deck() const { return deck_; }
   // Get the discard pile (the element at the back is the most recent discard.)
-  const std::vector<HanabiCard>& DiscardPile() const { return discard_pile_; }
+  const FixedVector<HanabiCard, kMaxDeckSize>& DiscardPile() const {
+    return discard_pile_;
+  }
   // Sequence of moves from beginning of game. Stored as <move, actor>.
+  // Empty if recording the full history was turned off.
   const std::vector<HanabiHistoryItem>& MoveHistory() const {
     return move_history_;
   }
+  // Whether every move is appended to MoveHistory() (the default). Turning
+  // this off keeps the state a fixed-size object, so that copies never
+  // allocate; observations only need the recent moves, which are always kept.
+  // Turning it off clears the history, turning it back on records the moves
+  // applied from then on.
+  void SetRecordMoveHistory(bool record);
+  bool RecordsMoveHistory() const { return record_move_history_; }
+  // Number of moves, including deals, applied since the start of the game.
+  int MoveCount() const { return move_count_; }
+  // Reports every move applied from now on to listener, which must outlive
+  // the state, or stops reporting if it is null. The listener belongs to
+  // this object: copies of the state do not report to it, and assigning to
+  // the state or resetting it keeps it.
+  void SetMoveListener(HanabiMoveListener* listener) {
+    move_listener_.listener = listener;
+  }
+  HanabiMoveListener* MoveListener() const { return move_listener_.listener; }
+  // Number of non-chance moves applied since the start of the game.
+  int PlayerMoveCount() const { return player_move_count_; }
+  // Number of moves available from RecentMove(),
+  // min(MoveCount(), kRecentMoveCapacity).
+  int NumRecentMoves() const { return recent_moves_.size(); }
+  // The age-th most recent move, RecentMove(0) being the last move applied.
+  const HanabiHistoryItem& RecentMove(int age) const {
+    assert(age >= 0 && age < NumRecentMoves());
+    return recent_moves_[(move_count_ - 1 - age) % kRecentMoveCapacity];
+  }
 
  private:
   // Add card to table if possible, if not lose a life token.
@@ -139,24 +272,51 @@ class HanabiState {
     return &hands_[(cur_player_ + offset) % hands_.size()];
   }
   void AdvanceToNextPlayer();  // Set cur_player to next player to act.
+  // Appends a move applied to the recent moves and the history.
+  void RecordMove(const HanabiHistoryItem& history);
   bool HintingIsLegal(HanabiMove move) const;
   int PlayerToDeal() const;  // -1 if no player needs a card.
   bool IncrementInformationTokens();
   void DecrementInformationTokens();
   void DecrementLifeTokens();
+  // Updates the hash of hands_[player] after any change to the hand.
+  void RehashHand(int player);
+  // Sets the hash of hands_[player] to one computed before.
+  void SetHandHash(int player, uint64_t hash) {
+    hands_hash_ ^= hand_hashes_[player] ^ hash;
+    hand_hashes_[player] = hash;
+  }
 
   HanabiGame* parent_game_ = nullptr;
   HanabiDeck deck_;
   // Back element of discard_pile_ is most recently discarded card.
-  std::vector<HanabiCard> discard_pile_;
-  std::vector<HanabiHand> hands_;
+  FixedVector<HanabiCard, kMaxDeckSize> discard_pile_;
+  FixedVector<HanabiHand, kMaxPlayers> hands_;
+  // Ring buffer of the last kRecentMoveCapacity moves; move i of the game is
+  // stored at index i % kRecentMoveCapacity.
+  FixedVector<HanabiHistoryItem, kRecentMoveCapacity> recent_moves_;
+  int move_count_ = 0;
+  int player_move_count_ = 0;
+  bool record_move_history_ = true;
   std::vector<HanabiHistoryItem> move_history_;
   int cur_player_ = -1;
   int next_non_chance_player_ = -1;  // Next non-chance player to act.
   int information_tokens_ = -1;
   int life_tokens_ = -1;
-  std::vector<int> fireworks_;
+  FixedVector<int, kMaxNumColors> fireworks_;
   int turns_to_play_ = -1;  // Number of turns to play once deck is empty.
+  // A listener pointer that copies and assignments leave alone.
+  struct MoveListenerSlot {
+    MoveListenerSlot() = default;
+    MoveListenerSlot(const MoveListenerSlot&) {}
+    MoveListenerSlot& operator=(const MoveListenerSlot&) { return *this; }
+    HanabiMoveListener* listener = nullptr;
+  };
+
+  MoveListenerSlot move_listener_;
+  // Zobrist hash of each hand, and of all hands together.
+  uint64_t hand_hashes_[kMaxPlayers] = {0};
+  uint64_t hands_hash_ = 0;
 };
 
 }  // namespace hanabi_learning_env
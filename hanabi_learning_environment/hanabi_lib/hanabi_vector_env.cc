@@ -0,0 +1,220 @@
+// Copyright 2018 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "hanabi_vector_env.h"
+
+#include <algorithm>
+
+#include "util.h"
+
+namespace hanabi_learning_env {
+
+HanabiVectorEnv::HanabiVectorEnv(HanabiGame* parent_game, int num_envs,
+                                 int num_threads, int first_game_index)
+    : parent_game_(parent_game),
+      encoder_(parent_game),
+      pool_(new ThreadPool(num_threads)) {
+  REQUIRE(parent_game != nullptr);
+  REQUIRE(num_envs > 0);
+  REQUIRE(first_game_index >= 0);
+  states_.reserve(num_envs);
+  rngs_.reserve(num_envs);
+  player_encoders_.reserve(num_envs * parent_game_->NumPlayers());
+  for (int i = 0; i < num_envs; ++i) {
+    std::seed_seq seed{static_cast<unsigned>(parent_game_->Seed()),
+                       static_cast<unsigned>(first_game_index + i)};
+    rngs_.emplace_back(seed);
+    states_.emplace_back(parent_game_,
+                         parent_game_->GetSampledStartPlayer(&rngs_[i]));
+    states_[i].SetRecordMoveHistory(false);
+    for (int player = 0; player < parent_game_->NumPlayers(); ++player) {
+      player_encoders_.emplace_back(parent_game_, player);
+    }
+    states_[i].DealInitialHands(&rngs_[i]);
+  }
+}
+
+HanabiVectorEnv::~HanabiVectorEnv() {
+  if (async_thread_.joinable()) {
+    {
+      std::lock_guard<std::mutex> lock(async_mutex_);
+      async_stop_ = true;
+    }
+    async_requested_.notify_one();
+    async_thread_.join();
+  }
+}
+
+void HanabiVectorEnv::Reset(const HanabiVectorEnvOutput& output) {
+  StepWait();
+  pool_->ParallelFor(NumEnvs(), [this, &output](int begin, int end) {
+    for (int i = begin; i < end; ++i) {
+      ResetGame(i);
+      if (output.rewards != nullptr) {
+        output.rewards[i] = 0;
+      }
+      if (output.dones != nullptr) {
+        output.dones[i] = 0;
+      }
+      WriteOutput(i, output);
+    }
+  });
+}
+
+bool HanabiVectorEnv::MovesAreLegal(const int* move_uids) const {
+  REQUIRE(move_uids != nullptr);
+  for (int i = 0; i < NumEnvs(); ++i) {
+    if (move_uids[i] < 0 || move_uids[i] >= NumMoves()) {
+      return false;
+    }
+    const HanabiState& state = states_[i];
+    if (((state.LegalMoveMask(state.CurPlayer()) >> move_uids[i]) & 1) == 0) {
+      return false;
+    }
+  }
+  return true;
+}
+
+bool HanabiVectorEnv::Step(const int* move_uids,
+                           const HanabiVectorEnvOutput& output) {
+  REQUIRE(move_uids != nullptr);
+  StepWait();
+  // Checked up front, so that an illegal move fails before any game of the
+  // batch is stepped rather than in ApplyMove on a worker thread.
+  if (!MovesAreLegal(move_uids)) {
+    return false;
+  }
+  StepGames(move_uids, output);
+  return true;
+}
+
+bool HanabiVectorEnv::StepAsync(const int* move_uids,
+                                const HanabiVectorEnvOutput& output) {
+  REQUIRE(move_uids != nullptr);
+  StepWait();
+  if (!MovesAreLegal(move_uids)) {
+    return false;
+  }
+  {
+    std::lock_guard<std::mutex> lock(async_mutex_);
+    async_move_uids_.assign(move_uids, move_uids + NumEnvs());
+    async_output_ = output;
+    async_step_requested_ = true;
+    async_step_pending_ = true;
+  }
+  if (!async_thread_.joinable()) {
+    async_thread_ = std::thread([this]() { AsyncLoop(); });
+  }
+  async_requested_.notify_one();
+  return true;
+}
+
+void HanabiVectorEnv::StepWait() {
+  std::unique_lock<std::mutex> lock(async_mutex_);
+  async_finished_.wait(lock, [this]() { return !async_step_pending_; });
+}
+
+void HanabiVectorEnv::AsyncLoop() {
+  std::unique_lock<std::mutex> lock(async_mutex_);
+  while (true) {
+    async_requested_.wait(
+        lock, [this]() { return async_step_requested_ || async_stop_; });
+    // The destructor waits for pending steps before stopping.
+    if (!async_step_requested_) {
+      return;
+    }
+    async_step_requested_ = false;
+    lock.unlock();
+    StepGames(async_move_uids_.data(), async_output_);
+    lock.lock();
+    async_step_pending_ = false;
+    async_finished_.notify_all();
+  }
+}
+
+void HanabiVectorEnv::StepGames(const int* move_uids,
+                                const HanabiVectorEnvOutput& output) {
+  pool_->ParallelFor(NumEnvs(), [this, move_uids, &output](int begin,
+                                                           int end) {
+    for (int i = begin; i < end; ++i) {
+      StepGame(i, move_uids[i], output);
+    }
+  });
+}
+
+void HanabiVectorEnv::StepGame(int i, int move_uid,
+                               const HanabiVectorEnvOutput& output) {
+  HanabiState& state = states_[i];
+  int last_score = state.Score();
+  state.ApplyMove(parent_game_->GetMove(move_uid));
+  DealCards(i);
+  if (output.rewards != nullptr) {
+    output.rewards[i] = state.Score() - last_score;
+  }
+  bool done = state.IsTerminal();
+  if (output.dones != nullptr) {
+    output.dones[i] = done;
+  }
+  if (done) {
+    ResetGame(i);
+  }
+  WriteOutput(i, output);
+}
+
+void HanabiVectorEnv::ResetGame(int i) {
+  // The state already records no move history.
+  states_[i].Reset(parent_game_->GetSampledStartPlayer(&rngs_[i]));
+  for (int player = 0; player < parent_game_->NumPlayers(); ++player) {
+    player_encoders_[i * parent_game_->NumPlayers() + player].Invalidate();
+  }
+  states_[i].DealInitialHands(&rngs_[i]);
+}
+
+void HanabiVectorEnv::DealCards(int i) {
+  HanabiState& state = states_[i];
+  while (state.CurPlayer() == kChancePlayerId) {
+    state.ApplyRandomChance(&rngs_[i]);
+  }
+}
+
+void HanabiVectorEnv::WriteOutput(int i, const HanabiVectorEnvOutput& output) {
+  const HanabiState& state = states_[i];
+  const int player = state.CurPlayer();
+  if (output.current_players != nullptr) {
+    output.current_players[i] = player;
+  }
+  if (output.observations != nullptr ||
+      output.packed_observations != nullptr) {
+    IncrementalCanonicalEncoder& encoder =
+        player_encoders_[i * parent_game_->NumPlayers() + player];
+    encoder.Update(state);
+    if (output.observations != nullptr) {
+      std::copy(encoder.Encoding().begin(), encoder.Encoding().end(),
+                output.observations + i * ObservationLength());
+    }
+    if (output.packed_observations != nullptr) {
+      encoder.EncodingPacked(output.packed_observations +
+                             i * PackedObservationLength());
+    }
+  }
+  if (output.legal_moves != nullptr) {
+    uint8_t* row = output.legal_moves + i * NumMoves();
+    const uint64_t mask = state.LegalMoveMask(player);
+    for (int uid = 0; uid < NumMoves(); ++uid) {
+      row[uid] = (mask >> uid) & 1;
+    }
+  }
+}
+
+}  // namespace hanabi_learning_env
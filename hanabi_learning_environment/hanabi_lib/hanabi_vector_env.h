@@ -0,0 +1,141 @@
+// Copyright 2018 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// A batch of independent Hanabi games that are stepped together, so that a
+// single call from Python can replace thousands of per-move FFI crossings.
+
+#ifndef __HANABI_VECTOR_ENV_H__
+#define __HANABI_VECTOR_ENV_H__
+
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <thread>
+#include <vector>
+
+#include "canonical_encoders.h"
+#include "hanabi_game.h"
+#include "hanabi_state.h"
+#include "thread_pool.h"
+
+namespace hanabi_learning_env {
+
+// Caller-owned output arrays, each holding one row per game. Any pointer may
+// be null to skip that output.
+struct HanabiVectorEnvOutput {
+  // Canonical encoding of the acting player's observation,
+  // [num_envs, ObservationLength()].
+  uint8_t* observations = nullptr;
+  // The same encoding packed into 64-bit words (see bit_packing.h),
+  // [num_envs, PackedObservationLength()].
+  uint64_t* packed_observations = nullptr;
+  // 1 for legal move uids of the acting player, [num_envs, MaxMoves()].
+  uint8_t* legal_moves = nullptr;
+  // Score differential of the step, [num_envs]. As in rl_env, this can be
+  // large and negative when the last life token is lost.
+  float* rewards = nullptr;
+  // 1 if the game finished during the step (and was reset), [num_envs].
+  uint8_t* dones = nullptr;
+  // Player to act in each game, [num_envs].
+  int* current_players = nullptr;
+};
+
+class HanabiVectorEnv {
+ public:
+  // All games share parent_game, which must outlive the environment. Games
+  // are split into contiguous shards stepped by num_threads threads
+  // (num_threads <= 0 uses all hardware threads). Each game draws its deals
+  // from its own generator, seeded from the game seed and the game's index
+  // plus first_game_index, so results do not depend on num_threads, and
+  // environments given disjoint index ranges play different games.
+  HanabiVectorEnv(HanabiGame* parent_game, int num_envs, int num_threads = 1,
+                  int first_game_index = 0);
+  // Waits for any step started by StepAsync.
+  ~HanabiVectorEnv();
+  HanabiVectorEnv(const HanabiVectorEnv&) = delete;
+  HanabiVectorEnv& operator=(const HanabiVectorEnv&) = delete;
+
+  int NumEnvs() const { return states_.size(); }
+  int NumThreads() const { return pool_->NumThreads(); }
+  // Number of encoding entries per game in the observations output.
+  int ObservationLength() const { return encoder_.Size(); }
+  // Number of words per game in the packed_observations output.
+  int PackedObservationLength() const { return encoder_.PackedSize(); }
+  // Number of entries per game in the legal_moves output.
+  int NumMoves() const { return parent_game_->MaxMoves(); }
+  const HanabiGame* ParentGame() const { return parent_game_; }
+  // Game i, always waiting for a player move (never at a chance node).
+  const HanabiState& State(int i) const { return states_[i]; }
+
+  // Starts a new game in every slot. Rewards and done flags are zeroed.
+  void Reset(const HanabiVectorEnvOutput& output);
+  // Returns true if move_uids[i] is a legal move of the acting player of
+  // game i for every game. Must not be called while a StepAsync step runs.
+  bool MovesAreLegal(const int* move_uids) const;
+  // Applies move_uids[i] for the acting player of game i, deals the
+  // replacement cards, and starts a new game in any slot that finished.
+  // Outputs describe the resulting (possibly new) games. Returns false,
+  // changing no game and writing no output, if any move is not legal.
+  bool Step(const int* move_uids, const HanabiVectorEnvOutput& output);
+
+  // Starts Step(move_uids, output) on a background thread and returns at
+  // once, so that the caller can work on the outputs of the previous step
+  // meanwhile, e.g. alternating between two sets of output arrays. move_uids
+  // is copied. Until StepWait() returns, output's arrays must stay valid and
+  // unread, and State() must not be called; Reset, Step and StepAsync wait
+  // for the step first. The moves are checked before the step starts: if
+  // any is not legal, returns false and starts nothing.
+  bool StepAsync(const int* move_uids, const HanabiVectorEnvOutput& output);
+  // Blocks until the step started by StepAsync has finished, if any.
+  void StepWait();
+
+ private:
+  void StepGames(const int* move_uids, const HanabiVectorEnvOutput& output);
+  // Runs the steps requested by StepAsync until the environment is
+  // destroyed.
+  void AsyncLoop();
+  void StepGame(int i, int move_uid, const HanabiVectorEnvOutput& output);
+  // Replaces game i by a new game and deals the initial hands.
+  void ResetGame(int i);
+  // Resolves chance moves until a player has to act.
+  void DealCards(int i);
+  void WriteOutput(int i, const HanabiVectorEnvOutput& output);
+
+  HanabiGame* parent_game_ = nullptr;
+  CanonicalObservationEncoder encoder_;
+  std::vector<HanabiState> states_;
+  // Observation encoder of player p in game i at i * NumPlayers() + p.
+  std::vector<IncrementalCanonicalEncoder> player_encoders_;
+  std::vector<std::mt19937> rngs_;
+  std::unique_ptr<ThreadPool> pool_;
+
+  // The step thread, started by the first StepAsync, which then drives the
+  // pool as the calling thread would.
+  std::thread async_thread_;
+  std::mutex async_mutex_;
+  std::condition_variable async_requested_;
+  std::condition_variable async_finished_;
+  std::vector<int> async_move_uids_;
+  HanabiVectorEnvOutput async_output_;
+  // Set by StepAsync, until the step has started and finished respectively.
+  bool async_step_requested_ = false;
+  bool async_step_pending_ = false;
+  bool async_stop_ = false;
+};
+
+}  // namespace hanabi_learning_env
+
+#endif
@@ -0,0 +1,202 @@
+// Copyright 2018 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "instrumentation.h"
+
+#include <mutex>
+
+#include "util.h"
+
+namespace hanabi_learning_env {
+
+namespace internal {
+std::atomic<bool> instrumentation_enabled(false);
+}  // namespace internal
+
+namespace {
+
+// The counters of one thread. Only the thread adds to them, without
+// contention; readers sum them over threads.
+struct CounterBlock {
+  CounterBlock() {
+    for (int i = 0; i < kNumInstrumentationCounters; ++i) {
+      counts[i].store(0, std::memory_order_relaxed);
+      nanoseconds[i].store(0, std::memory_order_relaxed);
+    }
+  }
+
+  std::atomic<int64_t> counts[kNumInstrumentationCounters];
+  std::atomic<int64_t> nanoseconds[kNumInstrumentationCounters];
+  CounterBlock* next = nullptr;
+};
+
+// The blocks of live threads, in an intrusive list so that registering a
+// thread never allocates (operator new counts allocations), and the totals
+// of exited threads.
+struct Registry {
+  std::mutex mutex;
+  CounterBlock* threads = nullptr;
+  CounterBlock exited;
+};
+
+// Never destroyed, so that threads exiting late can still unregister.
+Registry& GetRegistry() {
+  static Registry* registry = new Registry();
+  return *registry;
+}
+
+struct ThreadCounters {
+  ThreadCounters() {
+    Registry& registry = GetRegistry();
+    std::lock_guard<std::mutex> lock(registry.mutex);
+    block.next = registry.threads;
+    registry.threads = &block;
+  }
+
+  ~ThreadCounters() {
+    Registry& registry = GetRegistry();
+    std::lock_guard<std::mutex> lock(registry.mutex);
+    for (int i = 0; i < kNumInstrumentationCounters; ++i) {
+      registry.exited.counts[i].fetch_add(block.counts[i].load(),
+                                          std::memory_order_relaxed);
+      registry.exited.nanoseconds[i].fetch_add(block.nanoseconds[i].load(),
+                                               std::memory_order_relaxed);
+    }
+    CounterBlock** link = &registry.threads;
+    while (*link != &block) {
+      link = &(*link)->next;
+    }
+    *link = block.next;
+  }
+
+  CounterBlock block;
+  // Bit c is set while the thread is in a scope of counter c.
+  unsigned active_scopes = 0;
+};
+
+static_assert(kNumInstrumentationCounters <= 32,
+              "Active scopes must fit in an unsigned.");
+
+ThreadCounters& GetThreadCounters() {
+  thread_local ThreadCounters counters;
+  return counters;
+}
+
+void Add(CounterBlock* block, int counter, int64_t count,
+         int64_t nanoseconds) {
+  block->counts[counter].fetch_add(count, std::memory_order_relaxed);
+  if (nanoseconds != 0) {
+    block->nanoseconds[counter].fetch_add(nanoseconds,
+                                          std::memory_order_relaxed);
+  }
+}
+
+}  // namespace
+
+void SetInstrumentationEnabled(bool enabled) {
+  if (!kInstrumentationCompiled) {
+    return;
+  }
+  // Create the registry before anything is recorded, so that its
+  // allocation is not counted from within operator new.
+  GetRegistry();
+  internal::instrumentation_enabled.store(enabled, std::memory_order_relaxed);
+}
+
+const char* InstrumentationCounterName(InstrumentationCounter counter) {
+  switch (counter) {
+    case kCounterApplyPlay:
+      return "apply_play";
+    case kCounterApplyDiscard:
+      return "apply_discard";
+    case kCounterApplyRevealColor:
+      return "apply_reveal_color";
+    case kCounterApplyRevealRank:
+      return "apply_reveal_rank";
+    case kCounterApplyDeal:
+      return "apply_deal";
+    case kCounterRandomChance:
+      return "random_chance";
+    case kCounterLegalMoves:
+      return "legal_moves";
+    case kCounterObservation:
+      return "observation";
+    case kCounterEncode:
+      return "encode";
+    case kCounterCApi:
+      return "c_api";
+    case kCounterAllocation:
+      return "allocation";
+    default:
+      REQUIRE(false);
+      return nullptr;
+  }
+}
+
+void ReadInstrumentation(bool reset, InstrumentationValue* values) {
+  REQUIRE(values != nullptr);
+  for (int i = 0; i < kNumInstrumentationCounters; ++i) {
+    values[i] = InstrumentationValue();
+  }
+  Registry& registry = GetRegistry();
+  std::lock_guard<std::mutex> lock(registry.mutex);
+  auto read = [reset](std::atomic<int64_t>* value) {
+    return reset ? value->exchange(0, std::memory_order_relaxed)
+                 : value->load(std::memory_order_relaxed);
+  };
+  for (CounterBlock* block = &registry.exited; block != nullptr;
+       block = block == &registry.exited ? registry.threads : block->next) {
+    for (int i = 0; i < kNumInstrumentationCounters; ++i) {
+      values[i].count += read(&block->counts[i]);
+      values[i].nanoseconds += read(&block->nanoseconds[i]);
+    }
+  }
+}
+
+void ResetInstrumentation() {
+  InstrumentationValue values[kNumInstrumentationCounters];
+  ReadInstrumentation(/*reset=*/true, values);
+}
+
+void CountInstrumentation(InstrumentationCounter counter, int64_t count,
+                          int64_t nanoseconds) {
+  if (InstrumentationEnabled()) {
+    Add(&GetThreadCounters().block, counter, count, nanoseconds);
+  }
+}
+
+void InstrumentationScope::Begin(InstrumentationCounter counter,
+                                 int64_t count) {
+  ThreadCounters& counters = GetThreadCounters();
+  const unsigned bit = 1u << counter;
+  if (counters.active_scopes & bit) {
+    return;
+  }
+  counters.active_scopes |= bit;
+  counter_ = counter;
+  count_ = count;
+  start_ = std::chrono::steady_clock::now();
+}
+
+void InstrumentationScope::End() {
+  const int64_t nanoseconds =
+      std::chrono::duration_cast<std::chrono::nanoseconds>(
+          std::chrono::steady_clock::now() - start_)
+          .count();
+  ThreadCounters& counters = GetThreadCounters();
+  counters.active_scopes &= ~(1u << counter_);
+  Add(&counters.block, counter_, count_, nanoseconds);
+}
+
+}  // namespace hanabi_learning_env
@@ -0,0 +1,126 @@
+// Copyright 2018 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Counters and cumulative timers of the library's hot paths, for reporting
+// where time goes in production. The hooks are compiled in only with
+// HANABI_INSTRUMENTATION defined (the CMake option
+// HANABI_ENABLE_INSTRUMENTATION), and then record only while enabled at run
+// time; a disabled hook costs one relaxed load and branch. Without the
+// definition they compile to nothing and reads return zeros.
+
+#ifndef __INSTRUMENTATION_H__
+#define __INSTRUMENTATION_H__
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+
+namespace hanabi_learning_env {
+
+enum InstrumentationCounter {
+  // HanabiState::ApplyMove, by move type.
+  kCounterApplyPlay = 0,
+  kCounterApplyDiscard,
+  kCounterApplyRevealColor,
+  kCounterApplyRevealRank,
+  kCounterApplyDeal,
+  // HanabiState::ApplyRandomChance, sampling the card and dealing it, and
+  // one per card of HanabiState::DealInitialHands.
+  kCounterRandomChance,
+  kCounterLegalMoves,
+  // Construction or update of a HanabiObservation.
+  kCounterObservation,
+  // One per encoded observation, by any encoder.
+  kCounterEncode,
+  // Calls into the pyhanabi C API.
+  kCounterCApi,
+  // Calls to libpyhanabi's global operator new; untimed.
+  kCounterAllocation,
+  kNumInstrumentationCounters
+};
+
+struct InstrumentationValue {
+  int64_t count = 0;
+  // Wall-clock time spent in the counted calls. A call nested in one of the
+  // same counter is neither counted nor timed on its own.
+  int64_t nanoseconds = 0;
+};
+
+#if defined(HANABI_INSTRUMENTATION)
+constexpr bool kInstrumentationCompiled = true;
+#else
+constexpr bool kInstrumentationCompiled = false;
+#endif
+
+namespace internal {
+extern std::atomic<bool> instrumentation_enabled;
+}  // namespace internal
+
+// Starts or stops recording. No-op unless kInstrumentationCompiled.
+void SetInstrumentationEnabled(bool enabled);
+inline bool InstrumentationEnabled() {
+  return internal::instrumentation_enabled.load(std::memory_order_relaxed);
+}
+// A snake_case name for reports, e.g. "apply_play".
+const char* InstrumentationCounterName(InstrumentationCounter counter);
+// Writes the totals of all threads, live or exited, to values, indexed by
+// counter, and zeroes them if reset.
+void ReadInstrumentation(bool reset, InstrumentationValue* values);
+void ResetInstrumentation();
+// Adds to counter for the calling thread, if recording.
+void CountInstrumentation(InstrumentationCounter counter, int64_t count,
+                          int64_t nanoseconds);
+
+// Counts count calls and times its lifetime into counter while recording,
+// unless the thread is already in a scope of the same counter.
+class InstrumentationScope {
+ public:
+  explicit InstrumentationScope(InstrumentationCounter counter,
+                                int64_t count = 1) {
+    if (InstrumentationEnabled()) {
+      Begin(counter, count);
+    }
+  }
+  InstrumentationScope(const InstrumentationScope&) = delete;
+  InstrumentationScope& operator=(const InstrumentationScope&) = delete;
+  ~InstrumentationScope() {
+    if (counter_ >= 0) {
+      End();
+    }
+  }
+
+ private:
+  void Begin(InstrumentationCounter counter, int64_t count);
+  void End();
+
+  int counter_ = -1;
+  int64_t count_ = 0;
+  std::chrono::steady_clock::time_point start_;
+};
+
+}  // namespace hanabi_learning_env
+
+// Instruments the rest of the enclosing block, at most once per block.
+#if defined(HANABI_INSTRUMENTATION)
+#define HANABI_INSTRUMENT(counter) \
+  ::hanabi_learning_env::InstrumentationScope instrumentation_scope(counter)
+#define HANABI_INSTRUMENT_N(counter, count)                                 \
+  ::hanabi_learning_env::InstrumentationScope instrumentation_scope(counter, \
+                                                                     count)
+#else
+#define HANABI_INSTRUMENT(counter) static_cast<void>(0)
+#define HANABI_INSTRUMENT_N(counter, count) static_cast<void>(0)
+#endif
+
+#endif
@@ -0,0 +1,56 @@
+// Copyright 2018 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "object_pool.h"
+
+namespace hanabi_learning_env {
+
+HanabiState* HanabiStatePool::Acquire(const HanabiState& state) {
+  HanabiState* reused = Reuse();
+  if (reused == nullptr) {
+    return Add(std::unique_ptr<HanabiState>(new HanabiState(state)));
+  }
+  *reused = state;
+  return reused;
+}
+
+HanabiState* HanabiStatePool::AcquireNewGame(HanabiGame* parent_game,
+                                             int start_player,
+                                             bool record_move_history) {
+  REQUIRE(parent_game != nullptr);
+  HanabiState* state = Reuse();
+  if (state != nullptr && state->ParentGame() == parent_game) {
+    state->Reset(start_player);
+  } else if (state != nullptr) {
+    *state = HanabiState(parent_game, start_player);
+  } else {
+    state = Add(std::unique_ptr<HanabiState>(
+        new HanabiState(parent_game, start_player)));
+  }
+  state->SetRecordMoveHistory(record_move_history);
+  return state;
+}
+
+HanabiObservation* HanabiObservationPool::Acquire(const HanabiState& state,
+                                                  int observing_player) {
+  HanabiObservation* reused = Reuse();
+  if (reused == nullptr) {
+    return Add(std::unique_ptr<HanabiObservation>(
+        new HanabiObservation(state, observing_player)));
+  }
+  reused->Update(state, observing_player);
+  return reused;
+}
+
+}  // namespace hanabi_learning_env
@@ -0,0 +1,98 @@
+// Copyright 2018 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Pools of reusable states and observations, so that loops which need a
+// fresh one every step reuse the objects and their storage instead of going
+// to the heap. Pools are not thread safe; give each thread its own.
+//
+// They are for loops written against HanabiState and HanabiObservation, e.g.
+// an agent that copies states to search or builds observations to act on.
+// HanabiVectorEnv needs none: it keeps one state per game, resets it in
+// place, and encodes from the state without building observations.
+
+#ifndef __OBJECT_POOL_H__
+#define __OBJECT_POOL_H__
+
+#include <memory>
+#include <vector>
+
+#include "hanabi_observation.h"
+#include "hanabi_state.h"
+#include "util.h"
+
+namespace hanabi_learning_env {
+
+// Owns every object it hands out. Released objects are kept for reuse until
+// the pool is destroyed, so a loop that releases what it acquires stops
+// allocating once the pool holds as many objects as the loop keeps at once.
+template <typename T>
+class ObjectPool {
+ public:
+  ObjectPool() = default;
+  ObjectPool(const ObjectPool&) = delete;
+  ObjectPool& operator=(const ObjectPool&) = delete;
+
+  // Number of objects created by the pool, and how many are released.
+  int NumObjects() const { return objects_.size(); }
+  int NumAvailable() const { return available_.size(); }
+  // Returns an object acquired from this pool, which must not be used after.
+  void Release(T* object) {
+    REQUIRE(object != nullptr);
+    available_.push_back(object);
+  }
+
+ protected:
+  // A released object, or null if there is none.
+  T* Reuse() {
+    if (available_.empty()) {
+      return nullptr;
+    }
+    T* object = available_.back();
+    available_.pop_back();
+    return object;
+  }
+  T* Add(std::unique_ptr<T> object) {
+    objects_.push_back(std::move(object));
+    // Room to release every object without growing.
+    available_.reserve(objects_.size());
+    return objects_.back().get();
+  }
+
+ private:
+  std::vector<std::unique_ptr<T>> objects_;
+  std::vector<T*> available_;
+};
+
+class HanabiStatePool : public ObjectPool<HanabiState> {
+ public:
+  // Returns a copy of state. A reused state keeps the storage of its move
+  // history.
+  HanabiState* Acquire(const HanabiState& state);
+  // Returns the start of a new game of parent_game, as
+  // HanabiState(parent_game, start_player), that records its move history
+  // unless record_move_history is false.
+  HanabiState* AcquireNewGame(HanabiGame* parent_game, int start_player,
+                              bool record_move_history = true);
+};
+
+class HanabiObservationPool : public ObjectPool<HanabiObservation> {
+ public:
+  // Returns observing_player's observation of state, updated in place when
+  // an observation is reused (see HanabiObservation::Update).
+  HanabiObservation* Acquire(const HanabiState& state, int observing_player);
+};
+
+}  // namespace hanabi_learning_env
+
+#endif
@@ -18,24 +18,80 @@
 #ifndef __OBSERVATION_ENCODER_H__
 #define __OBSERVATION_ENCODER_H__
 
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <numeric>
 #include <vector>
 
+#include "bit_packing.h"
 #include "hanabi_observation.h"
+#include "hanabi_state.h"
 
 namespace hanabi_learning_env {
 
 class ObservationEncoder {
  public:
-  enum Type { kCanonical = 0 };
+  enum Type { kCanonical = 0, kBelief = 1 };
   virtual ~ObservationEncoder() = default;
 
   // Returns the shape (dimension sizes of the tensor).
   virtual std::vector<int> Shape() const = 0;
 
+  // Returns the number of elements in the encoding (the product of Shape()).
+  virtual int Size() const {
+    std::vector<int> shape = Shape();
+    return std::accumulate(shape.begin(), shape.end(), 1,
+                           std::multiplies<int>());
+  }
+
   // All of the canonical observation encodings are vectors of bits. We can
   // change this if we want something more general (e.g. floats or doubles).
   virtual std::vector<int> Encode(const HanabiObservation& obs) const = 0;
 
+  // Write the encoding into a caller-owned buffer with room for the product
+  // of Shape() elements. The default implementations copy the result of
+  // Encode(); encoders should override them to write the buffer directly.
+  virtual void EncodeInto(const HanabiObservation& obs, uint8_t* buffer) const {
+    std::vector<int> encoding = Encode(obs);
+    std::copy(encoding.begin(), encoding.end(), buffer);
+  }
+  virtual void EncodeInto(const HanabiObservation& obs, float* buffer) const {
+    std::vector<int> encoding = Encode(obs);
+    std::copy(encoding.begin(), encoding.end(), buffer);
+  }
+
+  // Write the encoding of player's observation of state, as
+  // EncodeInto(HanabiObservation(state, player), buffer). Encoders can
+  // override these to read the state without building the observation.
+  virtual void EncodeStateInto(const HanabiState& state, int player,
+                               uint8_t* buffer) const {
+    EncodeInto(HanabiObservation(state, player), buffer);
+  }
+  virtual void EncodeStateInto(const HanabiState& state, int player,
+                               float* buffer) const {
+    EncodeInto(HanabiObservation(state, player), buffer);
+  }
+
+  // Number of 64-bit words in a packed encoding (see bit_packing.h).
+  int PackedSize() const { return PackedLength(Size()); }
+
+  // Write the encoding packed into PackedSize() words of a caller-owned
+  // buffer. Only meaningful for encodings of bits. The default
+  // implementations pack the result of EncodeInto().
+  virtual void EncodePackedInto(const HanabiObservation& obs,
+                                uint64_t* buffer) const {
+    std::vector<uint8_t> bits(Size());
+    EncodeInto(obs, bits.data());
+    PackBits(bits.data(), bits.size(), buffer);
+  }
+  virtual void EncodeStatePackedInto(const HanabiState& state, int player,
+                                     uint64_t* buffer) const {
+    std::vector<uint8_t> bits(Size());
+    EncodeStateInto(state, player, bits.data());
+    PackBits(bits.data(), bits.size(), buffer);
+  }
+
   // Return the type of this encoder.
   virtual Type type() const = 0;
 };
@@ -0,0 +1,305 @@
+// Copyright 2018 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "replay_buffer.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#include "bit_packing.h"
+#include "util.h"
+
+namespace hanabi_learning_env {
+
+namespace {
+
+// Draws per sampled transition before Sample gives up, for buffers holding
+// few sampleable transitions.
+constexpr int kMaxSampleAttempts = 1000;
+
+}  // namespace
+
+SumTree::SumTree(int capacity) : capacity_(capacity) {
+  REQUIRE(capacity > 0);
+  while (num_leaves_ < capacity) {
+    num_leaves_ *= 2;
+  }
+  nodes_.resize(2 * num_leaves_, 0);
+}
+
+void SumTree::Set(int index, double priority) {
+  REQUIRE(index >= 0 && index < capacity_);
+  REQUIRE(priority >= 0);
+  max_recorded_priority_ = std::max(max_recorded_priority_, priority);
+  int node = num_leaves_ + index;
+  nodes_[node] = priority;
+  // Recompute rather than add the difference, so sums do not drift.
+  for (node /= 2; node >= 1; node /= 2) {
+    nodes_[node] = nodes_[2 * node] + nodes_[2 * node + 1];
+  }
+}
+
+int SumTree::Find(double query) const {
+  REQUIRE(Total() > 0);
+  int node = 1;
+  while (node < num_leaves_) {
+    const double left = nodes_[2 * node];
+    // Rounding may leave query past the last positive leaf; every positive
+    // node has a positive child, so stay left of zero subtrees.
+    if (query < left || nodes_[2 * node + 1] <= 0) {
+      node = 2 * node;
+    } else {
+      query -= left;
+      node = 2 * node + 1;
+    }
+  }
+  return node - num_leaves_;
+}
+
+void SumTree::StratifiedSample(int num_samples, std::mt19937* rng,
+                               int* indices) const {
+  REQUIRE(num_samples > 0);
+  std::uniform_real_distribution<double> uniform(0, 1);
+  const double stratum = Total() / num_samples;
+  for (int i = 0; i < num_samples; ++i) {
+    indices[i] = Find((i + uniform(*rng)) * stratum);
+  }
+}
+
+ReplayBuffer::ReplayBuffer(const ReplayBufferConfig& config)
+    : config_(config),
+      words_(PackedLength(config.observation_bits)),
+      sum_tree_(config.prioritized ? config.capacity : 1) {
+  REQUIRE(config.observation_bits > 0);
+  REQUIRE(config.num_moves > 0 && config.num_moves <= 64);
+  REQUIRE(config.stack_size >= 1 && config.update_horizon >= 1);
+  // Room for a sampleable transition: its state and next state.
+  REQUIRE(config.capacity >= config.stack_size + config.update_horizon);
+  observations_.resize(static_cast<int64_t>(config.capacity) * words_);
+  actions_.resize(config.capacity);
+  rewards_.resize(config.capacity);
+  terminals_.resize(config.capacity);
+  legal_moves_.resize(config.capacity);
+  for (int i = 0; i < config.update_horizon; ++i) {
+    discounts_.push_back(std::pow(config.gamma, i));
+  }
+  int seed = config.seed;
+  while (seed == -1) {
+    seed = std::random_device()();
+  }
+  rng_.seed(seed);
+}
+
+int ReplayBuffer::Size() const {
+  return std::min<int64_t>(add_count_, config_.capacity);
+}
+
+void ReplayBuffer::Add(const uint64_t* packed_observation, int action,
+                       float reward, bool terminal, uint64_t legal_moves) {
+  REQUIRE(packed_observation != nullptr);
+  REQUIRE(action >= 0 && action < config_.num_moves);
+  if (add_count_ == 0 || terminals_[Index(add_count_ - 1)]) {
+    const std::vector<uint64_t> padding(words_, 0);
+    for (int i = 0; i < config_.stack_size - 1; ++i) {
+      AddTransition(padding.data(), 0, 0, false, 0, 0);
+    }
+  }
+  AddTransition(packed_observation, action, reward, terminal, legal_moves,
+                sum_tree_.MaxRecordedPriority());
+}
+
+void ReplayBuffer::Add(const uint8_t* observation, int action, float reward,
+                       bool terminal, uint64_t legal_moves) {
+  REQUIRE(observation != nullptr);
+  std::vector<uint64_t> packed(words_);
+  PackBits(observation, config_.observation_bits, packed.data());
+  Add(packed.data(), action, reward, terminal, legal_moves);
+}
+
+void ReplayBuffer::AddTransition(const uint64_t* packed_observation,
+                                 int action, float reward, bool terminal,
+                                 uint64_t legal_moves, double priority) {
+  const int index = Index(add_count_);
+  std::memcpy(&observations_[static_cast<int64_t>(index) * words_],
+              packed_observation, words_ * sizeof(uint64_t));
+  actions_[index] = action;
+  rewards_[index] = reward;
+  terminals_[index] = terminal;
+  legal_moves_[index] = legal_moves;
+  if (config_.prioritized) {
+    sum_tree_.Set(index, priority);
+  }
+  ++add_count_;
+}
+
+int64_t ReplayBuffer::Position(int index) const {
+  REQUIRE(index >= 0 && index < Size());
+  if (add_count_ <= config_.capacity) {
+    return index;
+  }
+  const int64_t oldest = add_count_ - config_.capacity;
+  return oldest + (index - Index(oldest) + config_.capacity) %
+                      config_.capacity;
+}
+
+bool ReplayBuffer::IsSampleable(int index) const {
+  if (index < 0 || index >= Size()) {
+    return false;
+  }
+  const int64_t position = Position(index);
+  const int64_t first = position - config_.stack_size + 1;
+  if (first < std::max<int64_t>(0, add_count_ - config_.capacity) ||
+      position + config_.update_horizon >= add_count_) {
+    return false;
+  }
+  for (int64_t p = first; p < position; ++p) {
+    if (terminals_[Index(p)]) {
+      return false;
+    }
+  }
+  return true;
+}
+
+bool ReplayBuffer::Sample(int batch_size, int* indices) {
+  REQUIRE(batch_size > 0 && indices != nullptr);
+  const int64_t first = std::max<int64_t>(0, add_count_ - config_.capacity) +
+                        config_.stack_size - 1;
+  const int64_t last = add_count_ - 1 - config_.update_horizon;
+  if (last < first || (config_.prioritized && sum_tree_.Total() <= 0)) {
+    return false;
+  }
+  std::uniform_int_distribution<int64_t> uniform_position(first, last);
+  std::uniform_real_distribution<double> uniform(0, 1);
+  if (config_.prioritized) {
+    sum_tree_.StratifiedSample(batch_size, &rng_, indices);
+  }
+  int attempts = 0;
+  for (int i = 0; i < batch_size; ++i) {
+    if (!config_.prioritized) {
+      indices[i] = Index(uniform_position(rng_));
+    }
+    // Redraw transitions too close to the cursor or to an episode start.
+    while (!IsSampleable(indices[i])) {
+      if (++attempts > kMaxSampleAttempts * batch_size) {
+        return false;
+      }
+      indices[i] = config_.prioritized
+                       ? sum_tree_.Find(uniform(rng_) * sum_tree_.Total())
+                       : Index(uniform_position(rng_));
+    }
+  }
+  return true;
+}
+
+void ReplayBuffer::GetState(int64_t position, uint8_t* state,
+                            uint64_t* packed_state,
+                            std::vector<uint8_t>* frame) const {
+  const int stack_size = config_.stack_size;
+  const int bits = config_.observation_bits;
+  for (int s = 0; s < stack_size; ++s) {
+    const int index = Index(position - stack_size + 1 + s);
+    const uint64_t* words =
+        &observations_[static_cast<int64_t>(index) * words_];
+    if (packed_state != nullptr) {
+      std::memcpy(packed_state + s * words_, words,
+                  words_ * sizeof(uint64_t));
+    }
+    if (state == nullptr) {
+      continue;
+    }
+    if (stack_size == 1) {
+      UnpackBits(words, bits, state);
+      continue;
+    }
+    // Unpacked states are laid out [bits, stack_size].
+    uint8_t* values = frame->data();
+    UnpackBits(words, bits, values);
+    for (int b = 0; b < bits; ++b) {
+      state[b * stack_size + s] = values[b];
+    }
+  }
+}
+
+void ReplayBuffer::GetTransitions(int batch_size, const int* indices,
+                                  const ReplayBatch& batch) const {
+  REQUIRE(batch_size >= 0 && indices != nullptr);
+  const int64_t state_size =
+      static_cast<int64_t>(config_.observation_bits) * config_.stack_size;
+  const int64_t packed_state_size =
+      static_cast<int64_t>(words_) * config_.stack_size;
+  std::vector<uint8_t> frame(config_.observation_bits);
+  for (int i = 0; i < batch_size; ++i) {
+    const int64_t position = Position(indices[i]);
+    const int64_t next_position = position + config_.update_horizon;
+    REQUIRE(position - config_.stack_size + 1 >=
+                std::max<int64_t>(0, add_count_ - config_.capacity) &&
+            next_position < add_count_);
+    GetState(position,
+             batch.states != nullptr ? batch.states + i * state_size
+                                     : nullptr,
+             batch.packed_states != nullptr
+                 ? batch.packed_states + i * packed_state_size
+                 : nullptr,
+             &frame);
+    GetState(next_position,
+             batch.next_states != nullptr ? batch.next_states + i * state_size
+                                          : nullptr,
+             batch.packed_next_states != nullptr
+                 ? batch.packed_next_states + i * packed_state_size
+                 : nullptr,
+             &frame);
+    float reward = 0;
+    bool terminal = false;
+    for (int j = 0; j < config_.update_horizon && !terminal; ++j) {
+      const int index = Index(position + j);
+      reward += discounts_[j] * rewards_[index];
+      terminal = terminals_[index];
+    }
+    if (batch.actions != nullptr) {
+      batch.actions[i] = actions_[indices[i]];
+    }
+    if (batch.rewards != nullptr) {
+      batch.rewards[i] = reward;
+    }
+    if (batch.terminals != nullptr) {
+      batch.terminals[i] = terminal;
+    }
+    if (batch.next_legal_moves != nullptr) {
+      ExpandBits(legal_moves_[Index(next_position)], config_.num_moves,
+                 batch.next_legal_moves +
+                     static_cast<int64_t>(i) * config_.num_moves);
+    }
+  }
+}
+
+void ReplayBuffer::SetPriorities(int count, const int* indices,
+                                 const float* priorities) {
+  REQUIRE(config_.prioritized);
+  for (int i = 0; i < count; ++i) {
+    REQUIRE(indices[i] >= 0 && indices[i] < Size());
+    sum_tree_.Set(indices[i], priorities[i]);
+  }
+}
+
+void ReplayBuffer::GetPriorities(int count, const int* indices,
+                                 float* priorities) const {
+  REQUIRE(config_.prioritized);
+  for (int i = 0; i < count; ++i) {
+    REQUIRE(indices[i] >= 0 && indices[i] < config_.capacity);
+    priorities[i] = sum_tree_.Get(indices[i]);
+  }
+}
+
+}  // namespace hanabi_learning_env
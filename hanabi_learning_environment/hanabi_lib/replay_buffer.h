@@ -0,0 +1,172 @@
+// Copyright 2018 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// A native circular replay memory of packed observations, with n-step
+// returns, frame stacking and prioritized sampling, following the
+// semantics of agents/rainbow/replay_memory.py and
+// prioritized_replay_memory.py without per-transition Python work.
+
+#ifndef __REPLAY_BUFFER_H__
+#define __REPLAY_BUFFER_H__
+
+#include <cstdint>
+#include <random>
+#include <vector>
+
+namespace hanabi_learning_env {
+
+// A complete binary tree whose leaves hold nonnegative priorities and whose
+// inner nodes hold the sums of their subtrees, for sampling leaf i with
+// probability Get(i) / Total() in O(log capacity).
+class SumTree {
+ public:
+  explicit SumTree(int capacity);
+
+  int Capacity() const { return capacity_; }
+  double Total() const { return nodes_[1]; }
+  double Get(int index) const { return nodes_[num_leaves_ + index]; }
+  // The largest priority ever set, and at least 1.
+  double MaxRecordedPriority() const { return max_recorded_priority_; }
+  void Set(int index, double priority);
+  // Returns the leaf whose interval of the cumulative priorities holds
+  // query, in [0, Total()). Leaves of priority 0 are never returned.
+  int Find(double query) const;
+  // Splits [0, Total()) into num_samples equal strata and writes one leaf
+  // drawn from each to indices (Schaul et al., 2015). Total() must be > 0.
+  void StratifiedSample(int num_samples, std::mt19937* rng,
+                        int* indices) const;
+
+ private:
+  int capacity_;
+  // Leaves, rounded up to a power of two.
+  int num_leaves_ = 1;
+  double max_recorded_priority_ = 1;
+  // Heap layout: the root is node 1, the children of node i are 2i and
+  // 2i + 1, and leaf i is node num_leaves_ + i.
+  std::vector<double> nodes_;
+};
+
+struct ReplayBufferConfig {
+  // Bits of each observation, as encoded by an ObservationEncoder.
+  int observation_bits = 0;
+  // Number of move uids, at most 64.
+  int num_moves = 0;
+  // Number of transitions kept; the oldest are overwritten.
+  int capacity = 0;
+  // Observations per state: a state is the observation of its transition
+  // and those of the stack_size - 1 transitions before it.
+  int stack_size = 1;
+  // n of the n-step returns.
+  int update_horizon = 1;
+  float gamma = 1;
+  // Whether Sample draws transitions by priority rather than uniformly.
+  bool prioritized = false;
+  // Seed of the sampling generator, -1 for a random seed.
+  int seed = -1;
+};
+
+// The outputs of ReplayBuffer::GetTransitions, one row per transition.
+// Any pointer may be null to skip that output.
+struct ReplayBatch {
+  // [batch, observation_bits, stack_size], the layout of the state batches
+  // of replay_memory.py, oldest observation first.
+  uint8_t* states = nullptr;
+  // [batch, stack_size, PackedObservationLength()], the packed observations.
+  uint64_t* packed_states = nullptr;
+  int* actions = nullptr;
+  // Discounted rewards of the next update_horizon transitions, stopping at
+  // the end of the episode.
+  float* rewards = nullptr;
+  // The state update_horizon transitions later.
+  uint8_t* next_states = nullptr;
+  uint64_t* packed_next_states = nullptr;
+  // 1 if the episode ends within the next update_horizon transitions.
+  uint8_t* terminals = nullptr;
+  // [batch, num_moves], 1 for the legal moves of the next state.
+  uint8_t* next_legal_moves = nullptr;
+};
+
+// A circular buffer of transitions (observation, action, reward, terminal,
+// legal moves), each the observation an agent acted on and what followed.
+// Observations are stored once, packed, and states are stacked by index only
+// when sampled. As in replay_memory.py, every episode is preceded by
+// stack_size - 1 zero transitions, so that the states of its first
+// transitions are padded with zeros; those are never sampled.
+//
+// A transition can be sampled once its next state has been added, if its
+// state does not reach into an earlier episode or past the oldest
+// transition kept. Not thread-safe.
+class ReplayBuffer {
+ public:
+  explicit ReplayBuffer(const ReplayBufferConfig& config);
+  ReplayBuffer(const ReplayBuffer&) = delete;
+  ReplayBuffer& operator=(const ReplayBuffer&) = delete;
+
+  const ReplayBufferConfig& Config() const { return config_; }
+  int PackedObservationLength() const { return words_; }
+  // Number of transitions added, padding included.
+  int64_t AddCount() const { return add_count_; }
+  // Number of transitions held.
+  int Size() const;
+
+  // Adds a transition whose observation is packed as by
+  // ObservationEncoder::EncodePacked, and whose legal moves have bit uid set
+  // for each legal move uid. New transitions get MaxRecordedPriority().
+  void Add(const uint64_t* packed_observation, int action, float reward,
+           bool terminal, uint64_t legal_moves);
+  // As above, for an observation of one value per bit.
+  void Add(const uint8_t* observation, int action, float reward,
+           bool terminal, uint64_t legal_moves);
+
+  // Draws batch_size sampleable transitions, into indices, uniformly or by
+  // priority (stratified). Returns false if too few could be found.
+  bool Sample(int batch_size, int* indices);
+  void GetTransitions(int batch_size, const int* indices,
+                      const ReplayBatch& batch) const;
+  bool IsSampleable(int index) const;
+
+  // Priorities of transitions, for prioritized buffers.
+  void SetPriorities(int count, const int* indices, const float* priorities);
+  void GetPriorities(int count, const int* indices, float* priorities) const;
+  const SumTree& Priorities() const { return sum_tree_; }
+
+ private:
+  void AddTransition(const uint64_t* packed_observation, int action,
+                     float reward, bool terminal, uint64_t legal_moves,
+                     double priority);
+  // Number of transitions added before the one at index, which is held.
+  int64_t Position(int index) const;
+  int Index(int64_t position) const { return position % config_.capacity; }
+  // Writes the state ending at position, unpacking its observations through
+  // frame, of observation_bits values.
+  void GetState(int64_t position, uint8_t* state, uint64_t* packed_state,
+                std::vector<uint8_t>* frame) const;
+
+  ReplayBufferConfig config_;
+  int words_;
+  int64_t add_count_ = 0;
+  std::vector<uint64_t> observations_;
+  std::vector<int> actions_;
+  std::vector<float> rewards_;
+  std::vector<uint8_t> terminals_;
+  std::vector<uint64_t> legal_moves_;
+  // gamma^i for i < update_horizon.
+  std::vector<float> discounts_;
+  SumTree sum_tree_;
+  std::mt19937 rng_;
+};
+
+}  // namespace hanabi_learning_env
+
+#endif
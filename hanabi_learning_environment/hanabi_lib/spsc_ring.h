@@ -0,0 +1,144 @@
+// Copyright 2018 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// A lock-free single-producer, single-consumer ring of fixed-size slots, in
+// memory that may be shared between processes. Producer and consumer work in
+// the slots in place: the producer fills the next free slot and commits it,
+// and the consumer reads committed slots for as long as it needs before
+// releasing them.
+
+#ifndef __SPSC_RING_H__
+#define __SPSC_RING_H__
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <new>
+#include <thread>
+
+#include "util.h"
+
+namespace hanabi_learning_env {
+
+// Atomics in memory shared between processes must not depend on a lock
+// inside each process.
+static_assert(ATOMIC_LLONG_LOCK_FREE == 2 && ATOMIC_INT_LOCK_FREE == 2,
+              "Shared rings need lock-free 32 and 64-bit atomics.");
+
+// The positions of a ring, kept with the slots: the number of slots
+// committed and released so far. Each is written by one side only, and they
+// are on separate cache lines so that the sides do not contend.
+struct SpscRingIndices {
+  // Sets both positions to zero, e.g. in newly mapped memory.
+  void Initialize() {
+    new (&committed) std::atomic<uint64_t>(0);
+    new (&released) std::atomic<uint64_t>(0);
+  }
+
+  alignas(64) std::atomic<uint64_t> committed;
+  alignas(64) std::atomic<uint64_t> released;
+};
+
+// A view of a ring whose indices and capacity slots of slot_size bytes each
+// are owned elsewhere. Slot i of the ring's lifetime is at i % capacity.
+class SpscRing {
+ public:
+  SpscRing() = default;
+  SpscRing(SpscRingIndices* indices, uint8_t* slots, int capacity,
+           int64_t slot_size)
+      : indices_(indices),
+        slots_(slots),
+        capacity_(capacity),
+        slot_size_(slot_size) {
+    REQUIRE(indices != nullptr && slots != nullptr);
+    REQUIRE(capacity > 0 && slot_size > 0);
+  }
+
+  int Capacity() const { return capacity_; }
+
+  // Producer: the next slot to fill, or null while the ring is full.
+  uint8_t* WriteSlot() const {
+    const uint64_t committed =
+        indices_->committed.load(std::memory_order_relaxed);
+    if (committed - indices_->released.load(std::memory_order_acquire) >=
+        static_cast<uint64_t>(capacity_)) {
+      return nullptr;
+    }
+    return Slot(committed);
+  }
+  // Producer: publishes the slot returned by WriteSlot.
+  void Commit() {
+    indices_->committed.fetch_add(1, std::memory_order_release);
+  }
+
+  // Consumer: the number of committed slots not yet released.
+  int Readable() const {
+    return indices_->committed.load(std::memory_order_acquire) -
+           indices_->released.load(std::memory_order_relaxed);
+  }
+  // Consumer: the index-th oldest of the Readable() slots.
+  const uint8_t* ReadSlot(int index = 0) const {
+    return Slot(indices_->released.load(std::memory_order_relaxed) + index);
+  }
+  // Consumer: hands the oldest readable slot back to the producer.
+  void Release() {
+    indices_->released.fetch_add(1, std::memory_order_release);
+  }
+
+ private:
+  uint8_t* Slot(uint64_t position) const {
+    return slots_ + static_cast<int64_t>(position % capacity_) * slot_size_;
+  }
+
+  SpscRingIndices* indices_ = nullptr;
+  uint8_t* slots_ = nullptr;
+  int capacity_ = 0;
+  int64_t slot_size_ = 0;
+};
+
+// Waits for the other side of a ring without a system call at first, then
+// yielding the processor, then sleeping for growing periods, so that a
+// quick reply is seen at once and an idle side costs little.
+class SpscBackoff {
+ public:
+  void Wait() {
+    if (rounds_ < kSpinRounds) {
+      ++rounds_;
+    } else if (rounds_ < kSpinRounds + kYieldRounds) {
+      ++rounds_;
+      std::this_thread::yield();
+    } else {
+      std::this_thread::sleep_for(std::chrono::microseconds(sleep_us_));
+      if (sleep_us_ < kMaxSleepUs) {
+        sleep_us_ *= 2;
+      }
+    }
+  }
+  void Reset() {
+    rounds_ = 0;
+    sleep_us_ = 1;
+  }
+
+ private:
+  static constexpr int kSpinRounds = 64;
+  static constexpr int kYieldRounds = 2048;
+  static constexpr int kMaxSleepUs = 200;
+
+  int rounds_ = 0;
+  int sleep_us_ = 1;
+};
+
+}  // namespace hanabi_learning_env
+
+#endif
@@ -0,0 +1,34 @@
+// Copyright 2018 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "static_game.h"
+
+namespace hanabi_learning_env {
+
+StaticGameVariant FindStaticGameVariant(int num_colors, int num_ranks,
+                                        int num_players, int hand_size) {
+  if (num_ranks != 5 || num_players < 2 || num_players > 5) {
+    return kGenericGame;
+  }
+  if (num_colors == 5 && hand_size == (num_players < 4 ? 5 : 4)) {
+    return static_cast<StaticGameVariant>(kFullGame2Players + num_players - 2);
+  }
+  if (num_colors == 2 && hand_size == 2) {
+    return static_cast<StaticGameVariant>(kSmallGame2Players + num_players -
+                                          2);
+  }
+  return kGenericGame;
+}
+
+}  // namespace hanabi_learning_env
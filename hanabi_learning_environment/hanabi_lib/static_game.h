@@ -0,0 +1,123 @@
+// Copyright 2018 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Views of a HanabiGame whose dimensions are compile-time constants, so that
+// hot loops templated on the game type (encoders, legal move masks) are
+// unrolled for the common variants and run generically for the others.
+
+#ifndef __STATIC_GAME_H__
+#define __STATIC_GAME_H__
+
+#include <cassert>
+
+#include "hanabi_game.h"
+#include "util.h"
+
+namespace hanabi_learning_env {
+
+// Has the dimension accessors of HanabiGame as constexpr functions, and
+// forwards the other rules to the game it views. Code templated on the game
+// type takes either a StaticGame or a HanabiGame.
+template <int Colors, int Ranks, int Players, int HandSizeValue>
+class StaticGame {
+ public:
+  static_assert(Colors >= 1 && Colors <= kMaxNumColors, "Bad color count.");
+  static_assert(Ranks >= 1 && Ranks <= kMaxNumRanks, "Bad rank count.");
+  static_assert(Players >= 2 && Players <= kMaxPlayers, "Bad player count.");
+  static_assert(HandSizeValue >= 1 && HandSizeValue <= kMaxHandSize,
+                "Bad hand size.");
+
+  explicit StaticGame(const HanabiGame& game) : game_(game) {
+    assert(game.NumColors() == Colors && game.NumRanks() == Ranks &&
+           game.NumPlayers() == Players && game.HandSize() == HandSizeValue);
+  }
+
+  static constexpr int NumColors() { return Colors; }
+  static constexpr int NumRanks() { return Ranks; }
+  static constexpr int NumPlayers() { return Players; }
+  static constexpr int HandSize() { return HandSizeValue; }
+  // As the HanabiGame rules: three of the lowest rank, one of the highest,
+  // two of the others.
+  static constexpr int NumberCardInstances(int color, int rank) {
+    return (color < 0 || color >= Colors || rank < 0 || rank >= Ranks)
+               ? 0
+               : (rank == 0 ? 3 : (rank == Ranks - 1 ? 1 : 2));
+  }
+  static constexpr int CardsPerColor() { return Ranks == 1 ? 3 : 2 * Ranks; }
+  static constexpr int MaxDeckSize() { return CardsPerColor() * Colors; }
+  static constexpr int MaxMoves() {
+    return 2 * HandSizeValue + (Players - 1) * (Colors + Ranks);
+  }
+
+  int MaxInformationTokens() const { return game_.MaxInformationTokens(); }
+  int MaxLifeTokens() const { return game_.MaxLifeTokens(); }
+  HanabiGame::AgentObservationType ObservationType() const {
+    return game_.ObservationType();
+  }
+  const HanabiGame& Game() const { return game_; }
+
+ private:
+  const HanabiGame& game_;
+};
+
+// Variants with a StaticGame specialization, as HanabiGame::StaticVariant():
+// the Hanabi-Full and Hanabi-Small rules of rl_env.make() for 2 to 5
+// players.
+enum StaticGameVariant {
+  kGenericGame = 0,
+  kFullGame2Players,
+  kFullGame3Players,
+  kFullGame4Players,
+  kFullGame5Players,
+  kSmallGame2Players,
+  kSmallGame3Players,
+  kSmallGame4Players,
+  kSmallGame5Players,
+};
+
+// Returns the variant of a game with these dimensions, or kGenericGame.
+StaticGameVariant FindStaticGameVariant(int num_colors, int num_ranks,
+                                        int num_players, int hand_size);
+
+// Returns fn(view) for the StaticGame view of game if it has a specialized
+// variant, and fn(game) otherwise. fn has a templated operator() taking a
+// const reference to either type; its return type must not depend on it.
+template <typename Fn>
+auto DispatchStaticGame(const HanabiGame& game, const Fn& fn)
+    -> decltype(fn(game)) {
+  switch (game.StaticVariant()) {
+    case kFullGame2Players:
+      return fn(StaticGame<5, 5, 2, 5>(game));
+    case kFullGame3Players:
+      return fn(StaticGame<5, 5, 3, 5>(game));
+    case kFullGame4Players:
+      return fn(StaticGame<5, 5, 4, 4>(game));
+    case kFullGame5Players:
+      return fn(StaticGame<5, 5, 5, 4>(game));
+    case kSmallGame2Players:
+      return fn(StaticGame<2, 5, 2, 2>(game));
+    case kSmallGame3Players:
+      return fn(StaticGame<2, 5, 3, 2>(game));
+    case kSmallGame4Players:
+      return fn(StaticGame<2, 5, 4, 2>(game));
+    case kSmallGame5Players:
+      return fn(StaticGame<2, 5, 5, 2>(game));
+    default:
+      return fn(game);
+  }
+}
+
+}  // namespace hanabi_learning_env
+
+#endif
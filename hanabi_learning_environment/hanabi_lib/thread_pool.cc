@@ -0,0 +1,104 @@
+// Copyright 2018 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "thread_pool.h"
+
+#include <algorithm>
+
+#include "util.h"
+
+namespace hanabi_learning_env {
+
+ThreadPool::ThreadPool(int num_threads) {
+  if (num_threads <= 0) {
+    num_threads = std::max(1u, std::thread::hardware_concurrency());
+  }
+  workers_.reserve(num_threads - 1);
+  for (int shard = 1; shard < num_threads; ++shard) {
+    workers_.emplace_back(&ThreadPool::WorkerLoop, this, shard);
+  }
+}
+
+ThreadPool::~ThreadPool() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stop_ = true;
+  }
+  work_ready_.notify_all();
+  for (std::thread& worker : workers_) {
+    worker.join();
+  }
+}
+
+void ThreadPool::Run(int size, const void* loop, LoopFunction function) {
+  REQUIRE(size >= 0);
+  if (workers_.empty()) {
+    if (size > 0) {
+      function(loop, 0, size);
+    }
+    return;
+  }
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    REQUIRE(pending_ == 0);
+    loop_ = loop;
+    function_ = function;
+    size_ = size;
+    pending_ = workers_.size();
+    ++generation_;
+  }
+  work_ready_.notify_all();
+  RunShard(0);
+  std::unique_lock<std::mutex> lock(mutex_);
+  work_done_.wait(lock, [this] { return pending_ == 0; });
+  loop_ = nullptr;
+  function_ = nullptr;
+}
+
+void ThreadPool::WorkerLoop(int shard) {
+  int last_generation = 0;
+  while (true) {
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      work_ready_.wait(lock, [this, last_generation] {
+        return stop_ || generation_ != last_generation;
+      });
+      if (stop_) {
+        return;
+      }
+      last_generation = generation_;
+    }
+    RunShard(shard);
+    bool last_shard;
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      last_shard = --pending_ == 0;
+    }
+    if (last_shard) {
+      work_done_.notify_one();
+    }
+  }
+}
+
+void ThreadPool::RunShard(int shard) const {
+  // loop_, function_ and size_ are only written while no shard is pending.
+  const int num_shards = NumThreads();
+  const int begin = static_cast<long long>(size_) * shard / num_shards;
+  const int end = static_cast<long long>(size_) * (shard + 1) / num_shards;
+  if (begin < end) {
+    function_(loop_, begin, end);
+  }
+}
+
+}  // namespace hanabi_learning_env
@@ -0,0 +1,74 @@
+// Copyright 2018 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef __THREAD_POOL_H__
+#define __THREAD_POOL_H__
+
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace hanabi_learning_env {
+
+// A fixed set of worker threads that run one data-parallel loop at a time.
+// The calling thread takes part in every loop, so a pool of one thread starts
+// no workers and runs everything inline.
+class ThreadPool {
+ public:
+  // num_threads <= 0 uses the number of hardware threads.
+  explicit ThreadPool(int num_threads);
+  ~ThreadPool();
+  ThreadPool(const ThreadPool&) = delete;
+  ThreadPool& operator=(const ThreadPool&) = delete;
+
+  int NumThreads() const { return workers_.size() + 1; }
+
+  // Splits [0, size) into NumThreads() contiguous shards and calls
+  // fn(begin, end) once per non-empty shard, returning once all are done.
+  // Shard boundaries depend only on size and NumThreads(). Not reentrant:
+  // only one thread may call ParallelFor at a time. fn is called through a
+  // pointer rather than copied into a std::function, so that parallel loops
+  // never allocate.
+  template <typename Fn>
+  void ParallelFor(int size, const Fn& fn) {
+    Run(size, &fn, [](const void* loop, int begin, int end) {
+      (*static_cast<const Fn*>(loop))(begin, end);
+    });
+  }
+
+ private:
+  using LoopFunction = void (*)(const void* loop, int begin, int end);
+
+  void Run(int size, const void* loop, LoopFunction function);
+  void WorkerLoop(int shard);
+  void RunShard(int shard) const;
+
+  std::vector<std::thread> workers_;
+  std::mutex mutex_;
+  std::condition_variable work_ready_;
+  std::condition_variable work_done_;
+  // Current loop, valid while pending_ > 0: function_(loop_, begin, end).
+  const void* loop_ = nullptr;
+  LoopFunction function_ = nullptr;
+  int size_ = 0;
+  // Incremented for every loop, so that workers run each loop exactly once.
+  int generation_ = 0;
+  int pending_ = 0;
+  bool stop_ = false;
+};
+
+}  // namespace hanabi_learning_env
+
+#endif
@@ -0,0 +1,127 @@
+// Copyright 2018 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// A fixed-size, lock-free cache keyed by 64-bit hashes such as
+// HanabiState::Hash(), for transpositions in search and for memoizing
+// per-state or per-observation results.
+
+#ifndef __TRANSPOSITION_TABLE_H__
+#define __TRANSPOSITION_TABLE_H__
+
+#include <atomic>
+#include <cassert>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <type_traits>
+
+#include "util.h"
+
+namespace hanabi_learning_env {
+
+// Maps keys to values of type T, a trivially copyable type of at most 8
+// bytes, e.g. a packed visit count and value, or an index into a cache of
+// encodings. Entries are grouped in buckets of kBucketSize; a store replaces
+// the bucket's entry for the same key, or else one chosen by the key, so old
+// entries are overwritten without notice.
+//
+// Lookup and Store may be called concurrently from any number of threads
+// without locks. Each entry keeps its data and key ^ data in two atomic
+// words (Hyatt and Mann's lockless hashing): a lookup that reads halves of
+// two different stores recovers a key that does not match, and misses.
+template <typename T>
+class TranspositionTable {
+ public:
+  static_assert(sizeof(T) <= sizeof(uint64_t),
+                "Values must fit in 64 bits.");
+  static_assert(std::is_trivially_copyable<T>::value,
+                "Values must be trivially copyable.");
+  static constexpr int kBucketSize = 4;
+
+  // Holds at least min(capacity, 2^40) entries, rounded up to a power of two
+  // number of buckets.
+  explicit TranspositionTable(int64_t capacity) {
+    REQUIRE(capacity > 0);
+    while (num_buckets_ * kBucketSize < capacity &&
+           num_buckets_ < (int64_t{1} << 38)) {
+      num_buckets_ *= 2;
+    }
+    // Value-initialized, so every entry starts as the key 0 and data 0.
+    words_.reset(new std::atomic<uint64_t>[2 * Capacity()]());
+  }
+  TranspositionTable(const TranspositionTable&) = delete;
+  TranspositionTable& operator=(const TranspositionTable&) = delete;
+
+  int64_t Capacity() const { return num_buckets_ * kBucketSize; }
+
+  // Sets *value to the value last stored for key and returns true, or
+  // returns false if key has no entry. key must not be 0.
+  bool Lookup(uint64_t key, T* value) const {
+    assert(key != 0);
+    const std::atomic<uint64_t>* bucket = Bucket(key);
+    for (int i = 0; i < kBucketSize; ++i) {
+      const uint64_t data = bucket[2 * i].load(std::memory_order_relaxed);
+      const uint64_t check = bucket[2 * i + 1].load(std::memory_order_relaxed);
+      if ((check ^ data) == key) {
+        std::memcpy(value, &data, sizeof(T));
+        return true;
+      }
+    }
+    return false;
+  }
+
+  // Stores value for key, which must not be 0.
+  void Store(uint64_t key, const T& value) {
+    assert(key != 0);
+    std::atomic<uint64_t>* bucket = Bucket(key);
+    // Replace the key's entry if it has one, else an entry picked by key bits
+    // that are not used to pick the bucket.
+    int slot = (key >> 62) % kBucketSize;
+    for (int i = 0; i < kBucketSize; ++i) {
+      const uint64_t data = bucket[2 * i].load(std::memory_order_relaxed);
+      const uint64_t check = bucket[2 * i + 1].load(std::memory_order_relaxed);
+      if ((check ^ data) == key) {
+        slot = i;
+        break;
+      }
+    }
+    uint64_t data = 0;
+    std::memcpy(&data, &value, sizeof(T));
+    bucket[2 * slot].store(data, std::memory_order_relaxed);
+    bucket[2 * slot + 1].store(key ^ data, std::memory_order_relaxed);
+  }
+
+  // Removes all entries. Not safe to call concurrently with other methods.
+  void Clear() {
+    for (int64_t i = 0; i < 2 * Capacity(); ++i) {
+      words_[i].store(0, std::memory_order_relaxed);
+    }
+  }
+
+ private:
+  std::atomic<uint64_t>* Bucket(uint64_t key) const {
+    return &words_[2 * kBucketSize * (key & (num_buckets_ - 1))];
+  }
+
+  int64_t num_buckets_ = 1;
+  // Two words per entry, data then key ^ data.
+  std::unique_ptr<std::atomic<uint64_t>[]> words_;
+};
+
+template <typename T>
+constexpr int TranspositionTable<T>::kBucketSize;
+
+}  // namespace hanabi_learning_env
+
+#endif
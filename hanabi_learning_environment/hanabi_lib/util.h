@@ -24,6 +24,15 @@ namespace hanabi_learning_env {
 
 constexpr int kMaxNumColors = 5;
 constexpr int kMaxNumRanks = 5;
+constexpr int kMaxPlayers = 5;
+// Three, two or one copies of each rank, ten cards per color.
+constexpr int kMaxDeckSize = 10 * kMaxNumColors;
+// Hint reveal bitmasks are 8 bits wide.
+constexpr int kMaxHandSize = 8;
+// Upper bound on HanabiGame::MaxMoves(), so legal moves fit in 64 bits.
+constexpr int kMaxMoves = 2 * kMaxHandSize + (kMaxPlayers - 1) *
+                                                 (kMaxNumColors + kMaxNumRanks);
+static_assert(kMaxMoves <= 64, "Legal move masks must fit in 64 bits.");
 
 // Returns a character representation of an integer color/rank index.
 char ColorIndexToChar(int color);
@@ -14,34 +14,175 @@
 
 #include "pyhanabi.h"
 
+#include <algorithm>
 #include <cstdlib>
 #include <cstring>
 #include <iostream>
 #include <memory>
+#include <new>
+#include <random>
 #include <string>
+#include <type_traits>
 #include <unordered_map>
 
+#include "hanabi_lib/bit_packing.h"
 #include "hanabi_lib/canonical_encoders.h"
+#include "hanabi_lib/hanabi_belief.h"
 #include "hanabi_lib/hanabi_card.h"
+#include "hanabi_lib/hanabi_determinization.h"
+#include "hanabi_lib/hanabi_env_server.h"
+#include "hanabi_lib/hanabi_expectimax.h"
 #include "hanabi_lib/hanabi_game.h"
+#include "hanabi_lib/hanabi_game_log.h"
 #include "hanabi_lib/hanabi_history_item.h"
 #include "hanabi_lib/hanabi_move.h"
 #include "hanabi_lib/hanabi_observation.h"
+#include "hanabi_lib/hanabi_playout.h"
+#include "hanabi_lib/hanabi_search.h"
 #include "hanabi_lib/hanabi_state.h"
+#include "hanabi_lib/hanabi_vector_env.h"
+#include "hanabi_lib/instrumentation.h"
 #include "hanabi_lib/observation_encoder.h"
+#include "hanabi_lib/replay_buffer.h"
 #include "hanabi_lib/util.h"
 
+namespace {
+
+// Encodes a batch with the canonical encoder, or observation by observation
+// with other encoders.
+template <typename T>
+void EncodeStates(pyhanabi_observation_encoder_t* encoder,
+                  pyhanabi_state_t** states, const int* players, int num_states,
+                  T* buffer, int size) {
+  REQUIRE(encoder != nullptr);
+  REQUIRE(encoder->encoder != nullptr);
+  REQUIRE(num_states >= 0);
+  REQUIRE(num_states == 0 ||
+          (states != nullptr && players != nullptr && buffer != nullptr));
+  auto obs_enc = reinterpret_cast<hanabi_learning_env::ObservationEncoder*>(
+      encoder->encoder);
+  const int length = obs_enc->Size();
+  REQUIRE(size >= num_states * length);
+  std::vector<const hanabi_learning_env::HanabiState*> hanabi_states(
+      num_states);
+  for (int i = 0; i < num_states; ++i) {
+    REQUIRE(states[i] != nullptr);
+    REQUIRE(states[i]->state != nullptr);
+    hanabi_states[i] =
+        reinterpret_cast<hanabi_learning_env::HanabiState*>(states[i]->state);
+  }
+  if (obs_enc->type() == hanabi_learning_env::ObservationEncoder::kCanonical) {
+    static_cast<hanabi_learning_env::CanonicalObservationEncoder*>(obs_enc)
+        ->EncodeStatesInto(hanabi_states.data(), players, num_states, buffer);
+  } else {
+    for (int i = 0; i < num_states; ++i) {
+      obs_enc->EncodeStateInto(*hanabi_states[i], players[i],
+                               buffer + i * length);
+    }
+  }
+}
+
+// Copies a search result to the output arguments of SearchState and
+// SearchObservation.
+int ExportSearchResult(const hanabi_learning_env::HanabiSearchResult& result,
+                       pyhanabi_move_t* move, int* visit_counts,
+                       double* values) {
+  REQUIRE(move != nullptr);
+  move->move = new hanabi_learning_env::HanabiMove(result.move);
+  if (visit_counts != nullptr) {
+    std::copy(result.visit_counts.begin(), result.visit_counts.end(),
+              visit_counts);
+  }
+  if (values != nullptr) {
+    std::copy(result.values.begin(), result.values.end(), values);
+  }
+  return result.num_iterations;
+}
+
+// pyhanabi_observation_data_t spells out the bounds of util.h, which the C
+// header cannot include.
+static_assert(std::extent<decltype(pyhanabi_observation_data_t::hands)>::value ==
+                      hanabi_learning_env::kMaxPlayers &&
+                  std::extent<decltype(pyhanabi_observation_data_t::hands),
+                              1>::value == hanabi_learning_env::kMaxHandSize,
+              "Hands must hold kMaxPlayers hands of kMaxHandSize cards.");
+static_assert(
+    std::extent<decltype(pyhanabi_observation_data_t::fireworks)>::value ==
+        hanabi_learning_env::kMaxNumColors,
+    "Fireworks must hold kMaxNumColors entries.");
+static_assert(
+    std::extent<decltype(pyhanabi_observation_data_t::discard_pile)>::value ==
+        hanabi_learning_env::kMaxDeckSize,
+    "The discard pile must hold kMaxDeckSize cards.");
+static_assert(
+    std::extent<decltype(pyhanabi_observation_data_t::last_moves)>::value ==
+        2 * hanabi_learning_env::kMaxPlayers,
+    "Last moves must hold a move and a deal per player.");
+static_assert(
+    std::extent<decltype(pyhanabi_observation_data_t::legal_move_uids)>::value ==
+        hanabi_learning_env::kMaxMoves,
+    "Legal moves must hold kMaxMoves uids.");
+
+void ExportHistoryItem(const hanabi_learning_env::HanabiHistoryItem& item,
+                       pyhanabi_history_data_t* data) {
+  data->move_type = item.move.MoveType();
+  data->move_card_index = item.move.CardIndex();
+  data->move_target_offset = item.move.TargetOffset();
+  data->move_color = item.move.Color();
+  data->move_rank = item.move.Rank();
+  data->player = item.player;
+  data->scored = item.scored;
+  data->information_token = item.information_token;
+  data->color = item.color;
+  data->rank = item.rank;
+  data->reveal_bitmask = item.reveal_bitmask;
+  data->newly_revealed_bitmask = item.newly_revealed_bitmask;
+  data->deal_to_player = item.deal_to_player;
+}
+
+}  // namespace
+
+#if defined(HANABI_INSTRUMENTATION)
+// Counts the library's allocations, which all go through these (the library
+// links with -Bsymbolic-functions). Array and nothrow forms call them.
+void* operator new(std::size_t size) {
+  hanabi_learning_env::CountInstrumentation(
+      hanabi_learning_env::kCounterAllocation, 1, 0);
+  if (size == 0) {
+    size = 1;
+  }
+  void* ptr;
+  while ((ptr = std::malloc(size)) == nullptr) {
+    std::new_handler handler = std::get_new_handler();
+    if (handler == nullptr) {
+      throw std::bad_alloc();
+    }
+    handler();
+  }
+  return ptr;
+}
+
+void operator delete(void* ptr) noexcept { std::free(ptr); }
+#endif
+
 extern "C" {
 
 /* Helpers. */
 
-void DeleteString(char* str) { free(str); }
+void DeleteString(char* str) {
+  HANABI_INSTRUMENT(hanabi_learning_env::kCounterCApi);
+  free(str);
+}
 
 /* Wrapper definitions for HanabiCard. */
-int CardValid(pyhanabi_card_t* card) { return card->color >= 0; }
+int CardValid(pyhanabi_card_t* card) {
+  HANABI_INSTRUMENT(hanabi_learning_env::kCounterCApi);
+  return card->color >= 0;
+}
 
 /* Wrapper definitions for HanabiCardKnowledge. */
 char* CardKnowledgeToString(pyhanabi_card_knowledge_t* knowledge) {
+  HANABI_INSTRUMENT(hanabi_learning_env::kCounterCApi);
   REQUIRE(knowledge != nullptr);
   REQUIRE(knowledge->knowledge != nullptr);
   std::string str =
@@ -52,6 +193,7 @@ char* CardKnowledgeToString(pyhanabi_card_knowledge_t* knowledge) {
 }
 
 int ColorWasHinted(pyhanabi_card_knowledge_t* knowledge) {
+  HANABI_INSTRUMENT(hanabi_learning_env::kCounterCApi);
   REQUIRE(knowledge != nullptr);
   REQUIRE(knowledge->knowledge != nullptr);
   return reinterpret_cast<
@@ -61,6 +203,7 @@ int ColorWasHinted(pyhanabi_card_knowledge_t* knowledge) {
 }
 
 int KnownColor(pyhanabi_card_knowledge_t* knowledge) {
+  HANABI_INSTRUMENT(hanabi_learning_env::kCounterCApi);
   REQUIRE(knowledge != nullptr);
   REQUIRE(knowledge->knowledge != nullptr);
   return reinterpret_cast<
@@ -70,6 +213,7 @@ int KnownColor(pyhanabi_card_knowledge_t* knowledge) {
 }
 
 int ColorIsPlausible(pyhanabi_card_knowledge_t* knowledge, int color) {
+  HANABI_INSTRUMENT(hanabi_learning_env::kCounterCApi);
   REQUIRE(knowledge != nullptr);
   REQUIRE(knowledge->knowledge != nullptr);
   return reinterpret_cast<
@@ -79,6 +223,7 @@ int ColorIsPlausible(pyhanabi_card_knowledge_t* knowledge, int color) {
 }
 
 int RankWasHinted(pyhanabi_card_knowledge_t* knowledge) {
+  HANABI_INSTRUMENT(hanabi_learning_env::kCounterCApi);
   REQUIRE(knowledge != nullptr);
   REQUIRE(knowledge->knowledge != nullptr);
   return reinterpret_cast<
@@ -88,6 +233,7 @@ int RankWasHinted(pyhanabi_card_knowledge_t* knowledge) {
 }
 
 int KnownRank(pyhanabi_card_knowledge_t* knowledge) {
+  HANABI_INSTRUMENT(hanabi_learning_env::kCounterCApi);
   REQUIRE(knowledge != nullptr);
   REQUIRE(knowledge->knowledge != nullptr);
   return reinterpret_cast<
@@ -97,6 +243,7 @@ int KnownRank(pyhanabi_card_knowledge_t* knowledge) {
 }
 
 int RankIsPlausible(pyhanabi_card_knowledge_t* knowledge, int rank) {
+  HANABI_INSTRUMENT(hanabi_learning_env::kCounterCApi);
   REQUIRE(knowledge != nullptr);
   REQUIRE(knowledge->knowledge != nullptr);
   return reinterpret_cast<
@@ -106,18 +253,26 @@ int RankIsPlausible(pyhanabi_card_knowledge_t* knowledge, int rank) {
 }
 
 /* Wrapper definitions for HanabiMove. */
+void* NewMoveList(void) {
+  HANABI_INSTRUMENT(hanabi_learning_env::kCounterCApi);
+  return static_cast<void*>(new std::vector<hanabi_learning_env::HanabiMove>());
+}
+
 void DeleteMoveList(void* movelist) {
+  HANABI_INSTRUMENT(hanabi_learning_env::kCounterCApi);
   delete reinterpret_cast<std::vector<hanabi_learning_env::HanabiMove>*>(
       movelist);
 }
 
 int NumMoves(void* movelist) {
+  HANABI_INSTRUMENT(hanabi_learning_env::kCounterCApi);
   return reinterpret_cast<std::vector<hanabi_learning_env::HanabiMove>*>(
              movelist)
       ->size();
 }
 
 void GetMove(void* movelist, int index, pyhanabi_move_t* move) {
+  HANABI_INSTRUMENT(hanabi_learning_env::kCounterCApi);
   REQUIRE(move != nullptr);
   auto hanabi_movelist =
       reinterpret_cast<std::vector<hanabi_learning_env::HanabiMove>*>(movelist);
@@ -125,6 +280,7 @@ void GetMove(void* movelist, int index, pyhanabi_move_t* move) {
 }
 
 void DeleteMove(pyhanabi_move_t* move) {
+  HANABI_INSTRUMENT(hanabi_learning_env::kCounterCApi);
   REQUIRE(move != nullptr);
   REQUIRE(move->move != nullptr);
   delete reinterpret_cast<hanabi_learning_env::HanabiMove*>(move->move);
@@ -132,6 +288,7 @@ void DeleteMove(pyhanabi_move_t* move) {
 }
 
 char* MoveToString(pyhanabi_move_t* move) {
+  HANABI_INSTRUMENT(hanabi_learning_env::kCounterCApi);
   REQUIRE(move != nullptr);
   REQUIRE(move->move != nullptr);
   std::string str =
@@ -141,31 +298,37 @@ char* MoveToString(pyhanabi_move_t* move) {
 }
 
 int MoveType(pyhanabi_move_t* move) {
+  HANABI_INSTRUMENT(hanabi_learning_env::kCounterCApi);
   return reinterpret_cast<const hanabi_learning_env::HanabiMove*>(move->move)
       ->MoveType();
 }
 
 int CardIndex(pyhanabi_move_t* move) {
+  HANABI_INSTRUMENT(hanabi_learning_env::kCounterCApi);
   return reinterpret_cast<const hanabi_learning_env::HanabiMove*>(move->move)
       ->CardIndex();
 }
 
 int TargetOffset(pyhanabi_move_t* move) {
+  HANABI_INSTRUMENT(hanabi_learning_env::kCounterCApi);
   return reinterpret_cast<const hanabi_learning_env::HanabiMove*>(move->move)
       ->TargetOffset();
 }
 
 int MoveColor(pyhanabi_move_t* move) {
+  HANABI_INSTRUMENT(hanabi_learning_env::kCounterCApi);
   return reinterpret_cast<const hanabi_learning_env::HanabiMove*>(move->move)
       ->Color();
 }
 
 int MoveRank(pyhanabi_move_t* move) {
+  HANABI_INSTRUMENT(hanabi_learning_env::kCounterCApi);
   return reinterpret_cast<const hanabi_learning_env::HanabiMove*>(move->move)
       ->Rank();
 }
 
 bool GetDiscardMove(int card_index, pyhanabi_move_t* move) {
+  HANABI_INSTRUMENT(hanabi_learning_env::kCounterCApi);
   REQUIRE(move != nullptr);
   move->move = new hanabi_learning_env::HanabiMove(
       hanabi_learning_env::HanabiMove::kDiscard, card_index, -1, -1, -1);
@@ -173,6 +336,7 @@ bool GetDiscardMove(int card_index, pyhanabi_move_t* move) {
 }
 
 bool GetPlayMove(int card_index, pyhanabi_move_t* move) {
+  HANABI_INSTRUMENT(hanabi_learning_env::kCounterCApi);
   REQUIRE(move != nullptr);
   move->move = new hanabi_learning_env::HanabiMove(
       hanabi_learning_env::HanabiMove::kPlay, card_index, -1, -1, -1);
@@ -180,6 +344,7 @@ bool GetPlayMove(int card_index, pyhanabi_move_t* move) {
 }
 
 bool GetRevealColorMove(int target_offset, int color, pyhanabi_move_t* move) {
+  HANABI_INSTRUMENT(hanabi_learning_env::kCounterCApi);
   REQUIRE(move != nullptr);
   move->move = new hanabi_learning_env::HanabiMove(
       hanabi_learning_env::HanabiMove::kRevealColor, -1, target_offset, color,
@@ -188,6 +353,7 @@ bool GetRevealColorMove(int target_offset, int color, pyhanabi_move_t* move) {
 }
 
 bool GetRevealRankMove(int target_offset, int rank, pyhanabi_move_t* move) {
+  HANABI_INSTRUMENT(hanabi_learning_env::kCounterCApi);
   REQUIRE(move != nullptr);
   move->move = new hanabi_learning_env::HanabiMove(
       hanabi_learning_env::HanabiMove::kRevealRank, -1, target_offset, -1,
@@ -197,6 +363,7 @@ bool GetRevealRankMove(int target_offset, int rank, pyhanabi_move_t* move) {
 
 /* Wrapper definitions for HanabiHistoryItem. */
 void DeleteHistoryItem(pyhanabi_history_item_t* item) {
+  HANABI_INSTRUMENT(hanabi_learning_env::kCounterCApi);
   REQUIRE(item != nullptr);
   REQUIRE(item->item != nullptr);
   delete reinterpret_cast<hanabi_learning_env::HanabiHistoryItem*>(item->item);
@@ -204,6 +371,7 @@ void DeleteHistoryItem(pyhanabi_history_item_t* item) {
 }
 
 char* HistoryItemToString(pyhanabi_history_item_t* item) {
+  HANABI_INSTRUMENT(hanabi_learning_env::kCounterCApi);
   REQUIRE(item != nullptr);
   REQUIRE(item->item != nullptr);
   std::string str =
@@ -214,6 +382,7 @@ char* HistoryItemToString(pyhanabi_history_item_t* item) {
 }
 
 void HistoryItemMove(pyhanabi_history_item_t* item, pyhanabi_move_t* move) {
+  HANABI_INSTRUMENT(hanabi_learning_env::kCounterCApi);
   REQUIRE(item != nullptr);
   REQUIRE(item->item != nullptr);
   REQUIRE(move != nullptr);
@@ -224,6 +393,7 @@ void HistoryItemMove(pyhanabi_history_item_t* item, pyhanabi_move_t* move) {
 }
 
 int HistoryItemPlayer(pyhanabi_history_item_t* item) {
+  HANABI_INSTRUMENT(hanabi_learning_env::kCounterCApi);
   REQUIRE(item != nullptr);
   REQUIRE(item->item != nullptr);
   return reinterpret_cast<const hanabi_learning_env::HanabiHistoryItem*>(
@@ -232,6 +402,7 @@ int HistoryItemPlayer(pyhanabi_history_item_t* item) {
 }
 
 int HistoryItemScored(pyhanabi_history_item_t* item) {
+  HANABI_INSTRUMENT(hanabi_learning_env::kCounterCApi);
   REQUIRE(item != nullptr);
   REQUIRE(item->item != nullptr);
   return reinterpret_cast<const hanabi_learning_env::HanabiHistoryItem*>(
@@ -240,6 +411,7 @@ int HistoryItemScored(pyhanabi_history_item_t* item) {
 }
 
 int HistoryItemInformationToken(pyhanabi_history_item_t* item) {
+  HANABI_INSTRUMENT(hanabi_learning_env::kCounterCApi);
   REQUIRE(item != nullptr);
   REQUIRE(item->item != nullptr);
   return reinterpret_cast<const hanabi_learning_env::HanabiHistoryItem*>(
@@ -248,6 +420,7 @@ int HistoryItemInformationToken(pyhanabi_history_item_t* item) {
 }
 
 int HistoryItemColor(pyhanabi_history_item_t* item) {
+  HANABI_INSTRUMENT(hanabi_learning_env::kCounterCApi);
   REQUIRE(item != nullptr);
   REQUIRE(item->item != nullptr);
   return reinterpret_cast<const hanabi_learning_env::HanabiHistoryItem*>(
@@ -256,6 +429,7 @@ int HistoryItemColor(pyhanabi_history_item_t* item) {
 }
 
 int HistoryItemRank(pyhanabi_history_item_t* item) {
+  HANABI_INSTRUMENT(hanabi_learning_env::kCounterCApi);
   REQUIRE(item != nullptr);
   REQUIRE(item->item != nullptr);
   return reinterpret_cast<const hanabi_learning_env::HanabiHistoryItem*>(
@@ -264,6 +438,7 @@ int HistoryItemRank(pyhanabi_history_item_t* item) {
 }
 
 int HistoryItemRevealBitmask(pyhanabi_history_item_t* item) {
+  HANABI_INSTRUMENT(hanabi_learning_env::kCounterCApi);
   REQUIRE(item != nullptr);
   REQUIRE(item->item != nullptr);
   return reinterpret_cast<const hanabi_learning_env::HanabiHistoryItem*>(
@@ -272,6 +447,7 @@ int HistoryItemRevealBitmask(pyhanabi_history_item_t* item) {
 }
 
 int HistoryItemNewlyRevealedBitmask(pyhanabi_history_item_t* item) {
+  HANABI_INSTRUMENT(hanabi_learning_env::kCounterCApi);
   REQUIRE(item != nullptr);
   REQUIRE(item->item != nullptr);
   return reinterpret_cast<const hanabi_learning_env::HanabiHistoryItem*>(
@@ -280,6 +456,7 @@ int HistoryItemNewlyRevealedBitmask(pyhanabi_history_item_t* item) {
 }
 
 int HistoryItemDealToPlayer(pyhanabi_history_item_t* item) {
+  HANABI_INSTRUMENT(hanabi_learning_env::kCounterCApi);
   REQUIRE(item != nullptr);
   REQUIRE(item->item != nullptr);
   return reinterpret_cast<const hanabi_learning_env::HanabiHistoryItem*>(
@@ -289,6 +466,7 @@ int HistoryItemDealToPlayer(pyhanabi_history_item_t* item) {
 
 /* Wrapper definitions for HanabiState. */
 void NewState(pyhanabi_game_t* game, pyhanabi_state_t* state) {
+  HANABI_INSTRUMENT(hanabi_learning_env::kCounterCApi);
   REQUIRE(state != nullptr);
   REQUIRE(game != nullptr);
   REQUIRE(game->game != nullptr);
@@ -297,6 +475,7 @@ void NewState(pyhanabi_game_t* game, pyhanabi_state_t* state) {
 }
 
 void CopyState(const pyhanabi_state_t* src, pyhanabi_state_t* dest) {
+  HANABI_INSTRUMENT(hanabi_learning_env::kCounterCApi);
   REQUIRE(src != nullptr);
   REQUIRE(src->state != nullptr);
   REQUIRE(dest != nullptr);
@@ -305,6 +484,7 @@ void CopyState(const pyhanabi_state_t* src, pyhanabi_state_t* dest) {
 }
 
 void DeleteState(pyhanabi_state_t* state) {
+  HANABI_INSTRUMENT(hanabi_learning_env::kCounterCApi);
   REQUIRE(state != nullptr);
   REQUIRE(state->state != nullptr);
   delete reinterpret_cast<hanabi_learning_env::HanabiState*>(state->state);
@@ -312,6 +492,7 @@ void DeleteState(pyhanabi_state_t* state) {
 }
 
 void StateParentGame(pyhanabi_state_t* state, pyhanabi_game_t* dest_game) {
+  HANABI_INSTRUMENT(hanabi_learning_env::kCounterCApi);
   REQUIRE(state != nullptr);
   REQUIRE(state->state != nullptr);
   REQUIRE(dest_game != nullptr);
@@ -321,6 +502,7 @@ void StateParentGame(pyhanabi_state_t* state, pyhanabi_game_t* dest_game) {
 }
 
 void StateApplyMove(pyhanabi_state_t* state, pyhanabi_move_t* move) {
+  HANABI_INSTRUMENT(hanabi_learning_env::kCounterCApi);
   REQUIRE(state != nullptr);
   REQUIRE(state->state != nullptr);
   REQUIRE(move != nullptr);
@@ -333,6 +515,7 @@ void StateApplyMove(pyhanabi_state_t* state, pyhanabi_move_t* move) {
 }
 
 int StateCurPlayer(pyhanabi_state_t* state) {
+  HANABI_INSTRUMENT(hanabi_learning_env::kCounterCApi);
   REQUIRE(state != nullptr);
   REQUIRE(state->state != nullptr);
   return reinterpret_cast<hanabi_learning_env::HanabiState*>(state->state)
@@ -340,6 +523,7 @@ int StateCurPlayer(pyhanabi_state_t* state) {
 }
 
 void StateDealRandomCard(pyhanabi_state_t* state) {
+  HANABI_INSTRUMENT(hanabi_learning_env::kCounterCApi);
   REQUIRE(state != nullptr);
   REQUIRE(state->state != nullptr);
   auto hanabi_state =
@@ -347,7 +531,16 @@ void StateDealRandomCard(pyhanabi_state_t* state) {
   hanabi_state->ApplyRandomChance();
 }
 
+void StateDealInitialHands(pyhanabi_state_t* state) {
+  HANABI_INSTRUMENT(hanabi_learning_env::kCounterCApi);
+  REQUIRE(state != nullptr);
+  REQUIRE(state->state != nullptr);
+  reinterpret_cast<hanabi_learning_env::HanabiState*>(state->state)
+      ->DealInitialHands();
+}
+
 int StateDeckSize(pyhanabi_state_t* state) {
+  HANABI_INSTRUMENT(hanabi_learning_env::kCounterCApi);
   REQUIRE(state != nullptr);
   REQUIRE(state->state != nullptr);
   return reinterpret_cast<hanabi_learning_env::HanabiState*>(state->state)
@@ -356,6 +549,7 @@ int StateDeckSize(pyhanabi_state_t* state) {
 }
 
 int StateFireworks(pyhanabi_state_t* state, int color) {
+  HANABI_INSTRUMENT(hanabi_learning_env::kCounterCApi);
   REQUIRE(state != nullptr);
   REQUIRE(state->state != nullptr);
   return reinterpret_cast<hanabi_learning_env::HanabiState*>(state->state)
@@ -364,6 +558,7 @@ int StateFireworks(pyhanabi_state_t* state, int color) {
 }
 
 int StateDiscardPileSize(pyhanabi_state_t* state) {
+  HANABI_INSTRUMENT(hanabi_learning_env::kCounterCApi);
   REQUIRE(state != nullptr);
   REQUIRE(state->state != nullptr);
   return reinterpret_cast<hanabi_learning_env::HanabiState*>(state->state)
@@ -373,6 +568,7 @@ int StateDiscardPileSize(pyhanabi_state_t* state) {
 
 void StateGetDiscard(pyhanabi_state_t* state, int index,
                      pyhanabi_card_t* card) {
+  HANABI_INSTRUMENT(hanabi_learning_env::kCounterCApi);
   REQUIRE(state != nullptr);
   REQUIRE(state->state != nullptr);
   REQUIRE(card != nullptr);
@@ -385,6 +581,7 @@ void StateGetDiscard(pyhanabi_state_t* state, int index,
 }
 
 int StateGetHandSize(pyhanabi_state_t* state, int pid) {
+  HANABI_INSTRUMENT(hanabi_learning_env::kCounterCApi);
   REQUIRE(state != nullptr);
   return reinterpret_cast<hanabi_learning_env::HanabiState*>(state->state)
       ->Hands()
@@ -395,6 +592,7 @@ int StateGetHandSize(pyhanabi_state_t* state, int pid) {
 
 void StateGetHandCard(pyhanabi_state_t* state, int pid, int index,
                       pyhanabi_card_t* card) {
+  HANABI_INSTRUMENT(hanabi_learning_env::kCounterCApi);
   REQUIRE(state != nullptr);
   REQUIRE(state->state != nullptr);
   REQUIRE(card != nullptr);
@@ -409,6 +607,7 @@ void StateGetHandCard(pyhanabi_state_t* state, int pid, int index,
 }
 
 int StateInformationTokens(pyhanabi_state_t* state) {
+  HANABI_INSTRUMENT(hanabi_learning_env::kCounterCApi);
   REQUIRE(state != nullptr);
   REQUIRE(state->state != nullptr);
   return reinterpret_cast<hanabi_learning_env::HanabiState*>(state->state)
@@ -416,6 +615,7 @@ int StateInformationTokens(pyhanabi_state_t* state) {
 }
 
 int StateEndOfGameStatus(pyhanabi_state_t* state) {
+  HANABI_INSTRUMENT(hanabi_learning_env::kCounterCApi);
   REQUIRE(state != nullptr);
   REQUIRE(state->state != nullptr);
   return reinterpret_cast<hanabi_learning_env::HanabiState*>(state->state)
@@ -423,6 +623,7 @@ int StateEndOfGameStatus(pyhanabi_state_t* state) {
 }
 
 void* StateLegalMoves(pyhanabi_state_t* state) {
+  HANABI_INSTRUMENT(hanabi_learning_env::kCounterCApi);
   REQUIRE(state != nullptr);
   REQUIRE(state->state != nullptr);
   auto hanabi_state =
@@ -433,14 +634,53 @@ void* StateLegalMoves(pyhanabi_state_t* state) {
   return static_cast<void*>(list);
 }
 
+void StateLegalMovesInto(pyhanabi_state_t* state, void* movelist) {
+  HANABI_INSTRUMENT(hanabi_learning_env::kCounterCApi);
+  REQUIRE(state != nullptr);
+  REQUIRE(state->state != nullptr);
+  REQUIRE(movelist != nullptr);
+  auto hanabi_state =
+      reinterpret_cast<hanabi_learning_env::HanabiState*>(state->state);
+  hanabi_state->LegalMoves(
+      hanabi_state->CurPlayer(),
+      reinterpret_cast<std::vector<hanabi_learning_env::HanabiMove>*>(
+          movelist));
+}
+
+uint64_t StateLegalMoveMask(pyhanabi_state_t* state, int player) {
+  HANABI_INSTRUMENT(hanabi_learning_env::kCounterCApi);
+  REQUIRE(state != nullptr);
+  REQUIRE(state->state != nullptr);
+  return reinterpret_cast<hanabi_learning_env::HanabiState*>(state->state)
+      ->LegalMoveMask(player);
+}
+
 int StateLifeTokens(pyhanabi_state_t* state) {
+  HANABI_INSTRUMENT(hanabi_learning_env::kCounterCApi);
   REQUIRE(state != nullptr);
   REQUIRE(state->state != nullptr);
   return reinterpret_cast<hanabi_learning_env::HanabiState*>(state->state)
       ->LifeTokens();
 }
 
+uint64_t StateHash(pyhanabi_state_t* state) {
+  HANABI_INSTRUMENT(hanabi_learning_env::kCounterCApi);
+  REQUIRE(state != nullptr);
+  REQUIRE(state->state != nullptr);
+  return reinterpret_cast<hanabi_learning_env::HanabiState*>(state->state)
+      ->Hash();
+}
+
+uint64_t StateObserverHash(pyhanabi_state_t* state, int player) {
+  HANABI_INSTRUMENT(hanabi_learning_env::kCounterCApi);
+  REQUIRE(state != nullptr);
+  REQUIRE(state->state != nullptr);
+  return reinterpret_cast<hanabi_learning_env::HanabiState*>(state->state)
+      ->ObserverHash(player);
+}
+
 int StateNumPlayers(pyhanabi_state_t* state) {
+  HANABI_INSTRUMENT(hanabi_learning_env::kCounterCApi);
   REQUIRE(state != nullptr);
   REQUIRE(state->state != nullptr);
   return reinterpret_cast<hanabi_learning_env::HanabiState*>(state->state)
@@ -449,6 +689,7 @@ int StateNumPlayers(pyhanabi_state_t* state) {
 }
 
 int StateScore(pyhanabi_state_t* state) {
+  HANABI_INSTRUMENT(hanabi_learning_env::kCounterCApi);
   REQUIRE(state != nullptr);
   REQUIRE(state->state != nullptr);
   return reinterpret_cast<hanabi_learning_env::HanabiState*>(state->state)
@@ -456,6 +697,7 @@ int StateScore(pyhanabi_state_t* state) {
 }
 
 char* StateToString(pyhanabi_state_t* state) {
+  HANABI_INSTRUMENT(hanabi_learning_env::kCounterCApi);
   REQUIRE(state != nullptr);
   REQUIRE(state->state != nullptr);
   std::string str =
@@ -465,6 +707,7 @@ char* StateToString(pyhanabi_state_t* state) {
 }
 
 bool MoveIsLegal(const pyhanabi_state_t* state, const pyhanabi_move_t* move) {
+  HANABI_INSTRUMENT(hanabi_learning_env::kCounterCApi);
   auto hanabi_state =
       reinterpret_cast<const hanabi_learning_env::HanabiState*>(state->state);
   auto hanabi_move =
@@ -474,11 +717,13 @@ bool MoveIsLegal(const pyhanabi_state_t* state, const pyhanabi_move_t* move) {
 
 bool CardPlayableOnFireworks(const pyhanabi_state_t* state, int color,
                              int rank) {
+  HANABI_INSTRUMENT(hanabi_learning_env::kCounterCApi);
   return reinterpret_cast<const hanabi_learning_env::HanabiState*>(state->state)
       ->CardPlayableOnFireworks(color, rank);
 }
 
 int StateLenMoveHistory(pyhanabi_state_t* state) {
+  HANABI_INSTRUMENT(hanabi_learning_env::kCounterCApi);
   REQUIRE(state != nullptr);
   REQUIRE(state->state != nullptr);
   return reinterpret_cast<const hanabi_learning_env::HanabiState*>(state->state)
@@ -488,6 +733,7 @@ int StateLenMoveHistory(pyhanabi_state_t* state) {
 
 void StateGetMoveHistory(pyhanabi_state_t* state, int index,
                          pyhanabi_history_item_t* item) {
+  HANABI_INSTRUMENT(hanabi_learning_env::kCounterCApi);
   REQUIRE(state != nullptr);
   REQUIRE(state->state != nullptr);
   REQUIRE(item != nullptr);
@@ -499,6 +745,7 @@ void StateGetMoveHistory(pyhanabi_state_t* state, int index,
 
 /* Wrapper definitions for HanabiGame. */
 void DeleteGame(pyhanabi_game_t* game) {
+  HANABI_INSTRUMENT(hanabi_learning_env::kCounterCApi);
   REQUIRE(game != nullptr);
   REQUIRE(game->game != nullptr);
   delete reinterpret_cast<hanabi_learning_env::HanabiGame*>(game->game);
@@ -506,6 +753,7 @@ void DeleteGame(pyhanabi_game_t* game) {
 }
 
 void NewDefaultGame(pyhanabi_game_t* game) {
+  HANABI_INSTRUMENT(hanabi_learning_env::kCounterCApi);
   std::unordered_map<std::string, std::string> params;
   REQUIRE(game != nullptr);
   game->game = static_cast<void*>(new hanabi_learning_env::HanabiGame(params));
@@ -513,6 +761,7 @@ void NewDefaultGame(pyhanabi_game_t* game) {
 }
 
 void NewGame(pyhanabi_game_t* game, int list_length, const char** param_list) {
+  HANABI_INSTRUMENT(hanabi_learning_env::kCounterCApi);
   std::unordered_map<std::string, std::string> params;
 
   for (int p = 0; p < list_length; p += 2) {
@@ -527,6 +776,7 @@ void NewGame(pyhanabi_game_t* game, int list_length, const char** param_list) {
 }
 
 char* GameParamString(pyhanabi_game_t* game) {
+  HANABI_INSTRUMENT(hanabi_learning_env::kCounterCApi);
   REQUIRE(game != nullptr);
   REQUIRE(game->game != nullptr);
   std::string str;
@@ -539,52 +789,62 @@ char* GameParamString(pyhanabi_game_t* game) {
 }
 
 int NumPlayers(pyhanabi_game_t* game) {
+  HANABI_INSTRUMENT(hanabi_learning_env::kCounterCApi);
   return reinterpret_cast<hanabi_learning_env::HanabiGame*>(game->game)
       ->NumPlayers();
 }
 
 int NumColors(pyhanabi_game_t* game) {
+  HANABI_INSTRUMENT(hanabi_learning_env::kCounterCApi);
   return reinterpret_cast<hanabi_learning_env::HanabiGame*>(game->game)
       ->NumColors();
 }
 
 int NumRanks(pyhanabi_game_t* game) {
+  HANABI_INSTRUMENT(hanabi_learning_env::kCounterCApi);
   return reinterpret_cast<hanabi_learning_env::HanabiGame*>(game->game)
       ->NumRanks();
 }
 
 int HandSize(pyhanabi_game_t* game) {
+  HANABI_INSTRUMENT(hanabi_learning_env::kCounterCApi);
   return reinterpret_cast<hanabi_learning_env::HanabiGame*>(game->game)
       ->HandSize();
 }
 
 int MaxInformationTokens(pyhanabi_game_t* game) {
+  HANABI_INSTRUMENT(hanabi_learning_env::kCounterCApi);
   return reinterpret_cast<hanabi_learning_env::HanabiGame*>(game->game)
       ->MaxInformationTokens();
 }
 
 int MaxLifeTokens(pyhanabi_game_t* game) {
+  HANABI_INSTRUMENT(hanabi_learning_env::kCounterCApi);
   return reinterpret_cast<hanabi_learning_env::HanabiGame*>(game->game)
       ->MaxLifeTokens();
 }
 
 int ObservationType(pyhanabi_game_t* game) {
+  HANABI_INSTRUMENT(hanabi_learning_env::kCounterCApi);
   return reinterpret_cast<hanabi_learning_env::HanabiGame*>(game->game)
       ->ObservationType();
 }
 
 int NumCards(pyhanabi_game_t* game, int color, int rank) {
+  HANABI_INSTRUMENT(hanabi_learning_env::kCounterCApi);
   return reinterpret_cast<hanabi_learning_env::HanabiGame*>(game->game)
       ->NumberCardInstances(color, rank);
 }
 
 int GetMoveUid(pyhanabi_game_t* game, pyhanabi_move_t* move) {
+  HANABI_INSTRUMENT(hanabi_learning_env::kCounterCApi);
   return reinterpret_cast<hanabi_learning_env::HanabiGame*>(game->game)
       ->GetMoveUid(*reinterpret_cast<const hanabi_learning_env::HanabiMove*>(
           move->move));
 }
 
 void GetMoveByUid(pyhanabi_game_t* game, int move_uid, pyhanabi_move_t* move) {
+  HANABI_INSTRUMENT(hanabi_learning_env::kCounterCApi);
   REQUIRE(game != nullptr);
   REQUIRE(game->game != nullptr);
   REQUIRE(move != nullptr);
@@ -596,6 +856,7 @@ void GetMoveByUid(pyhanabi_game_t* game, int move_uid, pyhanabi_move_t* move) {
 }
 
 int MaxMoves(pyhanabi_game_t* game) {
+  HANABI_INSTRUMENT(hanabi_learning_env::kCounterCApi);
   return reinterpret_cast<hanabi_learning_env::HanabiGame*>(game->game)
       ->MaxMoves();
 }
@@ -603,6 +864,7 @@ int MaxMoves(pyhanabi_game_t* game) {
 /* Wrapper definitions for HanabiObservation. */
 void NewObservation(pyhanabi_state_t* state, int player,
                     pyhanabi_observation_t* observation) {
+  HANABI_INSTRUMENT(hanabi_learning_env::kCounterCApi);
   REQUIRE(state != nullptr);
   REQUIRE(state->state != nullptr);
   REQUIRE(observation != nullptr);
@@ -615,7 +877,22 @@ void NewObservation(pyhanabi_state_t* state, int player,
   REQUIRE(observation->observation != nullptr);
 }
 
+void ObservationUpdate(pyhanabi_observation_t* observation,
+                       pyhanabi_state_t* state, int player) {
+  HANABI_INSTRUMENT(hanabi_learning_env::kCounterCApi);
+  REQUIRE(observation != nullptr);
+  REQUIRE(observation->observation != nullptr);
+  REQUIRE(state != nullptr);
+  REQUIRE(state->state != nullptr);
+  reinterpret_cast<hanabi_learning_env::HanabiObservation*>(
+      observation->observation)
+      ->Update(*reinterpret_cast<hanabi_learning_env::HanabiState*>(
+                   state->state),
+               player);
+}
+
 void DeleteObservation(pyhanabi_observation_t* observation) {
+  HANABI_INSTRUMENT(hanabi_learning_env::kCounterCApi);
   REQUIRE(observation != nullptr);
   REQUIRE(observation->observation != nullptr);
   delete reinterpret_cast<hanabi_learning_env::HanabiObservation*>(
@@ -624,6 +901,7 @@ void DeleteObservation(pyhanabi_observation_t* observation) {
 }
 
 char* ObsToString(pyhanabi_observation_t* observation) {
+  HANABI_INSTRUMENT(hanabi_learning_env::kCounterCApi);
   REQUIRE(observation != nullptr);
   REQUIRE(observation->observation != nullptr);
   std::string str = reinterpret_cast<hanabi_learning_env::HanabiObservation*>(
@@ -633,6 +911,7 @@ char* ObsToString(pyhanabi_observation_t* observation) {
 }
 
 int ObsCurPlayerOffset(pyhanabi_observation_t* observation) {
+  HANABI_INSTRUMENT(hanabi_learning_env::kCounterCApi);
   REQUIRE(observation != nullptr);
   REQUIRE(observation->observation != nullptr);
   return reinterpret_cast<hanabi_learning_env::HanabiObservation*>(
@@ -641,6 +920,7 @@ int ObsCurPlayerOffset(pyhanabi_observation_t* observation) {
 }
 
 int ObsNumPlayers(pyhanabi_observation_t* observation) {
+  HANABI_INSTRUMENT(hanabi_learning_env::kCounterCApi);
   REQUIRE(observation != nullptr);
   REQUIRE(observation->observation != nullptr);
   return reinterpret_cast<hanabi_learning_env::HanabiObservation*>(
@@ -650,6 +930,7 @@ int ObsNumPlayers(pyhanabi_observation_t* observation) {
 }
 
 int ObsGetHandSize(pyhanabi_observation_t* observation, int pid) {
+  HANABI_INSTRUMENT(hanabi_learning_env::kCounterCApi);
   REQUIRE(observation != nullptr);
   REQUIRE(observation->observation != nullptr);
   return reinterpret_cast<hanabi_learning_env::HanabiObservation*>(
@@ -662,6 +943,7 @@ int ObsGetHandSize(pyhanabi_observation_t* observation, int pid) {
 
 void ObsGetHandCard(pyhanabi_observation_t* observation, int pid, int index,
                     pyhanabi_card_t* card) {
+  HANABI_INSTRUMENT(hanabi_learning_env::kCounterCApi);
   REQUIRE(observation != nullptr);
   REQUIRE(observation->observation != nullptr);
   REQUIRE(card != nullptr);
@@ -678,6 +960,7 @@ void ObsGetHandCard(pyhanabi_observation_t* observation, int pid, int index,
 
 void ObsGetHandCardKnowledge(pyhanabi_observation_t* observation, int pid,
                              int index, pyhanabi_card_knowledge_t* knowledge) {
+  HANABI_INSTRUMENT(hanabi_learning_env::kCounterCApi);
   REQUIRE(observation != nullptr);
   REQUIRE(observation->observation != nullptr);
   REQUIRE(knowledge != nullptr);
@@ -691,6 +974,7 @@ void ObsGetHandCardKnowledge(pyhanabi_observation_t* observation, int pid,
 }
 
 int ObsDiscardPileSize(pyhanabi_observation_t* observation) {
+  HANABI_INSTRUMENT(hanabi_learning_env::kCounterCApi);
   return reinterpret_cast<hanabi_learning_env::HanabiObservation*>(
              observation->observation)
       ->DiscardPile()
@@ -699,6 +983,7 @@ int ObsDiscardPileSize(pyhanabi_observation_t* observation) {
 
 void ObsGetDiscard(pyhanabi_observation_t* observation, int index,
                    pyhanabi_card_t* card) {
+  HANABI_INSTRUMENT(hanabi_learning_env::kCounterCApi);
   REQUIRE(observation != nullptr);
   REQUIRE(observation->observation != nullptr);
   REQUIRE(card != nullptr);
@@ -712,6 +997,7 @@ void ObsGetDiscard(pyhanabi_observation_t* observation, int index,
 }
 
 int ObsFireworks(pyhanabi_observation_t* observation, int color) {
+  HANABI_INSTRUMENT(hanabi_learning_env::kCounterCApi);
   REQUIRE(observation != nullptr);
   REQUIRE(observation->observation != nullptr);
   return reinterpret_cast<hanabi_learning_env::HanabiObservation*>(
@@ -721,6 +1007,7 @@ int ObsFireworks(pyhanabi_observation_t* observation, int color) {
 }
 
 int ObsDeckSize(pyhanabi_observation_t* observation) {
+  HANABI_INSTRUMENT(hanabi_learning_env::kCounterCApi);
   REQUIRE(observation != nullptr);
   REQUIRE(observation->observation != nullptr);
   return reinterpret_cast<hanabi_learning_env::HanabiObservation*>(
@@ -729,6 +1016,7 @@ int ObsDeckSize(pyhanabi_observation_t* observation) {
 }
 
 int ObsNumLastMoves(pyhanabi_observation_t* observation) {
+  HANABI_INSTRUMENT(hanabi_learning_env::kCounterCApi);
   REQUIRE(observation != nullptr);
   REQUIRE(observation->observation != nullptr);
   return reinterpret_cast<hanabi_learning_env::HanabiObservation*>(
@@ -739,6 +1027,7 @@ int ObsNumLastMoves(pyhanabi_observation_t* observation) {
 
 void ObsGetLastMove(pyhanabi_observation_t* observation, int index,
                     pyhanabi_history_item_t* item) {
+  HANABI_INSTRUMENT(hanabi_learning_env::kCounterCApi);
   REQUIRE(observation != nullptr);
   REQUIRE(observation->observation != nullptr);
   REQUIRE(item != nullptr);
@@ -750,6 +1039,7 @@ void ObsGetLastMove(pyhanabi_observation_t* observation, int index,
 }
 
 int ObsInformationTokens(pyhanabi_observation_t* observation) {
+  HANABI_INSTRUMENT(hanabi_learning_env::kCounterCApi);
   REQUIRE(observation != nullptr);
   REQUIRE(observation->observation != nullptr);
   return reinterpret_cast<hanabi_learning_env::HanabiObservation*>(
@@ -758,6 +1048,7 @@ int ObsInformationTokens(pyhanabi_observation_t* observation) {
 }
 
 int ObsLifeTokens(pyhanabi_observation_t* observation) {
+  HANABI_INSTRUMENT(hanabi_learning_env::kCounterCApi);
   REQUIRE(observation != nullptr);
   REQUIRE(observation->observation != nullptr);
   return reinterpret_cast<hanabi_learning_env::HanabiObservation*>(
@@ -766,6 +1057,7 @@ int ObsLifeTokens(pyhanabi_observation_t* observation) {
 }
 
 int ObsNumLegalMoves(pyhanabi_observation_t* observation) {
+  HANABI_INSTRUMENT(hanabi_learning_env::kCounterCApi);
   REQUIRE(observation != nullptr);
   REQUIRE(observation->observation != nullptr);
   return reinterpret_cast<hanabi_learning_env::HanabiObservation*>(
@@ -774,8 +1066,18 @@ int ObsNumLegalMoves(pyhanabi_observation_t* observation) {
       .size();
 }
 
+uint64_t ObsLegalMoveMask(pyhanabi_observation_t* observation) {
+  HANABI_INSTRUMENT(hanabi_learning_env::kCounterCApi);
+  REQUIRE(observation != nullptr);
+  REQUIRE(observation->observation != nullptr);
+  return reinterpret_cast<hanabi_learning_env::HanabiObservation*>(
+             observation->observation)
+      ->LegalMoveMask();
+}
+
 void ObsGetLegalMove(pyhanabi_observation_t* observation, int index,
                      pyhanabi_move_t* move) {
+  HANABI_INSTRUMENT(hanabi_learning_env::kCounterCApi);
   REQUIRE(observation != nullptr);
   REQUIRE(observation->observation != nullptr);
   REQUIRE(move != nullptr);
@@ -788,13 +1090,67 @@ void ObsGetLegalMove(pyhanabi_observation_t* observation, int index,
 
 bool ObsCardPlayableOnFireworks(const pyhanabi_observation_t* observation,
                                 int color, int rank) {
+  HANABI_INSTRUMENT(hanabi_learning_env::kCounterCApi);
   return reinterpret_cast<const hanabi_learning_env::HanabiObservation*>(
              observation->observation)
       ->CardPlayableOnFireworks(color, rank);
 }
 
+void ObsExportData(pyhanabi_observation_t* observation,
+                   pyhanabi_observation_data_t* data) {
+  HANABI_INSTRUMENT(hanabi_learning_env::kCounterCApi);
+  REQUIRE(observation != nullptr);
+  REQUIRE(observation->observation != nullptr);
+  REQUIRE(data != nullptr);
+  const auto& obs = *reinterpret_cast<hanabi_learning_env::HanabiObservation*>(
+      observation->observation);
+  data->cur_player_offset = obs.CurPlayerOffset();
+  data->num_players = obs.Hands().size();
+  data->num_colors = obs.Fireworks().size();
+  data->life_tokens = obs.LifeTokens();
+  data->information_tokens = obs.InformationTokens();
+  data->deck_size = obs.DeckSize();
+  for (int color = 0; color < data->num_colors; ++color) {
+    data->fireworks[color] = obs.Fireworks()[color];
+  }
+  for (int pid = 0; pid < data->num_players; ++pid) {
+    const hanabi_learning_env::HanabiHand& hand = obs.Hands()[pid];
+    data->hand_sizes[pid] = hand.Cards().size();
+    for (int i = 0; i < data->hand_sizes[pid]; ++i) {
+      const hanabi_learning_env::HanabiHand::CardKnowledge& knowledge =
+          hand.Knowledge()[i];
+      data->hands[pid][i].color = hand.Cards()[i].Color();
+      data->hands[pid][i].rank = hand.Cards()[i].Rank();
+      data->hinted_colors[pid][i] = knowledge.Color();
+      data->hinted_ranks[pid][i] = knowledge.Rank();
+      data->color_plausible_masks[pid][i] = knowledge.ColorPlausibleMask();
+      data->rank_plausible_masks[pid][i] = knowledge.RankPlausibleMask();
+    }
+  }
+  data->num_discards = obs.DiscardPile().size();
+  for (int i = 0; i < data->num_discards; ++i) {
+    data->discard_pile[i].color = obs.DiscardPile()[i].Color();
+    data->discard_pile[i].rank = obs.DiscardPile()[i].Rank();
+  }
+  data->num_last_moves = obs.LastMoves().size();
+  REQUIRE(data->num_last_moves <= 2 * hanabi_learning_env::kMaxPlayers);
+  for (int i = 0; i < data->num_last_moves; ++i) {
+    ExportHistoryItem(obs.LastMoves()[i], &data->last_moves[i]);
+  }
+  data->legal_move_mask = obs.LegalMoveMask();
+  data->num_legal_moves = 0;
+  for (uint64_t mask = data->legal_move_mask; mask != 0; mask &= mask - 1) {
+    int uid = 0;
+    while (((mask >> uid) & 1) == 0) {
+      ++uid;
+    }
+    data->legal_move_uids[data->num_legal_moves++] = uid;
+  }
+}
+
 void NewObservationEncoder(pyhanabi_observation_encoder_t* encoder,
                            pyhanabi_game_t* game, int type) {
+  HANABI_INSTRUMENT(hanabi_learning_env::kCounterCApi);
   REQUIRE(encoder != nullptr);
   REQUIRE(game != nullptr);
   REQUIRE(game->game != nullptr);
@@ -806,6 +1162,10 @@ void NewObservationEncoder(pyhanabi_observation_encoder_t* encoder,
       encoder->encoder = static_cast<hanabi_learning_env::ObservationEncoder*>(
           new hanabi_learning_env::CanonicalObservationEncoder(hanabi_game));
       break;
+    case hanabi_learning_env::ObservationEncoder::Type::kBelief:
+      encoder->encoder = static_cast<hanabi_learning_env::ObservationEncoder*>(
+          new hanabi_learning_env::BeliefObservationEncoder(hanabi_game));
+      break;
     default:
       std::cerr << "Encoder type not recognized." << std::endl;
       encoder->encoder = nullptr;
@@ -813,7 +1173,20 @@ void NewObservationEncoder(pyhanabi_observation_encoder_t* encoder,
   }
 }
 
+void NewBeliefObservationEncoder(pyhanabi_observation_encoder_t* encoder,
+                                 pyhanabi_game_t* game, int iterations) {
+  HANABI_INSTRUMENT(hanabi_learning_env::kCounterCApi);
+  REQUIRE(encoder != nullptr);
+  REQUIRE(game != nullptr);
+  REQUIRE(game->game != nullptr);
+  encoder->encoder = static_cast<hanabi_learning_env::ObservationEncoder*>(
+      new hanabi_learning_env::BeliefObservationEncoder(
+          reinterpret_cast<hanabi_learning_env::HanabiGame*>(game->game),
+          iterations));
+}
+
 void DeleteObservationEncoder(pyhanabi_observation_encoder_t* encoder) {
+  HANABI_INSTRUMENT(hanabi_learning_env::kCounterCApi);
   REQUIRE(encoder != nullptr);
   REQUIRE(encoder->encoder != nullptr);
   delete reinterpret_cast<hanabi_learning_env::ObservationEncoder*>(
@@ -822,6 +1195,7 @@ void DeleteObservationEncoder(pyhanabi_observation_encoder_t* encoder) {
 }
 
 char* ObservationShape(pyhanabi_observation_encoder_t* encoder) {
+  HANABI_INSTRUMENT(hanabi_learning_env::kCounterCApi);
   REQUIRE(encoder != nullptr);
   REQUIRE(encoder->encoder != nullptr);
   auto obs_enc = reinterpret_cast<hanabi_learning_env::ObservationEncoder*>(
@@ -839,6 +1213,7 @@ char* ObservationShape(pyhanabi_observation_encoder_t* encoder) {
 
 char* EncodeObservation(pyhanabi_observation_encoder_t* encoder,
                         pyhanabi_observation_t* observation) {
+  HANABI_INSTRUMENT(hanabi_learning_env::kCounterCApi);
   REQUIRE(encoder != nullptr);
   REQUIRE(encoder->encoder != nullptr);
   REQUIRE(observation != nullptr);
@@ -858,9 +1233,278 @@ char* EncodeObservation(pyhanabi_observation_encoder_t* encoder,
   return strdup(obs_str.c_str());
 }
 
+int ObservationLength(pyhanabi_observation_encoder_t* encoder) {
+  HANABI_INSTRUMENT(hanabi_learning_env::kCounterCApi);
+  REQUIRE(encoder != nullptr);
+  REQUIRE(encoder->encoder != nullptr);
+  return reinterpret_cast<hanabi_learning_env::ObservationEncoder*>(
+             encoder->encoder)
+      ->Size();
+}
+
+void EncodeObservationUint8(pyhanabi_observation_encoder_t* encoder,
+                            pyhanabi_observation_t* observation,
+                            uint8_t* buffer, int size) {
+  HANABI_INSTRUMENT(hanabi_learning_env::kCounterCApi);
+  REQUIRE(observation != nullptr);
+  REQUIRE(observation->observation != nullptr);
+  REQUIRE(buffer != nullptr);
+  REQUIRE(size >= ObservationLength(encoder));
+  reinterpret_cast<hanabi_learning_env::ObservationEncoder*>(encoder->encoder)
+      ->EncodeInto(*reinterpret_cast<hanabi_learning_env::HanabiObservation*>(
+                       observation->observation),
+                   buffer);
+}
+
+void EncodeObservationFloat(pyhanabi_observation_encoder_t* encoder,
+                            pyhanabi_observation_t* observation,
+                            float* buffer, int size) {
+  HANABI_INSTRUMENT(hanabi_learning_env::kCounterCApi);
+  REQUIRE(observation != nullptr);
+  REQUIRE(observation->observation != nullptr);
+  REQUIRE(buffer != nullptr);
+  REQUIRE(size >= ObservationLength(encoder));
+  reinterpret_cast<hanabi_learning_env::ObservationEncoder*>(encoder->encoder)
+      ->EncodeInto(*reinterpret_cast<hanabi_learning_env::HanabiObservation*>(
+                       observation->observation),
+                   buffer);
+}
+
+void EncodeStateUint8(pyhanabi_observation_encoder_t* encoder,
+                      pyhanabi_state_t* state, int player, uint8_t* buffer,
+                      int size) {
+  HANABI_INSTRUMENT(hanabi_learning_env::kCounterCApi);
+  REQUIRE(state != nullptr);
+  REQUIRE(state->state != nullptr);
+  REQUIRE(buffer != nullptr);
+  REQUIRE(size >= ObservationLength(encoder));
+  reinterpret_cast<hanabi_learning_env::ObservationEncoder*>(encoder->encoder)
+      ->EncodeStateInto(
+          *reinterpret_cast<hanabi_learning_env::HanabiState*>(state->state),
+          player, buffer);
+}
+
+void EncodeStateFloat(pyhanabi_observation_encoder_t* encoder,
+                      pyhanabi_state_t* state, int player, float* buffer,
+                      int size) {
+  HANABI_INSTRUMENT(hanabi_learning_env::kCounterCApi);
+  REQUIRE(state != nullptr);
+  REQUIRE(state->state != nullptr);
+  REQUIRE(buffer != nullptr);
+  REQUIRE(size >= ObservationLength(encoder));
+  reinterpret_cast<hanabi_learning_env::ObservationEncoder*>(encoder->encoder)
+      ->EncodeStateInto(
+          *reinterpret_cast<hanabi_learning_env::HanabiState*>(state->state),
+          player, buffer);
+}
+
+void EncodeStatesUint8(pyhanabi_observation_encoder_t* encoder,
+                       pyhanabi_state_t** states, const int* players,
+                       int num_states, uint8_t* buffer, int size) {
+  HANABI_INSTRUMENT(hanabi_learning_env::kCounterCApi);
+  EncodeStates(encoder, states, players, num_states, buffer, size);
+}
+
+void EncodeStatesFloat(pyhanabi_observation_encoder_t* encoder,
+                       pyhanabi_state_t** states, const int* players,
+                       int num_states, float* buffer, int size) {
+  HANABI_INSTRUMENT(hanabi_learning_env::kCounterCApi);
+  EncodeStates(encoder, states, players, num_states, buffer, size);
+}
+
+int ObservationPackedLength(pyhanabi_observation_encoder_t* encoder) {
+  HANABI_INSTRUMENT(hanabi_learning_env::kCounterCApi);
+  REQUIRE(encoder != nullptr);
+  REQUIRE(encoder->encoder != nullptr);
+  return reinterpret_cast<hanabi_learning_env::ObservationEncoder*>(
+             encoder->encoder)
+      ->PackedSize();
+}
+
+void EncodeObservationPacked(pyhanabi_observation_encoder_t* encoder,
+                             pyhanabi_observation_t* observation,
+                             uint64_t* buffer, int size) {
+  HANABI_INSTRUMENT(hanabi_learning_env::kCounterCApi);
+  REQUIRE(observation != nullptr);
+  REQUIRE(observation->observation != nullptr);
+  REQUIRE(buffer != nullptr);
+  REQUIRE(size >= ObservationPackedLength(encoder));
+  reinterpret_cast<hanabi_learning_env::ObservationEncoder*>(encoder->encoder)
+      ->EncodePackedInto(
+          *reinterpret_cast<hanabi_learning_env::HanabiObservation*>(
+              observation->observation),
+          buffer);
+}
+
+void EncodeStatePacked(pyhanabi_observation_encoder_t* encoder,
+                       pyhanabi_state_t* state, int player, uint64_t* buffer,
+                       int size) {
+  HANABI_INSTRUMENT(hanabi_learning_env::kCounterCApi);
+  REQUIRE(state != nullptr);
+  REQUIRE(state->state != nullptr);
+  REQUIRE(buffer != nullptr);
+  REQUIRE(size >= ObservationPackedLength(encoder));
+  reinterpret_cast<hanabi_learning_env::ObservationEncoder*>(encoder->encoder)
+      ->EncodeStatePackedInto(
+          *reinterpret_cast<hanabi_learning_env::HanabiState*>(state->state),
+          player, buffer);
+}
+
+void UnpackObservationsUint8(const uint64_t* packed, int num_rows,
+                             int num_bits, uint8_t* buffer) {
+  HANABI_INSTRUMENT(hanabi_learning_env::kCounterCApi);
+  REQUIRE(packed != nullptr || num_rows == 0);
+  REQUIRE(buffer != nullptr || num_rows == 0);
+  hanabi_learning_env::UnpackBitRows(packed, num_rows, num_bits, buffer);
+}
+
+void UnpackObservationsFloat(const uint64_t* packed, int num_rows,
+                             int num_bits, float* buffer) {
+  HANABI_INSTRUMENT(hanabi_learning_env::kCounterCApi);
+  REQUIRE(packed != nullptr || num_rows == 0);
+  REQUIRE(buffer != nullptr || num_rows == 0);
+  hanabi_learning_env::UnpackBitRows(packed, num_rows, num_bits, buffer);
+}
+
+/* VectorEnv functions. */
+void NewVectorEnv(pyhanabi_vector_env_t* env, pyhanabi_game_t* game,
+                  int num_envs, int num_threads) {
+  HANABI_INSTRUMENT(hanabi_learning_env::kCounterCApi);
+  REQUIRE(env != nullptr);
+  REQUIRE(game != nullptr);
+  REQUIRE(game->game != nullptr);
+  env->env = new hanabi_learning_env::HanabiVectorEnv(
+      reinterpret_cast<hanabi_learning_env::HanabiGame*>(game->game),
+      num_envs, num_threads);
+}
+
+void DeleteVectorEnv(pyhanabi_vector_env_t* env) {
+  HANABI_INSTRUMENT(hanabi_learning_env::kCounterCApi);
+  REQUIRE(env != nullptr);
+  REQUIRE(env->env != nullptr);
+  delete reinterpret_cast<hanabi_learning_env::HanabiVectorEnv*>(env->env);
+  env->env = nullptr;
+}
+
+int VectorEnvNumEnvs(pyhanabi_vector_env_t* env) {
+  HANABI_INSTRUMENT(hanabi_learning_env::kCounterCApi);
+  REQUIRE(env != nullptr);
+  REQUIRE(env->env != nullptr);
+  return reinterpret_cast<hanabi_learning_env::HanabiVectorEnv*>(env->env)
+      ->NumEnvs();
+}
+
+int VectorEnvNumThreads(pyhanabi_vector_env_t* env) {
+  HANABI_INSTRUMENT(hanabi_learning_env::kCounterCApi);
+  REQUIRE(env != nullptr);
+  REQUIRE(env->env != nullptr);
+  return reinterpret_cast<hanabi_learning_env::HanabiVectorEnv*>(env->env)
+      ->NumThreads();
+}
+
+int VectorEnvObservationLength(pyhanabi_vector_env_t* env) {
+  HANABI_INSTRUMENT(hanabi_learning_env::kCounterCApi);
+  REQUIRE(env != nullptr);
+  REQUIRE(env->env != nullptr);
+  return reinterpret_cast<hanabi_learning_env::HanabiVectorEnv*>(env->env)
+      ->ObservationLength();
+}
+
+int VectorEnvPackedObservationLength(pyhanabi_vector_env_t* env) {
+  HANABI_INSTRUMENT(hanabi_learning_env::kCounterCApi);
+  REQUIRE(env != nullptr);
+  REQUIRE(env->env != nullptr);
+  return reinterpret_cast<hanabi_learning_env::HanabiVectorEnv*>(env->env)
+      ->PackedObservationLength();
+}
+
+int VectorEnvNumMoves(pyhanabi_vector_env_t* env) {
+  HANABI_INSTRUMENT(hanabi_learning_env::kCounterCApi);
+  REQUIRE(env != nullptr);
+  REQUIRE(env->env != nullptr);
+  return reinterpret_cast<hanabi_learning_env::HanabiVectorEnv*>(env->env)
+      ->NumMoves();
+}
+
+void VectorEnvGetState(pyhanabi_vector_env_t* env, int index,
+                       pyhanabi_state_t* state) {
+  HANABI_INSTRUMENT(hanabi_learning_env::kCounterCApi);
+  REQUIRE(env != nullptr);
+  REQUIRE(env->env != nullptr);
+  REQUIRE(state != nullptr);
+  auto vector_env =
+      reinterpret_cast<hanabi_learning_env::HanabiVectorEnv*>(env->env);
+  REQUIRE(index >= 0 && index < vector_env->NumEnvs());
+  state->state = new hanabi_learning_env::HanabiState(vector_env->State(index));
+}
+
+void VectorEnvReset(pyhanabi_vector_env_t* env, uint8_t* observations,
+                    uint64_t* packed_observations, uint8_t* legal_moves,
+                    float* rewards, uint8_t* dones, int* current_players) {
+  HANABI_INSTRUMENT(hanabi_learning_env::kCounterCApi);
+  REQUIRE(env != nullptr);
+  REQUIRE(env->env != nullptr);
+  hanabi_learning_env::HanabiVectorEnvOutput output;
+  output.observations = observations;
+  output.packed_observations = packed_observations;
+  output.legal_moves = legal_moves;
+  output.rewards = rewards;
+  output.dones = dones;
+  output.current_players = current_players;
+  reinterpret_cast<hanabi_learning_env::HanabiVectorEnv*>(env->env)->Reset(
+      output);
+}
+
+int VectorEnvStep(pyhanabi_vector_env_t* env, const int* move_uids,
+                  uint8_t* observations, uint64_t* packed_observations,
+                  uint8_t* legal_moves, float* rewards, uint8_t* dones,
+                  int* current_players) {
+  HANABI_INSTRUMENT(hanabi_learning_env::kCounterCApi);
+  REQUIRE(env != nullptr);
+  REQUIRE(env->env != nullptr);
+  REQUIRE(move_uids != nullptr);
+  hanabi_learning_env::HanabiVectorEnvOutput output;
+  output.observations = observations;
+  output.packed_observations = packed_observations;
+  output.legal_moves = legal_moves;
+  output.rewards = rewards;
+  output.dones = dones;
+  output.current_players = current_players;
+  return reinterpret_cast<hanabi_learning_env::HanabiVectorEnv*>(env->env)
+      ->Step(move_uids, output);
+}
+
+int VectorEnvStepAsync(pyhanabi_vector_env_t* env, const int* move_uids,
+                       uint8_t* observations, uint64_t* packed_observations,
+                       uint8_t* legal_moves, float* rewards, uint8_t* dones,
+                       int* current_players) {
+  HANABI_INSTRUMENT(hanabi_learning_env::kCounterCApi);
+  REQUIRE(env != nullptr);
+  REQUIRE(env->env != nullptr);
+  REQUIRE(move_uids != nullptr);
+  hanabi_learning_env::HanabiVectorEnvOutput output;
+  output.observations = observations;
+  output.packed_observations = packed_observations;
+  output.legal_moves = legal_moves;
+  output.rewards = rewards;
+  output.dones = dones;
+  output.current_players = current_players;
+  return reinterpret_cast<hanabi_learning_env::HanabiVectorEnv*>(env->env)
+      ->StepAsync(move_uids, output);
+}
+
+void VectorEnvStepWait(pyhanabi_vector_env_t* env) {
+  HANABI_INSTRUMENT(hanabi_learning_env::kCounterCApi);
+  REQUIRE(env != nullptr);
+  REQUIRE(env->env != nullptr);
+  reinterpret_cast<hanabi_learning_env::HanabiVectorEnv*>(env->env)
+      ->StepWait();
+}
+
 /* Manual state setters */
 
 void StateSetLifeTokens(pyhanabi_state_t* state, int tokens) {
+  HANABI_INSTRUMENT(hanabi_learning_env::kCounterCApi);
   REQUIRE(state != nullptr);
   REQUIRE(state->state != nullptr);
   reinterpret_cast<hanabi_learning_env::HanabiState*>(state->state)
@@ -868,6 +1512,7 @@ void StateSetLifeTokens(pyhanabi_state_t* state, int tokens) {
 }
 
 void StateSetInformationTokens(pyhanabi_state_t* state, int tokens) {
+  HANABI_INSTRUMENT(hanabi_learning_env::kCounterCApi);
   REQUIRE(state != nullptr);
   REQUIRE(state->state != nullptr);
   reinterpret_cast<hanabi_learning_env::HanabiState*>(state->state)
@@ -875,6 +1520,7 @@ void StateSetInformationTokens(pyhanabi_state_t* state, int tokens) {
 }
 
 void StateSetFireworks(pyhanabi_state_t* state, const int* fireworks, int count) {
+  HANABI_INSTRUMENT(hanabi_learning_env::kCounterCApi);
   REQUIRE(state != nullptr);
   REQUIRE(state->state != nullptr);
   std::vector<int> fw(fireworks, fireworks + count);
@@ -883,6 +1529,7 @@ void StateSetFireworks(pyhanabi_state_t* state, const int* fireworks, int count)
 }
 
 void StateSetDiscardPile(pyhanabi_state_t* state, const pyhanabi_card_t* cards, int count) {
+  HANABI_INSTRUMENT(hanabi_learning_env::kCounterCApi);
   REQUIRE(state != nullptr);
   REQUIRE(state->state != nullptr);
   std::vector<hanabi_learning_env::HanabiCard> pile;
@@ -894,6 +1541,7 @@ void StateSetDiscardPile(pyhanabi_state_t* state, const pyhanabi_card_t* cards,
 }
 
 void StateSetHand(pyhanabi_state_t* state, int player, const pyhanabi_card_t* cards, int count) {
+  HANABI_INSTRUMENT(hanabi_learning_env::kCounterCApi);
   REQUIRE(state != nullptr);
   REQUIRE(state->state != nullptr);
   std::vector<hanabi_learning_env::HanabiCard> hand;
@@ -905,6 +1553,7 @@ void StateSetHand(pyhanabi_state_t* state, int player, const pyhanabi_card_t* ca
 }
 
 void StateSetDeck(pyhanabi_state_t* state, const pyhanabi_card_t* cards, int count) {
+  HANABI_INSTRUMENT(hanabi_learning_env::kCounterCApi);
   REQUIRE(state != nullptr);
   REQUIRE(state->state != nullptr);
   std::vector<hanabi_learning_env::HanabiCard> deck;
@@ -916,6 +1565,7 @@ void StateSetDeck(pyhanabi_state_t* state, const pyhanabi_card_t* cards, int cou
 }
 
 void StateSetCurPlayer(pyhanabi_state_t* state, int player) {
+  HANABI_INSTRUMENT(hanabi_learning_env::kCounterCApi);
   REQUIRE(state != nullptr);
   REQUIRE(state->state != nullptr);
   reinterpret_cast<hanabi_learning_env::HanabiState*>(state->state)
@@ -923,6 +1573,7 @@ void StateSetCurPlayer(pyhanabi_state_t* state, int player) {
 }
 
 void StateSetHandCard(pyhanabi_state_t* state, int player, int card_index, const pyhanabi_card_t* card) {
+  HANABI_INSTRUMENT(hanabi_learning_env::kCounterCApi);
   REQUIRE(state != nullptr);
   REQUIRE(state->state != nullptr);
   REQUIRE(card != nullptr);
@@ -931,4 +1582,808 @@ void StateSetHandCard(pyhanabi_state_t* state, int player, int card_index, const
       ->SetHandCard(player, card_index, h_card);
 }
 
+void StateSampleDeterminization(pyhanabi_state_t* state, int observer,
+                                pyhanabi_state_t* determinization) {
+  HANABI_INSTRUMENT(hanabi_learning_env::kCounterCApi);
+  REQUIRE(state != nullptr);
+  REQUIRE(state->state != nullptr);
+  REQUIRE(determinization != nullptr);
+  auto hanabi_state =
+      reinterpret_cast<hanabi_learning_env::HanabiState*>(state->state);
+  determinization->state = new hanabi_learning_env::HanabiState(
+      hanabi_learning_env::SampleDeterminization(
+          *hanabi_state, observer, hanabi_state->ParentGame()->Rng()));
+}
+
+void NewDeterminizationPool(pyhanabi_determinization_pool_t* pool, int size,
+                            int seed) {
+  HANABI_INSTRUMENT(hanabi_learning_env::kCounterCApi);
+  REQUIRE(pool != nullptr);
+  pool->pool = new hanabi_learning_env::HanabiDeterminizationPool(size, seed);
+}
+
+void DeleteDeterminizationPool(pyhanabi_determinization_pool_t* pool) {
+  HANABI_INSTRUMENT(hanabi_learning_env::kCounterCApi);
+  REQUIRE(pool != nullptr);
+  REQUIRE(pool->pool != nullptr);
+  delete reinterpret_cast<hanabi_learning_env::HanabiDeterminizationPool*>(
+      pool->pool);
+  pool->pool = nullptr;
+}
+
+int DeterminizationPoolSize(pyhanabi_determinization_pool_t* pool) {
+  HANABI_INSTRUMENT(hanabi_learning_env::kCounterCApi);
+  REQUIRE(pool != nullptr);
+  REQUIRE(pool->pool != nullptr);
+  return reinterpret_cast<hanabi_learning_env::HanabiDeterminizationPool*>(
+             pool->pool)
+      ->Size();
+}
+
+void DeterminizationPoolSample(pyhanabi_determinization_pool_t* pool,
+                               pyhanabi_state_t* state, int observer) {
+  HANABI_INSTRUMENT(hanabi_learning_env::kCounterCApi);
+  REQUIRE(pool != nullptr);
+  REQUIRE(pool->pool != nullptr);
+  REQUIRE(state != nullptr);
+  REQUIRE(state->state != nullptr);
+  reinterpret_cast<hanabi_learning_env::HanabiDeterminizationPool*>(pool->pool)
+      ->Sample(
+          *reinterpret_cast<hanabi_learning_env::HanabiState*>(state->state),
+          observer);
+}
+
+void DeterminizationPoolGetState(pyhanabi_determinization_pool_t* pool,
+                                 int index, pyhanabi_state_t* state) {
+  HANABI_INSTRUMENT(hanabi_learning_env::kCounterCApi);
+  REQUIRE(pool != nullptr);
+  REQUIRE(pool->pool != nullptr);
+  REQUIRE(state != nullptr);
+  auto determinization_pool =
+      reinterpret_cast<hanabi_learning_env::HanabiDeterminizationPool*>(
+          pool->pool);
+  REQUIRE(index >= 0 && index < determinization_pool->NumSampled());
+  state->state =
+      new hanabi_learning_env::HanabiState(determinization_pool->State(index));
+}
+
+/* Policy and playout functions. */
+void NewPolicy(pyhanabi_policy_t* policy, int type) {
+  HANABI_INSTRUMENT(hanabi_learning_env::kCounterCApi);
+  REQUIRE(policy != nullptr);
+  switch (static_cast<hanabi_learning_env::HanabiPolicy::Type>(type)) {
+    case hanabi_learning_env::HanabiPolicy::kRandom:
+      policy->policy = new hanabi_learning_env::RandomPolicy();
+      break;
+    case hanabi_learning_env::HanabiPolicy::kSimple:
+      policy->policy = new hanabi_learning_env::SimplePolicy();
+      break;
+    default:
+      std::cerr << "Policy type not recognized." << std::endl;
+      policy->policy = nullptr;
+      std::abort();
+  }
+}
+
+void DeletePolicy(pyhanabi_policy_t* policy) {
+  HANABI_INSTRUMENT(hanabi_learning_env::kCounterCApi);
+  REQUIRE(policy != nullptr);
+  REQUIRE(policy->policy != nullptr);
+  delete reinterpret_cast<hanabi_learning_env::HanabiPolicy*>(policy->policy);
+  policy->policy = nullptr;
+}
+
+void PolicyAct(pyhanabi_policy_t* policy, pyhanabi_state_t* state,
+               pyhanabi_move_t* move) {
+  HANABI_INSTRUMENT(hanabi_learning_env::kCounterCApi);
+  REQUIRE(policy != nullptr);
+  REQUIRE(policy->policy != nullptr);
+  REQUIRE(state != nullptr);
+  REQUIRE(state->state != nullptr);
+  REQUIRE(move != nullptr);
+  auto hanabi_state =
+      reinterpret_cast<hanabi_learning_env::HanabiState*>(state->state);
+  REQUIRE(hanabi_state->CurPlayer() != hanabi_learning_env::kChancePlayerId);
+  REQUIRE(!hanabi_state->IsTerminal());
+  move->move = new hanabi_learning_env::HanabiMove(
+      reinterpret_cast<hanabi_learning_env::HanabiPolicy*>(policy->policy)
+          ->Act(*hanabi_state, hanabi_state->ParentGame()->Rng()));
+}
+
+void PolicyPlayout(pyhanabi_policy_t* policy, pyhanabi_state_t* state,
+                   int seed, pyhanabi_playout_result_t* result) {
+  HANABI_INSTRUMENT(hanabi_learning_env::kCounterCApi);
+  REQUIRE(policy != nullptr);
+  REQUIRE(policy->policy != nullptr);
+  REQUIRE(state != nullptr);
+  REQUIRE(state->state != nullptr);
+  REQUIRE(result != nullptr);
+  while (seed == -1) {
+    seed = std::random_device()();
+  }
+  std::mt19937 rng(seed);
+  const hanabi_learning_env::HanabiPlayoutResult playout =
+      hanabi_learning_env::Playout(
+          reinterpret_cast<hanabi_learning_env::HanabiState*>(state->state),
+          *reinterpret_cast<hanabi_learning_env::HanabiPolicy*>(
+              policy->policy),
+          &rng);
+  result->score = playout.score;
+  result->end_of_game = playout.end_of_game;
+  result->num_moves = playout.num_moves;
+  result->num_plays = playout.num_plays;
+  result->num_misplays = playout.num_misplays;
+  result->num_discards = playout.num_discards;
+  result->num_hints = playout.num_hints;
+}
+
+void PolicyEvaluate(pyhanabi_policy_t* policy, pyhanabi_game_t* game,
+                    int num_games, int num_threads,
+                    pyhanabi_evaluation_t* evaluation) {
+  HANABI_INSTRUMENT(hanabi_learning_env::kCounterCApi);
+  REQUIRE(policy != nullptr);
+  REQUIRE(policy->policy != nullptr);
+  REQUIRE(game != nullptr);
+  REQUIRE(game->game != nullptr);
+  REQUIRE(evaluation != nullptr);
+  const hanabi_learning_env::HanabiEvaluation result =
+      hanabi_learning_env::EvaluatePolicy(
+          reinterpret_cast<hanabi_learning_env::HanabiGame*>(game->game),
+          *reinterpret_cast<hanabi_learning_env::HanabiPolicy*>(
+              policy->policy),
+          num_games, num_threads);
+  evaluation->num_games = result.num_games;
+  evaluation->mean_score = result.mean_score;
+  evaluation->score_stddev = result.score_stddev;
+  evaluation->mean_moves = result.mean_moves;
+  evaluation->mean_plays = result.mean_plays;
+  evaluation->mean_misplays = result.mean_misplays;
+  evaluation->mean_discards = result.mean_discards;
+  evaluation->mean_hints = result.mean_hints;
+  constexpr int kNumScores =
+      sizeof(evaluation->score_counts) / sizeof(evaluation->score_counts[0]);
+  static_assert(kNumScores == hanabi_learning_env::kMaxNumColors *
+                                      hanabi_learning_env::kMaxNumRanks +
+                                  1,
+                "score_counts must hold every score.");
+  for (int score = 0; score < kNumScores; ++score) {
+    evaluation->score_counts[score] =
+        score < static_cast<int>(result.score_counts.size())
+            ? result.score_counts[score]
+            : 0;
+  }
+  evaluation->num_out_of_life_tokens = result.num_out_of_life_tokens;
+  evaluation->num_out_of_cards = result.num_out_of_cards;
+  evaluation->num_completed_fireworks = result.num_completed_fireworks;
+}
+
+double StateExpectedValue(pyhanabi_state_t* state, int depth,
+                          pyhanabi_policy_t* policy, int num_threads) {
+  HANABI_INSTRUMENT(hanabi_learning_env::kCounterCApi);
+  REQUIRE(state != nullptr);
+  REQUIRE(state->state != nullptr);
+  REQUIRE(policy == nullptr || policy->policy != nullptr);
+  return hanabi_learning_env::ExpectedValue(
+      *reinterpret_cast<hanabi_learning_env::HanabiState*>(state->state),
+      depth,
+      policy == nullptr ? nullptr
+                        : reinterpret_cast<hanabi_learning_env::HanabiPolicy*>(
+                              policy->policy),
+      num_threads);
+}
+
+void StateExpectedMoveValues(pyhanabi_state_t* state, int depth,
+                             pyhanabi_policy_t* policy, int num_threads,
+                             double* move_values) {
+  HANABI_INSTRUMENT(hanabi_learning_env::kCounterCApi);
+  REQUIRE(state != nullptr);
+  REQUIRE(state->state != nullptr);
+  REQUIRE(policy == nullptr || policy->policy != nullptr);
+  REQUIRE(move_values != nullptr);
+  const std::vector<double> values = hanabi_learning_env::ExpectedMoveValues(
+      *reinterpret_cast<hanabi_learning_env::HanabiState*>(state->state),
+      depth,
+      policy == nullptr ? nullptr
+                        : reinterpret_cast<hanabi_learning_env::HanabiPolicy*>(
+                              policy->policy),
+      num_threads);
+  std::copy(values.begin(), values.end(), move_values);
+}
+
+void NewSearch(pyhanabi_search_t* search,
+               const pyhanabi_search_config_t* config,
+               pyhanabi_policy_t* rollout_policy) {
+  HANABI_INSTRUMENT(hanabi_learning_env::kCounterCApi);
+  REQUIRE(search != nullptr);
+  REQUIRE(config != nullptr);
+  REQUIRE(rollout_policy != nullptr);
+  REQUIRE(rollout_policy->policy != nullptr);
+  hanabi_learning_env::HanabiSearchConfig search_config;
+  search_config.num_iterations = config->num_iterations;
+  search_config.time_limit = config->time_limit;
+  search_config.exploration = config->exploration;
+  search_config.num_threads = config->num_threads;
+  search_config.score_lost_games = config->score_lost_games != 0;
+  search_config.seed = config->seed;
+  search_config.transposition_table_size = config->transposition_table_size;
+  search->search = new hanabi_learning_env::HanabiSearch(
+      search_config, reinterpret_cast<hanabi_learning_env::HanabiPolicy*>(
+                         rollout_policy->policy));
+}
+
+void DeleteSearch(pyhanabi_search_t* search) {
+  HANABI_INSTRUMENT(hanabi_learning_env::kCounterCApi);
+  REQUIRE(search != nullptr);
+  REQUIRE(search->search != nullptr);
+  delete reinterpret_cast<hanabi_learning_env::HanabiSearch*>(search->search);
+  search->search = nullptr;
+}
+
+int SearchState(pyhanabi_search_t* search, pyhanabi_state_t* state,
+                pyhanabi_move_t* move, int* visit_counts, double* values) {
+  HANABI_INSTRUMENT(hanabi_learning_env::kCounterCApi);
+  REQUIRE(search != nullptr);
+  REQUIRE(search->search != nullptr);
+  REQUIRE(state != nullptr);
+  REQUIRE(state->state != nullptr);
+  return ExportSearchResult(
+      reinterpret_cast<hanabi_learning_env::HanabiSearch*>(search->search)
+          ->Search(*reinterpret_cast<hanabi_learning_env::HanabiState*>(
+              state->state)),
+      move, visit_counts, values);
+}
+
+int SearchObservation(pyhanabi_search_t* search,
+                      pyhanabi_observation_t* observation,
+                      pyhanabi_move_t* move, int* visit_counts,
+                      double* values) {
+  HANABI_INSTRUMENT(hanabi_learning_env::kCounterCApi);
+  REQUIRE(search != nullptr);
+  REQUIRE(search->search != nullptr);
+  REQUIRE(observation != nullptr);
+  REQUIRE(observation->observation != nullptr);
+  return ExportSearchResult(
+      reinterpret_cast<hanabi_learning_env::HanabiSearch*>(search->search)
+          ->Search(*reinterpret_cast<hanabi_learning_env::HanabiObservation*>(
+              observation->observation)),
+      move, visit_counts, values);
+}
+
+void NewGameLogWriter(pyhanabi_game_log_writer_t* writer, const char* path,
+                      pyhanabi_game_t* game) {
+  HANABI_INSTRUMENT(hanabi_learning_env::kCounterCApi);
+  REQUIRE(writer != nullptr);
+  REQUIRE(path != nullptr);
+  REQUIRE(game != nullptr);
+  REQUIRE(game->game != nullptr);
+  writer->writer = new hanabi_learning_env::HanabiGameLogWriter(
+      path, *reinterpret_cast<hanabi_learning_env::HanabiGame*>(game->game));
+}
+
+void DeleteGameLogWriter(pyhanabi_game_log_writer_t* writer) {
+  HANABI_INSTRUMENT(hanabi_learning_env::kCounterCApi);
+  REQUIRE(writer != nullptr);
+  REQUIRE(writer->writer != nullptr);
+  delete reinterpret_cast<hanabi_learning_env::HanabiGameLogWriter*>(
+      writer->writer);
+  writer->writer = nullptr;
+}
+
+void GameLogWriterWriteGame(pyhanabi_game_log_writer_t* writer,
+                            pyhanabi_state_t* state, uint64_t seed) {
+  HANABI_INSTRUMENT(hanabi_learning_env::kCounterCApi);
+  REQUIRE(writer != nullptr);
+  REQUIRE(writer->writer != nullptr);
+  REQUIRE(state != nullptr);
+  REQUIRE(state->state != nullptr);
+  reinterpret_cast<hanabi_learning_env::HanabiGameLogWriter*>(writer->writer)
+      ->WriteGame(
+          *reinterpret_cast<hanabi_learning_env::HanabiState*>(state->state),
+          seed);
+}
+
+int64_t GameLogWriterNumGames(pyhanabi_game_log_writer_t* writer) {
+  HANABI_INSTRUMENT(hanabi_learning_env::kCounterCApi);
+  REQUIRE(writer != nullptr);
+  REQUIRE(writer->writer != nullptr);
+  return reinterpret_cast<hanabi_learning_env::HanabiGameLogWriter*>(
+             writer->writer)
+      ->NumGames();
+}
+
+void GameLogWriterFlush(pyhanabi_game_log_writer_t* writer) {
+  HANABI_INSTRUMENT(hanabi_learning_env::kCounterCApi);
+  REQUIRE(writer != nullptr);
+  REQUIRE(writer->writer != nullptr);
+  reinterpret_cast<hanabi_learning_env::HanabiGameLogWriter*>(writer->writer)
+      ->Flush();
+}
+
+void NewGameLogReader(pyhanabi_game_log_reader_t* reader, const char* path) {
+  HANABI_INSTRUMENT(hanabi_learning_env::kCounterCApi);
+  REQUIRE(reader != nullptr);
+  REQUIRE(path != nullptr);
+  reader->reader = new hanabi_learning_env::HanabiGameLogReader(path);
+}
+
+void DeleteGameLogReader(pyhanabi_game_log_reader_t* reader) {
+  HANABI_INSTRUMENT(hanabi_learning_env::kCounterCApi);
+  REQUIRE(reader != nullptr);
+  REQUIRE(reader->reader != nullptr);
+  delete reinterpret_cast<hanabi_learning_env::HanabiGameLogReader*>(
+      reader->reader);
+  reader->reader = nullptr;
+}
+
+char* GameLogReaderParameters(pyhanabi_game_log_reader_t* reader) {
+  HANABI_INSTRUMENT(hanabi_learning_env::kCounterCApi);
+  REQUIRE(reader != nullptr);
+  REQUIRE(reader->reader != nullptr);
+  std::string str;
+  for (const auto& param :
+       reinterpret_cast<hanabi_learning_env::HanabiGameLogReader*>(
+           reader->reader)
+           ->ParentGame()
+           ->Parameters()) {
+    str += param.first + "=" + param.second + "\n";
+  }
+  return strdup(str.c_str());
+}
+
+int GameLogReaderNumGames(pyhanabi_game_log_reader_t* reader) {
+  HANABI_INSTRUMENT(hanabi_learning_env::kCounterCApi);
+  REQUIRE(reader != nullptr);
+  REQUIRE(reader->reader != nullptr);
+  return reinterpret_cast<hanabi_learning_env::HanabiGameLogReader*>(
+             reader->reader)
+      ->NumGames();
+}
+
+uint64_t GameLogReaderSeed(pyhanabi_game_log_reader_t* reader, int game) {
+  HANABI_INSTRUMENT(hanabi_learning_env::kCounterCApi);
+  REQUIRE(reader != nullptr);
+  REQUIRE(reader->reader != nullptr);
+  return reinterpret_cast<hanabi_learning_env::HanabiGameLogReader*>(
+             reader->reader)
+      ->Seed(game);
+}
+
+int GameLogReaderNumMoves(pyhanabi_game_log_reader_t* reader, int game) {
+  HANABI_INSTRUMENT(hanabi_learning_env::kCounterCApi);
+  REQUIRE(reader != nullptr);
+  REQUIRE(reader->reader != nullptr);
+  return reinterpret_cast<hanabi_learning_env::HanabiGameLogReader*>(
+             reader->reader)
+      ->NumMoves(game);
+}
+
+int GameLogReaderNumPlayerMoves(pyhanabi_game_log_reader_t* reader,
+                                int game) {
+  HANABI_INSTRUMENT(hanabi_learning_env::kCounterCApi);
+  REQUIRE(reader != nullptr);
+  REQUIRE(reader->reader != nullptr);
+  return reinterpret_cast<hanabi_learning_env::HanabiGameLogReader*>(
+             reader->reader)
+      ->NumPlayerMoves(game);
+}
+
+void GameLogReaderReplay(pyhanabi_game_log_reader_t* reader, int game,
+                         int num_moves, pyhanabi_state_t* state) {
+  HANABI_INSTRUMENT(hanabi_learning_env::kCounterCApi);
+  REQUIRE(reader != nullptr);
+  REQUIRE(reader->reader != nullptr);
+  REQUIRE(state != nullptr);
+  REQUIRE(state->state != nullptr);
+  reinterpret_cast<hanabi_learning_env::HanabiGameLogReader*>(reader->reader)
+      ->Replay(game, num_moves,
+               reinterpret_cast<hanabi_learning_env::HanabiState*>(
+                   state->state));
+}
+
+int GameLogReaderEncodeGame(pyhanabi_game_log_reader_t* reader, int game,
+                            pyhanabi_observation_encoder_t* encoder,
+                            uint8_t* observations, int* move_uids) {
+  HANABI_INSTRUMENT(hanabi_learning_env::kCounterCApi);
+  REQUIRE(reader != nullptr);
+  REQUIRE(reader->reader != nullptr);
+  REQUIRE(encoder != nullptr);
+  REQUIRE(encoder->encoder != nullptr);
+  auto observation_encoder =
+      reinterpret_cast<hanabi_learning_env::ObservationEncoder*>(
+          encoder->encoder);
+  REQUIRE(observation_encoder->type() ==
+          hanabi_learning_env::ObservationEncoder::Type::kCanonical);
+  auto canonical_encoder =
+      static_cast<hanabi_learning_env::CanonicalObservationEncoder*>(
+          observation_encoder);
+  return reinterpret_cast<hanabi_learning_env::HanabiGameLogReader*>(
+             reader->reader)
+      ->EncodeGame(game, *canonical_encoder, observations, move_uids);
+}
+
+void NewReplayBuffer(pyhanabi_replay_buffer_t* buffer,
+                     const pyhanabi_replay_buffer_config_t* config) {
+  HANABI_INSTRUMENT(hanabi_learning_env::kCounterCApi);
+  REQUIRE(buffer != nullptr);
+  REQUIRE(config != nullptr);
+  hanabi_learning_env::ReplayBufferConfig buffer_config;
+  buffer_config.observation_bits = config->observation_bits;
+  buffer_config.num_moves = config->num_moves;
+  buffer_config.capacity = config->capacity;
+  buffer_config.stack_size = config->stack_size;
+  buffer_config.update_horizon = config->update_horizon;
+  buffer_config.gamma = config->gamma;
+  buffer_config.prioritized = config->prioritized != 0;
+  buffer_config.seed = config->seed;
+  buffer->buffer = new hanabi_learning_env::ReplayBuffer(buffer_config);
+}
+
+void DeleteReplayBuffer(pyhanabi_replay_buffer_t* buffer) {
+  HANABI_INSTRUMENT(hanabi_learning_env::kCounterCApi);
+  REQUIRE(buffer != nullptr);
+  REQUIRE(buffer->buffer != nullptr);
+  delete reinterpret_cast<hanabi_learning_env::ReplayBuffer*>(buffer->buffer);
+  buffer->buffer = nullptr;
+}
+
+int ReplayBufferPackedObservationLength(pyhanabi_replay_buffer_t* buffer) {
+  HANABI_INSTRUMENT(hanabi_learning_env::kCounterCApi);
+  REQUIRE(buffer != nullptr);
+  REQUIRE(buffer->buffer != nullptr);
+  return reinterpret_cast<hanabi_learning_env::ReplayBuffer*>(buffer->buffer)
+      ->PackedObservationLength();
+}
+
+int64_t ReplayBufferAddCount(pyhanabi_replay_buffer_t* buffer) {
+  HANABI_INSTRUMENT(hanabi_learning_env::kCounterCApi);
+  REQUIRE(buffer != nullptr);
+  REQUIRE(buffer->buffer != nullptr);
+  return reinterpret_cast<hanabi_learning_env::ReplayBuffer*>(buffer->buffer)
+      ->AddCount();
+}
+
+int ReplayBufferSize(pyhanabi_replay_buffer_t* buffer) {
+  HANABI_INSTRUMENT(hanabi_learning_env::kCounterCApi);
+  REQUIRE(buffer != nullptr);
+  REQUIRE(buffer->buffer != nullptr);
+  return reinterpret_cast<hanabi_learning_env::ReplayBuffer*>(buffer->buffer)
+      ->Size();
+}
+
+void ReplayBufferAdd(pyhanabi_replay_buffer_t* buffer,
+                     const uint8_t* observation,
+                     const uint64_t* packed_observation, int action,
+                     float reward, int terminal, const uint8_t* legal_moves) {
+  HANABI_INSTRUMENT(hanabi_learning_env::kCounterCApi);
+  REQUIRE(buffer != nullptr);
+  REQUIRE(buffer->buffer != nullptr);
+  REQUIRE((observation == nullptr) != (packed_observation == nullptr));
+  REQUIRE(legal_moves != nullptr);
+  auto replay_buffer =
+      reinterpret_cast<hanabi_learning_env::ReplayBuffer*>(buffer->buffer);
+  uint64_t legal_move_mask = 0;
+  for (int uid = 0; uid < replay_buffer->Config().num_moves; ++uid) {
+    if (legal_moves[uid]) {
+      legal_move_mask |= uint64_t{1} << uid;
+    }
+  }
+  if (observation != nullptr) {
+    replay_buffer->Add(observation, action, reward, terminal != 0,
+                       legal_move_mask);
+  } else {
+    replay_buffer->Add(packed_observation, action, reward, terminal != 0,
+                       legal_move_mask);
+  }
+}
+
+int ReplayBufferSample(pyhanabi_replay_buffer_t* buffer, int batch_size,
+                       int* indices) {
+  HANABI_INSTRUMENT(hanabi_learning_env::kCounterCApi);
+  REQUIRE(buffer != nullptr);
+  REQUIRE(buffer->buffer != nullptr);
+  return reinterpret_cast<hanabi_learning_env::ReplayBuffer*>(buffer->buffer)
+      ->Sample(batch_size, indices);
+}
+
+int ReplayBufferIsSampleable(pyhanabi_replay_buffer_t* buffer, int index) {
+  HANABI_INSTRUMENT(hanabi_learning_env::kCounterCApi);
+  REQUIRE(buffer != nullptr);
+  REQUIRE(buffer->buffer != nullptr);
+  return reinterpret_cast<hanabi_learning_env::ReplayBuffer*>(buffer->buffer)
+      ->IsSampleable(index);
+}
+
+void ReplayBufferGetTransitions(pyhanabi_replay_buffer_t* buffer,
+                                int batch_size, const int* indices,
+                                uint8_t* states, uint64_t* packed_states,
+                                int* actions, float* rewards,
+                                uint8_t* next_states,
+                                uint64_t* packed_next_states,
+                                uint8_t* terminals,
+                                uint8_t* next_legal_moves) {
+  HANABI_INSTRUMENT(hanabi_learning_env::kCounterCApi);
+  REQUIRE(buffer != nullptr);
+  REQUIRE(buffer->buffer != nullptr);
+  hanabi_learning_env::ReplayBatch batch;
+  batch.states = states;
+  batch.packed_states = packed_states;
+  batch.actions = actions;
+  batch.rewards = rewards;
+  batch.next_states = next_states;
+  batch.packed_next_states = packed_next_states;
+  batch.terminals = terminals;
+  batch.next_legal_moves = next_legal_moves;
+  reinterpret_cast<hanabi_learning_env::ReplayBuffer*>(buffer->buffer)
+      ->GetTransitions(batch_size, indices, batch);
+}
+
+void ReplayBufferSetPriorities(pyhanabi_replay_buffer_t* buffer, int count,
+                               const int* indices, const float* priorities) {
+  HANABI_INSTRUMENT(hanabi_learning_env::kCounterCApi);
+  REQUIRE(buffer != nullptr);
+  REQUIRE(buffer->buffer != nullptr);
+  reinterpret_cast<hanabi_learning_env::ReplayBuffer*>(buffer->buffer)
+      ->SetPriorities(count, indices, priorities);
+}
+
+void ReplayBufferGetPriorities(pyhanabi_replay_buffer_t* buffer, int count,
+                               const int* indices, float* priorities) {
+  HANABI_INSTRUMENT(hanabi_learning_env::kCounterCApi);
+  REQUIRE(buffer != nullptr);
+  REQUIRE(buffer->buffer != nullptr);
+  reinterpret_cast<hanabi_learning_env::ReplayBuffer*>(buffer->buffer)
+      ->GetPriorities(count, indices, priorities);
+}
+
+/* Env server functions. */
+void NewEnvServer(pyhanabi_env_server_t* server, pyhanabi_game_t* game,
+                  const pyhanabi_env_server_config_t* config) {
+  HANABI_INSTRUMENT(hanabi_learning_env::kCounterCApi);
+  REQUIRE(server != nullptr);
+  REQUIRE(game != nullptr);
+  REQUIRE(game->game != nullptr);
+  REQUIRE(config != nullptr);
+  REQUIRE(config->name != nullptr);
+  hanabi_learning_env::HanabiEnvServerConfig server_config;
+  server_config.name = config->name;
+  server_config.num_shards = config->num_shards;
+  server_config.envs_per_shard = config->envs_per_shard;
+  server_config.threads_per_shard = config->threads_per_shard;
+  server_config.packed_observations = config->packed_observations != 0;
+  server_config.ring_capacity = config->ring_capacity;
+  server->server = new hanabi_learning_env::HanabiEnvServer(
+      reinterpret_cast<hanabi_learning_env::HanabiGame*>(game->game),
+      server_config);
+}
+
+void DeleteEnvServer(pyhanabi_env_server_t* server) {
+  HANABI_INSTRUMENT(hanabi_learning_env::kCounterCApi);
+  REQUIRE(server != nullptr);
+  REQUIRE(server->server != nullptr);
+  delete reinterpret_cast<hanabi_learning_env::HanabiEnvServer*>(
+      server->server);
+  server->server = nullptr;
+}
+
+int64_t EnvServerSize(pyhanabi_env_server_t* server) {
+  HANABI_INSTRUMENT(hanabi_learning_env::kCounterCApi);
+  REQUIRE(server != nullptr);
+  REQUIRE(server->server != nullptr);
+  return reinterpret_cast<hanabi_learning_env::HanabiEnvServer*>(
+             server->server)
+      ->Size();
+}
+
+void NewEnvClient(pyhanabi_env_client_t* client) {
+  HANABI_INSTRUMENT(hanabi_learning_env::kCounterCApi);
+  REQUIRE(client != nullptr);
+  client->client = new hanabi_learning_env::HanabiEnvClient();
+}
+
+void DeleteEnvClient(pyhanabi_env_client_t* client) {
+  HANABI_INSTRUMENT(hanabi_learning_env::kCounterCApi);
+  REQUIRE(client != nullptr);
+  REQUIRE(client->client != nullptr);
+  delete reinterpret_cast<hanabi_learning_env::HanabiEnvClient*>(
+      client->client);
+  client->client = nullptr;
+}
+
+int EnvClientConnect(pyhanabi_env_client_t* client, const char* name,
+                     int shard) {
+  HANABI_INSTRUMENT(hanabi_learning_env::kCounterCApi);
+  REQUIRE(client != nullptr);
+  REQUIRE(client->client != nullptr);
+  REQUIRE(name != nullptr);
+  return reinterpret_cast<hanabi_learning_env::HanabiEnvClient*>(
+             client->client)
+      ->Connect(name, shard);
+}
+
+void EnvClientDisconnect(pyhanabi_env_client_t* client) {
+  HANABI_INSTRUMENT(hanabi_learning_env::kCounterCApi);
+  REQUIRE(client != nullptr);
+  REQUIRE(client->client != nullptr);
+  reinterpret_cast<hanabi_learning_env::HanabiEnvClient*>(client->client)
+      ->Disconnect();
+}
+
+int EnvClientConnected(pyhanabi_env_client_t* client) {
+  HANABI_INSTRUMENT(hanabi_learning_env::kCounterCApi);
+  REQUIRE(client != nullptr);
+  REQUIRE(client->client != nullptr);
+  return reinterpret_cast<hanabi_learning_env::HanabiEnvClient*>(
+             client->client)
+      ->Connected();
+}
+
+int EnvClientShard(pyhanabi_env_client_t* client) {
+  HANABI_INSTRUMENT(hanabi_learning_env::kCounterCApi);
+  REQUIRE(client != nullptr);
+  REQUIRE(client->client != nullptr);
+  return reinterpret_cast<hanabi_learning_env::HanabiEnvClient*>(
+             client->client)
+      ->Shard();
+}
+
+int EnvClientNumEnvs(pyhanabi_env_client_t* client) {
+  HANABI_INSTRUMENT(hanabi_learning_env::kCounterCApi);
+  REQUIRE(client != nullptr);
+  REQUIRE(client->client != nullptr);
+  return reinterpret_cast<hanabi_learning_env::HanabiEnvClient*>(
+             client->client)
+      ->NumEnvs();
+}
+
+int EnvClientObservationLength(pyhanabi_env_client_t* client) {
+  HANABI_INSTRUMENT(hanabi_learning_env::kCounterCApi);
+  REQUIRE(client != nullptr);
+  REQUIRE(client->client != nullptr);
+  return reinterpret_cast<hanabi_learning_env::HanabiEnvClient*>(
+             client->client)
+      ->ObservationLength();
+}
+
+int EnvClientPackedObservationLength(pyhanabi_env_client_t* client) {
+  HANABI_INSTRUMENT(hanabi_learning_env::kCounterCApi);
+  REQUIRE(client != nullptr);
+  REQUIRE(client->client != nullptr);
+  return reinterpret_cast<hanabi_learning_env::HanabiEnvClient*>(
+             client->client)
+      ->PackedObservationLength();
+}
+
+int EnvClientNumMoves(pyhanabi_env_client_t* client) {
+  HANABI_INSTRUMENT(hanabi_learning_env::kCounterCApi);
+  REQUIRE(client != nullptr);
+  REQUIRE(client->client != nullptr);
+  return reinterpret_cast<hanabi_learning_env::HanabiEnvClient*>(
+             client->client)
+      ->NumMoves();
+}
+
+char* EnvClientParameters(pyhanabi_env_client_t* client) {
+  HANABI_INSTRUMENT(hanabi_learning_env::kCounterCApi);
+  REQUIRE(client != nullptr);
+  REQUIRE(client->client != nullptr);
+  std::string str;
+  for (const auto& param :
+       reinterpret_cast<hanabi_learning_env::HanabiEnvClient*>(client->client)
+           ->Parameters()) {
+    str += param.first + "=" + param.second + "\n";
+  }
+  return strdup(str.c_str());
+}
+
+int EnvClientReset(pyhanabi_env_client_t* client) {
+  HANABI_INSTRUMENT(hanabi_learning_env::kCounterCApi);
+  REQUIRE(client != nullptr);
+  REQUIRE(client->client != nullptr);
+  return reinterpret_cast<hanabi_learning_env::HanabiEnvClient*>(
+             client->client)
+      ->Reset();
+}
+
+int EnvClientStep(pyhanabi_env_client_t* client, const int* move_uids) {
+  HANABI_INSTRUMENT(hanabi_learning_env::kCounterCApi);
+  REQUIRE(client != nullptr);
+  REQUIRE(client->client != nullptr);
+  REQUIRE(move_uids != nullptr);
+  return reinterpret_cast<hanabi_learning_env::HanabiEnvClient*>(
+             client->client)
+      ->Step(move_uids);
+}
+
+const uint8_t* EnvClientObservations(pyhanabi_env_client_t* client) {
+  HANABI_INSTRUMENT(hanabi_learning_env::kCounterCApi);
+  REQUIRE(client != nullptr);
+  REQUIRE(client->client != nullptr);
+  return reinterpret_cast<hanabi_learning_env::HanabiEnvClient*>(
+             client->client)
+      ->Observations();
+}
+
+const uint64_t* EnvClientPackedObservations(pyhanabi_env_client_t* client) {
+  HANABI_INSTRUMENT(hanabi_learning_env::kCounterCApi);
+  REQUIRE(client != nullptr);
+  REQUIRE(client->client != nullptr);
+  return reinterpret_cast<hanabi_learning_env::HanabiEnvClient*>(
+             client->client)
+      ->PackedObservations();
+}
+
+const uint8_t* EnvClientLegalMoves(pyhanabi_env_client_t* client) {
+  HANABI_INSTRUMENT(hanabi_learning_env::kCounterCApi);
+  REQUIRE(client != nullptr);
+  REQUIRE(client->client != nullptr);
+  return reinterpret_cast<hanabi_learning_env::HanabiEnvClient*>(
+             client->client)
+      ->LegalMoves();
+}
+
+const float* EnvClientRewards(pyhanabi_env_client_t* client) {
+  HANABI_INSTRUMENT(hanabi_learning_env::kCounterCApi);
+  REQUIRE(client != nullptr);
+  REQUIRE(client->client != nullptr);
+  return reinterpret_cast<hanabi_learning_env::HanabiEnvClient*>(
+             client->client)
+      ->Rewards();
+}
+
+const uint8_t* EnvClientDones(pyhanabi_env_client_t* client) {
+  HANABI_INSTRUMENT(hanabi_learning_env::kCounterCApi);
+  REQUIRE(client != nullptr);
+  REQUIRE(client->client != nullptr);
+  return reinterpret_cast<hanabi_learning_env::HanabiEnvClient*>(
+             client->client)
+      ->Dones();
+}
+
+const int* EnvClientCurrentPlayers(pyhanabi_env_client_t* client) {
+  HANABI_INSTRUMENT(hanabi_learning_env::kCounterCApi);
+  REQUIRE(client != nullptr);
+  REQUIRE(client->client != nullptr);
+  return reinterpret_cast<hanabi_learning_env::HanabiEnvClient*>(
+             client->client)
+      ->CurrentPlayers();
+}
+
+/* Instrumentation functions. */
+int InstrumentationIsCompiled() {
+  return hanabi_learning_env::kInstrumentationCompiled;
+}
+
+void InstrumentationSetEnabled(int enabled) {
+  hanabi_learning_env::SetInstrumentationEnabled(enabled != 0);
+}
+
+int InstrumentationIsEnabled() {
+  return hanabi_learning_env::InstrumentationEnabled();
+}
+
+int InstrumentationNumCounters() {
+  return hanabi_learning_env::kNumInstrumentationCounters;
+}
+
+const char* InstrumentationCounterName(int counter) {
+  REQUIRE(counter >= 0 &&
+          counter < hanabi_learning_env::kNumInstrumentationCounters);
+  return hanabi_learning_env::InstrumentationCounterName(
+      static_cast<hanabi_learning_env::InstrumentationCounter>(counter));
+}
+
+void InstrumentationRead(int64_t* counts, int64_t* nanoseconds, int reset) {
+  REQUIRE(counts != nullptr);
+  REQUIRE(nanoseconds != nullptr);
+  hanabi_learning_env::InstrumentationValue
+      values[hanabi_learning_env::kNumInstrumentationCounters];
+  hanabi_learning_env::ReadInstrumentation(reset != 0, values);
+  for (int i = 0; i < hanabi_learning_env::kNumInstrumentationCounters; ++i) {
+    counts[i] = values[i].count;
+    nanoseconds[i] = values[i].nanoseconds;
+  }
+}
+
+void InstrumentationReset() { hanabi_learning_env::ResetInstrumentation(); }
+
 } /* extern "C" */
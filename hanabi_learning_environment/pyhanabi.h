@@ -21,6 +21,8 @@
  * The set of functions below is referred to as the 'cdef' throughout the code.
  */
 
+#include <stdint.h>
+
 extern "C" {
 
 typedef struct PyHanabiCard {
@@ -58,11 +60,168 @@ typedef struct PyHanabiObservation {
   void* observation;
 } pyhanabi_observation_t;
 
+/* A hanabi_learning_env::HanabiHistoryItem with its move inlined, as in
+ * pyhanabi_observation_data_t. */
+typedef struct PyHanabiHistoryData {
+  int move_type;
+  int move_card_index;
+  int move_target_offset;
+  int move_color;
+  int move_rank;
+  int player;
+  int scored;
+  int information_token;
+  int color;
+  int rank;
+  int reveal_bitmask;
+  int newly_revealed_bitmask;
+  int deal_to_player;
+} pyhanabi_history_data_t;
+
+/* Fixed-layout copy of a HanabiObservation, filled by one ObsExportData
+ * call. Hands are indexed by player offset from the observer, then by card
+ * index, and the observer's own cards have color and rank -1. Array bounds
+ * are kMaxPlayers, kMaxHandSize, kMaxNumColors, kMaxDeckSize and kMaxMoves
+ * of hanabi_lib/util.h; only the leading num_* entries are set. */
+typedef struct PyHanabiObservationData {
+  int cur_player_offset;
+  int num_players;
+  int num_colors;
+  int life_tokens;
+  int information_tokens;
+  int deck_size;
+  int fireworks[5];
+  int hand_sizes[5];
+  pyhanabi_card_t hands[5][8];
+  /* Hinted color and rank of each card, -1 if not hinted. */
+  int hinted_colors[5][8];
+  int hinted_ranks[5][8];
+  /* Bit c (r) is set if color c (rank r) is still plausible for the card. */
+  int color_plausible_masks[5][8];
+  int rank_plausible_masks[5][8];
+  int num_discards;
+  pyhanabi_card_t discard_pile[50];
+  /* Most recent first, as ObsGetLastMove. At most one player move and one
+   * deal per player. */
+  int num_last_moves;
+  pyhanabi_history_data_t last_moves[10];
+  uint64_t legal_move_mask;
+  /* Legal move uids in increasing order. */
+  int num_legal_moves;
+  int legal_move_uids[56];
+} pyhanabi_observation_data_t;
+
 typedef struct PyHanabiObservationEncoder {
   /* Points to a hanabi_learning_env::ObservationEncoder. */
   void* encoder;
 } pyhanabi_observation_encoder_t;
 
+typedef struct PyHanabiVectorEnv {
+  /* Points to a hanabi_learning_env::HanabiVectorEnv. */
+  void* env;
+} pyhanabi_vector_env_t;
+
+typedef struct PyHanabiDeterminizationPool {
+  /* Points to a hanabi_learning_env::HanabiDeterminizationPool. */
+  void* pool;
+} pyhanabi_determinization_pool_t;
+
+typedef struct PyHanabiPolicy {
+  /* Points to a hanabi_learning_env::HanabiPolicy. */
+  void* policy;
+} pyhanabi_policy_t;
+
+/* As hanabi_learning_env::HanabiPlayoutResult. */
+typedef struct PyHanabiPlayoutResult {
+  int score;
+  int end_of_game;
+  int num_moves;
+  int num_plays;
+  int num_misplays;
+  int num_discards;
+  int num_hints;
+} pyhanabi_playout_result_t;
+
+/* As hanabi_learning_env::HanabiEvaluation. score_counts has room for every
+ * possible score (at most 5 colors * 5 ranks). */
+typedef struct PyHanabiEvaluation {
+  int num_games;
+  double mean_score;
+  double score_stddev;
+  double mean_moves;
+  double mean_plays;
+  double mean_misplays;
+  double mean_discards;
+  double mean_hints;
+  int64_t score_counts[26];
+  int64_t num_out_of_life_tokens;
+  int64_t num_out_of_cards;
+  int64_t num_completed_fireworks;
+} pyhanabi_evaluation_t;
+
+typedef struct PyHanabiSearch {
+  /* Points to a hanabi_learning_env::HanabiSearch. */
+  void* search;
+} pyhanabi_search_t;
+
+typedef struct PyHanabiGameLogWriter {
+  /* Points to a hanabi_learning_env::HanabiGameLogWriter. */
+  void* writer;
+} pyhanabi_game_log_writer_t;
+
+typedef struct PyHanabiGameLogReader {
+  /* Points to a hanabi_learning_env::HanabiGameLogReader. */
+  void* reader;
+} pyhanabi_game_log_reader_t;
+
+typedef struct PyHanabiReplayBuffer {
+  /* Points to a hanabi_learning_env::ReplayBuffer. */
+  void* buffer;
+} pyhanabi_replay_buffer_t;
+
+/* As hanabi_learning_env::ReplayBufferConfig. */
+typedef struct PyHanabiReplayBufferConfig {
+  int observation_bits;
+  int num_moves;
+  int capacity;
+  int stack_size;
+  int update_horizon;
+  float gamma;
+  int prioritized;
+  int seed;
+} pyhanabi_replay_buffer_config_t;
+
+typedef struct PyHanabiEnvServer {
+  /* Points to a hanabi_learning_env::HanabiEnvServer. */
+  void* server;
+} pyhanabi_env_server_t;
+
+typedef struct PyHanabiEnvClient {
+  /* Points to a hanabi_learning_env::HanabiEnvClient. */
+  void* client;
+} pyhanabi_env_client_t;
+
+/* As hanabi_learning_env::HanabiEnvServerConfig. */
+typedef struct PyHanabiEnvServerConfig {
+  const char* name;
+  int num_shards;
+  int envs_per_shard;
+  int threads_per_shard;
+  int packed_observations;
+  int ring_capacity;
+} pyhanabi_env_server_config_t;
+
+/* As hanabi_learning_env::HanabiSearchConfig. */
+typedef struct PyHanabiSearchConfig {
+  int num_iterations;
+  double time_limit;
+  double exploration;
+  int num_threads;
+  int score_lost_games;
+  int seed;
+  int transposition_table_size;
+} pyhanabi_search_config_t;
+
 /* Utility Functions. */
 void DeleteString(char* str);
 
@@ -79,6 +238,8 @@ int KnownRank(pyhanabi_card_knowledge_t* knowledge);
 int RankIsPlausible(pyhanabi_card_knowledge_t* knowledge, int rank);
 
 /* Move functions. */
+/* Allocates an empty move list, to be refilled with StateLegalMovesInto. */
+void* NewMoveList(void);
 void DeleteMoveList(void* movelist);
 int NumMoves(void* movelist);
 void GetMove(void* movelist, int index, pyhanabi_move_t* move);
@@ -115,6 +276,7 @@ void StateParentGame(pyhanabi_state_t* state, pyhanabi_game_t*dest_game);
 void StateApplyMove(pyhanabi_state_t* state, pyhanabi_move_t* move);
 int StateCurPlayer(pyhanabi_state_t* state);
 void StateDealRandomCard(pyhanabi_state_t* state);
+void StateDealInitialHands(pyhanabi_state_t* state);
 int StateDeckSize(pyhanabi_state_t* state);
 int StateFireworks(pyhanabi_state_t* state, int color);
 int StateDiscardPileSize(pyhanabi_state_t* state);
@@ -125,7 +287,17 @@ void StateGetHandCard(pyhanabi_state_t* state, int pid, int index,
 int StateEndOfGameStatus(pyhanabi_state_t* state);
 int StateInformationTokens(pyhanabi_state_t* state);
 void* StateLegalMoves(pyhanabi_state_t* state);
+/* Replaces the content of movelist by the legal moves of state, reusing the
+ * list's storage. */
+void StateLegalMovesInto(pyhanabi_state_t* state, void* movelist);
+/* Bit uid is set if move uid is legal for player. */
+uint64_t StateLegalMoveMask(pyhanabi_state_t* state, int player);
 int StateLifeTokens(pyhanabi_state_t* state);
+/* 64-bit hash of the full state, never 0. */
+uint64_t StateHash(pyhanabi_state_t* state);
+/* 64-bit hash of what player observes, equal for states the player cannot
+ * tell apart; never 0. */
+uint64_t StateObserverHash(pyhanabi_state_t* state, int player);
 int StateNumPlayers(pyhanabi_state_t* state);
 int StateScore(pyhanabi_state_t* state);
 char* StateToString(pyhanabi_state_t* state);
@@ -156,6 +328,10 @@ int MaxMoves(pyhanabi_game_t* game);
 /* Observation functions. */
 void NewObservation(pyhanabi_state_t* state, int player,
                     pyhanabi_observation_t* observation);
+/* Rebuilds an existing observation in place as player's view of state,
+ * without allocating a new observation object. */
+void ObservationUpdate(pyhanabi_observation_t* observation,
+                       pyhanabi_state_t* state, int player);
 void DeleteObservation(pyhanabi_observation_t* observation);
 char* ObsToString(pyhanabi_observation_t* observation);
 int ObsCurPlayerOffset(pyhanabi_observation_t* observation);
@@ -176,18 +352,100 @@ void ObsGetLastMove(pyhanabi_observation_t* observation, int index,
 int ObsInformationTokens(pyhanabi_observation_t* observation);
 int ObsLifeTokens(pyhanabi_observation_t* observation);
 int ObsNumLegalMoves(pyhanabi_observation_t* observation);
+uint64_t ObsLegalMoveMask(pyhanabi_observation_t* observation);
 void ObsGetLegalMove(pyhanabi_observation_t* observation, int index,
                      pyhanabi_move_t* move);
+/* Copies all of observation into data in one call. */
+void ObsExportData(pyhanabi_observation_t* observation,
+                   pyhanabi_observation_data_t* data);
 bool ObsCardPlayableOnFireworks(const pyhanabi_observation_t* observation,
                                 int color, int rank);
 
 /* ObservationEncoder functions. */
 void NewObservationEncoder(pyhanabi_observation_encoder_t* encoder,
                            pyhanabi_game_t* game, int type);
+/* A belief encoder (type 1) refined by iterations rounds of cross-card
+ * consistency; type 1 through NewObservationEncoder uses none. */
+void NewBeliefObservationEncoder(pyhanabi_observation_encoder_t* encoder,
+                                 pyhanabi_game_t* game, int iterations);
 void DeleteObservationEncoder(pyhanabi_observation_encoder_t* encoder);
 char* ObservationShape(pyhanabi_observation_encoder_t* encoder);
 char* EncodeObservation(pyhanabi_observation_encoder_t* encoder,
                         pyhanabi_observation_t* observation);
+int ObservationLength(pyhanabi_observation_encoder_t* encoder);
+/* Write the encoding into a caller-owned buffer of at least size elements. */
+void EncodeObservationUint8(pyhanabi_observation_encoder_t* encoder,
+                            pyhanabi_observation_t* observation,
+                            uint8_t* buffer, int size);
+void EncodeObservationFloat(pyhanabi_observation_encoder_t* encoder,
+                            pyhanabi_observation_t* observation,
+                            float* buffer, int size);
+/* Encode player's observation of state without building an observation. */
+void EncodeStateUint8(pyhanabi_observation_encoder_t* encoder,
+                      pyhanabi_state_t* state, int player, uint8_t* buffer,
+                      int size);
+void EncodeStateFloat(pyhanabi_observation_encoder_t* encoder,
+                      pyhanabi_state_t* state, int player, float* buffer,
+                      int size);
+
+/* Encode players[i]'s observation of states[i] into row i of a
+ * [num_states, ObservationLength] buffer of at least size elements. */
+void EncodeStatesUint8(pyhanabi_observation_encoder_t* encoder,
+                       pyhanabi_state_t** states, const int* players,
+                       int num_states, uint8_t* buffer, int size);
+void EncodeStatesFloat(pyhanabi_observation_encoder_t* encoder,
+                       pyhanabi_state_t** states, const int* players,
+                       int num_states, float* buffer, int size);
+/* Packed encodings hold bit i in bit i % 64 of word i / 64, with
+ * ObservationPackedLength words per observation. */
+int ObservationPackedLength(pyhanabi_observation_encoder_t* encoder);
+void EncodeObservationPacked(pyhanabi_observation_encoder_t* encoder,
+                             pyhanabi_observation_t* observation,
+                             uint64_t* buffer, int size);
+void EncodeStatePacked(pyhanabi_observation_encoder_t* encoder,
+                       pyhanabi_state_t* state, int player, uint64_t* buffer,
+                       int size);
+/* Unpack num_rows packed encodings of num_bits bits each, stored one after
+ * the other, into a [num_rows, num_bits] buffer. */
+void UnpackObservationsUint8(const uint64_t* packed, int num_rows,
+                             int num_bits, uint8_t* buffer);
+void UnpackObservationsFloat(const uint64_t* packed, int num_rows,
+                             int num_bits, float* buffer);
+
+/* VectorEnv functions.
+ * Output arrays hold one row per game and may be NULL to skip that output:
+ * observations [num_envs, VectorEnvObservationLength], packed_observations
+ * [num_envs, VectorEnvPackedObservationLength], legal_moves
+ * [num_envs, VectorEnvNumMoves], rewards, dones and current_players
+ * [num_envs]. */
+/* num_threads <= 0 uses all hardware threads. */
+void NewVectorEnv(pyhanabi_vector_env_t* env, pyhanabi_game_t* game,
+                  int num_envs, int num_threads);
+void DeleteVectorEnv(pyhanabi_vector_env_t* env);
+int VectorEnvNumEnvs(pyhanabi_vector_env_t* env);
+int VectorEnvNumThreads(pyhanabi_vector_env_t* env);
+int VectorEnvObservationLength(pyhanabi_vector_env_t* env);
+int VectorEnvPackedObservationLength(pyhanabi_vector_env_t* env);
+int VectorEnvNumMoves(pyhanabi_vector_env_t* env);
+void VectorEnvGetState(pyhanabi_vector_env_t* env, int index,
+                       pyhanabi_state_t* state);
+void VectorEnvReset(pyhanabi_vector_env_t* env, uint8_t* observations,
+                    uint64_t* packed_observations, uint8_t* legal_moves,
+                    float* rewards, uint8_t* dones, int* current_players);
+/* Returns 0, stepping no game, if any move is not legal, else 1. */
+int VectorEnvStep(pyhanabi_vector_env_t* env, const int* move_uids,
+                  uint8_t* observations, uint64_t* packed_observations,
+                  uint8_t* legal_moves, float* rewards, uint8_t* dones,
+                  int* current_players);
+/* As VectorEnvStep, on a background thread; returns at once, with 0 and
+ * no step started if any move is not legal. The outputs must stay valid
+ * and unread until VectorEnvStepWait returns, which blocks until the step
+ * has finished. */
+int VectorEnvStepAsync(pyhanabi_vector_env_t* env, const int* move_uids,
+                       uint8_t* observations, uint64_t* packed_observations,
+                       uint8_t* legal_moves, float* rewards, uint8_t* dones,
+                       int* current_players);
+void VectorEnvStepWait(pyhanabi_vector_env_t* env);
 
 /* Manual state setters */
 void StateSetLifeTokens(pyhanabi_state_t* state, int tokens);
@@ -199,6 +457,174 @@ void StateSetDeck(pyhanabi_state_t* state, const pyhanabi_card_t* cards, int cou
 void StateSetCurPlayer(pyhanabi_state_t* state, int player);
 void StateSetHandCard(pyhanabi_state_t* state, int player, int card_index, const pyhanabi_card_t* card);
 
+/* Determinization functions.
+ * A determinization replaces the observer's hand by cards consistent with the
+ * observer's knowledge and the cards it cannot see. */
+/* Allocates a new state, sampled with the parent game's generator. */
+void StateSampleDeterminization(pyhanabi_state_t* state, int observer,
+                                pyhanabi_state_t* determinization);
+void NewDeterminizationPool(pyhanabi_determinization_pool_t* pool, int size,
+                            int seed);
+void DeleteDeterminizationPool(pyhanabi_determinization_pool_t* pool);
+int DeterminizationPoolSize(pyhanabi_determinization_pool_t* pool);
+void DeterminizationPoolSample(pyhanabi_determinization_pool_t* pool,
+                               pyhanabi_state_t* state, int observer);
+/* Allocates a copy of determinization index of the last sample. */
+void DeterminizationPoolGetState(pyhanabi_determinization_pool_t* pool,
+                                 int index, pyhanabi_state_t* state);
+
+/* Policy and playout functions. */
+/* type is a hanabi_learning_env::HanabiPolicy::Type. */
+void NewPolicy(pyhanabi_policy_t* policy, int type);
+void DeletePolicy(pyhanabi_policy_t* policy);
+/* Allocates the move chosen for the current player, sampling with the
+ * state's parent game generator. */
+void PolicyAct(pyhanabi_policy_t* policy, pyhanabi_state_t* state,
+               pyhanabi_move_t* move);
+/* Plays state to the end in place. seed -1 draws a random seed. */
+void PolicyPlayout(pyhanabi_policy_t* policy, pyhanabi_state_t* state,
+                   int seed, pyhanabi_playout_result_t* result);
+/* num_threads <= 0 uses all hardware threads. */
+void PolicyEvaluate(pyhanabi_policy_t* policy, pyhanabi_game_t* game,
+                    int num_games, int num_threads,
+                    pyhanabi_evaluation_t* evaluation);
+
+/* Expectimax functions.
+ * As hanabi_learning_env::ExpectedValue and ExpectedMoveValues. policy may
+ * be NULL to maximize the expected score over moves. move_values has
+ * MaxMoves entries, -1 for illegal moves. */
+double StateExpectedValue(pyhanabi_state_t* state, int depth,
+                          pyhanabi_policy_t* policy, int num_threads);
+void StateExpectedMoveValues(pyhanabi_state_t* state, int depth,
+                             pyhanabi_policy_t* policy, int num_threads,
+                             double* move_values);
+
+/* Search functions. */
+/* rollout_policy must outlive the search. */
+void NewSearch(pyhanabi_search_t* search,
+               const pyhanabi_search_config_t* config,
+               pyhanabi_policy_t* rollout_policy);
+void DeleteSearch(pyhanabi_search_t* search);
+/* Allocates the move chosen for the current player of state, or for the
+ * observing player of observation, who must be the current player. Unless
+ * null, visit_counts and values receive the root statistics per move uid,
+ * and have room for MaxMoves() entries. Returns the number of iterations. */
+int SearchState(pyhanabi_search_t* search, pyhanabi_state_t* state,
+                pyhanabi_move_t* move, int* visit_counts, double* values);
+int SearchObservation(pyhanabi_search_t* search,
+                      pyhanabi_observation_t* observation,
+                      pyhanabi_move_t* move, int* visit_counts,
+                      double* values);
+
+/* Game log functions. */
+/* Creates or truncates the log at path. game must outlive the writer. */
+void NewGameLogWriter(pyhanabi_game_log_writer_t* writer, const char* path,
+                      pyhanabi_game_t* game);
+/* Closes the log. */
+void DeleteGameLogWriter(pyhanabi_game_log_writer_t* writer);
+/* Appends the game of state, which must have recorded its move history. */
+void GameLogWriterWriteGame(pyhanabi_game_log_writer_t* writer,
+                            pyhanabi_state_t* state, uint64_t seed);
+int64_t GameLogWriterNumGames(pyhanabi_game_log_writer_t* writer);
+void GameLogWriterFlush(pyhanabi_game_log_writer_t* writer);
+void NewGameLogReader(pyhanabi_game_log_reader_t* reader, const char* path);
+void DeleteGameLogReader(pyhanabi_game_log_reader_t* reader);
+/* The log's game parameters, as "key=value" lines. */
+char* GameLogReaderParameters(pyhanabi_game_log_reader_t* reader);
+int GameLogReaderNumGames(pyhanabi_game_log_reader_t* reader);
+uint64_t GameLogReaderSeed(pyhanabi_game_log_reader_t* reader, int game);
+int GameLogReaderNumMoves(pyhanabi_game_log_reader_t* reader, int game);
+int GameLogReaderNumPlayerMoves(pyhanabi_game_log_reader_t* reader,
+                                int game);
+/* Sets state, of a game with the log's parameters, to game after its first
+ * num_moves moves. */
+void GameLogReaderReplay(pyhanabi_game_log_reader_t* reader, int game,
+                         int num_moves, pyhanabi_state_t* state);
+/* Writes the canonical encoding of the acting player's observation before
+ * each player move of game, [NumPlayerMoves, encoder size], and the move
+ * uids, [NumPlayerMoves]. Either may be null. Returns NumPlayerMoves. */
+int GameLogReaderEncodeGame(pyhanabi_game_log_reader_t* reader, int game,
+                            pyhanabi_observation_encoder_t* encoder,
+                            uint8_t* observations, int* move_uids);
+
+/* Replay buffer functions.
+ * States are [batch, observation_bits, stack_size] and packed states
+ * [batch, stack_size, ReplayBufferPackedObservationLength]; legal move masks
+ * are [num_moves], 1 for legal uids. Output arrays may be NULL. */
+void NewReplayBuffer(pyhanabi_replay_buffer_t* buffer,
+                     const pyhanabi_replay_buffer_config_t* config);
+void DeleteReplayBuffer(pyhanabi_replay_buffer_t* buffer);
+int ReplayBufferPackedObservationLength(pyhanabi_replay_buffer_t* buffer);
+int64_t ReplayBufferAddCount(pyhanabi_replay_buffer_t* buffer);
+int ReplayBufferSize(pyhanabi_replay_buffer_t* buffer);
+/* Exactly one of observation [observation_bits] and packed_observation is
+ * not NULL. */
+void ReplayBufferAdd(pyhanabi_replay_buffer_t* buffer,
+                     const uint8_t* observation,
+                     const uint64_t* packed_observation, int action,
+                     float reward, int terminal, const uint8_t* legal_moves);
+/* Returns 1 if batch_size sampleable indices were drawn, 0 otherwise. */
+int ReplayBufferSample(pyhanabi_replay_buffer_t* buffer, int batch_size,
+                       int* indices);
+int ReplayBufferIsSampleable(pyhanabi_replay_buffer_t* buffer, int index);
+void ReplayBufferGetTransitions(pyhanabi_replay_buffer_t* buffer,
+                                int batch_size, const int* indices,
+                                uint8_t* states, uint64_t* packed_states,
+                                int* actions, float* rewards,
+                                uint8_t* next_states,
+                                uint64_t* packed_next_states,
+                                uint8_t* terminals,
+                                uint8_t* next_legal_moves);
+void ReplayBufferSetPriorities(pyhanabi_replay_buffer_t* buffer, int count,
+                               const int* indices, const float* priorities);
+void ReplayBufferGetPriorities(pyhanabi_replay_buffer_t* buffer, int count,
+                               const int* indices, float* priorities);
+
+/* Env server functions.
+ * Client requests return a hanabi_learning_env::HanabiEnvClient::Status:
+ * 0 on success, 1 if the server stopped, 2 for an illegal move uid. Client
+ * outputs point into shared memory, laid out as VectorEnv outputs, until the
+ * next request; they are NULL before the first successful one. */
+void NewEnvServer(pyhanabi_env_server_t* server, pyhanabi_game_t* game,
+                  const pyhanabi_env_server_config_t* config);
+void DeleteEnvServer(pyhanabi_env_server_t* server);
+int64_t EnvServerSize(pyhanabi_env_server_t* server);
+void NewEnvClient(pyhanabi_env_client_t* client);
+void DeleteEnvClient(pyhanabi_env_client_t* client);
+/* Returns 1 if connected to shard, or to the first free shard if shard < 0,
+ * of the server of the name, 0 otherwise. */
+int EnvClientConnect(pyhanabi_env_client_t* client, const char* name,
+                     int shard);
+void EnvClientDisconnect(pyhanabi_env_client_t* client);
+int EnvClientConnected(pyhanabi_env_client_t* client);
+int EnvClientShard(pyhanabi_env_client_t* client);
+int EnvClientNumEnvs(pyhanabi_env_client_t* client);
+int EnvClientObservationLength(pyhanabi_env_client_t* client);
+int EnvClientPackedObservationLength(pyhanabi_env_client_t* client);
+int EnvClientNumMoves(pyhanabi_env_client_t* client);
+char* EnvClientParameters(pyhanabi_env_client_t* client);
+int EnvClientReset(pyhanabi_env_client_t* client);
+int EnvClientStep(pyhanabi_env_client_t* client, const int* move_uids);
+const uint8_t* EnvClientObservations(pyhanabi_env_client_t* client);
+const uint64_t* EnvClientPackedObservations(pyhanabi_env_client_t* client);
+const uint8_t* EnvClientLegalMoves(pyhanabi_env_client_t* client);
+const float* EnvClientRewards(pyhanabi_env_client_t* client);
+const uint8_t* EnvClientDones(pyhanabi_env_client_t* client);
+const int* EnvClientCurrentPlayers(pyhanabi_env_client_t* client);
+
+/* Instrumentation functions.
+ * Counters are indexed 0 to InstrumentationNumCounters() - 1; reads fill
+ * arrays of that length, with counts and cumulative nanoseconds. Nothing is
+ * recorded unless the library was built with HANABI_ENABLE_INSTRUMENTATION
+ * and recording is enabled. */
+int InstrumentationIsCompiled();
+void InstrumentationSetEnabled(int enabled);
+int InstrumentationIsEnabled();
+int InstrumentationNumCounters();
+const char* InstrumentationCounterName(int counter);
+void InstrumentationRead(int64_t* counts, int64_t* nanoseconds, int reset);
+void InstrumentationReset();
+
 } /* extern "C" */
 
 #endif
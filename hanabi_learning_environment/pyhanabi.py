@@ -512,6 +512,8 @@ class HanabiState(object):
     NOTE: If c_state is supplied, game is ignored and c_state game is used.
     """
     self._state = ffi.new("pyhanabi_state_t*")
+    # Move list refilled by every legal_moves() call, created on first use.
+    self._movelist = None
     if c_state is None:
       self._game = game.c_game
       lib.NewState(self._game, self._state)
@@ -524,9 +526,23 @@ class HanabiState(object):
     """Returns a copy of the state."""
     return HanabiState(None, self._state)
 
-  def observation(self, player):
-    """Returns player's observed view of current environment state."""
-    return HanabiObservation(self._state, self._game, player)
+  @property
+  def c_state(self):
+    """Return the C++ HanabiState object."""
+    return self._state
+
+  def observation(self, player, observation=None):
+    """Returns player's observed view of current environment state.
+
+    Args:
+      player: observing player.
+      observation: HanabiObservation of a state of the same game to update in
+        place and return, instead of creating a new observation.
+    """
+    if observation is None:
+      return HanabiObservation(self._state, self._game, player)
+    observation.update(self, player)
+    return observation
 
   def apply_move(self, move):
     """Advance the environment state by making move for acting player."""
@@ -569,6 +585,14 @@ class HanabiState(object):
     """If cur_player == CHANCE_PLAYER_ID, make a random card-deal move."""
     lib.StateDealRandomCard(self._state)
 
+  def deal_initial_hands(self):
+    """Deals all opening hands of a new state in one call.
+
+    Deals the same cards as calling deal_random_card() while cur_player() is
+    CHANCE_PLAYER_ID, from the game's generator.
+    """
+    lib.StateDealInitialHands(self._state)
+
   def player_hands(self):
     """Returns a list of all hands, with cards ordered oldest to newest."""
     hand_list = []
@@ -635,18 +659,45 @@ class HanabiState(object):
     c_card.rank = card.rank()
     lib.StateSetHandCard(self._state, player_index, card_index, c_card)
 
+  def sample_determinization(self, observer):
+    """Returns a copy of the state with observer's hand resampled.
+
+    The observer's cards are replaced by cards it cannot see (its own hand and
+    the deck) that are consistent with its card knowledge. Uses the game's
+    generator; see HanabiDeterminizationPool for many samples per call.
+    """
+    c_state = ffi.new("pyhanabi_state_t*")
+    lib.StateSampleDeterminization(self._state, observer, c_state)
+    state = HanabiState(None, c_state)
+    lib.DeleteState(c_state)
+    return state
+
   def legal_moves(self):
     """Returns list of legal moves for currently acting player."""
     moves = []
-    c_movelist = lib.StateLegalMoves(self._state)
-    num_moves = lib.NumMoves(c_movelist)
+    if self._movelist is None:
+      self._movelist = lib.NewMoveList()
+    lib.StateLegalMovesInto(self._state, self._movelist)
+    num_moves = lib.NumMoves(self._movelist)
     for i in range(num_moves):
       c_move = ffi.new("pyhanabi_move_t*")
-      lib.GetMove(c_movelist, i, c_move)
+      lib.GetMove(self._movelist, i, c_move)
       moves.append(HanabiMove(c_move))
-    lib.DeleteMoveList(c_movelist)
     return moves
 
+  def legal_moves_mask(self, player=None):
+    """Returns legal moves as an int, with bit uid set if move uid is legal.
+
+    Args:
+      player: player to get legal moves for, or None for the current player.
+        Players other than the current player have no legal moves.
+    """
+    if player is None:
+      player = self.cur_player()
+    if player == CHANCE_PLAYER_ID:
+      return 0
+    return lib.StateLegalMoveMask(self._state, player)
+
   def move_is_legal(self, move):
     """Returns true if and only if move is legal for active agent."""
     return lib.MoveIsLegal(self._state, move.c_move)
@@ -668,6 +719,48 @@ class HanabiState(object):
     """Returns the number of players in the game."""
     return lib.StateNumPlayers(self._state)
 
+  def zobrist_hash(self):
+    """Returns a 64-bit hash of the full state, e.g. to key a cache."""
+    return lib.StateHash(self._state)
+
+  def observer_hash(self, player):
+    """Returns a 64-bit hash of player's information set.
+
+    States that player cannot tell apart, such as the determinizations of
+    player's observation, have the same hash.
+    """
+    return lib.StateObserverHash(self._state, player)
+
+  def expected_value(self, depth, policy=None, num_threads=1):
+    """Returns the exact expected score after depth more player moves.
+
+    Chance nodes average over every distinct card left in the deck, weighted
+    by its count; see hanabi_expectimax.h. The state's hidden cards are used
+    as they are.
+
+    Args:
+      depth: number of player moves to look ahead.
+      policy: HanabiPolicy choosing the player moves, or None to choose the
+        moves of highest expected score (expectimax).
+      num_threads: number of threads splitting the first node's branches,
+        <= 0 to use all hardware threads.
+    """
+    return lib.StateExpectedValue(
+        self._state, depth, ffi.NULL if policy is None else policy._policy,
+        num_threads)
+
+  def expected_move_values(self, depth, policy=None, num_threads=1):
+    """Returns expected_value() after each move of the acting player.
+
+    The list is indexed by move uid, with -1 for illegal moves. Each move
+    counts as the first of the depth player moves.
+    """
+    values = ffi.new("double[]", lib.MaxMoves(self._game))
+    lib.StateExpectedMoveValues(
+        self._state, depth, ffi.NULL if policy is None else policy._policy,
+        num_threads, values)
+    return list(values)
+
   def score(self):
     """Returns the co-operative game score at a terminal state.
 
@@ -695,6 +788,9 @@ class HanabiState(object):
     return self.__str__()
 
   def __del__(self):
+    if self._movelist is not None:
+      lib.DeleteMoveList(self._movelist)
+      self._movelist = None
     if self._state is not None:
       lib.DeleteState(self._state)
       self._state = None
@@ -861,6 +957,14 @@ class HanabiObservation(object):
     """Returns the C++ HanabiObservation object."""
     return self._observation
 
+  def update(self, state, player):
+    """Rebuilds this observation in place as player's view of state.
+
+    The C++ observation is reused, so no object is created or freed. state,
+    a HanabiState, must belong to the same game as this observation.
+    """
+    lib.ObservationUpdate(self._observation, state.c_state, player)
+
   def cur_player_offset(self):
     """Returns the player index of the acting player, relative to observer."""
     return lib.ObsCurPlayerOffset(self._observation)
@@ -958,6 +1062,10 @@ class HanabiObservation(object):
       moves.append(HanabiMove(move))
     return moves
 
+  def legal_moves_mask(self):
+    """Returns legal_moves() as an int, with bit uid set if move uid is legal."""
+    return lib.ObsLegalMoveMask(self._observation)
+
   def card_playable_on_fireworks(self, color, rank):
     """Returns true if and only if card can be successfully played.
 
@@ -967,10 +1075,60 @@ class HanabiObservation(object):
     """
     return lib.ObsCardPlayableOnFireworks(self._observation, color, rank)
 
+  def export_data(self, data=None):
+    """Copies the whole observation into a pyhanabi_observation_data_t.
+
+    One C call replaces the per-card and per-move calls of observed_hands(),
+    card_knowledge(), discard_pile(), last_moves() and legal_moves(). The
+    result is a copy, so it stays valid when this observation is updated.
+
+    Args:
+      data: pyhanabi_observation_data_t* to refill, or None for a new one.
+
+    Returns:
+      The filled pyhanabi_observation_data_t*, whose fields are read as
+      attributes (see pyhanabi.h).
+    """
+    if data is None:
+      data = ffi.new("pyhanabi_observation_data_t*")
+    lib.ObsExportData(self._observation, data)
+    return data
+
+
+# Buffer formats of 64-bit unsigned integers, e.g. numpy.uint64 arrays.
+UINT64_FORMATS = ("Q", "L") if ffi.sizeof("unsigned long") == 8 else ("Q",)
+
+
+def _c_buffer(buffer, formats, c_type, size, writable=True):
+  """Returns a cffi view of buffer, checked for element type and size.
+
+  Args:
+    buffer: contiguous buffer (e.g. a NumPy array), or None for NULL.
+    formats: struct format character, or tuple of accepted characters, of the
+      buffer elements.
+    c_type: cffi array type of the view, e.g. "uint8_t[]".
+    size: minimum number of elements.
+    writable: whether the C function writes to the buffer.
+  """
+  if buffer is None:
+    return ffi.NULL
+  view = memoryview(buffer)
+  if isinstance(formats, str):
+    formats = (formats,)
+  if view.format.lstrip("@=<") not in formats:
+    raise ValueError("Unsupported buffer format: {}. Expected {}.".format(
+        view.format, " or ".join(formats)))
+  if view.nbytes // view.itemsize < size:
+    raise ValueError("Buffer too small: {} elements, expected {}.".format(
+        view.nbytes // view.itemsize, size))
+  return ffi.from_buffer(c_type, buffer, require_writable=writable)
+
 
 class ObservationEncoderType(enum.IntEnum):
   """Encoder types, consistent with observation_encoder.h."""
   CANONICAL = 0
+  # Per-card probabilities of each identity, as float32; see hanabi_belief.h.
+  BELIEF = 1
 
 
 class ObservationEncoder(object):
@@ -981,11 +1139,23 @@ class ObservationEncoder(object):
   the shape and encode methods.
   """
 
-  def __init__(self, game, enc_type=ObservationEncoderType.CANONICAL):
-    """Construct using HanabiState.observation(player)."""
+  def __init__(self, game, enc_type=ObservationEncoderType.CANONICAL,
+               belief_iterations=0):
+    """Construct using HanabiState.observation(player).
+
+    Args:
+      game: HanabiGame whose observations are encoded.
+      enc_type: ObservationEncoderType.
+      belief_iterations: for BELIEF encoders, rounds of cross-card
+        consistency refining the independent per-card beliefs.
+    """
     self._game = game.c_game
     self._encoder = ffi.new("pyhanabi_observation_encoder_t*")
-    lib.NewObservationEncoder(self._encoder, self._game, enc_type)
+    if enc_type == ObservationEncoderType.BELIEF:
+      lib.NewBeliefObservationEncoder(self._encoder, self._game,
+                                      belief_iterations)
+    else:
+      lib.NewObservationEncoder(self._encoder, self._game, enc_type)
 
   def __del__(self):
     if self._encoder is not None:
@@ -1008,10 +1178,1044 @@ class ObservationEncoder(object):
     encoding_string = encode_ffi_string(c_encoding_str)
     lib.DeleteString(c_encoding_str)
     # Canonical observations are bit strings, so it is ok to encode using a
-    # string. For float or double observations, make a custom object
+    # string. For float or double observations, make a custom object; belief
+    # encoders give 1 for the identities of nonzero probability, and their
+    # probabilities through encode_into with a float32 buffer.
     encoding = [int(x) for x in encoding_string.split(",")]
     return encoding
 
+  def size(self):
+    """Returns the number of elements in an encoded observation."""
+    return lib.ObservationLength(self._encoder)
+
+  def encode_into(self, observation, buffer):
+    """Encode the observation directly into a caller-owned buffer.
+
+    Unlike encode(), no intermediate string or list is built.
+
+    Args:
+      observation: HanabiObservation to encode.
+      buffer: writable, contiguous buffer of uint8 or float32 elements (e.g. a
+        NumPy array) with room for at least size() elements.
+
+    Returns:
+      buffer, for convenience.
+
+    Raises:
+      ValueError: If buffer has an unsupported element type or size.
+    """
+    size = self.size()
+    if memoryview(buffer).format.lstrip("@=<") == "f":
+      lib.EncodeObservationFloat(self._encoder, observation.observation(),
+                                 _c_buffer(buffer, "f", "float[]", size), size)
+    else:
+      lib.EncodeObservationUint8(self._encoder, observation.observation(),
+                                 _c_buffer(buffer, "B", "uint8_t[]", size),
+                                 size)
+    return buffer
+
+  def encode_state_into(self, state, player, buffer):
+    """Encode player's observation of state into a caller-owned buffer.
+
+    Equivalent to encode_into(state.observation(player), buffer), but reads
+    the state directly instead of building an observation first.
+
+    Args:
+      state: HanabiState to encode.
+      player: index of the observing player.
+      buffer: writable, contiguous buffer of uint8 or float32 elements with
+        room for at least size() elements.
+
+    Returns:
+      buffer, for convenience.
+
+    Raises:
+      ValueError: If buffer has an unsupported element type or size.
+    """
+    size = self.size()
+    if memoryview(buffer).format.lstrip("@=<") == "f":
+      lib.EncodeStateFloat(self._encoder, state.c_state, player,
+                           _c_buffer(buffer, "f", "float[]", size), size)
+    else:
+      lib.EncodeStateUint8(self._encoder, state.c_state, player,
+                           _c_buffer(buffer, "B", "uint8_t[]", size), size)
+    return buffer
+
+
+  def encode_states_into(self, states, players, buffer):
+    """Encode a batch of observations in a single call.
+
+    Row i of buffer receives the encoding of players[i]'s observation of
+    states[i], as encode_state_into() would write it.
+
+    Args:
+      states: sequence of HanabiState.
+      players: sequence of observing player indices, one per state.
+      buffer: writable, contiguous buffer of uint8 or float32 elements with
+        room for at least len(states) * size() elements.
+
+    Returns:
+      buffer, for convenience.
+
+    Raises:
+      ValueError: If states and players differ in length, or buffer has an
+        unsupported element type or size.
+    """
+    if len(states) != len(players):
+      raise ValueError("Expected one player per state, got {} states and {} "
+                       "players.".format(len(states), len(players)))
+    num_states = len(states)
+    c_states = ffi.new("pyhanabi_state_t*[]",
+                       [state.c_state for state in states])
+    c_players = ffi.new("int[]", list(players))
+    size = num_states * self.size()
+    if memoryview(buffer).format.lstrip("@=<") == "f":
+      lib.EncodeStatesFloat(self._encoder, c_states, c_players, num_states,
+                            _c_buffer(buffer, "f", "float[]", size), size)
+    else:
+      lib.EncodeStatesUint8(self._encoder, c_states, c_players, num_states,
+                            _c_buffer(buffer, "B", "uint8_t[]", size), size)
+    return buffer
+
+  def packed_size(self):
+    """Returns the number of 64-bit words in a packed observation."""
+    return lib.ObservationPackedLength(self._encoder)
+
+  def encode_packed_into(self, observation, buffer):
+    """Encode the observation packed into 64-bit words.
+
+    Bit i of the encoding is bit i % 64 of word i // 64, and the unused bits
+    of the last word are zero, so that a packed observation takes 1/8 of the
+    memory of a uint8 encoding. unpack_observations() restores one element
+    per bit.
+
+    Args:
+      observation: HanabiObservation to encode.
+      buffer: writable, contiguous buffer of uint64 elements with room for at
+        least packed_size() elements.
+
+    Returns:
+      buffer, for convenience.
+    """
+    c_buffer = _c_buffer(buffer, UINT64_FORMATS, "uint64_t[]",
+                         self.packed_size())
+    lib.EncodeObservationPacked(self._encoder, observation.observation(),
+                                c_buffer, len(c_buffer))
+    return buffer
+
+  def encode_state_packed_into(self, state, player, buffer):
+    """Encode player's observation of state packed into 64-bit words.
+
+    Equivalent to encode_packed_into(state.observation(player), buffer).
+    """
+    c_buffer = _c_buffer(buffer, UINT64_FORMATS, "uint64_t[]",
+                         self.packed_size())
+    lib.EncodeStatePacked(self._encoder, state.c_state, player, c_buffer,
+                          len(c_buffer))
+    return buffer
+
+
+def unpack_observations(packed, num_bits, buffer):
+  """Unpacks packed observations into one element per bit.
+
+  Args:
+    packed: contiguous uint64 buffer of packed observations, each
+      ceil(num_bits / 64) words long, as written by
+      ObservationEncoder.encode_packed_into() or HanabiVectorEnv.
+    num_bits: number of bits per observation, ObservationEncoder.size().
+    buffer: writable, contiguous uint8 or float32 buffer, receiving
+      num_bits elements per observation in packed.
+
+  Returns:
+    buffer, for convenience.
+
+  Raises:
+    ValueError: If a buffer has an unsupported element type or size.
+  """
+  num_words = (num_bits + 63) // 64
+  view = memoryview(packed)
+  num_rows = view.nbytes // view.itemsize // num_words
+  c_packed = _c_buffer(packed, UINT64_FORMATS, "uint64_t[]",
+                       num_rows * num_words, writable=False)
+  if memoryview(buffer).format.lstrip("@=<") == "f":
+    c_buffer = _c_buffer(buffer, "f", "float[]", num_rows * num_bits)
+    lib.UnpackObservationsFloat(c_packed, num_rows, num_bits, c_buffer)
+  else:
+    c_buffer = _c_buffer(buffer, "B", "uint8_t[]", num_rows * num_bits)
+    lib.UnpackObservationsUint8(c_packed, num_rows, num_bits, c_buffer)
+  return buffer
+
+
+class HanabiVectorEnv(object):
+  """A batch of independent games of the same HanabiGame, stepped natively.
+
+  Each reset() or step() is a single call into the C++ library, which applies
+  one move per game, deals replacement cards, starts a new game in any slot
+  that finished, and writes the acting player's canonical observation and
+  legal move mask into caller-owned buffers. Games are split across
+  num_threads native threads; cffi releases the GIL for the duration of each
+  call, so other Python threads keep running while a batch is stepped.
+
+  Output buffers are writable, contiguous arrays (e.g. NumPy arrays) with one
+  row per game, and may be None to skip that output:
+    observations: uint8, num_envs * observation_length() elements.
+    packed_observations: uint64, num_envs * packed_observation_length()
+      elements, the observations packed as in
+      ObservationEncoder.encode_packed_into().
+    legal_moves: uint8, num_envs * num_moves() elements, 1 for legal uids.
+    rewards: float32, num_envs elements, score differential of the step.
+    dones: uint8, num_envs elements, 1 if the game finished (and was reset).
+    current_players: int32, num_envs elements.
+
+  Python wrapper of C++ HanabiVectorEnv class.
+  """
+
+  def __init__(self, game, num_envs, num_threads=1):
+    """Creates num_envs games of game.
+
+    Args:
+      game: HanabiGame shared by all games. Deals are drawn from per-game
+        generators seeded from the game's seed, so a seeded game gives the
+        same results for any num_threads.
+      num_envs: number of games.
+      num_threads: number of threads stepping the games, <= 0 to use all
+        hardware threads.
+    """
+    self._game = game
+    self._env = ffi.new("pyhanabi_vector_env_t*")
+    lib.NewVectorEnv(self._env, game.c_game, num_envs, num_threads)
+    # Output buffers of the step started by step_async, kept alive until it
+    # has finished.
+    self._pending_outputs = None
+
+  def __del__(self):
+    if self._env is not None:
+      lib.DeleteVectorEnv(self._env)
+      self._env = None
+      self._game = None
+    del self
+
+  def num_envs(self):
+    return lib.VectorEnvNumEnvs(self._env)
+
+  def num_threads(self):
+    return lib.VectorEnvNumThreads(self._env)
+
+  def observation_length(self):
+    """Returns the number of encoding elements per game."""
+    return lib.VectorEnvObservationLength(self._env)
+
+  def packed_observation_length(self):
+    """Returns the number of packed observation words per game."""
+    return lib.VectorEnvPackedObservationLength(self._env)
+
+  def num_moves(self):
+    """Returns the number of legal move mask elements per game."""
+    return lib.VectorEnvNumMoves(self._env)
+
+  def state(self, index):
+    """Returns a copy of the state of game index."""
+    self.step_wait()
+    c_state = ffi.new("pyhanabi_state_t*")
+    lib.VectorEnvGetState(self._env, index, c_state)
+    state = HanabiState(None, c_state)
+    lib.DeleteState(c_state)
+    return state
+
+  def reset(self, observations=None, legal_moves=None, rewards=None,
+            dones=None, current_players=None, packed_observations=None):
+    """Starts a new game in every slot and fills the given buffers."""
+    self.step_wait()
+    lib.VectorEnvReset(self._env, *self._outputs(observations,
+                                                 packed_observations,
+                                                 legal_moves, rewards, dones,
+                                                 current_players))
+
+  def step(self, move_uids, observations=None, legal_moves=None, rewards=None,
+           dones=None, current_players=None, packed_observations=None):
+    """Applies move_uids[i] in game i and fills the given buffers.
+
+    Args:
+      move_uids: int32 buffer of num_envs move uids, each legal for the
+        current player of its game.
+      observations, legal_moves, rewards, dones, current_players,
+        packed_observations: output buffers, see the class documentation.
+
+    Raises:
+      ValueError: If any move is not legal. No game is stepped.
+    """
+    self.step_wait()
+    c_moves = _c_buffer(move_uids, "i", "int[]", self.num_envs(),
+                        writable=False)
+    if not lib.VectorEnvStep(self._env, c_moves,
+                             *self._outputs(observations, packed_observations,
+                                            legal_moves, rewards, dones,
+                                            current_players)):
+      raise ValueError("Illegal move in batch; no game was stepped.")
+
+  def step_async(self, move_uids, observations=None, legal_moves=None,
+                 rewards=None, dones=None, current_players=None,
+                 packed_observations=None):
+    """Starts step() on a native thread and returns at once.
+
+    The step applies the moves and fills the buffers while Python works on
+    the outputs of the previous step, e.g. computing the next actions. The
+    buffers must not be read until step_wait() returns; alternate between
+    two sets of buffers to overlap steps with inference:
+
+      env.step_async(actions, observations=obs[1], legal_moves=legal[1])
+      ...  # Use obs[0] and legal[0].
+      env.step_wait()  # obs[1] and legal[1] are ready.
+
+    move_uids is copied, and can be reused at once. reset(), step() and
+    step_async() wait for a pending step first.
+
+    Raises:
+      ValueError: If any move is not legal. No step is started.
+    """
+    self.step_wait()
+    c_moves = _c_buffer(move_uids, "i", "int[]", self.num_envs(),
+                        writable=False)
+    outputs = self._outputs(observations, packed_observations, legal_moves,
+                            rewards, dones, current_players)
+    if not lib.VectorEnvStepAsync(self._env, c_moves, *outputs):
+      raise ValueError("Illegal move in batch; no game was stepped.")
+    self._pending_outputs = outputs
+
+  def step_wait(self):
+    """Blocks, without holding the GIL, until the pending step finishes."""
+    if self._pending_outputs is not None:
+      lib.VectorEnvStepWait(self._env)
+      self._pending_outputs = None
+
+  def _outputs(self, observations, packed_observations, legal_moves, rewards,
+               dones, current_players):
+    num_envs = self.num_envs()
+    return (_c_buffer(observations, "B", "uint8_t[]",
+                      num_envs * self.observation_length()),
+            _c_buffer(packed_observations, UINT64_FORMATS, "uint64_t[]",
+                      num_envs * self.packed_observation_length()),
+            _c_buffer(legal_moves, "B", "uint8_t[]",
+                      num_envs * self.num_moves()),
+            _c_buffer(rewards, "f", "float[]", num_envs),
+            _c_buffer(dones, "B", "uint8_t[]", num_envs),
+            _c_buffer(current_players, "i", "int[]", num_envs))
+
+
+class HanabiDeterminizationPool(object):
+  """A reusable set of determinizations sampled natively in a single call.
+
+  Each sample() replaces every state of the pool by a copy of the given state
+  in which the observer's hand is resampled from the cards it cannot see,
+  consistent with its card knowledge.
+
+  Python wrapper of C++ HanabiDeterminizationPool class.
+  """
+
+  def __init__(self, size, seed=-1):
+    """Creates a pool of size determinizations.
+
+    Args:
+      size: number of determinizations produced by each sample().
+      seed: seed of the pool's generator, -1 to pick one at random.
+    """
+    self._pool = ffi.new("pyhanabi_determinization_pool_t*")
+    lib.NewDeterminizationPool(self._pool, size, seed)
+
+  def __del__(self):
+    if self._pool is not None:
+      lib.DeleteDeterminizationPool(self._pool)
+      self._pool = None
+    del self
+
+  def size(self):
+    return lib.DeterminizationPoolSize(self._pool)
+
+  def sample(self, state, observer):
+    """Samples size() determinizations of state for observer."""
+    lib.DeterminizationPoolSample(self._pool, state.c_state, observer)
+
+  def state(self, index):
+    """Returns a copy of determinization index of the last sample()."""
+    c_state = ffi.new("pyhanabi_state_t*")
+    lib.DeterminizationPoolGetState(self._pool, index, c_state)
+    state = HanabiState(None, c_state)
+    lib.DeleteState(c_state)
+    return state
+
+
+class HanabiPolicyType(enum.IntEnum):
+  """Native policy types, consistent with hanabi_lib/hanabi_playout.h."""
+  RANDOM = 0
+  SIMPLE = 1
+
+
+class HanabiPolicy(object):
+  """A policy that chooses moves natively, without calling back into Python.
+
+  RANDOM plays a uniformly random legal move, as agents/random_agent.py.
+  SIMPLE follows the rules of agents/simple_agent.py.
+
+  Python wrapper of the C++ HanabiPolicy classes.
+  """
+
+  def __init__(self, policy_type=HanabiPolicyType.SIMPLE):
+    self._policy = ffi.new("pyhanabi_policy_t*")
+    lib.NewPolicy(self._policy, policy_type)
+
+  def __del__(self):
+    if self._policy is not None:
+      lib.DeletePolicy(self._policy)
+      self._policy = None
+    del self
+
+  def act(self, state):
+    """Returns the HanabiMove chosen for the current player of state."""
+    c_move = ffi.new("pyhanabi_move_t*")
+    lib.PolicyAct(self._policy, state.c_state, c_move)
+    return HanabiMove(c_move)
+
+  def playout(self, state, seed=-1):
+    """Plays state to the end in place, with this policy for every player.
+
+    Chance moves are drawn from a generator seeded with seed, or with a
+    random seed if seed is -1. Use state.copy() to keep the original state.
+
+    Returns:
+      A dict with the final score, end_of_game (a HanabiState's end of game
+      status) and the numbers of moves, plays, misplays, discards and hints.
+    """
+    result = ffi.new("pyhanabi_playout_result_t*")
+    lib.PolicyPlayout(self._policy, state.c_state, seed, result)
+    return {
+        "score": result.score,
+        "end_of_game": result.end_of_game,
+        "num_moves": result.num_moves,
+        "num_plays": result.num_plays,
+        "num_misplays": result.num_misplays,
+        "num_discards": result.num_discards,
+        "num_hints": result.num_hints,
+    }
+
+  def evaluate(self, game, num_games, num_threads=1):
+    """Plays num_games games of game natively, split across threads.
+
+    Blocks of consecutive games draw their deals from generators seeded from
+    the game's seed and the block index, so a seeded game gives the same
+    results for any num_threads.
+
+    Args:
+      game: HanabiGame to play.
+      num_games: number of games.
+      num_threads: number of threads, <= 0 to use all hardware threads.
+
+    Returns:
+      A dict with num_games, mean_score, score_stddev, the per-game means of
+      moves, plays, misplays, discards and hints, score_counts (the number
+      of games ending with each score, from 0 to the number of colors times
+      the number of ranks) and the number of games ending for each reason.
+    """
+    evaluation = ffi.new("pyhanabi_evaluation_t*")
+    lib.PolicyEvaluate(self._policy, game.c_game, num_games, num_threads,
+                       evaluation)
+    return {
+        "num_games": evaluation.num_games,
+        "mean_score": evaluation.mean_score,
+        "score_stddev": evaluation.score_stddev,
+        "mean_moves": evaluation.mean_moves,
+        "mean_plays": evaluation.mean_plays,
+        "mean_misplays": evaluation.mean_misplays,
+        "mean_discards": evaluation.mean_discards,
+        "mean_hints": evaluation.mean_hints,
+        "score_counts": [evaluation.score_counts[score]
+                         for score in range(
+                             game.num_colors() * game.num_ranks() + 1)],
+        "num_out_of_life_tokens": evaluation.num_out_of_life_tokens,
+        "num_out_of_cards": evaluation.num_out_of_cards,
+        "num_completed_fireworks": evaluation.num_completed_fireworks,
+    }
+
+
+class HanabiSearch(object):
+  """Native Information-Set Monte Carlo Tree Search (ISMCTS) with UCT.
+
+  Every iteration redeals the searching player's hand consistently with what
+  it knows, descends the tree of moves legal in that deal, adds one node and
+  plays out the rest of the game with rollout_policy. Each thread searches
+  its own tree, and the root statistics of the trees are summed.
+
+  Python wrapper of C++ HanabiSearch class.
+  """
+
+  def __init__(self,
+               rollout_policy=None,
+               num_iterations=1000,
+               time_limit=0.0,
+               exploration=0.5,
+               num_threads=1,
+               score_lost_games=True,
+               seed=-1,
+               transposition_table_size=0):
+    """Creates a search.
+
+    Args:
+      rollout_policy: HanabiPolicy playing out every iteration, a SIMPLE
+        policy if None.
+      num_iterations: iterations per search, shared between threads, 0 for no
+        limit.
+      time_limit: wall-clock budget per search in seconds, 0 for no limit.
+        At least one of num_iterations and time_limit must be set.
+      exploration: UCT exploration constant, for values in [0, 1] (the score
+        divided by the maximum score).
+      num_threads: number of threads, <= 0 to use all hardware threads.
+      score_lost_games: whether playouts that run out of life tokens are
+        valued by their fireworks rather than by their score of 0.
+      seed: seed of the search's generator, -1 for a random seed.
+      transposition_table_size: entries of a table, shared by the threads,
+        valuing each move by all its visits from the same information set of
+        the searching player, 0 for none. Results then depend on thread
+        timing.
+    """
+    if rollout_policy is None:
+      rollout_policy = HanabiPolicy(HanabiPolicyType.SIMPLE)
+    # The native search refers to the policy without owning it.
+    self._rollout_policy = rollout_policy
+    config = ffi.new("pyhanabi_search_config_t*")
+    config.num_iterations = num_iterations
+    config.time_limit = time_limit
+    config.exploration = exploration
+    config.num_threads = num_threads
+    config.score_lost_games = int(score_lost_games)
+    config.seed = seed
+    config.transposition_table_size = transposition_table_size
+    self._search = ffi.new("pyhanabi_search_t*")
+    lib.NewSearch(self._search, config, rollout_policy._policy)
+
+  def __del__(self):
+    if self._search is not None:
+      lib.DeleteSearch(self._search)
+      self._search = None
+    del self
+
+  def search(self, target):
+    """Searches for the player to act.
+
+    Args:
+      target: a HanabiState, searched for its current player with only that
+        player's information, or a HanabiObservation of the current player,
+        whose moves are relative to the observer.
+
+    Returns:
+      A dict with the chosen HanabiMove as move, num_iterations, and the
+      root visit_counts and mean values (in [0, 1]) of every move uid.
+    """
+    num_moves = lib.MaxMoves(target._game)
+    visit_counts = ffi.new("int[]", num_moves)
+    values = ffi.new("double[]", num_moves)
+    c_move = ffi.new("pyhanabi_move_t*")
+    if isinstance(target, HanabiState):
+      num_iterations = lib.SearchState(self._search, target.c_state, c_move,
+                                       visit_counts, values)
+    else:
+      num_iterations = lib.SearchObservation(self._search,
+                                             target.observation(), c_move,
+                                             visit_counts, values)
+    return {
+        "move": HanabiMove(c_move),
+        "num_iterations": num_iterations,
+        "visit_counts": list(visit_counts),
+        "values": list(values),
+    }
+
+
+class HanabiGameLogWriter(object):
+  """Writes games to a binary game log, with one byte per move.
+
+  Logs store the game parameters once and the moves of every game, deals
+  included; HanabiGameLogReader replays them to recover any state or
+  observation.
+
+  Python wrapper of C++ HanabiGameLogWriter class.
+  """
+
+  def __init__(self, path, game):
+    """Creates or truncates the log at path, for games of game."""
+    self._game = game
+    self._writer = ffi.new("pyhanabi_game_log_writer_t*")
+    lib.NewGameLogWriter(self._writer, path.encode("utf-8"), game.c_game)
+
+  def __del__(self):
+    self.close()
+
+  def write_game(self, state, seed=0):
+    """Appends the game of state, which must record its move history.
+
+    Args:
+      state: HanabiState of the log's game, finished or not.
+      seed: integer in [0, 2**64) stored with the game, e.g. the seed of the
+        generator that dealt it.
+    """
+    lib.GameLogWriterWriteGame(self._writer, state.c_state, seed)
+
+  def num_games(self):
+    """Returns the number of games written so far."""
+    return lib.GameLogWriterNumGames(self._writer)
+
+  def flush(self):
+    lib.GameLogWriterFlush(self._writer)
+
+  def close(self):
+    """Closes the log. Nothing may be written afterwards."""
+    if self._writer is not None:
+      lib.DeleteGameLogWriter(self._writer)
+      self._writer = None
+      self._game = None
+
+
+class HanabiGameLogReader(object):
+  """Reads a binary game log through a memory mapping and replays its games.
+
+  Python wrapper of C++ HanabiGameLogReader class.
+  """
+
+  def __init__(self, path):
+    self._reader = ffi.new("pyhanabi_game_log_reader_t*")
+    lib.NewGameLogReader(self._reader, path.encode("utf-8"))
+    c_string = lib.GameLogReaderParameters(self._reader)
+    lines = encode_ffi_string(c_string).splitlines()
+    lib.DeleteString(c_string)
+    self._game = HanabiGame(dict(line.split("=", 1) for line in lines))
+    self._encoder = None
+
+  def __del__(self):
+    if self._reader is not None:
+      lib.DeleteGameLogReader(self._reader)
+      self._reader = None
+    del self
+
+  def game(self):
+    """Returns the HanabiGame of the log's parameters."""
+    return self._game
+
+  def num_games(self):
+    return lib.GameLogReaderNumGames(self._reader)
+
+  def seed(self, game):
+    """Returns the seed stored with game index game."""
+    return lib.GameLogReaderSeed(self._reader, game)
+
+  def num_moves(self, game):
+    """Returns the number of moves of game, deals included."""
+    return lib.GameLogReaderNumMoves(self._reader, game)
+
+  def num_player_moves(self, game):
+    return lib.GameLogReaderNumPlayerMoves(self._reader, game)
+
+  def replay(self, game, num_moves=None):
+    """Returns a new HanabiState of game after its first num_moves moves.
+
+    Args:
+      game: index of the game in the log.
+      num_moves: number of moves to replay, deals included, or None for all.
+    """
+    if num_moves is None:
+      num_moves = self.num_moves(game)
+    state = HanabiState(self._game)
+    lib.GameLogReaderReplay(self._reader, game, num_moves, state.c_state)
+    return state
+
+  def encode_game(self, game, observations=None, move_uids=None):
+    """Regenerates the canonical observations of every player move of game.
+
+    Args:
+      game: index of the game in the log.
+      observations: writable uint8 buffer (e.g. a NumPy array) receiving, for
+        each player move in order, the encoding of the acting player's
+        observation before the move, num_player_moves(game) *
+        observation_length() elements; or None.
+      move_uids: writable int32 buffer receiving the uid of each player
+        move, num_player_moves(game) elements; or None.
+
+    Returns:
+      The number of player moves of game.
+    """
+    num_player_moves = self.num_player_moves(game)
+    return lib.GameLogReaderEncodeGame(
+        self._reader, game, self._canonical_encoder()._encoder,
+        _c_buffer(observations, "B", "uint8_t[]",
+                  num_player_moves * self.observation_length()),
+        _c_buffer(move_uids, "i", "int[]", num_player_moves))
+
+  def observation_length(self):
+    """Returns the number of elements of each encoded observation."""
+    return lib.ObservationLength(self._canonical_encoder()._encoder)
+
+  def _canonical_encoder(self):
+    if self._encoder is None:
+      self._encoder = ObservationEncoder(self._game)
+    return self._encoder
+
+
+class HanabiReplayBuffer(object):
+  """A native circular replay memory of packed observations.
+
+  Follows agents/rainbow/replay_memory.py and prioritized_replay_memory.py:
+  transitions are added one at a time, each episode is preceded by
+  stack_size - 1 zero transitions, sampled states stack an observation with
+  the stack_size - 1 before it, and rewards are n-step discounted returns
+  truncated at the end of the episode. Observations are stored packed, and
+  sampling, stacking and priority updates run natively, one call per batch.
+
+  Buffers are contiguous arrays (e.g. NumPy arrays); outputs may be None:
+    states, next_states: uint8, batch * observation_bits * stack_size
+      elements, laid out [batch, observation_bits, stack_size].
+    packed_states, packed_next_states: uint64, batch * stack_size *
+      packed_observation_length() elements.
+    actions: int32; rewards: float32; terminals: uint8; batch elements.
+    next_legal_moves: uint8, batch * num_moves elements, 1 for legal uids.
+
+  Python wrapper of C++ ReplayBuffer class.
+  """
+
+  def __init__(self, observation_bits, num_moves, capacity, stack_size=1,
+               update_horizon=1, gamma=1.0, prioritized=False, seed=-1):
+    """Creates an empty buffer.
+
+    Args:
+      observation_bits: number of elements of each observation.
+      num_moves: number of move uids, at most 64.
+      capacity: number of transitions kept, padding included.
+      stack_size: number of observations per state.
+      update_horizon: n of the n-step returns.
+      gamma: discount factor.
+      prioritized: whether sample() draws by priority. New transitions get
+        the largest priority set so far, and at least 1.
+      seed: seed of the sampling generator, -1 for a random seed.
+    """
+    self._observation_bits = observation_bits
+    self._num_moves = num_moves
+    self._stack_size = stack_size
+    config = ffi.new("pyhanabi_replay_buffer_config_t*")
+    config.observation_bits = observation_bits
+    config.num_moves = num_moves
+    config.capacity = capacity
+    config.stack_size = stack_size
+    config.update_horizon = update_horizon
+    config.gamma = gamma
+    config.prioritized = int(prioritized)
+    config.seed = seed
+    self._buffer = ffi.new("pyhanabi_replay_buffer_t*")
+    lib.NewReplayBuffer(self._buffer, config)
+
+  def __del__(self):
+    if self._buffer is not None:
+      lib.DeleteReplayBuffer(self._buffer)
+      self._buffer = None
+    del self
+
+  def packed_observation_length(self):
+    """Returns the number of words of each packed observation."""
+    return lib.ReplayBufferPackedObservationLength(self._buffer)
+
+  def add_count(self):
+    """Returns the number of transitions added, padding included."""
+    return lib.ReplayBufferAddCount(self._buffer)
+
+  def size(self):
+    """Returns the number of transitions held."""
+    return lib.ReplayBufferSize(self._buffer)
+
+  def add(self, observation, action, reward, terminal, legal_moves,
+          packed_observation=None):
+    """Adds a transition.
+
+    Args:
+      observation: uint8 buffer of observation_bits elements, or None if
+        packed_observation is given.
+      action: uid of the move taken.
+      reward: reward of the move.
+      terminal: whether the move ended the episode.
+      legal_moves: uint8 buffer of num_moves elements, 1 for the legal uids.
+      packed_observation: uint64 buffer of packed_observation_length()
+        words, as from ObservationEncoder.encode_packed_into(), if
+        observation is None.
+    """
+    lib.ReplayBufferAdd(
+        self._buffer,
+        _c_buffer(observation, "B", "uint8_t[]", self._observation_bits,
+                  writable=False),
+        _c_buffer(packed_observation, UINT64_FORMATS, "uint64_t[]",
+                  self.packed_observation_length(), writable=False),
+        action, reward, int(terminal),
+        _c_buffer(legal_moves, "B", "uint8_t[]", self._num_moves,
+                  writable=False))
+
+  def sample(self, indices):
+    """Fills the int32 buffer indices with indices of sampled transitions.
+
+    Raises:
+      RuntimeError: if the buffer holds too few sampleable transitions.
+    """
+    batch_size = len(indices)
+    if not lib.ReplayBufferSample(
+        self._buffer, batch_size,
+        _c_buffer(indices, "i", "int[]", batch_size)):
+      raise RuntimeError("Could not sample {} valid transitions.".format(
+          batch_size))
+
+  def is_sampleable(self, index):
+    return bool(lib.ReplayBufferIsSampleable(self._buffer, index))
+
+  def get_transitions(self, indices, states=None, actions=None, rewards=None,
+                      next_states=None, terminals=None, next_legal_moves=None,
+                      packed_states=None, packed_next_states=None):
+    """Writes the transitions at indices, an int32 buffer, to the outputs."""
+    batch_size = len(indices)
+    state_size = batch_size * self._observation_bits * self._stack_size
+    packed_size = (batch_size * self._stack_size *
+                   self.packed_observation_length())
+    lib.ReplayBufferGetTransitions(
+        self._buffer, batch_size,
+        _c_buffer(indices, "i", "int[]", batch_size, writable=False),
+        _c_buffer(states, "B", "uint8_t[]", state_size),
+        _c_buffer(packed_states, UINT64_FORMATS, "uint64_t[]", packed_size),
+        _c_buffer(actions, "i", "int[]", batch_size),
+        _c_buffer(rewards, "f", "float[]", batch_size),
+        _c_buffer(next_states, "B", "uint8_t[]", state_size),
+        _c_buffer(packed_next_states, UINT64_FORMATS, "uint64_t[]",
+                  packed_size),
+        _c_buffer(terminals, "B", "uint8_t[]", batch_size),
+        _c_buffer(next_legal_moves, "B", "uint8_t[]",
+                  batch_size * self._num_moves))
+
+  def set_priorities(self, indices, priorities):
+    """Sets the priorities, a float32 buffer, of the transitions at indices."""
+    count = len(indices)
+    lib.ReplayBufferSetPriorities(
+        self._buffer, count,
+        _c_buffer(indices, "i", "int[]", count, writable=False),
+        _c_buffer(priorities, "f", "float[]", count, writable=False))
+
+  def get_priorities(self, indices, priorities):
+    """Writes the priorities of the transitions at indices to priorities."""
+    count = len(indices)
+    lib.ReplayBufferGetPriorities(
+        self._buffer, count,
+        _c_buffer(indices, "i", "int[]", count, writable=False),
+        _c_buffer(priorities, "f", "float[]", count))
+
+
+class HanabiEnvServer(object):
+  """Serves shards of HanabiVectorEnv games through POSIX shared memory.
+
+  Each shard is stepped by its own native thread for one HanabiEnvClient at
+  a time, typically in another process. Requests and outputs go through
+  lock-free rings in the shared memory object, so nothing is pickled or
+  copied on the way. The server stops, and removes the object, when it is
+  deleted.
+
+  Python wrapper of C++ HanabiEnvServer class.
+  """
+
+  def __init__(self, game, name, num_shards=1, envs_per_shard=64,
+               threads_per_shard=1, packed_observations=False,
+               ring_capacity=2):
+    """Creates the shared memory object name and starts serving.
+
+    Args:
+      game: HanabiGame of all shards. Shard s plays games s * envs_per_shard
+        onwards of the game's seed, as a single HanabiVectorEnv would.
+      name: name of the shared memory object, e.g. "hanabi". An existing
+        object of the name is replaced.
+      num_shards: number of shards, each used by one client.
+      envs_per_shard: number of games of each shard.
+      threads_per_shard: number of threads stepping each shard.
+      packed_observations: whether clients get packed_observations() rather
+        than observations().
+      ring_capacity: number of responses per shard, at least 2.
+    """
+    self._game = game
+    c_name = ffi.new("char[]", name.encode("ascii"))
+    config = ffi.new("pyhanabi_env_server_config_t*")
+    config.name = c_name
+    config.num_shards = num_shards
+    config.envs_per_shard = envs_per_shard
+    config.threads_per_shard = threads_per_shard
+    config.packed_observations = int(packed_observations)
+    config.ring_capacity = ring_capacity
+    self._server = ffi.new("pyhanabi_env_server_t*")
+    lib.NewEnvServer(self._server, game.c_game, config)
+
+  def __del__(self):
+    if self._server is not None:
+      lib.DeleteEnvServer(self._server)
+      self._server = None
+      self._game = None
+    del self
+
+  def size(self):
+    """Returns the size of the shared memory object in bytes."""
+    return lib.EnvServerSize(self._server)
+
+
+def _shared_view(pointer, format, shape):
+  """Returns a memoryview of shape over the C array at pointer, or None."""
+  if pointer == ffi.NULL:
+    return None
+  num_bytes = ffi.sizeof(ffi.typeof(pointer).item)
+  for dim in shape:
+    num_bytes *= dim
+  return memoryview(ffi.buffer(pointer, num_bytes)).cast(format, shape)
+
+
+class HanabiEnvClient(object):
+  """One shard of a HanabiEnvServer, possibly in another process.
+
+  reset() and step() behave as those of HanabiVectorEnv, but the outputs are
+  read in place from shared memory: observations(), legal_moves() and the
+  others return memoryviews of the server's response, which
+  numpy.asarray() maps as NumPy arrays without copying. They stay valid
+  until the next request, and are None before the first successful one.
+
+  Python wrapper of C++ HanabiEnvClient class.
+  """
+
+  def __init__(self, name, shard=-1):
+    """Connects to shard of the server name, or to the first free shard.
+
+    Raises:
+      RuntimeError: no server serves name, or the shard is taken.
+    """
+    self._client = ffi.new("pyhanabi_env_client_t*")
+    lib.NewEnvClient(self._client)
+    if not lib.EnvClientConnect(self._client, name.encode("ascii"), shard):
+      raise RuntimeError("No free shard of env server {}.".format(name))
+    c_string = lib.EnvClientParameters(self._client)
+    lines = encode_ffi_string(c_string).splitlines()
+    lib.DeleteString(c_string)
+    self._parameters = dict(line.split("=", 1) for line in lines)
+
+  def __del__(self):
+    if self._client is not None:
+      lib.DeleteEnvClient(self._client)
+      self._client = None
+    del self
+
+  def close(self):
+    """Hands the shard back to the server."""
+    lib.EnvClientDisconnect(self._client)
+
+  def shard(self):
+    return lib.EnvClientShard(self._client)
+
+  def num_envs(self):
+    return lib.EnvClientNumEnvs(self._client)
+
+  def observation_length(self):
+    """Returns the encoding elements per game, 0 if the server packs them."""
+    return lib.EnvClientObservationLength(self._client)
+
+  def packed_observation_length(self):
+    """Returns the packed words per game, 0 unless the server packs them."""
+    return lib.EnvClientPackedObservationLength(self._client)
+
+  def num_moves(self):
+    return lib.EnvClientNumMoves(self._client)
+
+  def parameters(self):
+    """Returns the parameters of the served game, as strings."""
+    return dict(self._parameters)
+
+  def reset(self):
+    """Starts a new game in every slot of the shard."""
+    self._check(lib.EnvClientReset(self._client))
+
+  def step(self, move_uids):
+    """Applies move_uids[i], an int32 buffer, in game i of the shard.
+
+    Raises:
+      ValueError: a move is illegal; no game was stepped, and the outputs
+        are unchanged.
+      RuntimeError: the server stopped.
+    """
+    c_moves = _c_buffer(move_uids, "i", "int[]", self.num_envs(),
+                        writable=False)
+    self._check(lib.EnvClientStep(self._client, c_moves))
+
+  def observations(self):
+    """uint8 [num_envs, observation_length()], or None if packed."""
+    if self.observation_length() == 0:
+      return None
+    return _shared_view(lib.EnvClientObservations(self._client), "B",
+                        [self.num_envs(), self.observation_length()])
+
+  def packed_observations(self):
+    """uint64 [num_envs, packed_observation_length()], or None."""
+    if self.packed_observation_length() == 0:
+      return None
+    return _shared_view(lib.EnvClientPackedObservations(self._client), "Q",
+                        [self.num_envs(), self.packed_observation_length()])
+
+  def legal_moves(self):
+    """uint8 [num_envs, num_moves()], 1 for legal uids."""
+    return _shared_view(lib.EnvClientLegalMoves(self._client), "B",
+                        [self.num_envs(), self.num_moves()])
+
+  def rewards(self):
+    """float32 [num_envs], score differential of the last step."""
+    return _shared_view(lib.EnvClientRewards(self._client), "f",
+                        [self.num_envs()])
+
+  def dones(self):
+    """uint8 [num_envs], 1 if the game finished (and was reset)."""
+    return _shared_view(lib.EnvClientDones(self._client), "B",
+                        [self.num_envs()])
+
+  def current_players(self):
+    """int32 [num_envs]."""
+    return _shared_view(lib.EnvClientCurrentPlayers(self._client), "i",
+                        [self.num_envs()])
+
+  def _check(self, status):
+    if status == 1:
+      raise RuntimeError("The env server stopped.")
+    if status == 2:
+      raise ValueError("Illegal move uid.")
+
+
+def instrumentation_compiled():
+  """Whether the library was built with HANABI_ENABLE_INSTRUMENTATION."""
+  return bool(lib.InstrumentationIsCompiled())
+
+
+def set_instrumentation_enabled(enabled=True):
+  """Starts or stops recording the hot-path counters and timers."""
+  lib.InstrumentationSetEnabled(int(enabled))
+
+
+def read_instrumentation(reset=False):
+  """Returns the counters of all threads, optionally zeroing them.
+
+  Returns:
+    A dict from counter name, e.g. "apply_play" or "encode", to a dict with
+    "count" and cumulative "nanoseconds". All zeros unless
+    instrumentation_compiled() and recording was enabled.
+  """
+  num_counters = lib.InstrumentationNumCounters()
+  counts = ffi.new("int64_t[]", num_counters)
+  nanoseconds = ffi.new("int64_t[]", num_counters)
+  lib.InstrumentationRead(counts, nanoseconds, int(reset))
+  return {
+      encode_ffi_string(lib.InstrumentationCounterName(i)): {
+          "count": counts[i],
+          "nanoseconds": nanoseconds[i]
+      } for i in range(num_counters)
+  }
+
+
+def reset_instrumentation():
+  lib.InstrumentationReset()
+
 
 try_cdef()
 if cdef_loaded():
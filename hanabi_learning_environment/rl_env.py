@@ -66,6 +66,213 @@ class Environment(object):
     raise NotImplementedError("Not implemented in Abstract Base class")
 
 
+class ObservationDict(dict):
+  """Observation dict whose entries are built on first access.
+
+  The observation is copied into a pyhanabi_observation_data_t by one C call
+  when the dict is made, and each entry is assembled from that copy only when
+  it is first read, then stored in the dict. Anything that needs the whole
+  dict (iteration, views, copies, comparison, pickling, removal) builds the
+  remaining entries first. Otherwise it is a plain dict, with the entries,
+  key order and values of the dicts HanabiEnv used to return.
+  """
+
+  _KEYS = ("current_player", "current_player_offset", "life_tokens",
+           "information_tokens", "num_players", "deck_size", "fireworks",
+           "legal_moves", "legal_moves_as_int", "observed_hands",
+           "discard_pile", "card_knowledge", "vectorized", "pyhanabi")
+
+  def __init__(self, data, move_dicts, entries):
+    """Creates the dict.
+
+    Args:
+      data: pyhanabi_observation_data_t* from HanabiObservation.export_data,
+        owned by this dict from now on.
+      move_dicts: list of move dicts by uid, only read.
+      entries: dict of the entries that are not built from data.
+    """
+    super(ObservationDict, self).__init__(entries)
+    self._data = data
+    self._move_dicts = move_dicts
+    # Entries not built yet, in order.
+    self._pending = [key for key in self._KEYS if key not in entries]
+
+  def __missing__(self, key):
+    if key not in self._pending:
+      raise KeyError(key)
+    value = getattr(self, "_build_" + key)()
+    dict.__setitem__(self, key, value)
+    self._remove_pending(key)
+    return value
+
+  def _remove_pending(self, key):
+    self._pending.remove(key)
+    if not self._pending:
+      self._data = None
+      # Entries were inserted in the order they were built; restore the
+      # order of the plain dicts, followed by any keys added since.
+      entries = [(name, dict.pop(self, name))
+                 for name in self._KEYS
+                 if dict.__contains__(self, name)]
+      added = list(dict.items(self))
+      dict.clear(self)
+      dict.update(self, entries)
+      dict.update(self, added)
+
+  def _build_all(self):
+    """Builds every pending entry, after which this is a plain dict."""
+    for key in list(self._pending):
+      self.__missing__(key)
+
+  def __contains__(self, key):
+    return key in self._pending or dict.__contains__(self, key)
+
+  def __len__(self):
+    return dict.__len__(self) + len(self._pending)
+
+  def __iter__(self):
+    self._build_all()
+    return dict.__iter__(self)
+
+  def __setitem__(self, key, value):
+    dict.__setitem__(self, key, value)
+    if key in self._pending:
+      self._remove_pending(key)
+
+  def __delitem__(self, key):
+    self._build_all()
+    dict.__delitem__(self, key)
+
+  def __eq__(self, other):
+    self._build_all()
+    if isinstance(other, ObservationDict):
+      other._build_all()  # pylint: disable=protected-access
+    return dict.__eq__(self, other)
+
+  def __ne__(self, other):
+    equal = self.__eq__(other)
+    return equal if equal is NotImplemented else not equal
+
+  def __repr__(self):
+    self._build_all()
+    return dict.__repr__(self)
+
+  def __reduce__(self):
+    return (dict, (self.copy(),))
+
+  def get(self, key, default=None):
+    return self[key] if key in self else default
+
+  def keys(self):
+    self._build_all()
+    return dict.keys(self)
+
+  def values(self):
+    self._build_all()
+    return dict.values(self)
+
+  def items(self):
+    self._build_all()
+    return dict.items(self)
+
+  def copy(self):
+    self._build_all()
+    return dict(dict.items(self))
+
+  def pop(self, key, *default):
+    self._build_all()
+    return dict.pop(self, key, *default)
+
+  def popitem(self):
+    self._build_all()
+    return dict.popitem(self)
+
+  def update(self, *args, **kwargs):
+    for key, value in dict(*args, **kwargs).items():
+      self[key] = value
+
+  def __ior__(self, other):
+    self.update(other)
+    return self
+
+  def __or__(self, other):
+    return self.copy() | other
+
+  def __ror__(self, other):
+    return other | self.copy()
+
+  def __reversed__(self):
+    self._build_all()
+    return reversed(list(dict.keys(self)))
+
+  def setdefault(self, key, default=None):
+    if key in self:
+      return self[key]
+    dict.__setitem__(self, key, default)
+    return default
+
+  def clear(self):
+    self._pending = []
+    self._data = None
+    dict.clear(self)
+
+  def _cards(self, cards, size):
+    return [{
+        "color": pyhanabi.color_idx_to_char(cards[i].color),
+        "rank": cards[i].rank
+    } for i in range(size)]
+
+  def _build_current_player_offset(self):
+    return self._data.cur_player_offset
+
+  def _build_life_tokens(self):
+    return self._data.life_tokens
+
+  def _build_information_tokens(self):
+    return self._data.information_tokens
+
+  def _build_num_players(self):
+    return self._data.num_players
+
+  def _build_deck_size(self):
+    return self._data.deck_size
+
+  def _build_fireworks(self):
+    return {
+        pyhanabi.COLOR_CHAR[color]: self._data.fireworks[color]
+        for color in range(self._data.num_colors)
+    }
+
+  def _build_legal_moves_as_int(self):
+    return list(self._data.legal_move_uids[0:self._data.num_legal_moves])
+
+  def _build_legal_moves(self):
+    return [
+        dict(self._move_dicts[uid])
+        for uid in self._data.legal_move_uids[0:self._data.num_legal_moves]
+    ]
+
+  def _build_observed_hands(self):
+    return [
+        self._cards(self._data.hands[pid], self._data.hand_sizes[pid])
+        for pid in range(self._data.num_players)
+    ]
+
+  def _build_discard_pile(self):
+    return self._cards(self._data.discard_pile, self._data.num_discards)
+
+  def _build_card_knowledge(self):
+    knowledge = []
+    for pid in range(self._data.num_players):
+      colors = self._data.hinted_colors[pid]
+      ranks = self._data.hinted_ranks[pid]
+      knowledge.append([{
+          "color": pyhanabi.color_idx_to_char(colors[i]),
+          "rank": ranks[i] if ranks[i] >= 0 else None
+      } for i in range(self._data.hand_sizes[pid])])
+    return knowledge
+
+
 class HanabiEnv(Environment):
   """RL interface to a Hanabi environment.
 
@@ -82,7 +289,7 @@ class HanabiEnv(Environment):
   ```
   """
 
-  def __init__(self, config):
+  def __init__(self, config, reuse_observations=False):
     r"""Creates an environment with the given game configuration.
 
     Args:
@@ -99,13 +306,28 @@ class HanabiEnv(Environment):
             1: First-order common knowledge observation.
           - seed: int, Random seed.
           - random_start_player: bool, Random start player.
+      reuse_observations: bool, If True, the "pyhanabi" entry of each player's
+        observation is the same HanabiObservation on every reset and step,
+        updated in place, which saves creating one per player per step. An
+        observation kept from an earlier step then shows the current state.
     """
     assert isinstance(config, dict), "Expected config to be of type dict."
     self.game = pyhanabi.HanabiGame(config)
 
     self.observation_encoder = pyhanabi.ObservationEncoder(
         self.game, pyhanabi.ObservationEncoderType.CANONICAL)
+    # Encoding of the last observation, refilled for every player and step.
+    self._encoding = memoryview(bytearray(self.observation_encoder.size()))
     self.players = self.game.num_players()
+    # Moves and their dicts by uid, so that steps create no move objects.
+    self._moves = [
+        self.game.get_move(uid) for uid in range(self.game.max_moves())
+    ]
+    self._move_dicts = [move.to_dict() for move in self._moves]
+    # Observation of each player, updated in place by every reset and step
+    # if reuse_observations is set.
+    self._reuse_observations = reuse_observations
+    self._observations = [None] * self.players
 
   def reset(self):
     r"""Resets the environment for a new game.
@@ -206,11 +428,13 @@ class HanabiEnv(Environment):
                                                       1}]],
                                   'num_players': 2,
                                   'vectorized': [ 0, 0, 1, ... ]}]}
+
+      The "pyhanabi" entries are new HanabiObservations, unless the env was
+      created with reuse_observations=True; then they are the same objects on
+      every reset and step, updated in place.
     """
     self.state = self.game.new_initial_state()
-
-    while self.state.cur_player() == pyhanabi.CHANCE_PLAYER_ID:
-      self.state.deal_random_card()
+    self.state.deal_initial_hands()
 
     obs = self._make_observation_all_players()
     obs["current_player"] = self.state.cur_player()
@@ -333,6 +557,10 @@ class HanabiEnv(Environment):
                                             {'color': 'W', 'rank': 1}]],
                             'num_players': 2,
                             'vectorized': [ 0, 0, 1, ... ]}]}
+
+      The "pyhanabi" entries are new HanabiObservations, unless the env was
+      created with reuse_observations=True; then they are the same objects on
+      every reset and step, updated in place.
       reward: float, Reward obtained from taking the action.
       done: bool, Whether the game is done.
       info: dict, Optional debugging information.
@@ -345,7 +573,7 @@ class HanabiEnv(Environment):
       action = self._build_move(action)
     elif isinstance(action, int):
       # Convert int action into a Hanabi move.
-      action = self.game.get_move(action)
+      action = self._moves[action]
     else:
       raise ValueError("Expected action as dict or int, got: {}".format(
           action))
@@ -372,8 +600,14 @@ class HanabiEnv(Environment):
       dict, containing observations for all players.
     """
     obs = {}
+    for player_id in range(self.players):
+      if self._reuse_observations:
+        self._observations[player_id] = self.state.observation(
+            player_id, self._observations[player_id])
+      else:
+        self._observations[player_id] = self.state.observation(player_id)
     player_observations = [self._extract_dict_from_backend(
-        player_id, self.state.observation(player_id))
+        player_id, self._observations[player_id])
         for player_id in range(self.players)]  # pylint: disable=bad-continuation
     obs["player_observations"] = player_observations
     obs["current_player"] = self.state.cur_player()
@@ -387,55 +621,17 @@ class HanabiEnv(Environment):
       observation: A `pyhanabi.HanabiObservation` object.
 
     Returns:
-      obs_dict: dict, mapping from HanabiObservation to a dict.
+      ObservationDict, mapping entry names to observation features.
     """
-    obs_dict = {}
-    obs_dict["current_player"] = self.state.cur_player()
-    obs_dict["current_player_offset"] = observation.cur_player_offset()
-    obs_dict["life_tokens"] = observation.life_tokens()
-    obs_dict["information_tokens"] = observation.information_tokens()
-    obs_dict["num_players"] = observation.num_players()
-    obs_dict["deck_size"] = observation.deck_size()
-
-    obs_dict["fireworks"] = {}
-    fireworks = self.state.fireworks()
-    for color, firework in zip(pyhanabi.COLOR_CHAR, fireworks):
-      obs_dict["fireworks"][color] = firework
-
-    obs_dict["legal_moves"] = []
-    obs_dict["legal_moves_as_int"] = []
-    for move in observation.legal_moves():
-      obs_dict["legal_moves"].append(move.to_dict())
-      obs_dict["legal_moves_as_int"].append(self.game.get_move_uid(move))
-
-    obs_dict["observed_hands"] = []
-    for player_hand in observation.observed_hands():
-      cards = [card.to_dict() for card in player_hand]
-      obs_dict["observed_hands"].append(cards)
-
-    obs_dict["discard_pile"] = [
-        card.to_dict() for card in observation.discard_pile()
-    ]
-
-    # Return hints received.
-    obs_dict["card_knowledge"] = []
-    for player_hints in observation.card_knowledge():
-      player_hints_as_dicts = []
-      for hint in player_hints:
-        hint_d = {}
-        if hint.color() is not None:
-          hint_d["color"] = pyhanabi.color_idx_to_char(hint.color())
-        else:
-          hint_d["color"] = None
-        hint_d["rank"] = hint.rank()
-        player_hints_as_dicts.append(hint_d)
-      obs_dict["card_knowledge"].append(player_hints_as_dicts)
-
-    # ipdb.set_trace()
-    obs_dict["vectorized"] = self.observation_encoder.encode(observation)
-    obs_dict["pyhanabi"] = observation
-
-    return obs_dict
+    # Every entry but these is read from one copy of the observation, and is
+    # only built if the agent reads it.
+    return ObservationDict(
+        observation.export_data(), self._move_dicts, {
+            "current_player": self.state.cur_player(),
+            "vectorized": self.observation_encoder.encode_into(
+                observation, self._encoding).tolist(),
+            "pyhanabi": observation,
+        })
 
   def _build_move(self, action):
     """Build a move from an action dict.
@@ -489,11 +685,9 @@ class HanabiEnv(Environment):
     else:
       raise ValueError("Unknown action_type: {}".format(action_type))
 
-    legal_moves = self.state.legal_moves()
-    assert (str(move) in map(
-        str,
-        legal_moves)), "Illegal action: {}. Move should be one of : {}".format(
-            move, legal_moves)
+    assert self.state.move_is_legal(
+        move), "Illegal action: {}. Move should be one of : {}".format(
+            move, self.state.legal_moves())
 
     return move
 
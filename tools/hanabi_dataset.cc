@@ -0,0 +1,337 @@
+// Copyright 2018 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Builds an offline training dataset from game logs (see hanabi_game_log.h).
+//
+// Usage:
+//   hanabi_dataset --output_dir=<dir> [--threads=<n>] [--shard_steps=<n>]
+//       <log file or directory>...
+//
+// Every player move of every game becomes one step: the acting player's
+// canonical observation before the move, its legal moves, the move, and the
+// return from then on (the final score minus the score before the move, as
+// the sum of rl_env's rewards). Directories contribute their *.log files,
+// and all logs must be of the same game up to the seed.
+//
+// Steps are written in the order of the logs and of their games, in shards
+// of whole games holding at least shard_steps steps (but the last). Shard
+// k is written as four NumPy files in output_dir:
+//   shard-<k>.observations.npy  uint64 [steps, words], the observations
+//       packed as in bit_packing.h; numpy.unpackbits(a.view(numpy.uint8),
+//       axis=1, bitorder="little")[:, :observation_bits] recovers them.
+//   shard-<k>.legal_moves.npy   uint64 [steps], bit uid set for legal uids.
+//   shard-<k>.actions.npy       uint8 [steps], move uids.
+//   shard-<k>.returns.npy       float32 [steps].
+// metadata.txt holds the game parameters, observation_bits, num_moves
+// (the number of move uids), num_games, num_steps and num_shards, one
+// "key=value" per line. Shards are replayed in parallel, and the output does
+// not depend on the number of threads.
+
+#include <dirent.h>
+#include <sys/stat.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "bit_packing.h"
+#include "canonical_encoders.h"
+#include "hanabi_game.h"
+#include "hanabi_game_log.h"
+#include "hanabi_state.h"
+#include "thread_pool.h"
+#include "util.h"
+
+namespace hle = hanabi_learning_env;
+
+namespace {
+
+struct Options {
+  std::string output_dir;
+  int num_threads = 0;
+  int64_t shard_steps = int64_t{1} << 18;
+  std::vector<std::string> inputs;
+};
+
+bool ParseFlag(const char* arg, const char* flag, const char** value) {
+  const size_t length = std::strlen(flag);
+  if (std::strncmp(arg, flag, length) != 0) {
+    return false;
+  }
+  *value = arg + length;
+  return true;
+}
+
+bool ParseOptions(int argc, char** argv, Options* options) {
+  for (int i = 1; i < argc; ++i) {
+    const char* value = nullptr;
+    if (ParseFlag(argv[i], "--output_dir=", &value)) {
+      options->output_dir = value;
+    } else if (ParseFlag(argv[i], "--threads=", &value)) {
+      options->num_threads = std::atoi(value);
+    } else if (ParseFlag(argv[i], "--shard_steps=", &value)) {
+      options->shard_steps = std::atoll(value);
+    } else if (argv[i][0] != '-') {
+      options->inputs.push_back(argv[i]);
+    } else {
+      return false;
+    }
+  }
+  return !options->output_dir.empty() && !options->inputs.empty() &&
+         options->shard_steps > 0;
+}
+
+bool EndsWith(const std::string& text, const std::string& suffix) {
+  return text.size() >= suffix.size() &&
+         text.compare(text.size() - suffix.size(), suffix.size(), suffix) == 0;
+}
+
+// Expands directories to their *.log files, sorted by name.
+std::vector<std::string> ListLogs(const std::vector<std::string>& inputs) {
+  std::vector<std::string> paths;
+  for (const std::string& input : inputs) {
+    struct stat input_stat;
+    REQUIRE(stat(input.c_str(), &input_stat) == 0);
+    if (!S_ISDIR(input_stat.st_mode)) {
+      paths.push_back(input);
+      continue;
+    }
+    std::vector<std::string> names;
+    DIR* dir = opendir(input.c_str());
+    REQUIRE(dir != nullptr);
+    while (const dirent* entry = readdir(dir)) {
+      if (EndsWith(entry->d_name, ".log")) {
+        names.push_back(entry->d_name);
+      }
+    }
+    closedir(dir);
+    std::sort(names.begin(), names.end());
+    for (const std::string& name : names) {
+      paths.push_back(input + "/" + name);
+    }
+  }
+  return paths;
+}
+
+std::unordered_map<std::string, std::string> ParametersWithoutSeed(
+    const hle::HanabiGame& game) {
+  std::unordered_map<std::string, std::string> params = game.Parameters();
+  params.erase("seed");
+  return params;
+}
+
+// Writes a little-endian NumPy array of the given element type ("<u8",
+// "|u1", "<f4") and shape.
+void WriteNpy(const std::string& path, const std::string& descr,
+              const std::vector<int64_t>& shape, const void* data,
+              size_t num_bytes) {
+  std::string header = "{'descr': '" + descr + "', 'fortran_order': False, " +
+                       "'shape': (";
+  for (int i = 0; i < static_cast<int>(shape.size()); ++i) {
+    header += (i > 0 ? ", " : "") + std::to_string(shape[i]);
+  }
+  header += shape.size() == 1 ? ",), }" : "), }";
+  // The magic, version and header length take 10 bytes, and the header is
+  // padded with spaces and a newline to align the data to 64 bytes.
+  header.append(63 - (10 + header.size()) % 64, ' ');
+  header += '\n';
+  std::FILE* file = std::fopen(path.c_str(), "wb");
+  REQUIRE(file != nullptr);
+  const char preamble[8] = {'\x93', 'N', 'U', 'M', 'P', 'Y', 1, 0};
+  const uint8_t header_length[2] = {static_cast<uint8_t>(header.size()),
+                                    static_cast<uint8_t>(header.size() >> 8)};
+  REQUIRE(std::fwrite(preamble, 1, sizeof(preamble), file) ==
+          sizeof(preamble));
+  REQUIRE(std::fwrite(header_length, 1, 2, file) == 2);
+  REQUIRE(std::fwrite(header.data(), 1, header.size(), file) ==
+          header.size());
+  REQUIRE(std::fwrite(data, 1, num_bytes, file) == num_bytes);
+  REQUIRE(std::fclose(file) == 0);
+}
+
+// A game of one of the logs.
+struct GameRef {
+  int log;
+  int game;
+};
+
+// The steps of one shard, one row per player move.
+struct Shard {
+  void Resize(int64_t num_steps, int words) {
+    observations.resize(num_steps * words);
+    legal_moves.resize(num_steps);
+    actions.resize(num_steps);
+    returns.resize(num_steps);
+  }
+
+  std::vector<uint64_t> observations;
+  std::vector<uint64_t> legal_moves;
+  std::vector<uint8_t> actions;
+  std::vector<float> returns;
+};
+
+// Replays game into rows [row, row + its player moves) of shard, encoding
+// each player's observations incrementally. parent_game is the game of the
+// encoders, with the parameters of the log up to the seed.
+void EncodeGame(hle::HanabiGame* parent_game,
+                const hle::HanabiGameLogReader& reader, int game,
+                std::vector<hle::IncrementalCanonicalEncoder>* encoders,
+                int words, int64_t row, Shard* shard) {
+  hle::HanabiState state(parent_game, reader.StartPlayer(game));
+  state.SetRecordMoveHistory(false);
+  for (hle::IncrementalCanonicalEncoder& encoder : *encoders) {
+    encoder.Invalidate();
+  }
+  const int64_t first_row = row;
+  const int num_moves = reader.NumMoves(game);
+  for (int i = 0; i < num_moves; ++i) {
+    const hle::HanabiMove move = reader.Move(game, i);
+    if (move.MoveType() != hle::HanabiMove::kDeal) {
+      const int player = state.CurPlayer();
+      hle::IncrementalCanonicalEncoder& encoder = (*encoders)[player];
+      encoder.Update(state);
+      encoder.EncodingPacked(&shard->observations[row * words]);
+      shard->legal_moves[row] = state.LegalMoveMask(player);
+      shard->actions[row] = parent_game->GetMoveUid(move);
+      // The score before the move, until the final score is known.
+      shard->returns[row] = state.Score();
+      ++row;
+    }
+    state.ApplyMove(move);
+  }
+  const int final_score = state.Score();
+  for (int64_t r = first_row; r < row; ++r) {
+    shard->returns[r] = final_score - shard->returns[r];
+  }
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  Options options;
+  if (!ParseOptions(argc, argv, &options)) {
+    std::fprintf(stderr,
+                 "usage: %s --output_dir=<dir> [--threads=<n>] "
+                 "[--shard_steps=<n>] <log file or directory>...\n",
+                 argv[0]);
+    return 1;
+  }
+  const uint16_t endianness_probe = 1;
+  REQUIRE(*reinterpret_cast<const uint8_t*>(&endianness_probe) == 1);
+  const auto start_time = std::chrono::steady_clock::now();
+
+  const std::vector<std::string> paths = ListLogs(options.inputs);
+  REQUIRE(!paths.empty());
+  std::vector<std::unique_ptr<hle::HanabiGameLogReader>> readers;
+  for (const std::string& path : paths) {
+    readers.emplace_back(new hle::HanabiGameLogReader(path));
+    REQUIRE(ParametersWithoutSeed(*readers.back()->ParentGame()) ==
+            ParametersWithoutSeed(*readers[0]->ParentGame()));
+  }
+  const hle::HanabiGame& game = *readers[0]->ParentGame();
+  const hle::CanonicalObservationEncoder canonical_encoder(&game);
+  const int observation_bits = canonical_encoder.Size();
+  const int words = hle::PackedLength(observation_bits);
+
+  // Shards of whole games, delimited by their first game and first row.
+  std::vector<GameRef> games;
+  std::vector<int64_t> game_rows;
+  std::vector<int> shard_first_game = {0};
+  std::vector<int64_t> shard_first_row = {0};
+  int64_t num_steps = 0;
+  for (int log = 0; log < static_cast<int>(readers.size()); ++log) {
+    for (int g = 0; g < readers[log]->NumGames(); ++g) {
+      if (num_steps - shard_first_row.back() >= options.shard_steps) {
+        shard_first_game.push_back(games.size());
+        shard_first_row.push_back(num_steps);
+      }
+      games.push_back({log, g});
+      game_rows.push_back(num_steps);
+      num_steps += readers[log]->NumPlayerMoves(g);
+    }
+  }
+  shard_first_game.push_back(games.size());
+  shard_first_row.push_back(num_steps);
+  const int num_shards = shard_first_game.size() - 1;
+
+  hle::ThreadPool pool(options.num_threads);
+  std::atomic<int> next_shard(0);
+  pool.ParallelFor(pool.NumThreads(), [&](int begin, int end) {
+    std::vector<hle::IncrementalCanonicalEncoder> encoders;
+    for (int player = 0; player < game.NumPlayers(); ++player) {
+      encoders.emplace_back(&game, player);
+    }
+    Shard shard;
+    for (int thread = begin; thread < end; ++thread) {
+      for (int s = next_shard++; s < num_shards; s = next_shard++) {
+        const int64_t first_row = shard_first_row[s];
+        shard.Resize(shard_first_row[s + 1] - first_row, words);
+        for (int g = shard_first_game[s]; g < shard_first_game[s + 1]; ++g) {
+          EncodeGame(readers[0]->ParentGame(), *readers[games[g].log],
+                     games[g].game, &encoders, words,
+                     game_rows[g] - first_row, &shard);
+        }
+        char name[32];
+        std::snprintf(name, sizeof(name), "shard-%05d", s);
+        const std::string prefix = options.output_dir + "/" + name;
+        const int64_t rows = shard.actions.size();
+        WriteNpy(prefix + ".observations.npy", "<u8", {rows, words},
+                 shard.observations.data(),
+                 shard.observations.size() * sizeof(uint64_t));
+        WriteNpy(prefix + ".legal_moves.npy", "<u8", {rows},
+                 shard.legal_moves.data(), rows * sizeof(uint64_t));
+        WriteNpy(prefix + ".actions.npy", "|u1", {rows}, shard.actions.data(),
+                 rows);
+        WriteNpy(prefix + ".returns.npy", "<f4", {rows}, shard.returns.data(),
+                 rows * sizeof(float));
+      }
+    }
+  });
+
+  std::FILE* metadata =
+      std::fopen((options.output_dir + "/metadata.txt").c_str(), "w");
+  REQUIRE(metadata != nullptr);
+  std::unordered_map<std::string, std::string> params = game.Parameters();
+  params.erase("seed");
+  std::vector<std::pair<std::string, std::string>> sorted(params.begin(),
+                                                          params.end());
+  std::sort(sorted.begin(), sorted.end());
+  for (const auto& param : sorted) {
+    std::fprintf(metadata, "%s=%s\n", param.first.c_str(),
+                 param.second.c_str());
+  }
+  std::fprintf(metadata, "observation_bits=%d\nnum_moves=%d\n",
+               observation_bits, game.MaxMoves());
+  std::fprintf(metadata, "num_games=%zu\nnum_steps=%lld\nnum_shards=%d\n",
+               games.size(), static_cast<long long>(num_steps), num_shards);
+  REQUIRE(std::fclose(metadata) == 0);
+
+  const double seconds = std::chrono::duration<double>(
+                             std::chrono::steady_clock::now() - start_time)
+                             .count();
+  std::printf("%d logs, %zu games, %lld steps in %d shards, %.2f s "
+              "(%.0f steps/s)\n",
+              static_cast<int>(readers.size()), games.size(),
+              static_cast<long long>(num_steps), num_shards, seconds,
+              num_steps / std::max(seconds, 1e-9));
+  return 0;
+}
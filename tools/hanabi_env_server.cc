@@ -0,0 +1,118 @@
+// Copyright 2018 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Serves Hanabi games to actor processes through shared memory (see
+// hanabi_env_server.h) until interrupted.
+//
+// Usage:
+//   hanabi_env_server --name=<name> [--shards=<n>] [--envs_per_shard=<n>]
+//       [--threads_per_shard=<n>] [--ring_capacity=<n>] [--packed]
+//       [<game parameter>=<value>...]
+//
+// Game parameters are those of HanabiGame, e.g. players=3 seed=7. Clients
+// connect with HanabiEnvClient, or pyhanabi.HanabiEnvClient(name) from
+// Python, one per shard. SIGINT or SIGTERM stops the server and removes the
+// shared memory object.
+
+#include <signal.h>
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <unordered_map>
+
+#include "hanabi_env_server.h"
+#include "hanabi_game.h"
+#include "util.h"
+
+namespace hle = hanabi_learning_env;
+
+namespace {
+
+struct Options {
+  hle::HanabiEnvServerConfig config;
+  std::unordered_map<std::string, std::string> game_params;
+};
+
+bool ParseFlag(const char* arg, const char* flag, const char** value) {
+  const size_t length = std::strlen(flag);
+  if (std::strncmp(arg, flag, length) != 0) {
+    return false;
+  }
+  *value = arg + length;
+  return true;
+}
+
+bool ParseOptions(int argc, char** argv, Options* options) {
+  for (int i = 1; i < argc; ++i) {
+    const char* value = nullptr;
+    if (ParseFlag(argv[i], "--name=", &value)) {
+      options->config.name = value;
+    } else if (ParseFlag(argv[i], "--shards=", &value)) {
+      options->config.num_shards = std::atoi(value);
+    } else if (ParseFlag(argv[i], "--envs_per_shard=", &value)) {
+      options->config.envs_per_shard = std::atoi(value);
+    } else if (ParseFlag(argv[i], "--threads_per_shard=", &value)) {
+      options->config.threads_per_shard = std::atoi(value);
+    } else if (ParseFlag(argv[i], "--ring_capacity=", &value)) {
+      options->config.ring_capacity = std::atoi(value);
+    } else if (std::strcmp(argv[i], "--packed") == 0) {
+      options->config.packed_observations = true;
+    } else if (argv[i][0] != '-' && std::strchr(argv[i], '=') != nullptr) {
+      const std::string param = argv[i];
+      const size_t equals = param.find('=');
+      options->game_params[param.substr(0, equals)] = param.substr(equals + 1);
+    } else {
+      return false;
+    }
+  }
+  return !options->config.name.empty() && options->config.num_shards > 0 &&
+         options->config.envs_per_shard > 0 &&
+         options->config.ring_capacity >= 2;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  Options options;
+  if (!ParseOptions(argc, argv, &options)) {
+    std::fprintf(stderr,
+                 "usage: %s --name=<name> [--shards=<n>] "
+                 "[--envs_per_shard=<n>] [--threads_per_shard=<n>] "
+                 "[--ring_capacity=<n>] [--packed] "
+                 "[<game parameter>=<value>...]\n",
+                 argv[0]);
+    return 1;
+  }
+  // Blocked before the server starts its threads, which inherit the mask,
+  // so that the signals are only taken by sigwait below.
+  sigset_t signals;
+  sigemptyset(&signals);
+  sigaddset(&signals, SIGINT);
+  sigaddset(&signals, SIGTERM);
+  REQUIRE(pthread_sigmask(SIG_BLOCK, &signals, nullptr) == 0);
+
+  hle::HanabiGame game(options.game_params);
+  hle::HanabiEnvServer server(&game, options.config);
+  std::fprintf(stderr,
+               "Serving %d shards of %d games as %s (%lld bytes).\n",
+               server.NumShards(), options.config.envs_per_shard,
+               server.Name().c_str(),
+               static_cast<long long>(server.Size()));
+  int received = 0;
+  sigwait(&signals, &received);
+  std::fprintf(stderr, "Stopping.\n");
+  return 0;
+}